@@ -10,6 +10,28 @@
 
 using namespace mooncake;
 
+// 対称描画ボタンを押すたびに順に切り替えるモード
+static const struct {
+    drawing::SymmetryMode mode;
+    const char* label;
+} SYMMETRY_MODES[] = {
+    {{1, false}, "Sym"}, {{1, true}, "Mirror"}, {{2, true}, "x4"},     {{3, true}, "x6"},
+    {{4, true}, "x8"},   {{6, true}, "x12"},    {{6, false}, "Spin 6"},
+};
+static constexpr int SYMMETRY_MODE_NUM = sizeof(SYMMETRY_MODES) / sizeof(SYMMETRY_MODES[0]);
+
+// 図形ボタンを押すたびに順に切り替える図形（最後の次は図形ツールを外す）
+static const struct {
+    drawing::ShapeType type;
+    const char* label;
+} SHAPE_TOOLS[] = {
+    {drawing::SHAPE_LINE, "Line"},
+    {drawing::SHAPE_RECTANGLE, "Rect"},
+    {drawing::SHAPE_CIRCLE, "Circle"},
+    {drawing::SHAPE_ELLIPSE, "Ellipse"},
+};
+static constexpr int SHAPE_TOOL_NUM = sizeof(SHAPE_TOOLS) / sizeof(SHAPE_TOOLS[0]);
+
 AppDrawingCamera::AppDrawingCamera()
 {
     setAppInfo().name = "DrawingCamera";
@@ -32,30 +54,89 @@ void AppDrawingCamera::onOpen()
 
     // 描画モードで開始
     switchToDrawingMode();
+
+    // タッチを高頻度でサンプリングしてキューに溜める（未対応なら LVGL のイベントで描画する）
+    GetHAL()->touchSamples.clear();
+    GetHAL()->viewGestures.clear();
+    _touch_sampling = GetHAL()->setTouchSampling(true);
+    for (auto& finger : _fingers) {
+        finger.pressed = false;
+    }
+    _pinch.end();
+    mclog::tagInfo(getAppInfo().name, "touch sample queue: {} ({} fingers)", _touch_sampling,
+                   GetHAL()->getMaxTouchPoints());
+
+    // 入力から表示までの遅延は開いている間の分だけ集計する
+    {
+        LvglLockGuard lock;
+        GetHAL()->latencyTrace.reset();
+    }
+    _latency_log_ms = GetHAL()->millis();
+
+    // メモリに置ききれないインクのタイルは SD カード（デスクトップでは一時ディレクトリ）へ追い出す
+    std::string scratch_dir = GetHAL()->getScratchDir();
+    if (!scratch_dir.empty() && _page_file.open(scratch_dir + "/drawing_tiles.bin", _ink_layer.tileBytes())) {
+        _ink_layer.setPageFile(&_page_file);
+    }
+    mclog::tagInfo(getAppInfo().name, "tile page file: {}", _page_file.isOpen() ? _page_file.path() : "none");
 }
 
 void AppDrawingCamera::onRunning()
 {
+    // 前回から溜まったタッチサンプルをまとめて描画する
+    if (_touch_sampling) {
+        processViewGestures();
+        processTouchSamples();
+    }
+
+    // 撮影したフレームは LVGL のロックの外で写真にする
+    if (_photo_pending) {
+        setBackgroundImage();
+    }
+
+    if (GetHAL()->millis() - _latency_log_ms >= LATENCY_LOG) {
+        logLatency();
+    }
 }
 
 void AppDrawingCamera::onClose()
 {
     mclog::tagInfo(getAppInfo().name, "on close");
 
-    // カメラキャプチャを停止
-    if (_current_state == STATE_CAMERA_PREVIEW) {
-        GetHAL()->stopCameraCapture();
-    }
+    GetHAL()->setTouchSampling(false);
+    _touch_sampling = false;
+
+    // カメラの電源を切る（撮影の合間は一時停止して温めておくだけなので、ここで閉じる）
+    GetHAL()->powerOffCamera();
 
     // バッファをクリーンアップ
     if (_canvas_buffer) {
         lv_draw_buf_destroy(_canvas_buffer);
         _canvas_buffer = nullptr;
     }
-    if (_background_buffer) {
-        lv_draw_buf_destroy(_background_buffer);
-        _background_buffer = nullptr;
+    // フレームは返すときに HAL が消去するので、ロックの中では受け取るだけにする
+    hal::HalBase::CameraFrame_t pending;
+    hal::HalBase::CameraFrame_t photo;
+    {
+        LvglLockGuard lock;
+        pending        = _pending_photo;
+        photo          = _photo_frame;
+        _pending_photo = {};
+        _photo_frame   = {};
+        _photo_pending = false;
+        _photo         = {};
     }
+    GetHAL()->releaseCameraFrame(pending);
+    GetHAL()->releaseCameraFrame(photo);
+    std::vector<uint16_t>().swap(_photo_pixels);
+    _has_background_image = false;
+
+    // 履歴と記録は閉じたキャンバスのものなので、レイヤーと一緒に捨てる
+    _undo_history.clear();
+    _stroke_log.clear();
+    _ink_layer.clear();
+    _ink_layer.setPageFile(nullptr);
+    _page_file.close();
 }
 
 void AppDrawingCamera::initDrawingScreen()
@@ -73,9 +154,9 @@ void AppDrawingCamera::initDrawingScreen()
     lv_obj_set_scroll_dir(_main_screen, LV_DIR_NONE);
     lv_obj_clear_flag(_main_screen, LV_OBJ_FLAG_SCROLLABLE);
 
-    // キャンバス作成（全画面サイズ）
+    // キャンバス作成（全画面サイズ。キャンバスのうち表示範囲だけを描く）
     _canvas = lv_canvas_create(_main_screen);
-    lv_obj_set_size(_canvas, CANVAS_WIDTH, CANVAS_HEIGHT);
+    lv_obj_set_size(_canvas, SCREEN_WIDTH, SCREEN_HEIGHT);
     lv_obj_align(_canvas, LV_ALIGN_CENTER, 0, 0);  // 画面中央に配置
 
     // キャンバスのスクロールを無効化
@@ -83,15 +164,20 @@ void AppDrawingCamera::initDrawingScreen()
     lv_obj_set_scroll_dir(_canvas, LV_DIR_NONE);
     lv_obj_clear_flag(_canvas, LV_OBJ_FLAG_SCROLLABLE);
 
-    // キャンバス用バッファ作成
-    _canvas_buffer = lv_draw_buf_create(CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
+    // 表示用バッファ作成（キャンバス全体の画像は持たない。写真のバッファは撮影したときに確保する）
+    _canvas_buffer = lv_draw_buf_create(SCREEN_WIDTH, SCREEN_HEIGHT, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
     lv_canvas_set_draw_buf(_canvas, _canvas_buffer);
 
-    // 背景画像保存用バッファ作成
-    _background_buffer = lv_draw_buf_create(CANVAS_WIDTH, CANVAS_HEIGHT, LV_COLOR_FORMAT_RGB565, LV_STRIDE_AUTO);
-
-    // キャンバスを白で初期化
-    lv_canvas_fill_bg(_canvas, lv_color_white(), LV_OPA_COVER);
+    _ink_layer.init(CANVAS_WIDTH, CANVAS_HEIGHT, INK_FORMAT);
+    _ink_layer.setResidentBudget(INK_BUDGET);
+    _undo_history.init(CANVAS_WIDTH, CANVAS_HEIGHT, UNDO_BUDGET);
+    _flood_fill.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    _stroke_log.init(STROKE_LOG_SIZE);
+    _brush.setSize(drawing::BRUSH_SIZES[_brush_size_index]);
+    _viewport.init(CANVAS_WIDTH, CANVAS_HEIGHT, SCREEN_WIDTH, SCREEN_HEIGHT);
+    _symmetry.setMode(SYMMETRY_MODES[_symmetry_index].mode, _viewport.visibleRect());
+    _mip_pyramid.init(CANVAS_WIDTH, CANVAS_HEIGHT, VIEW_BUDGET, lv_color_to_u16(lv_color_white()),
+                      [this](int index, const drawing::PixelBuffer565& out) { return composeTile(index, out); });
 
     // キャンバスのタッチイベント設定
     lv_obj_add_event_cb(_canvas, canvasEventHandler, LV_EVENT_PRESSED, this);
@@ -99,6 +185,9 @@ void AppDrawingCamera::initDrawingScreen()
     lv_obj_add_event_cb(_canvas, canvasEventHandler, LV_EVENT_RELEASED, this);
     lv_obj_add_flag(_canvas, LV_OBJ_FLAG_CLICKABLE);
 
+    // 描画による更新領域はリフレッシュ開始時にまとめて無効化する
+    lv_display_add_event_cb(lv_obj_get_display(_canvas), displayRefrStartHandler, LV_EVENT_REFR_START, this);
+
     // 現在選択中の色を表示するボタン（左上に配置）
     _current_color_btn = lv_btn_create(_main_screen);
     lv_obj_set_size(_current_color_btn, 80, 80);
@@ -112,6 +201,82 @@ void AppDrawingCamera::initDrawingScreen()
     lv_obj_set_style_border_color(_current_color_btn, lv_color_hex(0x666666), 0);
     lv_obj_set_style_radius(_current_color_btn, 40, 0);
 
+    // ブラシサイズボタン（色選択ボタンの右、中の円で現在のサイズを表示）
+    _brush_size_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_brush_size_btn, 80, 80);
+    lv_obj_align(_brush_size_btn, LV_ALIGN_TOP_LEFT, 120, 20);
+    lv_obj_add_event_cb(_brush_size_btn, brushSizeBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_set_style_bg_color(_brush_size_btn, lv_color_white(), 0);
+    lv_obj_set_style_border_width(_brush_size_btn, 3, 0);
+    lv_obj_set_style_border_color(_brush_size_btn, lv_color_hex(0x666666), 0);
+    lv_obj_set_style_radius(_brush_size_btn, 40, 0);
+    lv_obj_move_foreground(_brush_size_btn);  // 前面に移動
+
+    _brush_size_dot = lv_obj_create(_brush_size_btn);
+    lv_obj_set_style_border_width(_brush_size_dot, 0, 0);
+    lv_obj_set_style_radius(_brush_size_dot, LV_RADIUS_CIRCLE, 0);
+    lv_obj_clear_flag(_brush_size_dot, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_clear_flag(_brush_size_dot, LV_OBJ_FLAG_SCROLLABLE);
+    updateBrushSizeButton();
+
+    initBrushSizePanel();
+
+    // 塗りつぶしツールボタン（ブラシサイズボタンの右、押すたびにペンと切り替え）
+    _fill_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_fill_btn, 120, 80);
+    lv_obj_align(_fill_btn, LV_ALIGN_TOP_LEFT, 220, 20);
+    lv_obj_add_flag(_fill_btn, LV_OBJ_FLAG_CHECKABLE);
+    lv_obj_add_event_cb(_fill_btn, toolBtnEventHandler, LV_EVENT_VALUE_CHANGED, this);
+    lv_obj_move_foreground(_fill_btn);  // 前面に移動
+
+    lv_obj_t* fill_label = lv_label_create(_fill_btn);
+    lv_label_set_text(fill_label, "Fill");
+    lv_obj_center(fill_label);
+
+    // 消しゴムツールボタン（塗りつぶしボタンの右、押すたびにペンと切り替え）
+    _eraser_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_eraser_btn, 120, 80);
+    lv_obj_align(_eraser_btn, LV_ALIGN_TOP_LEFT, 360, 20);
+    lv_obj_add_flag(_eraser_btn, LV_OBJ_FLAG_CHECKABLE);
+    lv_obj_add_event_cb(_eraser_btn, toolBtnEventHandler, LV_EVENT_VALUE_CHANGED, this);
+    lv_obj_move_foreground(_eraser_btn);  // 前面に移動
+
+    lv_obj_t* eraser_label = lv_label_create(_eraser_btn);
+    lv_label_set_text(eraser_label, "Erase");
+    lv_obj_center(eraser_label);
+
+    // 対称描画ボタン（消しゴムボタンの右、押すたびに次のモードへ切り替え）
+    _symmetry_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_symmetry_btn, 120, 80);
+    lv_obj_align(_symmetry_btn, LV_ALIGN_TOP_LEFT, 500, 20);
+    lv_obj_add_event_cb(_symmetry_btn, symmetryBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_move_foreground(_symmetry_btn);  // 前面に移動
+
+    _symmetry_label = lv_label_create(_symmetry_btn);
+    lv_label_set_text(_symmetry_label, SYMMETRY_MODES[_symmetry_index].label);
+    lv_obj_center(_symmetry_label);
+
+    // 図形ツールボタン（対称描画ボタンの右、押すたびに次の図形へ切り替え）
+    _shape_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_shape_btn, 120, 80);
+    lv_obj_align(_shape_btn, LV_ALIGN_TOP_LEFT, 640, 20);
+    lv_obj_add_event_cb(_shape_btn, shapeBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_move_foreground(_shape_btn);  // 前面に移動
+
+    _shape_label = lv_label_create(_shape_btn);
+    lv_label_set_text(_shape_label, "Shape");
+    lv_obj_center(_shape_label);
+
+    // 表示倍率ボタン（左下、押すと等倍・左上に戻す）
+    _zoom_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_zoom_btn, 120, 80);
+    lv_obj_align(_zoom_btn, LV_ALIGN_BOTTOM_LEFT, 20, -20);
+    lv_obj_add_event_cb(_zoom_btn, zoomBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_move_foreground(_zoom_btn);  // 前面に移動
+
+    _zoom_label = lv_label_create(_zoom_btn);
+    lv_obj_center(_zoom_label);
+
     // カラーパレットコンテナ（横方向展開、最初は非表示）
     _color_palette = lv_obj_create(_main_screen);
     lv_obj_set_size(_color_palette, 800, 120);               // 横長に変更
@@ -155,6 +320,7 @@ void AppDrawingCamera::initDrawingScreen()
         lv_obj_set_size(color_btn, btn_size, btn_size);
         lv_obj_set_pos(color_btn, spacing + i * (btn_size + spacing), btn_y);  // 横配置に変更
         lv_obj_set_style_bg_color(color_btn, _palette_colors[i], 0);
+        _ink_layer.setPaletteColor(i, lv_color_to_u16(_palette_colors[i]));
         lv_obj_set_style_border_width(color_btn, 2, 0);
         lv_obj_set_style_border_color(color_btn, lv_color_hex(0x666666), 0);
         lv_obj_set_style_radius(color_btn, btn_size / 2, 0);
@@ -185,6 +351,78 @@ void AppDrawingCamera::initDrawingScreen()
     lv_obj_t* clear_label = lv_label_create(_clear_btn);
     lv_label_set_text(clear_label, "Clear");
     lv_obj_center(clear_label);
+
+    // やり直しボタン（クリアボタンの左）
+    _redo_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_redo_btn, 120, 80);
+    lv_obj_align(_redo_btn, LV_ALIGN_TOP_RIGHT, -160, 20);
+    lv_obj_add_event_cb(_redo_btn, redoBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_move_foreground(_redo_btn);  // 前面に移動
+
+    lv_obj_t* redo_label = lv_label_create(_redo_btn);
+    lv_label_set_text(redo_label, "Redo");
+    lv_obj_center(redo_label);
+
+    // 取り消しボタン（やり直しボタンの左）
+    _undo_btn = lv_btn_create(_main_screen);
+    lv_obj_set_size(_undo_btn, 120, 80);
+    lv_obj_align(_undo_btn, LV_ALIGN_TOP_RIGHT, -300, 20);
+    lv_obj_add_event_cb(_undo_btn, undoBtnEventHandler, LV_EVENT_CLICKED, this);
+    lv_obj_move_foreground(_undo_btn);  // 前面に移動
+
+    lv_obj_t* undo_label = lv_label_create(_undo_btn);
+    lv_label_set_text(undo_label, "Undo");
+    lv_obj_center(undo_label);
+
+    updateUndoButtons();
+
+    // キャンバスの表示範囲を描く（インクも写真もないので白になる）
+    renderView();
+}
+
+void AppDrawingCamera::initBrushSizePanel()
+{
+    // ブラシサイズパネル（ブラシサイズボタンの下に横方向展開、最初は非表示）
+    _brush_size_panel = lv_obj_create(_main_screen);
+    lv_obj_set_size(_brush_size_panel, BRUSH_PANEL_WIDTH, 120);
+    lv_obj_align(_brush_size_panel, LV_ALIGN_TOP_LEFT, 20, 120);
+    lv_obj_set_style_bg_color(_brush_size_panel, lv_color_hex(0x333333), 0);
+    lv_obj_set_style_border_width(_brush_size_panel, 2, 0);
+    lv_obj_set_style_border_color(_brush_size_panel, lv_color_white(), 0);
+    lv_obj_set_style_radius(_brush_size_panel, 20, 0);
+    lv_obj_set_style_pad_all(_brush_size_panel, 0, 0);
+    lv_obj_clear_flag(_brush_size_panel, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_move_foreground(_brush_size_panel);  // 前面に移動
+    lv_obj_add_flag(_brush_size_panel, LV_OBJ_FLAG_HIDDEN);
+
+    int btn_size = 70;
+    int spacing  = 10;
+    int btn_y    = (120 - btn_size) / 2;  // パネル内で縦中央に配置
+
+    for (int i = 0; i < drawing::BRUSH_SIZE_NUM; i++) {
+        lv_obj_t* size_btn = lv_btn_create(_brush_size_panel);
+        lv_obj_set_size(size_btn, btn_size, btn_size);
+        lv_obj_set_pos(size_btn, spacing + i * (btn_size + spacing), btn_y);
+        lv_obj_set_style_bg_color(size_btn, lv_color_white(), 0);
+        lv_obj_set_style_border_width(size_btn, 2, 0);
+        lv_obj_set_style_border_color(size_btn, lv_color_hex(0x666666), 0);
+        lv_obj_set_style_radius(size_btn, btn_size / 2, 0);
+        lv_obj_add_event_cb(size_btn, brushSizePanelEventHandler, LV_EVENT_CLICKED, this);
+
+        // サイズインデックスを保存
+        lv_obj_set_user_data(size_btn, (void*)(intptr_t)i);
+
+        // 実際の直径の円を表示（ボタンに収まる範囲）
+        int dot_size  = std::min(drawing::BRUSH_SIZES[i], btn_size - 14);
+        lv_obj_t* dot = lv_obj_create(size_btn);
+        lv_obj_set_size(dot, dot_size, dot_size);
+        lv_obj_set_style_bg_color(dot, lv_color_black(), 0);
+        lv_obj_set_style_border_width(dot, 0, 0);
+        lv_obj_set_style_radius(dot, LV_RADIUS_CIRCLE, 0);
+        lv_obj_clear_flag(dot, LV_OBJ_FLAG_CLICKABLE);
+        lv_obj_clear_flag(dot, LV_OBJ_FLAG_SCROLLABLE);
+        lv_obj_center(dot);
+    }
 }
 
 void AppDrawingCamera::initCameraScreen()
@@ -199,7 +437,7 @@ void AppDrawingCamera::initCameraScreen()
 
     // カメラプレビュー用キャンバス（シンプルに画面サイズで作成）
     _camera_preview = lv_canvas_create(_camera_screen);
-    lv_obj_set_size(_camera_preview, CANVAS_WIDTH, CANVAS_HEIGHT);
+    lv_obj_set_size(_camera_preview, SCREEN_WIDTH, SCREEN_HEIGHT);
     lv_obj_align(_camera_preview, LV_ALIGN_CENTER, 0, 0);
 
     // HALがバッファを設定するので、ここでは初期化のみ
@@ -227,60 +465,386 @@ void AppDrawingCamera::canvasEventHandler(lv_event_t* e)
     lv_obj_t* canvas           = static_cast<lv_obj_t*>(lv_event_get_target(e));
     lv_event_code_t event_code = lv_event_get_code(e);
 
+    // タッチサンプルのキューが使える場合は onRunning() 側で描画する
+    if (app->_touch_sampling) return;
+
     lv_point_t point;
     lv_indev_get_point(lv_indev_get_act(), &point);
 
-    // キャンバス座標に変換
-    lv_coord_t canvas_x = point.x - lv_obj_get_x(canvas);
-    lv_coord_t canvas_y = point.y - lv_obj_get_y(canvas);
+    // キャンバスのオブジェクト上の座標（画面座標）から、表示倍率と位置を戻してキャンバス座標に変換
+    lv_coord_t screen_x = point.x - lv_obj_get_x(canvas);
+    lv_coord_t screen_y = point.y - lv_obj_get_y(canvas);
+    lv_coord_t canvas_x = 0;
+    lv_coord_t canvas_y = 0;
 
-    // UI要素の領域をチェック（描画を避ける）
-    bool is_ui_area = false;
+    // キャンバス範囲内かつUI領域外でのみ処理
+    if (app->isDrawableArea(screen_x, screen_y) && app->screenToCanvas(screen_x, screen_y, canvas_x, canvas_y)) {
+        // 読んだ時刻は分からないので、イベントの時刻から測る
+        const uint64_t now_us = GetHAL()->micros();
+        GetHAL()->latencyTrace.markSample(now_us, now_us);
+        if (event_code == LV_EVENT_PRESSED) {
+            app->beginStroke(0, canvas_x, canvas_y, lv_tick_get());
+        } else if (event_code == LV_EVENT_PRESSING) {
+            app->continueStroke(0, canvas_x, canvas_y, lv_tick_get());
+        }
+    }
+
+    if (event_code == LV_EVENT_RELEASED) {
+        app->endStroke(0, lv_tick_get());
+    }
+}
+
+bool AppDrawingCamera::isDrawableArea(lv_coord_t screen_x, lv_coord_t screen_y)
+{
+    if (screen_x < 0 || screen_x >= SCREEN_WIDTH || screen_y < 0 || screen_y >= SCREEN_HEIGHT) {
+        return false;
+    }
 
+    // UI要素の領域をチェック（描画を避ける）
     // 色選択ボタン領域（左上）
-    if (canvas_x >= 20 && canvas_x <= 100 && canvas_y >= 20 && canvas_y <= 100) {
-        is_ui_area = true;
+    if (screen_x >= 20 && screen_x <= 100 && screen_y >= 20 && screen_y <= 100) {
+        return false;
+    }
+
+    // ブラシサイズボタン領域（左上、色選択ボタンの右）
+    if (screen_x >= 120 && screen_x <= 200 && screen_y >= 20 && screen_y <= 100) {
+        return false;
     }
 
-    // クリアボタン領域（右上）
-    if (canvas_x >= CANVAS_WIDTH - 140 && canvas_x <= CANVAS_WIDTH - 20 && canvas_y >= 20 && canvas_y <= 100) {
-        is_ui_area = true;
+    // 塗りつぶし・消しゴム・対称描画・図形ボタン領域（左上、ブラシサイズボタンの右）
+    if (screen_x >= 220 && screen_x <= 760 && screen_y >= 20 && screen_y <= 100) {
+        return false;
+    }
+
+    // 取り消し・やり直し・クリアボタン領域（右上）
+    if (screen_x >= SCREEN_WIDTH - 420 && screen_x <= SCREEN_WIDTH - 20 && screen_y >= 20 && screen_y <= 100) {
+        return false;
+    }
+
+    // 表示倍率ボタン領域（左下）
+    if (screen_x >= 20 && screen_x <= 140 && screen_y >= SCREEN_HEIGHT - 100 && screen_y <= SCREEN_HEIGHT - 20) {
+        return false;
     }
 
     // カメラボタン領域（右下）
-    if (canvas_x >= CANVAS_WIDTH - 180 && canvas_x <= CANVAS_WIDTH - 20 && canvas_y >= CANVAS_HEIGHT - 100 &&
-        canvas_y <= CANVAS_HEIGHT - 20) {
-        is_ui_area = true;
+    if (screen_x >= SCREEN_WIDTH - 180 && screen_x <= SCREEN_WIDTH - 20 && screen_y >= SCREEN_HEIGHT - 100 &&
+        screen_y <= SCREEN_HEIGHT - 20) {
+        return false;
+    }
+
+    // ブラシサイズパネル領域（左上、展開時のみ）
+    if (_brush_panel_expanded && screen_y >= 120 && screen_y <= 240 && screen_x >= 20 &&
+        screen_x <= 20 + BRUSH_PANEL_WIDTH) {
+        return false;
     }
 
     // 横展開パレット領域（上部中央、展開時のみ）
-    if (app->_palette_expanded && canvas_y >= 120 && canvas_y <= 240 && canvas_x >= 200 && canvas_x <= 1080) {
-        is_ui_area = true;
+    if (_palette_expanded && screen_y >= 120 && screen_y <= 240 && screen_x >= 200 && screen_x <= 1080) {
+        return false;
     }
 
-    // キャンバス範囲内かつUI領域外でのみ処理
-    if (canvas_x >= 0 && canvas_x < CANVAS_WIDTH && canvas_y >= 0 && canvas_y < CANVAS_HEIGHT && !is_ui_area) {
-        if (event_code == LV_EVENT_PRESSED) {
-            // タッチ開始 - 最初の点を描画
-            app->_is_drawing  = true;
-            app->_last_draw_x = canvas_x;
-            app->_last_draw_y = canvas_y;
-            app->drawOnCanvas(canvas_x, canvas_y);
-        } else if (event_code == LV_EVENT_PRESSING) {
-            // タッチ中 - 前回の点から現在の点まで線を描画
-            if (app->_is_drawing && app->_last_draw_x >= 0 && app->_last_draw_y >= 0) {
-                app->drawLine(app->_last_draw_x, app->_last_draw_y, canvas_x, canvas_y);
+    return true;
+}
+
+bool AppDrawingCamera::screenToCanvas(lv_coord_t screen_x, lv_coord_t screen_y, lv_coord_t& canvas_x,
+                                      lv_coord_t& canvas_y)
+{
+    int32_t x, y;
+    bool inside = _viewport.toCanvas(screen_x, screen_y, x, y);
+    canvas_x    = x;
+    canvas_y    = y;
+    return inside;
+}
+
+void AppDrawingCamera::beginStroke(int finger, lv_coord_t x, lv_coord_t y, uint32_t timeMs)
+{
+    // 塗りつぶしツールはタッチした瞬間に一度だけ塗る
+    if (_current_tool == TOOL_FILL) {
+        const drawing::Rect area = fillArea();
+        _stroke_log.fill(timeMs, _current_color_index, x, y, area);
+        fillAt(x, y, area);
+        return;
+    }
+
+    // 図形ツールはドラッグ中はプレビューだけを表示し、離したときにインクへ描く（図形は 1 本の指だけ）
+    if (_current_tool == TOOL_SHAPE) {
+        if (_shape_active) return;
+        _shape_finger = finger;
+        beginShape(x, y);
+        return;
+    }
+
+    // タッチ開始 - 最初の点を描画（同時に描いているストロークをまとめて 1 回のアンドゥ単位とする）
+    Finger_t& f = _fingers[finger];
+    if (f.inStroke) return;
+    _stroke_log.beginStroke(timeMs,
+                            _current_tool == TOOL_ERASER ? drawing::StrokeEvent::TOOL_ERASER
+                                                         : drawing::StrokeEvent::TOOL_PEN,
+                            _current_color_index, _brush.size(), _symmetry.mode().encode(), _symmetry.centerX2(),
+                            _symmetry.centerY2(), x, y, finger);
+    if (_drawing_fingers == 0) {
+        _undo_history.beginStep();
+        _stroke_bounds = drawing::Rect();
+    }
+    _drawing_fingers++;
+    f.inStroke = true;
+    f.lastX    = x;
+    f.lastY    = y;
+    drawOnCanvas(finger, x, y);
+}
+
+void AppDrawingCamera::continueStroke(int finger, lv_coord_t x, lv_coord_t y, uint32_t timeMs)
+{
+    if (_shape_active) {
+        if (finger == _shape_finger) moveShape(x, y);
+        return;
+    }
+
+    // タッチ中 - 前回の点から現在の点まで滑らかな曲線で描画（平滑化前の入力点を記録する）
+    Finger_t& f = _fingers[finger];
+    if (f.inStroke && f.lastX >= 0 && f.lastY >= 0) {
+        _stroke_log.addPoint(timeMs, x, y, finger);
+        drawSmoothedTo(finger, x, y);
+    }
+    f.lastX = x;
+    f.lastY = y;
+}
+
+void AppDrawingCamera::endStroke(int finger, uint32_t timeMs)
+{
+    if (_shape_active && finger == _shape_finger) {
+        commitShape(timeMs);
+    }
+
+    // タッチ終了
+    Finger_t& f = _fingers[finger];
+    if (f.inStroke) {
+        // 未確定の最後の区間を描き切る
+        finishStroke(finger);
+        _stroke_log.endStroke(timeMs, finger);
+        f.stroke.end();
+        f.inStroke = false;
+        _drawing_fingers--;
+    }
+    f.lastX = -1;
+    f.lastY = -1;
+
+    // 同時に描いていた最後の指が離れたら 1 回の操作として閉じる
+    if (_drawing_fingers > 0 || !_undo_history.isStepOpen()) return;
+
+    const auto& stats = _dirty_region.getStats();
+    mclog::tagInfo(getAppInfo().name, "stroke dirty rects: submitted {}, flushed {} in {} refreshes",
+                   stats.submitted, stats.flushed, stats.flushes);
+    _dirty_region.resetStats();
+
+    const auto& log = _stroke_log.getStats();
+    mclog::tagInfo(getAppInfo().name, "stroke log: {} strokes, {} points, {} bytes ({:.2f} B/pt), dropped {}",
+                   log.strokes, log.points, log.bytes, log.bytesPerPoint(), log.dropped);
+
+    // 消しゴムでインクがなくなったタイルは解放する
+    if (_current_tool == TOOL_ERASER) {
+        _ink_layer.releaseEmptyTiles(_stroke_bounds);
+    }
+
+    _undo_history.endStep();
+    updateUndoButtons();
+    trimMemory();
+}
+
+void AppDrawingCamera::cancelStrokes(uint32_t timeMs)
+{
+    if (_shape_active) {
+        _shape_active = false;
+        markShapeDirty(_shape);
+    }
+    if (_drawing_fingers == 0) return;
+
+    // 描きかけの線は書き込む前のタイルに戻し、履歴にも残さない（ログには取り消したことを記録する）
+    for (auto& f : _fingers) {
+        f.stroke.end();
+        f.inStroke = false;
+    }
+    _drawing_fingers = 0;
+    _undo_history.cancelStep(_ink_layer, [this](const drawing::Rect& area) { markCanvasDirty(area); });
+    _stroke_log.cancelStrokes(timeMs);
+    GetHAL()->latencyTrace.cancel();
+    updateUndoButtons();
+    mclog::tagInfo(getAppInfo().name, "strokes cancelled for two-finger gesture");
+}
+
+bool AppDrawingCamera::isDrawing() const
+{
+    return _drawing_fingers > 0;
+}
+
+void AppDrawingCamera::processTouchSamples()
+{
+    auto& samples = GetHAL()->touchSamples;
+    if (samples.empty()) return;
+
+    // キャンバスは LVGL の描画と共有しているので、まとめて一度だけロックする
+    LvglLockGuard lock;
+    size_t num = samples.drain([this](const hal::HalBase::TouchSample_t& sample) { handleTouchSample(sample); },
+                               MAX_TOUCH_BATCH);
+
+    _touch_stats.batches++;
+    _touch_stats.samples += num;
+    _touch_stats.maxBatch = std::max<uint32_t>(_touch_stats.maxBatch, num);
+
+    // ピンチで変えた表示は最後に一度だけ描き直す
+    if (_view_pending) {
+        _view_pending = false;
+        renderView();
+    }
+}
+
+void AppDrawingCamera::logLatency()
+{
+    _latency_log_ms = GetHAL()->millis();
+
+    // 描いた入力がなかった間は何も出さない
+    LvglLockGuard lock;
+    auto& trace = GetHAL()->latencyTrace;
+    if (trace.count() == 0) return;
+
+    const auto stats = GetHAL()->getLatencyStats();
+    for (int i = 0; i < LatencyTrace::STAGE_NUM; i++) {
+        const auto& stage = stats.stages[i];
+        mclog::tagInfo(getAppInfo().name, "latency {}: {} frames, min {:.2f} p50 {:.2f} p99 {:.2f} max {:.2f} ms",
+                       LatencyTrace::stageName(i), stage.count, stage.minUs / 1000.0f, stage.p50Us / 1000.0f,
+                       stage.p99Us / 1000.0f, stage.maxUs / 1000.0f);
+    }
+    trace.reset();
+}
+
+void AppDrawingCamera::processViewGestures()
+{
+    auto& gestures = GetHAL()->viewGestures;
+    if (gestures.empty()) return;
+
+    // 溜まった操作をまとめて反映し、表示は最後に一度だけ描き直す
+    LvglLockGuard lock;
+    const float zoom = _viewport.zoom();
+    bool changed     = false;
+    gestures.drain(
+        [&](const hal::HalBase::ViewGesture_t& gesture) {
+            if (_current_state != STATE_DRAWING) return;
+            const float x = (float)(gesture.x - lv_obj_get_x(_canvas));
+            const float y = (float)(gesture.y - lv_obj_get_y(_canvas));
+            if (gesture.zoom != 1.0f) {
+                changed |= _viewport.zoomAt(gesture.zoom, x, y);
+            }
+            if (gesture.panX != 0.0f || gesture.panY != 0.0f) {
+                changed |= _viewport.panBy(gesture.panX, gesture.panY);
             }
-            app->_last_draw_x = canvas_x;
-            app->_last_draw_y = canvas_y;
+        },
+        MAX_VIEW_BATCH);
+    if (!changed) return;
+
+    renderView();
+    if (_viewport.zoom() != zoom) {
+        mclog::tagInfo(getAppInfo().name, "View zoom {:.0f}% (mip level {})", _viewport.zoom() * 100.0f,
+                       _viewport.level());
+    }
+}
+
+void AppDrawingCamera::handleTouchSample(const hal::HalBase::TouchSample_t& sample)
+{
+    if (sample.id >= MAX_FINGERS) return;
+    const int id           = sample.id;
+    Finger_t& finger       = _fingers[id];
+    const uint32_t time_ms = (uint32_t)(sample.timestampUs / 1000);
+
+    // 描画画面以外ではタッチ状態だけ追跡する
+    if (_current_state != STATE_DRAWING) {
+        endStroke(id, time_ms);
+        if (_pinch.involves(id)) _pinch.end();
+        finger.pressed = sample.pressed;
+        finger.inView  = false;
+        return;
+    }
+
+    lv_coord_t screen_x = sample.x - lv_obj_get_x(_canvas);
+    lv_coord_t screen_y = sample.y - lv_obj_get_y(_canvas);
+    lv_coord_t canvas_x = 0;
+    lv_coord_t canvas_y = 0;
+    bool in_view        = isDrawableArea(screen_x, screen_y);
+    bool drawable       = in_view && screenToCanvas(screen_x, screen_y, canvas_x, canvas_y);
+    finger.screenX      = screen_x;
+    finger.screenY      = screen_y;
+
+    // 描く点だけを遅延の計測に入れる（ピンチの指は描かない）
+    if (sample.pressed && drawable && !_pinch.isActive()) {
+        GetHAL()->latencyTrace.markSample(sample.timestampUs, GetHAL()->micros());
+    }
+
+    if (sample.pressed && !finger.pressed) {
+        // 押した位置がキャンバス上ならストローク開始（UI上なら離すまで描かない）
+        finger.pressed   = true;
+        finger.inView    = in_view;
+        finger.pressedMs = time_ms;
+        if (beginPinch(id)) return;
+        if (drawable && !_pinch.isActive()) {
+            beginStroke(id, canvas_x, canvas_y, time_ms);
+        }
+    } else if (sample.pressed) {
+        if (_pinch.involves(id)) {
+            movePinch(id);
+        } else if (drawable) {
+            continueStroke(id, canvas_x, canvas_y, time_ms);
         }
+    } else if (finger.pressed) {
+        finger.pressed = false;
+        if (_pinch.involves(id)) {
+            // 片方の指を離したら終わり（残った指は離すまで描かない）
+            _pinch.end();
+            mclog::tagInfo(getAppInfo().name, "Pinch end: zoom {:.0f}% (mip level {})", _viewport.zoom() * 100.0f,
+                           _viewport.level());
+            return;
+        }
+        if (finger.inStroke && _drawing_fingers == 1) {
+            mclog::tagInfo(getAppInfo().name, "touch samples: {} in {} batches (max {}), dropped {}",
+                           _touch_stats.samples, _touch_stats.batches, _touch_stats.maxBatch,
+                           GetHAL()->touchSamples.dropped());
+            _touch_stats = TouchStats_t();
+        }
+        endStroke(id, time_ms);
     }
+}
 
-    if (event_code == LV_EVENT_RELEASED) {
-        // タッチ終了
-        app->_is_drawing  = false;
-        app->_last_draw_x = -1;
-        app->_last_draw_y = -1;
+bool AppDrawingCamera::beginPinch(int finger)
+{
+    // もう 1 本だけが UI の外で触れていて、その指が触れてから PINCH_WINDOW 以内なら 2 本指の操作にする
+    const Finger_t& f = _fingers[finger];
+    if (_pinch.isActive() || !f.inView) return false;
+    int other = -1;
+    for (int i = 0; i < MAX_FINGERS; i++) {
+        if (i == finger || !_fingers[i].pressed) continue;
+        if (other >= 0) return false;
+        other = i;
+    }
+    if (other < 0) return false;
+    const Finger_t& o = _fingers[other];
+    if (!o.inView || f.pressedMs - o.pressedMs > PINCH_WINDOW) return false;
+
+    cancelStrokes(f.pressedMs);
+    _pinch.begin(other, o.screenX, o.screenY, finger, f.screenX, f.screenY, _viewport.zoom());
+    mclog::tagInfo(getAppInfo().name, "Pinch begin: fingers {} and {}", other, finger);
+    return true;
+}
+
+void AppDrawingCamera::movePinch(int finger)
+{
+    const Finger_t& f = _fingers[finger];
+    drawing::PinchGesture::Update_t update;
+    if (!_pinch.move(finger, f.screenX, f.screenY, update)) return;
+
+    // 中点の移動でずらしてから、移動後の中点を中心に倍率を合わせる
+    if (update.panX != 0.0f || update.panY != 0.0f) {
+        _view_pending |= _viewport.panBy(update.panX, update.panY);
+    }
+    if (update.zoom != _viewport.zoom()) {
+        _view_pending |= _viewport.zoomAt(update.zoom / _viewport.zoom(), update.focusX, update.focusY);
     }
 }
 
@@ -292,7 +856,8 @@ void AppDrawingCamera::colorPaletteEventHandler(lv_event_t* e)
     // 選択された色のインデックスを取得
     int color_index = (int)(intptr_t)lv_obj_get_user_data(btn);
     if (color_index >= 0 && color_index < 10) {
-        app->_current_color = app->_palette_colors[color_index];
+        app->_current_color       = app->_palette_colors[color_index];
+        app->_current_color_index = color_index;
         mclog::tagInfo("DrawingCamera", "Color changed to index %d", color_index);
 
         // 現在選択中の色ボタンの表示を更新
@@ -309,6 +874,66 @@ void AppDrawingCamera::currentColorBtnEventHandler(lv_event_t* e)
     app->togglePalette();
 }
 
+void AppDrawingCamera::brushSizeBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->toggleBrushPanel();
+}
+
+void AppDrawingCamera::brushSizePanelEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    lv_obj_t* btn         = static_cast<lv_obj_t*>(lv_event_get_target(e));
+
+    // 選択されたサイズのインデックスを取得
+    int size_index = (int)(intptr_t)lv_obj_get_user_data(btn);
+    if (size_index >= 0 && size_index < drawing::BRUSH_SIZE_NUM) {
+        app->setBrushSize(size_index);
+
+        // サイズを選択したらパネルを自動的に閉じる
+        app->toggleBrushPanel();
+    }
+}
+
+void AppDrawingCamera::toolBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    lv_obj_t* btn         = static_cast<lv_obj_t*>(lv_event_get_target(e));
+    lv_obj_t* other       = btn == app->_fill_btn ? app->_eraser_btn : app->_fill_btn;
+
+    // ツールボタンはどちらか一方だけ選択でき、選択を外すとペンに戻る（図形ツールも外す）
+    if (lv_obj_has_state(btn, LV_STATE_CHECKED)) {
+        app->setShapeTool(-1);
+        app->_current_tool = btn == app->_fill_btn ? TOOL_FILL : TOOL_ERASER;
+        lv_obj_remove_state(other, LV_STATE_CHECKED);
+    } else {
+        app->_current_tool = TOOL_PEN;
+    }
+
+    static const char* tool_names[] = {"pen", "fill", "eraser", "shape"};
+    mclog::tagInfo(app->getAppInfo().name, "Tool changed to {}", tool_names[app->_current_tool]);
+}
+
+void AppDrawingCamera::symmetryBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->setSymmetryMode((app->_symmetry_index + 1) % SYMMETRY_MODE_NUM);
+}
+
+void AppDrawingCamera::shapeBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->setShapeTool(app->_shape_index + 1 < SHAPE_TOOL_NUM ? app->_shape_index + 1 : -1);
+}
+
+void AppDrawingCamera::zoomBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->_viewport.reset();
+    app->renderView();
+    mclog::tagInfo(app->getAppInfo().name, "View reset to 100%");
+}
+
 void AppDrawingCamera::cameraBtnEventHandler(lv_event_t* e)
 {
     AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
@@ -345,219 +970,398 @@ void AppDrawingCamera::clearBtnEventHandler(lv_event_t* e)
     app->clearCanvas();
 }
 
-void AppDrawingCamera::drawOnCanvas(lv_coord_t x, lv_coord_t y)
+void AppDrawingCamera::undoBtnEventHandler(lv_event_t* e)
 {
-    // 究極高速化：事前計算 + DMA風メモリ操作
-    lv_draw_buf_t* buf = lv_canvas_get_draw_buf(_canvas);
-    if (!buf || !buf->data) return;
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->undoCanvas();
+}
 
-    // 高速定数
-    static const int radius   = BRUSH_SIZE / 2;
-    static const int diameter = BRUSH_SIZE;
+void AppDrawingCamera::redoBtnEventHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->redoCanvas();
+}
 
-    // 色をRGB565形式に変換
-    uint16_t color16 = lv_color_to_u16(_current_color);
+void AppDrawingCamera::displayRefrStartHandler(lv_event_t* e)
+{
+    AppDrawingCamera* app = static_cast<AppDrawingCamera*>(lv_event_get_user_data(e));
+    app->flushDirtyRegion();
+}
 
-    // 高速バッファアクセス
-    uint32_t buf_width   = buf->header.w;
-    uint16_t* pixel_data = (uint16_t*)buf->data;
+static drawing::PixelBuffer565 get_pixels(lv_draw_buf_t* buf)
+{
+    drawing::PixelBuffer565 pixels;
+    if (!buf || !buf->data) return pixels;
+
+    pixels.data   = (uint16_t*)buf->data;
+    pixels.width  = buf->header.w;
+    pixels.height = buf->header.h;
+    pixels.stride = buf->header.stride / sizeof(uint16_t);
+    return pixels;
+}
 
-    // 超高速範囲チェック（分岐予測最適化）
-    if (__builtin_expect(
-            x < radius || y < radius || x >= (int)(buf_width - radius) || y >= (int)(buf->header.h - radius), 0)) {
-        return;
+drawing::InkPen AppDrawingCamera::currentPen()
+{
+    // 消しゴムはインクを消すだけなので、写真があればその画素がそのまま見える
+    if (_current_tool == TOOL_ERASER) {
+        return drawing::InkPen::eraser();
     }
+    return drawing::InkPen::draw(_current_color_index);
+}
 
-    // 究極最適化：正方形ブラシ（円計算を省略）
-    int start_y = y - radius;
-    int end_y   = y + radius;
-    int start_x = x - radius;
-
-    // 行ごとに超高速メモリ書き込み
-    for (int py = start_y; py <= end_y; py++) {
-        uint16_t* row_start = pixel_data + py * buf_width + start_x;
-
-        // memset風の超高速一括書き込み（アンロールループ）
-        uint16_t* ptr = row_start;
-        int remaining = diameter;
-
-        // 8ピクセルずつ展開（CPU パイプライン最適化）
-        while (remaining >= 8) {
-            ptr[0] = color16;
-            ptr[1] = color16;
-            ptr[2] = color16;
-            ptr[3] = color16;
-            ptr[4] = color16;
-            ptr[5] = color16;
-            ptr[6] = color16;
-            ptr[7] = color16;
-            ptr += 8;
-            remaining -= 8;
-        }
+void AppDrawingCamera::drawOnCanvas(int finger, lv_coord_t x, lv_coord_t y)
+{
+    // アンチエイリアス付きの円形ブラシ（対称描画では全コピーに押す。端はキャンバス範囲でクリップ）
+    Finger_t& f = _fingers[finger];
+    f.stroke.begin(_ink_layer, _brush, currentPen(), _symmetry, x, y,
+                   [this](const drawing::Rect& area) { prepareCanvasWrite(area); },
+                   [this](const drawing::Rect& area) { markCanvasDirty(area); });
+
+    f.smoother.begin(x, y, _brush.size() * 0.5f * STROKE_SPACING);
+    GetHAL()->latencyTrace.markRaster(GetHAL()->micros());
+}
 
-        // 残りのピクセル
-        while (remaining > 0) {
-            *ptr++ = color16;
-            remaining--;
-        }
-    }
+void AppDrawingCamera::drawLineTo(int finger, lv_coord_t x, lv_coord_t y)
+{
+    drawing::SymmetryStroke& stroke = _fingers[finger].stroke;
+    if (!stroke.isActive()) return;
+
+    // 前回の点からの線分をスキャンライン単位で一度だけ塗り、縁だけを合成する
+    // （各コピーの更新矩形は同じ更新領域にまとめ、次のリフレッシュで一度に無効化する）
+    stroke.lineTo(_ink_layer, x, y, [this](const drawing::Rect& area) { prepareCanvasWrite(area); },
+                  [this](const drawing::Rect& area) { markCanvasDirty(area); });
+    GetHAL()->latencyTrace.markRaster(GetHAL()->micros());
+}
 
-    // 画面更新最適化（部分更新のみ）
-    lv_area_t update_area;
-    update_area.x1 = x - radius;
-    update_area.y1 = y - radius;
-    update_area.x2 = x + radius;
-    update_area.y2 = y + radius;
-    lv_obj_invalidate_area(_canvas, &update_area);
+drawing::Rect AppDrawingCamera::fillArea() const
+{
+    // 見えている範囲と写真の範囲（キャンバスは画面よりずっと広いので、白紙の塗りつぶしが全体に広がらないようにする）
+    drawing::Rect area = _viewport.visibleRect();
+    if (_has_background_image) area.join(drawing::Rect{0, 0, _photo.width - 1, _photo.height - 1});
+    return area;
 }
 
-void AppDrawingCamera::drawLine(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2)
+void AppDrawingCamera::fillAt(lv_coord_t x, lv_coord_t y, const drawing::Rect& area)
 {
-    // 点の間隔を計算
-    int distance = abs(x2 - x1) + abs(y2 - y1);
+    // 境界の判定は写真とインクを合成した色で行う（画素はその場で合成するので、キャンバス全体の合成結果は要らない）
+    drawing::InkCompositePixels pixels(_ink_layer, _photo, lv_color_to_u16(lv_color_white()));
+
+    // 写真の上では同じ色の領域でも画素値が揺らぐので、許容差ありで塗る
+    int tolerance = _has_background_image ? FILL_TOLERANCE : 0;
+
+    // 合成結果で領域を求めてから、タイルごとにインクのレイヤーへ塗る（塗る直前にそのタイルをアンドゥ用に保存する）。
+    // 全体を塗るタイルは単色タイルにするので、広い領域でもタイルのメモリは縁の分しか増えない
+    auto result = _flood_fill.fillSpans(pixels, x, y, tolerance, area, [](const drawing::Rect&) {});
+    _undo_history.beginStep();
+    _flood_fill.forEachFilledTile(
+        result.bounds, _ink_layer.grid(),
+        [&](int index) {
+            _undo_history.captureTile(_ink_layer, index);
+            _ink_layer.fillTile(index, _current_color_index);
+        },
+        [&](int index, const drawing::Rect& span) {
+            _undo_history.captureTile(_ink_layer, index);
+            _ink_layer.fillSpan(span.y1, span.x1, span.x2, _current_color_index);
+        });
+    _undo_history.endStep();
+    GetHAL()->latencyTrace.markRaster(GetHAL()->micros());
+
+    // 塗った範囲だけを合成し直す
+    markCanvasDirty(result.bounds);
+    updateUndoButtons();
+    trimMemory();
+    mclog::tagInfo(getAppInfo().name, "fill: {} px in ({}, {})-({}, {}), overflows {}, solid tiles {}", result.pixels,
+                   result.bounds.x1, result.bounds.y1, result.bounds.x2, result.bounds.y2, result.overflows,
+                   _ink_layer.solidCount());
+}
 
-    // 距離が短い場合は直接円を描画
-    if (distance <= BRUSH_SIZE / 2) {
-        drawOnCanvas(x2, y2);
-        return;
+void AppDrawingCamera::drawSmoothedTo(int finger, lv_coord_t x, lv_coord_t y)
+{
+    // 形が確定した区間だけが等間隔の点として出てくるので、点どうしを線分でつなぐ
+    _fingers[finger].smoother.addPoint(x, y, [this, finger](const drawing::StrokePoint& p) {
+        drawLineTo(finger, (lv_coord_t)std::lround(p.x), (lv_coord_t)std::lround(p.y));
+    });
+}
+
+void AppDrawingCamera::finishStroke(int finger)
+{
+    _fingers[finger].smoother.finish([this, finger](const drawing::StrokePoint& p) {
+        drawLineTo(finger, (lv_coord_t)std::lround(p.x), (lv_coord_t)std::lround(p.y));
+    });
+}
+
+void AppDrawingCamera::beginShape(lv_coord_t x, lv_coord_t y)
+{
+    // 対称描画は図形には適用しない
+    _shape.type            = SHAPE_TOOLS[_shape_index].type;
+    _shape.x0              = x;
+    _shape.y0              = y;
+    _shape.x1              = x;
+    _shape.y1              = y;
+    _shape.thickness       = _brush.size();
+    _shape_active          = true;
+    _shape_preview_pending = true;
+}
+
+void AppDrawingCamera::moveShape(lv_coord_t x, lv_coord_t y)
+{
+    if (x == _shape.x1 && y == _shape.y1) return;
+
+    // 前のプレビューは画素を退避せず、線が通った範囲だけを次のリフレッシュで写真とインクから合成し直す
+    markShapeDirty(_shape);
+    _shape.x1              = x;
+    _shape.y1              = y;
+    _shape_preview_pending = true;
+}
+
+void AppDrawingCamera::commitShape(uint32_t timeMs)
+{
+    _shape_active = false;
+    markShapeDirty(_shape);
+    if (_shape.x0 == _shape.x1 && _shape.y0 == _shape.y1) return;
+
+    // 線が通る範囲のタイルだけをアンドゥ用に保存してからインクへ描く
+    const drawing::ShapeCover cover = drawing::ShapeCover::of(_shape);
+    _undo_history.beginStep();
+    for (int i = 0; i < cover.count; i++) {
+        _undo_history.capture(_ink_layer, cover.rects[i]);
     }
+    drawing::draw_shape(_ink_layer, _shape, currentPen());
+    _undo_history.endStep();
 
-    // ブレゼンハムアルゴリズムで等間隔に円を描画
-    int dx  = abs(x2 - x1);
-    int dy  = abs(y2 - y1);
-    int sx  = x1 < x2 ? 1 : -1;
-    int sy  = y1 < y2 ? 1 : -1;
-    int err = dx - dy;
+    _stroke_log.shape(timeMs, _shape.type, _current_color_index, _shape.thickness, _shape.x0, _shape.y0, _shape.x1,
+                      _shape.y1);
+    updateUndoButtons();
+}
 
-    int x          = x1;
-    int y          = y1;
-    int step_count = 0;
+void AppDrawingCamera::markShapeDirty(const drawing::Shape& shape)
+{
+    const drawing::ShapeCover cover = drawing::ShapeCover::of(shape);
+    for (int i = 0; i < cover.count; i++) {
+        markCanvasDirty(cover.rects[i].intersect(_ink_layer.bounds()));
+    }
+}
 
-    while (true) {
-        // 一定間隔で円を描画（重複を防ぐ）
-        if (step_count % (BRUSH_SIZE / 4) == 0) {
-            drawOnCanvas(x, y);
-        }
+void AppDrawingCamera::prepareCanvasWrite(const drawing::Rect& area)
+{
+    // 書き込み前のタイルをアンドゥ用に保存（ストローク中に初めて触れるタイルだけ）
+    _undo_history.capture(_ink_layer, area);
+    _stroke_bounds.join(area);
+}
 
-        if (x == x2 && y == y2) break;
+void AppDrawingCamera::markCanvasDirty(const drawing::Rect& area)
+{
+    // 合成と画面更新は次のリフレッシュまでためておく
+    _dirty_region.add(area);
+}
 
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            x += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            y += sy;
+void AppDrawingCamera::flushDirtyRegion()
+{
+    if (!_canvas) return;
+
+    // 更新領域が写る画面の範囲だけを、作り直したタイルから描き直して無効化する
+    _dirty_region.flush([&](const drawing::Rect& rect) { presentCanvas(rect); });
+
+    // 図形のプレビューは表示用のバッファに画面座標で直接描き、線が通る範囲だけを無効化する（インクには書かない）
+    if (_shape_active && _shape_preview_pending) {
+        _shape_preview_pending = false;
+        drawing::PixelBuffer565 view = get_pixels(_canvas_buffer);
+        drawing::Shape preview       = _shape;
+        preview.x0                   = (int32_t)std::lround(_viewport.toScreenX((float)_shape.x0));
+        preview.y0                   = (int32_t)std::lround(_viewport.toScreenY((float)_shape.y0));
+        preview.x1                   = (int32_t)std::lround(_viewport.toScreenX((float)_shape.x1));
+        preview.y1                   = (int32_t)std::lround(_viewport.toScreenY((float)_shape.y1));
+        preview.thickness            = std::max(1, (int)std::lround(_shape.thickness * _viewport.zoom()));
+        drawing::draw_shape(view, preview, lv_color_to_u16(_current_color));
+        GetHAL()->latencyTrace.markRaster(GetHAL()->micros());
+
+        const drawing::ShapeCover cover = drawing::ShapeCover::of(preview);
+        for (int i = 0; i < cover.count; i++) {
+            presentScreen(cover.rects[i].intersect(view.bounds()));
         }
-        step_count++;
     }
+}
+
+void AppDrawingCamera::presentCanvas(const drawing::Rect& area)
+{
+    if (area.isEmpty()) return;
+
+    // 変わったタイルは次に読むときに作り直す（表示範囲の外のタイルは読まれるまで作らない）
+    _mip_pyramid.invalidate(area);
+
+    drawing::Rect screen = _viewport.toScreen(area);
+    _viewport.render(get_pixels(_canvas_buffer), screen, lv_color_to_u16(lv_color_hex(VIEW_BACKDROP)),
+                     [this](int index) { return _mip_pyramid.tile(index); });
+    presentScreen(screen);
+}
+
+void AppDrawingCamera::presentScreen(const drawing::Rect& screen)
+{
+    if (screen.isEmpty()) return;
+
+    lv_area_t update_area;
+    update_area.x1 = screen.x1;
+    update_area.y1 = screen.y1;
+    update_area.x2 = screen.x2;
+    update_area.y2 = screen.y2;
+    lv_obj_invalidate_area(_canvas, &update_area);
+    GetHAL()->latencyTrace.markInvalidate(GetHAL()->micros());
+}
+
+void AppDrawingCamera::renderView()
+{
+    // 段が変われば保持しているタイルは捨てて、表示範囲のタイルだけを作り直す
+    _mip_pyramid.setLevel(_viewport.level());
+    drawing::PixelBuffer565 view = get_pixels(_canvas_buffer);
+    _viewport.render(view, view.bounds(), lv_color_to_u16(lv_color_hex(VIEW_BACKDROP)),
+                     [this](int index) { return _mip_pyramid.tile(index); });
+    lv_obj_invalidate(_canvas);
+    trimMemory();
+    updateZoomButton();
+}
 
-    // 最終点も描画
-    drawOnCanvas(x2, y2);
+bool AppDrawingCamera::composeTile(int index, const drawing::PixelBuffer565& out)
+{
+    return _ink_layer.compositeTile(index, _photo, lv_color_to_u16(lv_color_white()), out);
+}
+
+void AppDrawingCamera::trimMemory()
+{
+    // 表示範囲のタイルは残し、上限を超えた分を遠いタイルから追い出す（タイルの画素を参照していない時点で呼ぶ）
+    const drawing::Rect visible = _viewport.visibleRect();
+    _ink_layer.setPinnedArea(visible);
+    int paged = _ink_layer.trim();
+    _mip_pyramid.trim(visible);
+    if (paged > 0) {
+        mclog::tagInfo(getAppInfo().name, "Ink tiles paged out: {} (resident {}, paged {}, file {} KB, {} bytes)",
+                       paged, _ink_layer.residentCount(), _ink_layer.pagedCount(), _page_file.fileBytes() / 1024,
+                       _ink_layer.allocatedBytes());
+    }
 }
 
 void AppDrawingCamera::clearCanvas()
 {
     LvglLockGuard lock;
 
-    if (_has_background_image && _background_buffer) {
-        // 保存された背景画像を復元
-        lv_draw_buf_t* canvas_buf = lv_canvas_get_draw_buf(_canvas);
-        if (canvas_buf && canvas_buf->data && _background_buffer->data) {
-            uint32_t buffer_size = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
-            memcpy(canvas_buf->data, _background_buffer->data, buffer_size);
-            lv_obj_invalidate(_canvas);
-            mclog::tagInfo(getAppInfo().name, "Background image restored from saved buffer");
-        }
-    } else {
-        // 白で塗りつぶし
-        lv_canvas_fill_bg(_canvas, lv_color_white(), LV_OPA_COVER);
-        mclog::tagInfo(getAppInfo().name, "Canvas cleared to white");
+    // インクのあるタイルだけを解放する（写真はそのまま残る）
+    int tile_num = _ink_layer.tileCount();
+    size_t bytes = _ink_layer.bytes();
+
+    // クリアも取り消せるように、解放するタイルを保存しておく
+    _undo_history.beginStep();
+    // （追い出したタイルも読み戻すので、保存したタイルから解放してメモリを増やさない）
+    _ink_layer.forEachTile([&](int index, const drawing::Rect& rect) {
+        _undo_history.captureTile(_ink_layer, index);
+        _ink_layer.releaseTile(index);
+        markCanvasDirty(rect);
+    });
+    _undo_history.endStep();
+    updateUndoButtons();
+
+    _ink_layer.clear();
+
+    // 何も消さなかった場合はアンドゥのステップもできないので記録しない（再生時の取り消しがずれる）
+    if (tile_num > 0) {
+        _stroke_log.event(drawing::StrokeEvent::CLEAR, lv_tick_get());
     }
+    mclog::tagInfo(getAppInfo().name, "Ink cleared ({} tiles, {} bytes), photo {}", tile_num, bytes,
+                   _has_background_image ? "kept" : "none");
 }
 
-void AppDrawingCamera::setBackgroundImage()
+void AppDrawingCamera::undoCanvas()
 {
     LvglLockGuard lock;
 
-    if (_camera_preview && _canvas) {
-        mclog::tagInfo(getAppInfo().name, "Copying camera image to canvas background");
-
-        // カメラプレビューとキャンバスのドローバッファを取得
-        lv_draw_buf_t* camera_buf = lv_canvas_get_draw_buf(_camera_preview);
-        lv_draw_buf_t* canvas_buf = lv_canvas_get_draw_buf(_canvas);
-
-        if (camera_buf && canvas_buf) {
-            // バッファサイズを確認
-            uint32_t camera_width  = camera_buf->header.w;
-            uint32_t camera_height = camera_buf->header.h;
-            uint32_t canvas_width  = canvas_buf->header.w;
-            uint32_t canvas_height = canvas_buf->header.h;
-
-            mclog::tagInfo(getAppInfo().name, "Camera buffer: %dx%d, Canvas buffer: %dx%d", camera_width, camera_height,
-                           canvas_width, canvas_height);
-
-            // 両方のバッファが同じサイズの場合は直接コピー
-            if (camera_width == canvas_width && camera_height == canvas_height) {
-                uint8_t* camera_data = camera_buf->data;
-                uint8_t* canvas_data = canvas_buf->data;
-
-                if (camera_data && canvas_data) {
-                    // RGB565フォーマットを前提として、1ピクセル = 2バイト
-                    uint32_t buffer_size = camera_width * camera_height * 2;
-                    memcpy(canvas_data, camera_data, buffer_size);
-                    mclog::tagInfo(getAppInfo().name, "Camera image copied directly (%d bytes)", buffer_size);
-                } else {
-                    mclog::tagError(getAppInfo().name, "Failed to get buffer data pointers");
-                    return;
-                }
-            } else {
-                // サイズが異なる場合はピクセル単位でコピー（1:1スケール）
-                uint32_t copy_width  = (camera_width < canvas_width) ? camera_width : canvas_width;
-                uint32_t copy_height = (camera_height < canvas_height) ? camera_height : canvas_height;
-
-                mclog::tagInfo(getAppInfo().name, "Copying %dx%d pixels", copy_width, copy_height);
-
-                for (uint32_t y = 0; y < copy_height; y++) {
-                    for (uint32_t x = 0; x < copy_width; x++) {
-                        lv_color32_t pixel_color32 = lv_canvas_get_px(_camera_preview, x, y);
-                        lv_color_t pixel_color =
-                            lv_color_make(pixel_color32.red, pixel_color32.green, pixel_color32.blue);
-                        lv_canvas_set_px(_canvas, x, y, pixel_color, LV_OPA_COVER);
-                    }
-
-                    // 進行状況（100行毎）
-                    if (y % 100 == 0) {
-                        mclog::tagInfo(getAppInfo().name, "Copying line %d/%d", y, copy_height);
-                    }
-                }
-                mclog::tagInfo(getAppInfo().name, "Camera image copied pixel by pixel");
-            }
+    if (_undo_history.undo(_ink_layer, [&](const drawing::Rect& rect) { markCanvasDirty(rect); })) {
+        _stroke_log.event(drawing::StrokeEvent::UNDO, lv_tick_get());
+        const auto stats = _undo_history.getStats();
+        mclog::tagInfo(getAppInfo().name, "Undo (undo {}, redo {}, {} / {} bytes)", stats.undoLevels,
+                       stats.redoLevels, stats.bytes, stats.rawBytes);
+    }
+    updateUndoButtons();
+    trimMemory();
+}
 
-            // キャンバスを無効化して再描画を促す
-            lv_obj_invalidate(_canvas);
-
-            // 背景画像を保存用バッファにコピー
-            if (_background_buffer && _background_buffer->data) {
-                lv_draw_buf_t* canvas_buf = lv_canvas_get_draw_buf(_canvas);
-                if (canvas_buf && canvas_buf->data) {
-                    uint32_t buffer_size = CANVAS_WIDTH * CANVAS_HEIGHT * 2;
-                    memcpy(_background_buffer->data, canvas_buf->data, buffer_size);
-                    mclog::tagInfo(getAppInfo().name, "Background image saved to buffer");
-                }
-            }
+void AppDrawingCamera::redoCanvas()
+{
+    LvglLockGuard lock;
 
-        } else {
-            mclog::tagError(getAppInfo().name, "Failed to get draw buffers");
-            return;
-        }
+    if (_undo_history.redo(_ink_layer, [&](const drawing::Rect& rect) { markCanvasDirty(rect); })) {
+        _stroke_log.event(drawing::StrokeEvent::REDO, lv_tick_get());
+        const auto stats = _undo_history.getStats();
+        mclog::tagInfo(getAppInfo().name, "Redo (undo {}, redo {}, {} / {} bytes)", stats.undoLevels,
+                       stats.redoLevels, stats.bytes, stats.rawBytes);
+    }
+    updateUndoButtons();
+    trimMemory();
+}
+
+void AppDrawingCamera::setBackgroundImage()
+{
+    // capturePhoto() が置いていったフレームを受け取る
+    hal::HalBase::CameraFrame_t frame;
+    {
+        LvglLockGuard lock;
+        frame          = _pending_photo;
+        _pending_photo = {};
+        _photo_pending = false;
+    }
+    if (!frame.data) return;
+
+    drawing::PixelBuffer565 camera;
+    camera.data   = frame.data;
+    camera.width  = frame.width;
+    camera.height = frame.height;
+    camera.stride = frame.stride;
+    mclog::tagInfo(getAppInfo().name, "Camera frame: {}x{}, photo: {}x{}", camera.width, camera.height, SCREEN_WIDTH,
+                   SCREEN_HEIGHT);
+
+    // 画面と同じ大きさならフレームをそのまま写真にする（コピーしない）。
+    // 大きさが違う場合だけロックの外で 1 回変換し、フレームはすぐ HAL に返す
+    drawing::PixelBuffer565 photo = camera;
+    std::vector<uint16_t> pixels;
+    if (camera.width != SCREEN_WIDTH || camera.height != SCREEN_HEIGHT) {
+        pixels.resize((size_t)SCREEN_WIDTH * SCREEN_HEIGHT);
+        photo.data   = pixels.data();
+        photo.width  = SCREEN_WIDTH;
+        photo.height = SCREEN_HEIGHT;
+        photo.stride = SCREEN_WIDTH;
+
+        // 画面に合わせて拡大縮小する（Tab5 では PPA、倍率が合わなければソフトウェア）。余白は白にする
+        const uint32_t start = GetHAL()->millis();
+        GetHAL()->scaleImage({camera.data, camera.width, camera.height, camera.stride},
+                             {photo.data, photo.width, photo.height, photo.stride}, PHOTO_POLICY, PHOTO_FILTER,
+                             lv_color_to_u16(lv_color_white()));
+        GetHAL()->releaseCameraFrame(frame);
+        frame = {};
+        mclog::tagInfo(getAppInfo().name, "Camera image scaled {}x{} -> {}x{} in {} ms", camera.width, camera.height,
+                       photo.width, photo.height, GetHAL()->millis() - start);
+    }
 
+    hal::HalBase::CameraFrame_t previous;
+    {
+        LvglLockGuard lock;
+
+        // 写真を差し替え、前の写真のフレームと画素はロックを抜けてから HAL に返す・解放する
+        previous     = _photo_frame;
+        _photo_frame = frame;
+        _photo_pixels.swap(pixels);
+        _photo = photo;
+
+        // 以前の描画は写真ごと置き換わるので、インクと履歴も破棄して全体を合成し直す
+        // （写真の外に描いたインクもあるので、解放するタイルは clearCanvas() と同じくすべて無効化する）
+        _ink_layer.forEachTile([&](int, const drawing::Rect& rect) { markCanvasDirty(rect); });
+        _ink_layer.clear();
+        _undo_history.clear();
+        updateUndoButtons();
+        _stroke_log.event(drawing::StrokeEvent::PHOTO, lv_tick_get());
         _has_background_image = true;
-        mclog::tagInfo(getAppInfo().name, "Camera image set as background successfully");
-    } else {
-        mclog::tagError(getAppInfo().name, "Camera preview or canvas is null");
+        markCanvasDirty(drawing::Rect{0, 0, SCREEN_WIDTH - 1, SCREEN_HEIGHT - 1});
+        trimMemory();
     }
+    GetHAL()->releaseCameraFrame(previous);
+
+    mclog::tagInfo(getAppInfo().name, "Camera image set as background ({})", frame.data ? "zero copy" : "converted");
 }
 
 void AppDrawingCamera::switchToDrawingMode()
@@ -595,29 +1399,55 @@ void AppDrawingCamera::switchToCameraMode()
 
 void AppDrawingCamera::capturePhoto()
 {
-    LvglLockGuard lock;
+    // 前に置いていったフレーム（onRunning() がまだ受け取っていなければ）はロックを抜けてから返す
+    hal::HalBase::CameraFrame_t replaced;
+    {
+        LvglLockGuard lock;
 
-    _current_state = STATE_CAMERA_CAPTURE;
+        _current_state = STATE_CAMERA_CAPTURE;
 
-    mclog::tagInfo(getAppInfo().name, "Capturing photo...");
+        mclog::tagInfo(getAppInfo().name, "Capturing photo...");
 
-    // カメラが実際にキャプチャしているかチェック
-    if (!GetHAL()->isCameraCapturing()) {
-        mclog::tagWarn(getAppInfo().name, "Camera is not capturing, cannot take photo");
-        switchToDrawingMode();
-        return;
-    }
+        // カメラが実際にキャプチャしているかチェック
+        if (!GetHAL()->isCameraCapturing()) {
+            mclog::tagWarn(getAppInfo().name, "Camera is not capturing, cannot take photo (resume failures {})",
+                           GetHAL()->getCameraStartStats().resumeFailures);
+            switchToDrawingMode();
+            return;
+        }
 
-    // 撮影した画像を背景として設定
-    setBackgroundImage();
+        // プレビューのコマ落ちと同じコマの繰り返しを確認する
+        const auto frames = GetHAL()->getCameraFrameStats();
+        mclog::tagInfo(getAppInfo().name, "Preview frames: displayed {}, dropped {}, duplicated {}", frames.displayed,
+                       frames.dropped, frames.duplicated);
+
+        // 開始から最初のコマまでの時間（電源オフから開いた場合と、一時停止から再開した場合）と再開の失敗回数
+        const auto starts = GetHAL()->getCameraStartStats();
+        mclog::tagInfo(
+            getAppInfo().name,
+            "Camera start to first frame: cold {} (p50 {:.1f} ms), warm {} (p50 {:.1f} ms), resume failures {}",
+            starts.cold.count, starts.cold.p50Us / 1000.0f, starts.warm.count, starts.warm.p50Us / 1000.0f,
+            starts.resumeFailures);
+
+        // 表示中のフレームをコピーせずに受け取り、写真にするのは onRunning() に任せる（ここは LVGL のロックの中）
+        hal::HalBase::CameraFrame_t frame;
+        if (GetHAL()->takeCameraFrame(frame)) {
+            replaced       = _pending_photo;
+            _pending_photo = frame;
+            _photo_pending = true;
+        } else {
+            mclog::tagWarn(getAppInfo().name, "No camera frame to take");
+        }
 
-    // カメラキャプチャを停止
-    GetHAL()->stopCameraCapture();
+        // カメラキャプチャを停止
+        GetHAL()->stopCameraCapture();
 
-    // 描画モードに戻る
-    switchToDrawingMode();
+        // 描画モードに戻る
+        switchToDrawingMode();
 
-    mclog::tagInfo(getAppInfo().name, "Photo captured and set as background");
+        mclog::tagInfo(getAppInfo().name, "Photo captured");
+    }
+    GetHAL()->releaseCameraFrame(replaced);
 }
 
 void AppDrawingCamera::togglePalette()
@@ -627,6 +1457,12 @@ void AppDrawingCamera::togglePalette()
     _palette_expanded = !_palette_expanded;
 
     if (_palette_expanded) {
+        // ブラシサイズパネルと重ならないように閉じる
+        if (_brush_panel_expanded) {
+            _brush_panel_expanded = false;
+            lv_obj_add_flag(_brush_size_panel, LV_OBJ_FLAG_HIDDEN);
+        }
+
         // パレットを表示
         lv_obj_clear_flag(_color_palette, LV_OBJ_FLAG_HIDDEN);
         mclog::tagInfo(getAppInfo().name, "Palette expanded");
@@ -637,6 +1473,79 @@ void AppDrawingCamera::togglePalette()
     }
 }
 
+void AppDrawingCamera::toggleBrushPanel()
+{
+    LvglLockGuard lock;
+
+    _brush_panel_expanded = !_brush_panel_expanded;
+
+    if (_brush_panel_expanded) {
+        // カラーパレットと重ならないように閉じる
+        if (_palette_expanded) {
+            _palette_expanded = false;
+            lv_obj_add_flag(_color_palette, LV_OBJ_FLAG_HIDDEN);
+        }
+
+        // パネルを表示
+        lv_obj_clear_flag(_brush_size_panel, LV_OBJ_FLAG_HIDDEN);
+        mclog::tagInfo(getAppInfo().name, "Brush panel expanded");
+    } else {
+        // パネルを非表示
+        lv_obj_add_flag(_brush_size_panel, LV_OBJ_FLAG_HIDDEN);
+        mclog::tagInfo(getAppInfo().name, "Brush panel collapsed");
+    }
+}
+
+void AppDrawingCamera::setBrushSize(int index)
+{
+    // ストローク途中では変更しない（BrushStroke がマスクを参照している）
+    if (isDrawing()) return;
+    if (!_brush.setSize(drawing::BRUSH_SIZES[index])) return;
+
+    _brush_size_index = index;
+    mclog::tagInfo(getAppInfo().name, "Brush size changed to {}px (specialized kernel: {})", _brush.size(),
+                   _brush.isSpecialized());
+    updateBrushSizeButton();
+}
+
+void AppDrawingCamera::setSymmetryMode(int index)
+{
+    // ストローク途中では変更しない（SymmetryStroke が変換を参照している）
+    if (isDrawing()) return;
+
+    _symmetry_index = index;
+    // 対称の中心は選んだときに見えている範囲の中心（キャンバスの中心だとコピーが画面の外に出る）。
+    // 中心はストロークごとに操作ログへ記録するので、後でスクロールしても書き出しと再生は一致する
+    _symmetry.setMode(SYMMETRY_MODES[index].mode, _viewport.visibleRect());
+    lv_label_set_text(_symmetry_label, SYMMETRY_MODES[index].label);
+    mclog::tagInfo(getAppInfo().name, "Symmetry changed to {} ({} copies, center ({:.1f}, {:.1f}))",
+                   SYMMETRY_MODES[index].label, _symmetry.copies(), _symmetry.centerX2() * 0.5f,
+                   _symmetry.centerY2() * 0.5f);
+}
+
+void AppDrawingCamera::setShapeTool(int index)
+{
+    // ドラッグ途中では変更しない
+    if (_shape_active || index == _shape_index) return;
+
+    _shape_index = index;
+    if (index < 0) {
+        lv_label_set_text(_shape_label, "Shape");
+        if (_current_tool == TOOL_SHAPE) {
+            _current_tool = TOOL_PEN;
+        }
+        mclog::tagInfo(getAppInfo().name, "Shape tool off");
+        return;
+    }
+
+    // 図形ツールは塗りつぶし・消しゴムと同時には使わない
+    lv_obj_remove_state(_fill_btn, LV_STATE_CHECKED);
+    lv_obj_remove_state(_eraser_btn, LV_STATE_CHECKED);
+    _current_tool = TOOL_SHAPE;
+    lv_label_set_text(_shape_label, SHAPE_TOOLS[index].label);
+    mclog::tagInfo(getAppInfo().name, "Shape tool changed to {}", SHAPE_TOOLS[index].label);
+}
+
 void AppDrawingCamera::updateCurrentColorButton()
 {
     LvglLockGuard lock;
@@ -644,4 +1553,40 @@ void AppDrawingCamera::updateCurrentColorButton()
     if (_current_color_btn) {
         lv_obj_set_style_bg_color(_current_color_btn, _current_color, 0);
     }
+    updateBrushSizeButton();
+}
+
+void AppDrawingCamera::updateBrushSizeButton()
+{
+    LvglLockGuard lock;
+
+    if (_brush_size_dot) {
+        // ボタンに収まる範囲で実際の直径を表示（白は見えないので枠の色で表示）
+        int dot_size    = std::min(_brush.size(), 60);
+        lv_color_t fill = lv_color_eq(_current_color, lv_color_white()) ? lv_color_hex(0x666666) : _current_color;
+        lv_obj_set_size(_brush_size_dot, dot_size, dot_size);
+        lv_obj_set_style_bg_color(_brush_size_dot, fill, 0);
+        lv_obj_center(_brush_size_dot);
+    }
+}
+
+void AppDrawingCamera::updateUndoButtons()
+{
+    LvglLockGuard lock;
+
+    if (_undo_btn) {
+        lv_obj_set_state(_undo_btn, LV_STATE_DISABLED, !_undo_history.canUndo());
+    }
+    if (_redo_btn) {
+        lv_obj_set_state(_redo_btn, LV_STATE_DISABLED, !_undo_history.canRedo());
+    }
+}
+
+void AppDrawingCamera::updateZoomButton()
+{
+    LvglLockGuard lock;
+
+    if (_zoom_label) {
+        lv_label_set_text_fmt(_zoom_label, "%d%%", (int)std::lround(_viewport.zoom() * 100.0f));
+    }
 }
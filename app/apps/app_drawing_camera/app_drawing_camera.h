@@ -6,6 +6,22 @@
 #pragma once
 #include <mooncake.h>
 #include <lvgl.h>
+#include <hal/hal.h>
+#include "stroke_raster.h"
+#include "brush.h"
+#include "stroke_smoother.h"
+#include "dirty_region.h"
+#include "flood_fill.h"
+#include "ink_layer.h"
+#include "undo_history.h"
+#include "stroke_log.h"
+#include "symmetry.h"
+#include "shape_raster.h"
+#include "mip_pyramid.h"
+#include "viewport.h"
+#include "pinch_gesture.h"
+#include <atomic>
+#include <vector>
 
 /**
  * @brief Drawing Camera App - お絵描きカメラアプリ
@@ -31,9 +47,22 @@ private:
     lv_obj_t* _canvas            = nullptr;
     lv_obj_t* _color_palette     = nullptr;
     lv_obj_t* _current_color_btn = nullptr;  // 現在選択中の色を表示するボタン
+    lv_obj_t* _brush_size_btn    = nullptr;  // 現在のブラシサイズを表示するボタン
+    lv_obj_t* _brush_size_dot    = nullptr;  // ブラシサイズボタン内の円
+    lv_obj_t* _brush_size_panel  = nullptr;  // ブラシサイズ選択パネル
+    lv_obj_t* _fill_btn          = nullptr;  // 塗りつぶしツールの切り替えボタン
+    lv_obj_t* _eraser_btn        = nullptr;  // 消しゴムツールの切り替えボタン
+    lv_obj_t* _symmetry_btn      = nullptr;  // 対称描画のモード切り替えボタン
+    lv_obj_t* _symmetry_label    = nullptr;  // 現在の対称描画のモード名
+    lv_obj_t* _shape_btn         = nullptr;  // 図形ツールの切り替えボタン
+    lv_obj_t* _shape_label       = nullptr;  // 現在の図形の種類
+    lv_obj_t* _zoom_btn          = nullptr;  // 表示倍率（押すと等倍に戻す）
+    lv_obj_t* _zoom_label        = nullptr;
     lv_obj_t* _camera_btn        = nullptr;
     lv_obj_t* _back_btn          = nullptr;
     lv_obj_t* _clear_btn         = nullptr;
+    lv_obj_t* _undo_btn          = nullptr;
+    lv_obj_t* _redo_btn          = nullptr;
 
     // カメラモード用UI
     lv_obj_t* _camera_screen   = nullptr;
@@ -41,43 +70,177 @@ private:
     lv_obj_t* _camera_back_btn = nullptr;
 
     // 描画用データ
-    lv_draw_buf_t* _canvas_buffer     = nullptr;
-    lv_draw_buf_t* _background_buffer = nullptr;  // 背景画像保存用
-    lv_color_t _current_color         = lv_color_black();
-    lv_color_t _palette_colors[10];  // カラーパレットの色
-    static constexpr int CANVAS_WIDTH  = 1280;
-    static constexpr int CANVAS_HEIGHT = 720;
-    static constexpr int BRUSH_SIZE    = 20;
+    lv_draw_buf_t* _canvas_buffer = nullptr;  // 表示用（キャンバスの表示範囲を写した画面の大きさの画像）
+    drawing::PixelBuffer565 _photo;           // 撮影した写真（キャンバスの左上に置く。撮影するまで空）
+    lv_color_t _current_color     = lv_color_black();
+    int _current_color_index      = 0;  // インクのパレット番号（_palette_colors のインデックス）
+    lv_color_t _palette_colors[10];     // カラーパレットの色
+    static constexpr int SCREEN_WIDTH       = 1280;                               // 表示の大きさ
+    static constexpr int SCREEN_HEIGHT      = 720;
+    static constexpr int CANVAS_WIDTH       = 4096;                               // キャンバスの大きさ（画面と同じならスクロールしない）
+    static constexpr int CANVAS_HEIGHT      = 4096;
+    static constexpr size_t INK_BUDGET      = 4 * 1024 * 1024;                    // メモリに置くインクのタイルの上限（PSRAM）
+    static constexpr size_t VIEW_BUDGET     = 4 * 1024 * 1024;                    // 表示用に保持するタイルの上限（PSRAM）
+    static constexpr size_t UNDO_BUDGET     = 1024 * 1024;                        // アンドゥ履歴のメモリ上限（PSRAM）
+    static constexpr size_t STROKE_LOG_SIZE = 512 * 1024;                         // 操作ログの上限（PSRAM）
+    static constexpr int BRUSH_PANEL_WIDTH  = drawing::BRUSH_SIZE_NUM * 80 + 10;  // ブラシサイズパネルの幅
+    static constexpr float STROKE_SPACING   = 1.0f;                               // 補間点の間隔（ブラシ半径比）
+    static constexpr size_t MAX_TOUCH_BATCH = 64;                                 // onRunning() 1 回で処理するサンプル数の上限
+    static constexpr int FILL_TOLERANCE     = 24;                                 // 写真の上で塗りつぶすときの色の許容差
+    static constexpr size_t MAX_VIEW_BATCH  = 32;                                 // onRunning() 1 回で処理するズーム操作の上限
+    static constexpr uint32_t VIEW_BACKDROP = 0x303030;                           // 縮小表示でキャンバスの外側に見える色
+    static constexpr int MAX_FINGERS        = hal::HalBase::MAX_TOUCH_POINTS;     // 同時に描ける指の数
+    static constexpr uint32_t PINCH_WINDOW  = 150;                                // 2 本指の操作とみなす触れる時刻の差（ミリ秒）
+    static constexpr uint32_t LATENCY_LOG   = 5000;                               // 入力から表示までの遅延をログに出す間隔（ミリ秒）
+
+    // インクの持ち方（INK_FORMAT_4BIT にするとインクのメモリは半分になるが、縁はアンチエイリアスしない）
+    static constexpr drawing::InkFormat INK_FORMAT = drawing::INK_FORMAT_8BIT;
+
+    // 画面と大きさが違うフレームの合わせ方（POLICY_FIT にすると全体が収まり、余白は白になる）
+    static constexpr ImageScaler::Policy_t PHOTO_POLICY = ImageScaler::POLICY_FILL;
+    static constexpr ImageScaler::Filter_t PHOTO_FILTER = ImageScaler::FILTER_BILINEAR;
+
+    // 写真の持ち主（カメラから受け取ったフレームか、大きさを合わせて変換した画素のどちらか）
+    hal::HalBase::CameraFrame_t _photo_frame;    // HAL に返すまでアプリが持つフレーム
+    std::vector<uint16_t> _photo_pixels;         // 画面と大きさが違うフレームを変換したもの
+    hal::HalBase::CameraFrame_t _pending_photo;  // 撮影して取り込み待ちのフレーム（LVGL のロックで守る）
+    std::atomic<bool> _photo_pending{false};
 
     // 状態管理
     enum AppState { STATE_DRAWING, STATE_CAMERA_PREVIEW, STATE_CAMERA_CAPTURE };
+    enum DrawTool { TOOL_PEN, TOOL_FILL, TOOL_ERASER, TOOL_SHAPE };
     AppState _current_state    = STATE_DRAWING;
+    DrawTool _current_tool     = TOOL_PEN;
     bool _has_background_image = false;
     bool _palette_expanded     = false;  // パレットの展開状態
+    bool _brush_panel_expanded = false;  // ブラシサイズパネルの展開状態
+    int _brush_size_index      = 3;      // drawing::BRUSH_SIZES のインデックス（初期値 20px）
+    int _symmetry_index        = 0;      // SYMMETRY_MODES のインデックス（0 は対称なし）
+    int _shape_index           = -1;     // SHAPE_TOOLS のインデックス（-1 は図形ツールを使わない）
+
+    // タッチサンプルのキュー（HAL が対応していれば LVGL のイベントの代わりに使う）
+    struct TouchStats_t {
+        uint32_t samples  = 0;
+        uint32_t batches  = 0;
+        uint32_t maxBatch = 0;
+    };
+    bool _touch_sampling = false;
+    TouchStats_t _touch_stats;
+    uint32_t _latency_log_ms = 0;  // 遅延を最後にログに出した時刻
+
+    // 指ごとのストローク（同時に描いたストロークは、最後の指が離れるまでをまとめて 1 回のアンドゥ単位とする）
+    struct Finger_t {
+        drawing::SymmetryStroke stroke;    // 対称描画の全コピーを同時に描く
+        drawing::StrokeSmoother smoother;  // 入力点の平滑化（Catmull-Rom 曲線を等間隔の点列にする）
+        bool pressed       = false;        // 触れている（UI の上で押した場合も含む）
+        bool inView        = false;        // 押した位置が UI の外だった
+        bool inStroke      = false;        // ストローク中
+        lv_coord_t lastX   = -1;           // 最後に描いた点（キャンバス座標）
+        lv_coord_t lastY   = -1;
+        int32_t screenX    = 0;            // 最後の位置（画面座標）
+        int32_t screenY    = 0;
+        uint32_t pressedMs = 0;            // 触れた時刻
+    };
+    Finger_t _fingers[MAX_FINGERS];
+    int _drawing_fingers = 0;  // ストローク中の指の数
+
+    // 2 本指のピンチとドラッグ（1 本目のすぐ後に 2 本目が触れたら描きかけの線を取り消して切り替える）
+    drawing::PinchGesture _pinch;
+    bool _view_pending = false;  // サンプルをすべて処理した後で表示を描き直す
+
+    // アンチエイリアス付きブラシ（サイズごとに専用のスタンプカーネルを持つ）
+    drawing::Brush _brush;
+
+    // 対称描画（モードごとの変換行列）
+    drawing::Symmetry _symmetry;
+
+    // ドラッグ中の図形（プレビューは表示用のバッファに直接描き、離したときにインクへ描く）
+    drawing::Shape _shape;
+    bool _shape_active          = false;
+    bool _shape_preview_pending = false;  // 次のリフレッシュでプレビューを描き直す
+    int _shape_finger           = 0;      // 図形をドラッグしている指
+
+    // 表示倍率と位置、表示に使う段のタイル（キャンバス全体の合成結果は持たない）
+    drawing::Viewport _viewport;
+    drawing::MipPyramid _mip_pyramid;
+
+    // 画面更新領域（リフレッシュごとにまとめて合成・無効化）
+    drawing::DirtyRegion _dirty_region;
+
+    // 写真の上に重ねるインク（描いたタイルだけ確保し、表示は更新領域ごとに合成する）
+    drawing::InkLayer _ink_layer;
+    drawing::TilePageFile _page_file;  // メモリに置けないタイルの追い出し先（SD カードか一時ディレクトリ）
+    drawing::Rect _stroke_bounds;      // 現在のストローク（同時に描いている分すべて）で書き込んだ範囲
+
+    // タイル単位のアンドゥ・リドゥ履歴
+    drawing::UndoHistory _undo_history;
+
+    // 塗りつぶし（作業領域は初期化時に確保）
+    drawing::FloodFill _flood_fill;
 
-    // タッチ描画の補完用
-    bool _is_drawing        = false;
-    lv_coord_t _last_draw_x = -1;
-    lv_coord_t _last_draw_y = -1;
+    // 入力点と操作の記録（再生・再描画用）
+    drawing::StrokeLog _stroke_log;
 
     // 初期化メソッド
     void initDrawingScreen();
     void initCameraScreen();
     void initColorPalette();
+    void initBrushSizePanel();
 
     // イベントハンドラ
     static void canvasEventHandler(lv_event_t* e);
     static void colorPaletteEventHandler(lv_event_t* e);
     static void currentColorBtnEventHandler(lv_event_t* e);
+    static void brushSizeBtnEventHandler(lv_event_t* e);
+    static void brushSizePanelEventHandler(lv_event_t* e);
+    static void toolBtnEventHandler(lv_event_t* e);
+    static void symmetryBtnEventHandler(lv_event_t* e);
+    static void shapeBtnEventHandler(lv_event_t* e);
     static void cameraBtnEventHandler(lv_event_t* e);
     static void cameraPreviewEventHandler(lv_event_t* e);
     static void backBtnEventHandler(lv_event_t* e);
     static void clearBtnEventHandler(lv_event_t* e);
+    static void undoBtnEventHandler(lv_event_t* e);
+    static void redoBtnEventHandler(lv_event_t* e);
+    static void zoomBtnEventHandler(lv_event_t* e);
+    static void displayRefrStartHandler(lv_event_t* e);
 
     // 描画メソッド
-    void drawOnCanvas(lv_coord_t x, lv_coord_t y);
-    void drawLine(lv_coord_t x1, lv_coord_t y1, lv_coord_t x2, lv_coord_t y2);
+    bool isDrawableArea(lv_coord_t screen_x, lv_coord_t screen_y);
+    bool screenToCanvas(lv_coord_t screen_x, lv_coord_t screen_y, lv_coord_t& canvas_x, lv_coord_t& canvas_y);
+    void beginStroke(int finger, lv_coord_t x, lv_coord_t y, uint32_t timeMs);
+    void continueStroke(int finger, lv_coord_t x, lv_coord_t y, uint32_t timeMs);
+    void endStroke(int finger, uint32_t timeMs);
+    void cancelStrokes(uint32_t timeMs);
+    bool isDrawing() const;
+    void processTouchSamples();
+    void logLatency();
+    void processViewGestures();
+    void handleTouchSample(const hal::HalBase::TouchSample_t& sample);
+    bool beginPinch(int finger);
+    void movePinch(int finger);
+    void drawOnCanvas(int finger, lv_coord_t x, lv_coord_t y);
+    drawing::Rect fillArea() const;
+    void fillAt(lv_coord_t x, lv_coord_t y, const drawing::Rect& area);
+    drawing::InkPen currentPen();
+    void drawLineTo(int finger, lv_coord_t x, lv_coord_t y);
+    void drawSmoothedTo(int finger, lv_coord_t x, lv_coord_t y);
+    void finishStroke(int finger);
+    void beginShape(lv_coord_t x, lv_coord_t y);
+    void moveShape(lv_coord_t x, lv_coord_t y);
+    void commitShape(uint32_t timeMs);
+    void markShapeDirty(const drawing::Shape& shape);
+    void prepareCanvasWrite(const drawing::Rect& area);
+    void markCanvasDirty(const drawing::Rect& area);
+    void flushDirtyRegion();
+    void presentCanvas(const drawing::Rect& area);
+    void presentScreen(const drawing::Rect& screen);
+    void renderView();
+    bool composeTile(int index, const drawing::PixelBuffer565& out);
+    void trimMemory();
     void clearCanvas();
+    void undoCanvas();
+    void redoCanvas();
     void setBackgroundImage();
 
     // 状態切り替え
@@ -85,5 +248,12 @@ private:
     void switchToCameraMode();
     void capturePhoto();
     void togglePalette();
+    void toggleBrushPanel();
+    void setBrushSize(int index);
+    void setSymmetryMode(int index);
+    void setShapeTool(int index);
     void updateCurrentColorButton();
+    void updateBrushSizeButton();
+    void updateUndoButtons();
+    void updateZoomButton();
 };
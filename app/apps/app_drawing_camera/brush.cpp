@@ -0,0 +1,504 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "brush.h"
+#include "ink_layer.h"
+#include "paint.h"
+#include <cstring>
+#include <utility>
+
+using namespace drawing;
+
+/* -------------------------------------------------------------------------- */
+/*                                    Stamp                                   */
+/* -------------------------------------------------------------------------- */
+namespace {
+
+template <typename Paint>
+Rect stamp_brush_impl(int32_t x, int32_t y, const BrushMaskView& mask, const Paint& paint)
+{
+    Rect bounds;
+    const Rect clip  = paint.bounds();
+    const int32_t ox = x - mask.half;  // マスク左上のキャンバス座標
+    const int32_t oy = y - mask.half;
+
+    // 全体がバッファ内に収まる場合（ほとんどの場合）はクリップ計算を省く
+    if (ox >= 0 && oy >= 0 && ox + mask.dim <= clip.x2 + 1 && oy + mask.dim <= clip.y2 + 1) {
+        const uint8_t* alpha = mask.alpha;
+        for (int my = 0; my < mask.dim; my++) {
+            const auto row = paint.row(oy + my);
+            const int lo   = mask.rowLo[my];
+            const int sl   = mask.solidLo[my];
+            const int sr   = mask.solidHi[my];
+            const int hi   = mask.rowHi[my];
+            if (sl > sr) {
+                paint.blend(row, ox + lo, alpha + lo, hi - lo + 1);
+            } else {
+                // 縁だけ合成し、内側は単色で塗る
+                paint.blend(row, ox + lo, alpha + lo, sl - lo);
+                paint.fill(row, ox + sl, sr - sl + 1);
+                paint.blend(row, ox + sr + 1, alpha + sr + 1, hi - sr);
+            }
+            alpha += mask.dim;
+        }
+        return Rect{ox, oy, ox + mask.dim - 1, oy + mask.dim - 1};
+    }
+
+    const int32_t y1 = std::max<int32_t>(0, oy);
+    const int32_t y2 = std::min<int32_t>(clip.y2, oy + mask.dim - 1);
+    for (int32_t py = y1; py <= y2; py++) {
+        const int my     = py - oy;
+        const int32_t xl = std::max<int32_t>(0, ox + mask.rowLo[my]);
+        const int32_t xr = std::min<int32_t>(clip.x2, ox + mask.rowHi[my]);
+        if (xl > xr) continue;
+
+        const auto row        = paint.row(py);
+        const uint8_t* alpha  = mask.alpha + my * mask.dim;
+        const int32_t solid_l = std::max(xl, ox + mask.solidLo[my]);
+        const int32_t solid_r = std::min(xr, ox + mask.solidHi[my]);
+
+        if (solid_l > solid_r) {
+            paint.blend(row, xl, alpha + (xl - ox), xr - xl + 1);
+        } else {
+            paint.blend(row, xl, alpha + (xl - ox), solid_l - xl);
+            paint.fill(row, solid_l, solid_r - solid_l + 1);
+            paint.blend(row, solid_r + 1, alpha + (solid_r + 1 - ox), xr - solid_r);
+        }
+        bounds.joinSpan(py, xl, xr);
+    }
+    return bounds;
+}
+
+}  // namespace
+
+Rect drawing::stamp_brush(const PixelBuffer565& buffer, int32_t x, int32_t y, const BrushMaskView& mask,
+                          uint16_t color)
+{
+    if (!buffer.data) return Rect{};
+    return stamp_brush_impl(x, y, mask, SolidPaint(buffer, color));
+}
+
+Rect drawing::stamp_brush(InkLayer& layer, int32_t x, int32_t y, const BrushMaskView& mask, const InkPen& pen)
+{
+    if (pen.erase) return stamp_brush_impl(x, y, mask, InkErasePaint{layer});
+    return stamp_brush_impl(x, y, mask, InkPaint{layer, pen.index});
+}
+
+/* -------------------------------------------------------------------------- */
+/*                           Size-specialized stamp                           */
+/* -------------------------------------------------------------------------- */
+namespace {
+
+template <int Size>
+struct BrushMaskTable {
+    static constexpr BrushMask<Size> mask = {};
+};
+
+// マスクの Row 行目の Lo 列から続く縁の合成率を、テンプレート引数の並びとして Paint に渡す
+template <int Size, int Row, int Lo, typename Paint, int... I>
+inline void blend_run(const typename Paint::Row row, int32_t x, const Paint& paint, std::integer_sequence<int, I...>)
+{
+    constexpr const BrushMask<Size>& mask = BrushMaskTable<Size>::mask;
+    paint.template blendRun<mask.alpha[Row * BrushMask<Size>::DIM + Lo + I]...>(row, x);
+}
+
+// 1 行分（範囲と縁の合成率はすべてコンパイル時定数なので、縁の合成は展開され分岐も表引きも残らない）
+template <int Size, int Row, typename Paint>
+inline void stamp_row(const typename Paint::Row row, int32_t ox, const Paint& paint)
+{
+    constexpr const BrushMask<Size>& mask = BrushMaskTable<Size>::mask;
+    constexpr int lo                      = mask.rowLo[Row];
+    constexpr int hi                      = mask.rowHi[Row];
+    constexpr int solid_l                 = mask.solidLo[Row];
+    constexpr int solid_r                 = mask.solidHi[Row];
+
+    if constexpr (lo > hi) {
+        return;
+    } else if constexpr (solid_l > solid_r) {
+        blend_run<Size, Row, lo>(row, ox + lo, paint, std::make_integer_sequence<int, hi - lo + 1>{});
+    } else {
+        blend_run<Size, Row, lo>(row, ox + lo, paint, std::make_integer_sequence<int, solid_l - lo>{});
+        // 内側の単色部分は 1 画素ずつ展開すると大きいサイズで遅くなるため、長さだけ定数で渡す
+        paint.template fillRun<solid_r - solid_l + 1>(row, ox + solid_l);
+        blend_run<Size, Row, solid_r + 1>(row, ox + solid_r + 1, paint,
+                                          std::make_integer_sequence<int, hi - solid_r>{});
+    }
+}
+
+// マスクは上下対称なので、Row 行目と下から Row 行目を同じコードで塗る（展開するコードが半分になる）
+template <int Size, int Row, typename Paint>
+inline void stamp_row_pair(int32_t ox, int32_t oy, const Paint& paint)
+{
+    constexpr int mirror = BrushMask<Size>::DIM - 1 - Row;
+    constexpr int step   = Row == mirror ? 1 : mirror - Row;
+    for (int32_t y = oy + Row; y <= oy + mirror; y += step) {
+        stamp_row<Size, Row>(paint.row(y), ox, paint);
+    }
+}
+
+template <int Size, typename Paint, int... Rows>
+inline void stamp_rows(int32_t ox, int32_t oy, const Paint& paint, std::integer_sequence<int, Rows...>)
+{
+    (stamp_row_pair<Size, Rows>(ox, oy, paint), ...);
+}
+
+// マスク全体が範囲内に収まるか（収まらない場合は共通のカーネルでクリップする）
+template <int Size>
+bool stamp_fits(const Rect& bounds, int32_t x, int32_t y)
+{
+    constexpr int DIM = BrushMask<Size>::DIM;
+    const int32_t ox  = x - Size / 2;
+    const int32_t oy  = y - Size / 2;
+    return ox >= 0 && oy >= 0 && ox + DIM <= bounds.x2 + 1 && oy + DIM <= bounds.y2 + 1;
+}
+
+template <int Size, typename Paint>
+Rect stamp_fixed_inside(int32_t x, int32_t y, const Paint& paint)
+{
+    constexpr int DIM = BrushMask<Size>::DIM;
+    const int32_t ox  = x - Size / 2;
+    const int32_t oy  = y - Size / 2;
+    stamp_rows<Size>(ox, oy, paint, std::make_integer_sequence<int, DIM / 2 + 1>{});
+    return Rect{ox, oy, ox + DIM - 1, oy + DIM - 1};
+}
+
+template <int Size>
+Rect stamp_brush_fixed(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color)
+{
+    if (!buffer.data || !stamp_fits<Size>(buffer.bounds(), x, y)) {
+        return stamp_brush(buffer, x, y, BrushMaskView::from(BrushMaskTable<Size>::mask), color);
+    }
+    return stamp_fixed_inside<Size>(x, y, SolidPaint(buffer, color));
+}
+
+template <int Size>
+Rect ink_brush_fixed(InkLayer& layer, int32_t x, int32_t y, const InkPen& pen)
+{
+    if (!stamp_fits<Size>(layer.bounds(), x, y)) {
+        return stamp_brush(layer, x, y, BrushMaskView::from(BrushMaskTable<Size>::mask), pen);
+    }
+    if (pen.erase) return stamp_fixed_inside<Size>(x, y, InkErasePaint{layer});
+    return stamp_fixed_inside<Size>(x, y, InkPaint{layer, pen.index});
+}
+
+struct BrushKernel {
+    BrushMaskView mask;
+    StampFn stamp;
+    InkStampFn ink;
+};
+
+template <int Size>
+constexpr BrushKernel make_kernel()
+{
+    return BrushKernel{BrushMaskView::from(BrushMaskTable<Size>::mask), &stamp_brush_fixed<Size>,
+                       &ink_brush_fixed<Size>};
+}
+
+const BrushKernel _kernels[] = {make_kernel<4>(),  make_kernel<8>(),  make_kernel<14>(),
+                                make_kernel<20>(), make_kernel<32>(), make_kernel<48>()};
+
+constexpr bool kernels_match_sizes()
+{
+    constexpr int sizes[] = {4, 8, 14, 20, 32, 48};
+    if (sizeof(sizes) / sizeof(sizes[0]) != BRUSH_SIZE_NUM) return false;
+    for (int i = 0; i < BRUSH_SIZE_NUM; i++) {
+        if (sizes[i] != BRUSH_SIZES[i]) return false;
+    }
+    return true;
+}
+static_assert(kernels_match_sizes(), "kernel table and BRUSH_SIZES mismatch");
+
+}  // namespace
+
+/* -------------------------------------------------------------------------- */
+/*                                    Brush                                   */
+/* -------------------------------------------------------------------------- */
+bool Brush::setSize(int size)
+{
+    if (size < 1 || size > MAX_BRUSH_SIZE) return false;
+
+    for (const auto& kernel : _kernels) {
+        if (kernel.mask.size == size) {
+            _mask  = kernel.mask;
+            _stamp = kernel.stamp;
+            _ink   = kernel.ink;
+            _storage.clear();
+            _storage.shrink_to_fit();
+            return true;
+        }
+    }
+
+    // 専用カーネルがないサイズはマスクを実行時に生成する
+    const int dim       = detail::brush_mask_dim(size);
+    const int ring_size = detail::brush_ring_size(size);
+    _storage.assign(dim * 4 * sizeof(int16_t) + ring_size + dim * dim * 2, 0);
+
+    // 行ごとの範囲は境界をそろえるため先頭に置く
+    int16_t* rows     = (int16_t*)_storage.data();
+    uint8_t* ring     = (uint8_t*)(rows + dim * 4);
+    uint8_t* coverage = ring + ring_size;
+    uint8_t* alpha    = coverage + dim * dim;
+    detail::build_brush_mask(size, ring, coverage, alpha, rows, rows + dim, rows + dim * 2, rows + dim * 3);
+
+    _mask          = BrushMaskView();
+    _mask.size     = size;
+    _mask.half     = size / 2;
+    _mask.dim      = dim;
+    _mask.r2Inner  = detail::brush_r2_inner(size);
+    _mask.r2Outer  = detail::brush_r2_outer(size);
+    _mask.ring     = ring;
+    _mask.coverage = coverage;
+    _mask.alpha    = alpha;
+    _mask.rowLo    = rows;
+    _mask.rowHi    = rows + dim;
+    _mask.solidLo  = rows + dim * 2;
+    _mask.solidHi  = rows + dim * 3;
+    _stamp         = nullptr;
+    _ink           = nullptr;
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Segment                                  */
+/* -------------------------------------------------------------------------- */
+namespace {
+
+// 線分とピクセル中心の距離から被覆率を求める。端点もピクセルも整数なので、行の中では線分方向への射影と
+// 外積（垂直距離 × 長さ）を 1 ピクセルごとに dx・dy だけ足していく
+struct SegmentCoverage {
+    const BrushMaskView& mask;
+    int32_t x0, y0, dx, dy;
+    int64_t l2;
+    float inv_l2;
+
+    SegmentCoverage(const BrushMaskView& brushMask, BrushPoint from, BrushPoint to) : mask(brushMask)
+    {
+        x0     = from.x;
+        y0     = from.y;
+        dx     = to.x - from.x;
+        dy     = to.y - from.y;
+        l2     = (int64_t)dx * dx + (int64_t)dy * dy;
+        inv_l2 = l2 > 0 ? 1.0f / (float)l2 : 0.0f;
+    }
+
+    // 行 py の px から順に進める
+    struct Cursor {
+        int64_t rx, ry, dot, cross;
+    };
+
+    Cursor start(int32_t px, int32_t py) const
+    {
+        const int64_t rx = px - x0;
+        const int64_t ry = py - y0;
+        return Cursor{rx, ry, rx * dx + ry * dy, rx * dy - ry * dx};
+    }
+
+    void next(Cursor& c) const
+    {
+        c.rx++;
+        c.dot += dx;
+        c.cross += dy;
+    }
+
+    uint8_t get(const Cursor& c) const
+    {
+        if (c.dot <= 0) return mask.coverageAt((float)(c.rx * c.rx + c.ry * c.ry));
+        if (c.dot >= l2) {
+            const int64_t ex = c.rx - dx;
+            const int64_t ey = c.ry - dy;
+            return mask.coverageAt((float)(ex * ex + ey * ey));
+        }
+        const float cross = (float)c.cross;
+        return mask.coverageAt(cross * cross * inv_l2);
+    }
+};
+
+// 両端の円と胴体の行ごとの区間。行は y_beg から 1 行ずつ順に next() で進める。
+// 端点は整数なので両端の円は同じ半幅表を使い、行ごとの計算は固定小数点の加算と表引きだけで済む
+struct SegmentRows {
+    detail::BodyEdges body;
+    detail::CapRows cap0;
+    detail::CapRows cap1;
+
+    SegmentRows(const detail::CapTable& table, BrushPoint from, BrushPoint to, float r, int32_t y_beg)
+    {
+        body.init(from.x, from.y, to.x, to.y, r, y_beg);
+        cap0.init(table, from.y, from.x);
+        cap1.init(table, to.y, to.x);
+    }
+
+    // 行 y の区間（16.16）。cap_lo / cap_hi には始点円だけの区間を返す（始点円にかからなければ lo > hi）
+    void next(int32_t y, int64_t& lo, int64_t& hi, int64_t& cap_lo, int64_t& cap_hi)
+    {
+        lo     = INT64_MAX;
+        hi     = INT64_MIN;
+        cap_lo = INT64_MAX;
+        cap_hi = INT64_MIN;
+        int64_t span_lo, span_hi;
+        if (cap0.get(y, span_lo, span_hi)) {
+            lo = cap_lo = span_lo;
+            hi = cap_hi = span_hi;
+        }
+        if (cap1.get(y, span_lo, span_hi)) {
+            lo = std::min(lo, span_lo);
+            hi = std::max(hi, span_hi);
+        }
+        if (body.next(y, span_lo, span_hi)) {
+            lo = std::min(lo, span_lo);
+            hi = std::max(hi, span_hi);
+        }
+    }
+};
+
+template <typename Paint>
+Rect stroke_segment_impl(const BrushPoint* before, BrushPoint from, BrushPoint to, const BrushMaskView& mask,
+                         const Paint& paint)
+{
+    Rect bounds;
+    if (before && before->x == from.x && before->y == from.y) before = nullptr;
+
+    const Rect clip     = paint.bounds();
+    const float r       = mask.size / 2.0f;
+    const float r_outer = r + 0.5f;  // これより遠いピクセルは被覆率 0
+    const float r_inner = r - 0.5f;  // これより近いピクセルは被覆率 255
+
+    const int32_t y_beg = std::max(clip.y1, detail::ceil_to_int(std::min(from.y, to.y) - r_outer));
+    const int32_t y_end = std::min(clip.y2, detail::floor_to_int(std::max(from.y, to.y) + r_outer));
+
+    // 平方根と浮動小数点は線分ごとの準備だけにする（半幅表は同じ太さの線分で使い回す）
+    detail::CapTable& outer_table = detail::cap_table(0);
+    detail::CapTable& inner_table = detail::cap_table(1);
+    outer_table.prepare(r_outer, 0);
+    inner_table.prepare(r_inner, 0);
+    SegmentRows outer(outer_table, from, to, r_outer, y_beg);
+    SegmentRows inner(inner_table, from, to, r_inner, y_beg);
+
+    const SegmentCoverage segment(mask, from, to);
+    const SegmentCoverage previous(mask, before ? *before : from, from);
+
+    // 縁のピクセル：前の線分（または始点の点）で描画済みの被覆率を差し引いて合成する
+    auto blend_fringe = [&](const typename Paint::Row row, int32_t py, int32_t xl, int32_t xr) {
+        if (xl > xr) return;
+        auto cur  = segment.start(xl, py);
+        auto prev = previous.start(xl, py);
+        for (int32_t px = xl; px <= xr; px++, segment.next(cur), previous.next(prev)) {
+            uint32_t c = segment.get(cur);
+            if (c == 0) continue;
+            uint32_t p = before ? previous.get(prev) : mask.at(px - from.x, py - from.y);
+            if (p >= c) continue;
+            if (p != 0) {
+                // 既に p の割合で塗られている下地に重ねて合計が c になる割合
+                c = (c - p) * 255 / (255 - p);
+            }
+            paint.put(row, px, c);
+        }
+    };
+
+    for (int32_t y = y_beg; y <= y_end; y++) {
+        // 外側（被覆率 > 0）の区間と、内側（被覆率 255）の区間のうち始点円で塗りつぶし済みの区間
+        int64_t lo, hi, cap_lo, cap_hi;
+        int64_t in_lo, in_hi, in_cap_lo, in_cap_hi;
+        outer.next(y, lo, hi, cap_lo, cap_hi);
+        inner.next(y, in_lo, in_hi, in_cap_lo, in_cap_hi);
+        if (lo > hi) continue;
+        const int32_t oxl = std::max(clip.x1, detail::fx_ceil(lo));
+        const int32_t oxr = std::min(clip.x2, detail::fx_floor(hi));
+        if (oxl > oxr) continue;
+
+        const auto row = paint.row(y);
+        if (r_inner <= 0.0f || in_lo > in_hi) {
+            blend_fringe(row, y, oxl, oxr);
+        } else {
+            const int32_t ixl = std::max(oxl, detail::fx_ceil(in_lo));
+            const int32_t ixr = std::min(oxr, detail::fx_floor(in_hi));
+            blend_fringe(row, y, oxl, std::min(oxr, ixl - 1));
+            blend_fringe(row, y, std::max(oxl, ixr + 1), oxr);
+
+            auto fill = [&](int32_t xl, int32_t xr) {
+                if (xl <= xr) paint.fill(row, xl, xr - xl + 1);
+            };
+            if (in_cap_lo > in_cap_hi) {
+                fill(ixl, ixr);
+            } else {
+                fill(ixl, std::min(ixr, detail::fx_ceil(in_cap_lo) - 1));
+                fill(std::max(ixl, detail::fx_floor(in_cap_hi) + 1), ixr);
+            }
+        }
+        bounds.joinSpan(y, oxl, oxr);
+    }
+    return bounds;
+}
+
+}  // namespace
+
+Rect drawing::stroke_segment(const PixelBuffer565& buffer, const BrushPoint* before, BrushPoint from, BrushPoint to,
+                             const BrushMaskView& mask, uint16_t color)
+{
+    if (!buffer.data || (from.x == to.x && from.y == to.y)) return Rect{};
+    return stroke_segment_impl(before, from, to, mask, SolidPaint(buffer, color));
+}
+
+Rect drawing::stroke_segment(InkLayer& layer, const BrushPoint* before, BrushPoint from, BrushPoint to,
+                             const BrushMaskView& mask, const InkPen& pen)
+{
+    if (from.x == to.x && from.y == to.y) return Rect{};
+    if (pen.erase) return stroke_segment_impl(before, from, to, mask, InkErasePaint{layer});
+    return stroke_segment_impl(before, from, to, mask, InkPaint{layer, pen.index});
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 BrushStroke                                */
+/* -------------------------------------------------------------------------- */
+Rect BrushStroke::begin(const PixelBuffer565& buffer, const Brush& brush, uint16_t color, int32_t x, int32_t y)
+{
+    _brush     = &brush;
+    _color     = color;
+    _last      = BrushPoint{x, y};
+    _point_num = 1;
+    return brush.stamp(buffer, x, y, color);
+}
+
+Rect BrushStroke::begin(InkLayer& layer, const Brush& brush, const InkPen& pen, int32_t x, int32_t y)
+{
+    _brush     = &brush;
+    _pen       = pen;
+    _last      = BrushPoint{x, y};
+    _point_num = 1;
+    return brush.stamp(layer, x, y, pen);
+}
+
+Rect BrushStroke::lineTo(const PixelBuffer565& buffer, int32_t x, int32_t y)
+{
+    if (!isActive()) return Rect{};
+    if (x == _last.x && y == _last.y) return Rect{};
+
+    BrushPoint to = {x, y};
+    Rect bounds = stroke_segment(buffer, _point_num >= 2 ? &_before : nullptr, _last, to, _brush->mask(), _color);
+    _before     = _last;
+    _last       = to;
+    _point_num++;
+    return bounds;
+}
+
+Rect BrushStroke::lineTo(InkLayer& layer, int32_t x, int32_t y)
+{
+    if (!isActive()) return Rect{};
+    if (x == _last.x && y == _last.y) return Rect{};
+
+    BrushPoint to = {x, y};
+    Rect bounds = stroke_segment(layer, _point_num >= 2 ? &_before : nullptr, _last, to, _brush->mask(), _pen);
+    _before     = _last;
+    _last       = to;
+    _point_num++;
+    return bounds;
+}
+
+Rect BrushStroke::lineToBounds(int32_t x, int32_t y) const
+{
+    if (!isActive()) return Rect{};
+    Rect bounds = _brush->stampBounds(_last.x, _last.y);
+    bounds.join(_brush->stampBounds(x, y));
+    return bounds;
+}
@@ -0,0 +1,463 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include <cstdint>
+#include <vector>
+
+namespace drawing {
+
+class InkLayer;
+
+/* -------------------------------------------------------------------------- */
+/*                                RGB565 blend                                */
+/* -------------------------------------------------------------------------- */
+// G を上位 16 ビットに、R と B を下位に分けて 1 回の乗算で 3 成分を同時に合成する
+static constexpr uint32_t RGB565_BLEND_MASK = 0x07E0F81F;
+
+inline uint32_t expand_565(uint16_t color)
+{
+    return (color | ((uint32_t)color << 16)) & RGB565_BLEND_MASK;
+}
+
+/**
+ * @brief 1 ピクセルを合成する
+ *
+ * @param bg 下地
+ * @param fgExpanded expand_565() 済みの描画色
+ * @param alpha 0 ~ 32
+ */
+inline uint16_t blend_565(uint16_t bg, uint32_t fgExpanded, uint32_t alpha)
+{
+    uint32_t bg_e   = expand_565(bg);
+    uint32_t result = ((((fgExpanded - bg_e) * alpha) >> 5) + bg_e) & RGB565_BLEND_MASK;
+    return (uint16_t)(result | (result >> 16));
+}
+
+/**
+ * @brief 前景に合成率を掛けた値で 1 ピクセルを合成する（blend_565 と同じ結果になる）
+ *
+ * 合成率が定数なら fgScaled は 1 回の計算を使い回せるので、1 ピクセルあたりの演算が減る
+ *
+ * @param bg 下地
+ * @param fgScaled expand_565() した前景 * alpha
+ * @param alpha 0 ~ 32
+ */
+inline uint16_t blend_565_scaled(uint16_t bg, uint32_t fgScaled, uint32_t alpha)
+{
+    uint32_t result = ((fgScaled + expand_565(bg) * (32 - alpha)) >> 5) & RGB565_BLEND_MASK;
+    return (uint16_t)(result | (result >> 16));
+}
+
+/**
+ * @brief 8 ビットの被覆率を合成用の 0 ~ 32 に変換する
+ *
+ */
+inline uint32_t coverage_to_alpha(uint8_t coverage)
+{
+    return (coverage + 4) >> 3;
+}
+
+/**
+ * @brief 合成率の配列に従って 1 行分を合成する（4 ピクセル単位で展開）
+ *
+ * 合成率 0 と 32 でも結果は正確なので分岐せずに同じ式で処理する（ベクトル化しやすい）。
+ *
+ * @param alpha 0 ~ 32
+ */
+inline void blend_span_565(uint16_t* ptr, const uint8_t* alpha, int32_t count, uint32_t fgExpanded)
+{
+    while (count >= 4) {
+        ptr[0] = blend_565(ptr[0], fgExpanded, alpha[0]);
+        ptr[1] = blend_565(ptr[1], fgExpanded, alpha[1]);
+        ptr[2] = blend_565(ptr[2], fgExpanded, alpha[2]);
+        ptr[3] = blend_565(ptr[3], fgExpanded, alpha[3]);
+        ptr += 4;
+        alpha += 4;
+        count -= 4;
+    }
+    for (int i = 0; i < count; i++) {
+        ptr[i] = blend_565(ptr[i], fgExpanded, alpha[i]);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Brush mask                                 */
+/* -------------------------------------------------------------------------- */
+// 縁の被覆率表の、距離の二乗 1 あたりの分割数
+static constexpr int BRUSH_RING_STEPS = 4;
+
+// スタンプで合成率（0 ~ 32）がこれ以下の縁のピクセルは書かない（色の差の 1/16 未満で見た目は変わらない）
+static constexpr int BRUSH_SKIP_ALPHA = 2;
+
+// 書き出し時に 4 倍へ拡大しても最大のブラシ（48px）を描けるように、240 まで扱う
+static constexpr int MAX_BRUSH_SIZE = 240;
+
+namespace detail {
+
+constexpr double const_sqrt(double v)
+{
+    if (v <= 0.0) return 0.0;
+    double x = v > 1.0 ? v : 1.0;
+    for (int i = 0; i < 32; i++) {
+        x = 0.5 * (x + v / x);
+    }
+    return x;
+}
+
+/**
+ * @brief ピクセル中心からブラシ中心までの距離に対する被覆率（1 ピクセル幅の線形フォールオフ）
+ *
+ */
+constexpr uint8_t radial_coverage(double distance, double radius)
+{
+    double c = radius + 0.5 - distance;
+    if (c <= 0.0) return 0;
+    if (c >= 1.0) return 255;
+    return (uint8_t)(c * 255.0 + 0.5);
+}
+
+constexpr int brush_mask_dim(int size)
+{
+    return (size / 2) * 2 + 1;
+}
+constexpr int brush_ring_size(int size)
+{
+    return BRUSH_RING_STEPS * size + 1;
+}
+constexpr double brush_r2_inner(int size)
+{
+    return (size / 2.0 - 0.5) * (size / 2.0 - 0.5);
+}
+constexpr double brush_r2_outer(int size)
+{
+    return (size / 2.0 + 0.5) * (size / 2.0 + 0.5);
+}
+
+/**
+ * @brief マスクの各表を生成する（コンパイル時・実行時の両方で使う）
+ *
+ * 縁（距離 r - 0.5 ~ r + 0.5）の被覆率は距離の二乗から引く表（ring）にしておき、
+ * マスクもストロークの縁も同じ表を使う（点とストロークの継ぎ目で濃度が揃い、ストローク描画で平方根を計算しない）。
+ * 合成率が BRUSH_SKIP_ALPHA 以下のピクセルはマスクから外し、合成率 32 のピクセルは単色塗りの範囲に入れる。
+ */
+constexpr void build_brush_mask(int size, uint8_t* ring, uint8_t* coverage, uint8_t* alpha, int16_t* rowLo,
+                                int16_t* rowHi, int16_t* solidLo, int16_t* solidHi)
+{
+    const int half        = size / 2;
+    const int dim         = brush_mask_dim(size);
+    const int ring_size   = brush_ring_size(size);
+    const double radius   = size / 2.0;
+    const double r2_inner = brush_r2_inner(size);
+    for (int i = 0; i < ring_size; i++) {
+        ring[i] = radial_coverage(const_sqrt(r2_inner + (double)i / BRUSH_RING_STEPS), radius);
+    }
+
+    for (int y = 0; y < dim; y++) {
+        rowLo[y]   = dim;
+        rowHi[y]   = -1;
+        solidLo[y] = dim;
+        solidHi[y] = -1;
+        for (int x = 0; x < dim; x++) {
+            // ピクセル中心の距離の二乗は整数なので表の位置も整数になる
+            int d2                = (x - half) * (x - half) + (y - half) * (y - half);
+            int index             = (int)(d2 * BRUSH_RING_STEPS - r2_inner * BRUSH_RING_STEPS);
+            uint8_t c             = index < 0 ? 255 : (index >= ring_size ? 0 : ring[index]);
+            uint8_t a             = (c + 4) >> 3;
+            if (a <= BRUSH_SKIP_ALPHA) {
+                c = 0;
+                a = 0;
+            }
+            coverage[y * dim + x] = c;
+            alpha[y * dim + x]    = a;
+            if (a != 0) {
+                if (rowLo[y] > x) rowLo[y] = x;
+                rowHi[y] = x;
+            }
+            if (a == 32) {
+                if (solidLo[y] > x) solidLo[y] = x;
+                solidHi[y] = x;
+            }
+        }
+    }
+}
+
+}  // namespace detail
+
+/**
+ * @brief ブラシサイズごとの被覆率マスク（コンパイル時に生成）
+ *
+ * 中心を整数座標に置いた直径 Size の円。行ごとに合成率が 0 でない範囲と 32 の範囲を持ち、
+ * 内側は単色塗り、縁だけを合成する。
+ */
+template <int Size>
+struct BrushMask {
+    static_assert(Size > 0 && Size <= MAX_BRUSH_SIZE, "unsupported brush size");
+
+    static constexpr int SIZE      = Size;
+    static constexpr int HALF      = Size / 2;
+    static constexpr int DIM       = detail::brush_mask_dim(Size);
+    static constexpr int RING_SIZE = detail::brush_ring_size(Size);
+
+    uint8_t ring[RING_SIZE]     = {};  // 被覆率[(d^2 - r2Inner) * BRUSH_RING_STEPS]
+    uint8_t coverage[DIM * DIM] = {};
+    uint8_t alpha[DIM * DIM]    = {};  // coverage を合成用の 0 ~ 32 にしたもの
+    int16_t rowLo[DIM]          = {};  // 合成率が 0 でない範囲（マスク内の列番号）
+    int16_t rowHi[DIM]          = {};
+    int16_t solidLo[DIM]        = {};  // 合成率 32 の範囲（空なら solidLo > solidHi）
+    int16_t solidHi[DIM]        = {};
+
+    constexpr BrushMask()
+    {
+        detail::build_brush_mask(Size, ring, coverage, alpha, rowLo, rowHi, solidLo, solidHi);
+    }
+};
+
+/**
+ * @brief サイズに依存しない形でマスクを参照するためのビュー
+ *
+ */
+struct BrushMaskView {
+    int size                = 0;
+    int half                = 0;
+    int dim                 = 0;
+    float r2Inner           = 0.0f;
+    float r2Outer           = 0.0f;
+    const uint8_t* ring     = nullptr;
+    const uint8_t* coverage = nullptr;
+    const uint8_t* alpha    = nullptr;
+    const int16_t* rowLo    = nullptr;
+    const int16_t* rowHi    = nullptr;
+    const int16_t* solidLo  = nullptr;
+    const int16_t* solidHi  = nullptr;
+
+    template <int Size>
+    static constexpr BrushMaskView from(const BrushMask<Size>& mask)
+    {
+        BrushMaskView view;
+        view.size     = Size;
+        view.half     = BrushMask<Size>::HALF;
+        view.dim      = BrushMask<Size>::DIM;
+        view.r2Inner  = detail::brush_r2_inner(Size);
+        view.r2Outer  = detail::brush_r2_outer(Size);
+        view.ring     = mask.ring;
+        view.coverage = mask.coverage;
+        view.alpha    = mask.alpha;
+        view.rowLo    = mask.rowLo;
+        view.rowHi    = mask.rowHi;
+        view.solidLo  = mask.solidLo;
+        view.solidHi  = mask.solidHi;
+        return view;
+    }
+
+    /**
+     * @brief 中心からの距離の二乗に対する被覆率
+     *
+     */
+    uint8_t coverageAt(float d2) const
+    {
+        if (d2 <= r2Inner) return 255;
+        if (d2 >= r2Outer) return 0;
+        return ring[(int)((d2 - r2Inner) * BRUSH_RING_STEPS + 0.5f)];
+    }
+
+    uint8_t at(int32_t dx, int32_t dy) const
+    {
+        if (dx < -half || dx > half || dy < -half || dy > half) return 0;
+        return coverage[(dy + half) * dim + dx + half];
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                     Ink                                    */
+/* -------------------------------------------------------------------------- */
+/**
+ * @brief InkLayer にブラシで書き込む内容（パレット番号のインク、または消しゴム）
+ *
+ */
+struct InkPen {
+    int index  = 0;
+    bool erase = false;
+
+    static InkPen draw(int index)
+    {
+        InkPen pen;
+        pen.index = index;
+        return pen;
+    }
+    static InkPen eraser()
+    {
+        InkPen pen;
+        pen.erase = true;
+        return pen;
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                    Brush                                   */
+/* -------------------------------------------------------------------------- */
+/**
+ * @brief 専用カーネルを用意しているブラシサイズ（直径ピクセル）
+ *
+ */
+static constexpr int BRUSH_SIZES[]  = {4, 8, 14, 20, 32, 48};
+static constexpr int BRUSH_SIZE_NUM = sizeof(BRUSH_SIZES) / sizeof(BRUSH_SIZES[0]);
+
+/**
+ * @brief ブラシを 1 回押す関数（サイズごとに展開したカーネル）
+ *
+ * @return Rect 書き込んだ領域（バッファ範囲でクリップ済み）
+ */
+using StampFn = Rect (*)(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color);
+
+/**
+ * @brief InkLayer にブラシを 1 回押す関数（StampFn と同じ展開をしたもの）
+ *
+ */
+using InkStampFn = Rect (*)(InkLayer& layer, int32_t x, int32_t y, const InkPen& pen);
+
+/**
+ * @brief アンチエイリアス付きの円形ブラシを 1 回押す（任意サイズ共通の実装）
+ *
+ * @return Rect 書き込んだ領域（バッファ範囲でクリップ済み）
+ */
+Rect stamp_brush(const PixelBuffer565& buffer, int32_t x, int32_t y, const BrushMaskView& mask, uint16_t color);
+Rect stamp_brush(InkLayer& layer, int32_t x, int32_t y, const BrushMaskView& mask, const InkPen& pen);
+
+/**
+ * @brief サイズを選んで使うブラシ
+ *
+ * BRUSH_SIZES のサイズはコンパイル時に生成したマスクと、行ごとに展開したテンプレートのカーネルを使う。
+ * それ以外のサイズは実行時にマスクを生成し、共通のカーネルで描く。
+ */
+class Brush {
+public:
+    Brush()
+    {
+        setSize(BRUSH_SIZES[0]);
+    }
+    Brush(const Brush&)            = delete;
+    Brush& operator=(const Brush&) = delete;
+
+    /**
+     * @brief サイズを変更する
+     *
+     * @param size 直径ピクセル（1 ~ MAX_BRUSH_SIZE）
+     * @return true 変更した
+     */
+    bool setSize(int size);
+
+    int size() const
+    {
+        return _mask.size;
+    }
+    const BrushMaskView& mask() const
+    {
+        return _mask;
+    }
+
+    /**
+     * @brief 専用カーネルを使っているか（false なら共通のカーネル）
+     *
+     */
+    bool isSpecialized() const
+    {
+        return _stamp != nullptr;
+    }
+
+    Rect stamp(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color) const
+    {
+        return _stamp ? _stamp(buffer, x, y, color) : stamp_brush(buffer, x, y, _mask, color);
+    }
+    Rect stamp(InkLayer& layer, int32_t x, int32_t y, const InkPen& pen) const
+    {
+        return _ink ? _ink(layer, x, y, pen) : stamp_brush(layer, x, y, _mask, pen);
+    }
+
+    /**
+     * @brief stamp() が書き込む可能性のある範囲
+     *
+     */
+    Rect stampBounds(int32_t x, int32_t y) const
+    {
+        return Rect{x - _mask.half, y - _mask.half, x + _mask.half, y + _mask.half};
+    }
+
+private:
+    BrushMaskView _mask;
+    StampFn _stamp  = nullptr;
+    InkStampFn _ink = nullptr;
+    std::vector<uint8_t> _storage;  // 実行時に生成したマスク
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                   Stroke                                   */
+/* -------------------------------------------------------------------------- */
+struct BrushPoint {
+    int32_t x = 0;
+    int32_t y = 0;
+};
+
+/**
+ * @brief 前の点からの線分をアンチエイリアス付きで描く
+ *
+ * 始点にはすでに同じブラシが描かれている前提で、描画済みの被覆率を差し引いた分だけ合成する
+ * （継ぎ目の縁が二重に濃くならない）。描画済みの被覆率は before から始点までの線分、
+ * before が nullptr なら始点のマスク（ブラシを押した結果）として求める。
+ *
+ * @return Rect 書き込んだ領域（バッファ範囲でクリップ済み）
+ */
+Rect stroke_segment(const PixelBuffer565& buffer, const BrushPoint* before, BrushPoint from, BrushPoint to,
+                    const BrushMaskView& mask, uint16_t color);
+
+Rect stroke_segment(InkLayer& layer, const BrushPoint* before, BrushPoint from, BrushPoint to,
+                    const BrushMaskView& mask, const InkPen& pen);
+
+/**
+ * @brief 1 本のストロークを点の追加で描いていくためのヘルパー
+ *
+ */
+class BrushStroke {
+public:
+    /**
+     * @brief ストロークを開始して最初の点を押す
+     *
+     */
+    Rect begin(const PixelBuffer565& buffer, const Brush& brush, uint16_t color, int32_t x, int32_t y);
+    Rect begin(InkLayer& layer, const Brush& brush, const InkPen& pen, int32_t x, int32_t y);
+
+    /**
+     * @brief 最後の点から線分を描く
+     *
+     */
+    Rect lineTo(const PixelBuffer565& buffer, int32_t x, int32_t y);
+    Rect lineTo(InkLayer& layer, int32_t x, int32_t y);
+
+    void end()
+    {
+        _point_num = 0;
+    }
+    bool isActive() const
+    {
+        return _point_num > 0;
+    }
+
+    /**
+     * @brief lineTo() が書き込む可能性のある範囲（書き込み前に知りたい場合に使う）
+     *
+     */
+    Rect lineToBounds(int32_t x, int32_t y) const;
+
+private:
+    const Brush* _brush = nullptr;
+    uint16_t _color = 0;  // RGB565 に描く場合
+    InkPen _pen;          // InkLayer に描く場合
+    BrushPoint _last;
+    BrushPoint _before;  // _last の一つ前の点（_point_num >= 2 のとき有効）
+    int _point_num = 0;
+};
+
+}  // namespace drawing
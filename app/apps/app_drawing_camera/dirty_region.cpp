@@ -0,0 +1,62 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "dirty_region.h"
+
+using namespace drawing;
+
+// 結合した場合に新たに再描画対象となる（どちらにも含まれない）面積
+int64_t DirtyRegion::merge_overhead(const Rect& a, const Rect& b)
+{
+    Rect joined = a;
+    joined.join(b);
+    return joined.area() - (a.area() + b.area() - a.intersect(b).area());
+}
+
+void DirtyRegion::merge_into(int index, const Rect& rect)
+{
+    _rects[index].join(rect);
+
+    // 大きくなった矩形が他の矩形を安く吸収できる場合は続けて結合する
+    for (int i = 0; i < _count; i++) {
+        if (i == index) continue;
+        if (merge_overhead(_rects[index], _rects[i]) <= _merge_overhead) {
+            _rects[index].join(_rects[i]);
+            _rects[i] = _rects[--_count];
+            if (index == _count) index = i;
+            i = -1;
+        }
+    }
+}
+
+void DirtyRegion::add(const Rect& rect)
+{
+    if (rect.isEmpty()) return;
+    _stats.submitted++;
+
+    // 余分な面積が最小になる結合先を探す
+    int best_index        = -1;
+    int64_t best_overhead = INT64_MAX;
+    for (int i = 0; i < _count; i++) {
+        int64_t overhead = merge_overhead(_rects[i], rect);
+        if (overhead < best_overhead) {
+            best_overhead = overhead;
+            best_index    = i;
+        }
+    }
+
+    if (best_index >= 0 && best_overhead <= _merge_overhead) {
+        merge_into(best_index, rect);
+        return;
+    }
+
+    if (_count < MAX_RECTS) {
+        _rects[_count++] = rect;
+        return;
+    }
+
+    // 上限に達したら最も安い結合先にまとめる
+    merge_into(best_index, rect);
+}
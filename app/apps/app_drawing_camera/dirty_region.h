@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include <cstdint>
+
+namespace drawing {
+
+/**
+ * @brief 描画更新領域の集約
+ *
+ * 描画のたびに発生する小さな更新矩形を 1 リフレッシュ分ためておき、
+ * 結合しても余分な面積が閾値以下のものはまとめて、少数の矩形として一度に無効化する。
+ */
+class DirtyRegion {
+public:
+    static constexpr int MAX_RECTS = 16;  // 対称描画の最大コピー数（12）でもコピーごとに別の矩形にできる数
+
+    struct Stats_t {
+        uint32_t submitted = 0;  // add() された矩形数
+        uint32_t flushed   = 0;  // flush() で出力した矩形数
+        uint32_t flushes   = 0;  // 矩形を出力した flush() の回数
+    };
+
+    /**
+     * @brief 結合を許す余分な面積（ピクセル数）
+     *
+     * @param overheadPx
+     */
+    void setMergeOverhead(int64_t overheadPx)
+    {
+        _merge_overhead = overheadPx;
+    }
+
+    /**
+     * @brief 更新矩形を追加する
+     *
+     * @param rect
+     */
+    void add(const Rect& rect);
+
+    /**
+     * @brief たまっている矩形をすべて出力して空にする
+     *
+     * @param fn void(const Rect&)
+     */
+    template <typename Fn>
+    void flush(Fn&& fn)
+    {
+        if (_count == 0) return;
+        for (int i = 0; i < _count; i++) {
+            fn(_rects[i]);
+        }
+        _stats.flushed += _count;
+        _stats.flushes++;
+        _count = 0;
+    }
+
+    bool isEmpty() const
+    {
+        return _count == 0;
+    }
+    const Stats_t& getStats() const
+    {
+        return _stats;
+    }
+    void resetStats()
+    {
+        _stats = Stats_t();
+    }
+
+private:
+    Rect _rects[MAX_RECTS];
+    int _count              = 0;
+    int64_t _merge_overhead = 64 * 64;
+    Stats_t _stats;
+
+    static int64_t merge_overhead(const Rect& a, const Rect& b);
+    void merge_into(int index, const Rect& rect);
+};
+
+}  // namespace drawing
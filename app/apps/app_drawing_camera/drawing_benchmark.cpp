@@ -0,0 +1,1693 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "drawing_benchmark.h"
+#include "stroke_raster.h"
+#include "brush.h"
+#include "ink_layer.h"
+#include "stroke_smoother.h"
+#include "undo_history.h"
+#include "flood_fill.h"
+#include "stroke_log.h"
+#include "stroke_export.h"
+#include "symmetry.h"
+#include "shape_raster.h"
+#include "mip_pyramid.h"
+#include "viewport.h"
+#include "dirty_region.h"
+#include "tile_page_file.h"
+#include "pinch_gesture.h"
+#include <hal/utils/image_scale/image_scale.h>
+#include <mooncake_log.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace drawing;
+
+static const std::string _tag = "bench";
+
+static constexpr int CANVAS_WIDTH  = 1280;
+static constexpr int CANVAS_HEIGHT = 720;
+static constexpr int BRUSH_SIZE    = 20;
+
+namespace {
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+struct RasterStats {
+    uint64_t pixels        = 0;
+    uint64_t invalidations = 0;
+    bool countsPixels      = true;  // false なら pixels は数えていない（AA の経路）
+};
+
+using Stroke = std::vector<Point>;
+
+/* -------------------------------------------------------------------------- */
+/*                                 Test input                                 */
+/* -------------------------------------------------------------------------- */
+// 高速なスワイプを模した入力（イベント間隔が広く、1 セグメントが長い）
+std::vector<Stroke> make_fast_swipes(int strokeNum, int pointsPerStroke)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> pos_x(0, CANVAS_WIDTH - 1);
+    std::uniform_int_distribution<int> pos_y(0, CANVAS_HEIGHT - 1);
+    std::uniform_int_distribution<int> step(-80, 80);
+
+    std::vector<Stroke> strokes(strokeNum);
+    for (auto& stroke : strokes) {
+        Point p = {pos_x(gen), pos_y(gen)};
+        int vx  = step(gen);
+        int vy  = step(gen) / 2;
+        for (int i = 0; i < pointsPerStroke; i++) {
+            stroke.push_back(p);
+            vx  = std::clamp(vx + step(gen) / 4, -80, 80);
+            vy  = std::clamp(vy + step(gen) / 4, -80, 80);
+            p.x = std::clamp(p.x + vx, 0, CANVAS_WIDTH - 1);
+            p.y = std::clamp(p.y + vy, 0, CANVAS_HEIGHT - 1);
+        }
+    }
+    return strokes;
+}
+
+// 手書きを模した入力（120Hz 程度のサンプリングで、1 セグメントが短い）
+std::vector<Stroke> make_handwriting(int strokeNum, int pointsPerStroke)
+{
+    std::mt19937 gen(5678);
+    std::uniform_int_distribution<int> pos_x(100, CANVAS_WIDTH - 100);
+    std::uniform_int_distribution<int> pos_y(100, CANVAS_HEIGHT - 100);
+    std::uniform_int_distribution<int> step(-3, 3);
+
+    std::vector<Stroke> strokes(strokeNum);
+    for (auto& stroke : strokes) {
+        Point p = {pos_x(gen), pos_y(gen)};
+        int vx  = 0;
+        int vy  = 0;
+        for (int i = 0; i < pointsPerStroke; i++) {
+            stroke.push_back(p);
+            vx  = std::clamp(vx + step(gen), -12, 12);
+            vy  = std::clamp(vy + step(gen), -12, 12);
+            p.x = std::clamp(p.x + vx, 0, CANVAS_WIDTH - 1);
+            p.y = std::clamp(p.y + vy, 0, CANVAS_HEIGHT - 1);
+        }
+    }
+    return strokes;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                       Legacy path (square stamping)                        */
+/* -------------------------------------------------------------------------- */
+// 以前の drawOnCanvas / drawLine と同じ処理（比較用）
+void legacy_stamp(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color, RasterStats& stats)
+{
+    const int radius   = BRUSH_SIZE / 2;
+    const int diameter = BRUSH_SIZE;
+    if (x < radius || y < radius || x >= buffer.width - radius || y >= buffer.height - radius) {
+        return;
+    }
+    for (int py = y - radius; py <= y + radius; py++) {
+        fill_span_565(buffer.row(py) + x - radius, diameter, color);
+    }
+    stats.pixels += (uint64_t)(diameter + 1) * diameter;
+    stats.invalidations++;
+}
+
+void legacy_line(const PixelBuffer565& buffer, Point a, Point b, uint16_t color, RasterStats& stats)
+{
+    int distance = std::abs(b.x - a.x) + std::abs(b.y - a.y);
+    if (distance <= BRUSH_SIZE / 2) {
+        legacy_stamp(buffer, b.x, b.y, color, stats);
+        return;
+    }
+
+    int dx         = std::abs(b.x - a.x);
+    int dy         = std::abs(b.y - a.y);
+    int sx         = a.x < b.x ? 1 : -1;
+    int sy         = a.y < b.y ? 1 : -1;
+    int err        = dx - dy;
+    int x          = a.x;
+    int y          = a.y;
+    int step_count = 0;
+    while (true) {
+        if (step_count % (BRUSH_SIZE / 4) == 0) {
+            legacy_stamp(buffer, x, y, color, stats);
+        }
+        if (x == b.x && y == b.y) break;
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            x += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            y += sy;
+        }
+        step_count++;
+    }
+    legacy_stamp(buffer, b.x, b.y, color, stats);
+}
+
+void legacy_stroke(const PixelBuffer565& buffer, const Stroke& stroke, uint16_t color, RasterStats& stats)
+{
+    legacy_stamp(buffer, stroke[0].x, stroke[0].y, color, stats);
+    for (size_t i = 1; i < stroke.size(); i++) {
+        legacy_line(buffer, stroke[i - 1], stroke[i], color, stats);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                         Span path (capsule raster)                         */
+/* -------------------------------------------------------------------------- */
+void capsule_stroke(const PixelBuffer565& buffer, const Stroke& stroke, uint16_t color, RasterStats& stats)
+{
+    auto count_span = [&](int32_t y, int32_t xl, int32_t xr) {
+        fill_span_565(buffer.row(y) + xl, xr - xl + 1, color);
+        stats.pixels += xr - xl + 1;
+    };
+
+    Capsule capsule;
+    capsule.x0     = stroke[0].x;
+    capsule.y0     = stroke[0].y;
+    capsule.x1     = stroke[0].x;
+    capsule.y1     = stroke[0].y;
+    capsule.radius = BRUSH_SIZE / 2.0f;
+    for_each_capsule_span(buffer.bounds(), capsule, count_span);
+    stats.invalidations++;
+
+    capsule.startCap = false;
+    for (size_t i = 1; i < stroke.size(); i++) {
+        capsule.x0 = stroke[i - 1].x;
+        capsule.y0 = stroke[i - 1].y;
+        capsule.x1 = stroke[i].x;
+        capsule.y1 = stroke[i].y;
+        if (!for_each_capsule_span(buffer.bounds(), capsule, count_span).isEmpty()) {
+            stats.invalidations++;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                          AA path (brush mask stroke)                       */
+/* -------------------------------------------------------------------------- */
+// 書き込みピクセル数は BrushStroke の内側でしか分からないので数えない（px/stroke は "-" と表示する）
+void brush_stroke(const PixelBuffer565& buffer, const Stroke& stroke, uint16_t color, RasterStats& stats)
+{
+    static Brush brush_tip;
+    brush_tip.setSize(BRUSH_SIZE);
+
+    stats.countsPixels = false;
+    BrushStroke brush;
+    brush.begin(buffer, brush_tip, color, stroke[0].x, stroke[0].y);
+    stats.invalidations++;
+    for (size_t i = 1; i < stroke.size(); i++) {
+        if (!brush.lineTo(buffer, stroke[i].x, stroke[i].y).isEmpty()) {
+            stats.invalidations++;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                         Ink path (brush mask on tiles)                     */
+/* -------------------------------------------------------------------------- */
+// アプリが実際に通る経路（InkLayer のタイルに InkPaint で描く）。brush_stroke と同じく書き込みピクセル数は数えない
+void ink_stroke(InkLayer& layer, const Stroke& stroke, uint16_t color, RasterStats& stats)
+{
+    static Brush brush_tip;
+    brush_tip.setSize(BRUSH_SIZE);
+
+    stats.countsPixels = false;
+    const InkPen pen   = InkPen::draw(color % INK_PALETTE_SIZE);
+    BrushStroke brush;
+    brush.begin(layer, brush_tip, pen, stroke[0].x, stroke[0].y);
+    stats.invalidations++;
+    for (size_t i = 1; i < stroke.size(); i++) {
+        if (!brush.lineTo(layer, stroke[i].x, stroke[i].y).isEmpty()) {
+            stats.invalidations++;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                        Smoothed path (Catmull-Rom + AA)                    */
+/* -------------------------------------------------------------------------- */
+// brush_stroke と同じく書き込みピクセル数は数えない
+void smoothed_stroke(const PixelBuffer565& buffer, const Stroke& stroke, uint16_t color, RasterStats& stats)
+{
+    static Brush brush_tip;
+    brush_tip.setSize(BRUSH_SIZE);
+
+    stats.countsPixels = false;
+    BrushStroke brush;
+    StrokeSmoother smoother;
+    brush.begin(buffer, brush_tip, color, stroke[0].x, stroke[0].y);
+    smoother.begin(stroke[0].x, stroke[0].y, BRUSH_SIZE * 0.5f);  // 間隔はブラシ半径
+    stats.invalidations++;
+
+    auto line_to = [&](const StrokePoint& p) {
+        if (!brush.lineTo(buffer, std::lround(p.x), std::lround(p.y)).isEmpty()) {
+            stats.invalidations++;
+        }
+    };
+    for (size_t i = 1; i < stroke.size(); i++) {
+        smoother.addPoint(stroke[i].x, stroke[i].y, line_to);
+    }
+    smoother.finish(line_to);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Runner                                   */
+/* -------------------------------------------------------------------------- */
+template <typename StrokeFn>
+void run_stroke_case(const char* name, const PixelBuffer565& buffer, const std::vector<Stroke>& strokes,
+                     StrokeFn&& strokeFn)
+{
+    RasterStats stats;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < strokes.size(); i++) {
+        strokeFn(buffer, strokes[i], (uint16_t)(i * 2654435761u), stats);
+    }
+    auto end   = std::chrono::steady_clock::now();
+    double us  = std::chrono::duration<double, std::micro>(end - start).count();
+    double num = (double)strokes.size();
+
+    if (!stats.countsPixels) {
+        mclog::tagInfo(_tag, "{:<10} {:>10} px/stroke {:>8.1f} inval/stroke {:>9.2f} us/stroke", name, "-",
+                       stats.invalidations / num, us / num);
+        return;
+    }
+    mclog::tagInfo(_tag, "{:<10} {:>10.0f} px/stroke {:>8.1f} inval/stroke {:>9.2f} us/stroke", name,
+                   stats.pixels / num, stats.invalidations / num, us / num);
+}
+
+void bench_stroke_raster()
+{
+    mclog::tagInfo(_tag, "--- stroke raster: fast swipe, brush {} px, {}x{} ---", BRUSH_SIZE, CANVAS_WIDTH,
+                   CANVAS_HEIGHT);
+
+    std::vector<uint16_t> pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 buffer = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    auto strokes = make_fast_swipes(200, 32);
+    run_stroke_case("legacy", buffer, strokes, legacy_stroke);
+    run_stroke_case("capsule", buffer, strokes, capsule_stroke);
+    run_stroke_case("brush AA", buffer, strokes, brush_stroke);
+    run_stroke_case("smoothed", buffer, strokes, smoothed_stroke);
+
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    run_stroke_case("ink AA", buffer, strokes, [&](const PixelBuffer565&, const Stroke& stroke, uint16_t color,
+                                                    RasterStats& stats) { ink_stroke(layer, stroke, color, stats); });
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Strokes                                  */
+/* -------------------------------------------------------------------------- */
+template <typename StrokeFn>
+double measure_strokes(const std::vector<Stroke>& strokes, StrokeFn&& strokeFn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& stroke : strokes) {
+        strokeFn(stroke);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / strokes.size();
+}
+
+void draw_stroke(const PixelBuffer565& buffer, const Brush& tip, uint16_t color, const Stroke& stroke)
+{
+    BrushStroke brush;
+    brush.begin(buffer, tip, color, stroke[0].x, stroke[0].y);
+    for (size_t i = 1; i < stroke.size(); i++) {
+        brush.lineTo(buffer, stroke[i].x, stroke[i].y);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Brush stamp                                 */
+/* -------------------------------------------------------------------------- */
+// 戻り値は stamps/s
+template <typename StampFn>
+double measure_stamps(const std::vector<Point>& points, StampFn&& stampFn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < points.size(); i++) {
+        stampFn(points[i], (uint16_t)(i * 2654435761u));
+    }
+    auto end  = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    return points.size() / us * 1e6;
+}
+
+template <typename StampFn>
+void run_stamp_case(const char* name, const std::vector<Point>& points, StampFn&& stampFn)
+{
+    mclog::tagInfo(_tag, "{:<10} {:>10.0f} stamps/s", name, measure_stamps(points, stampFn));
+}
+
+// バッファ端にかからない位置（クリップなしの経路を測る）
+std::vector<Point> make_stamp_points(int num, int margin)
+{
+    std::mt19937 gen(5678);
+    std::uniform_int_distribution<int> pos_x(margin, CANVAS_WIDTH - margin - 1);
+    std::uniform_int_distribution<int> pos_y(margin, CANVAS_HEIGHT - margin - 1);
+    std::vector<Point> points(num);
+    for (auto& p : points) {
+        p = {pos_x(gen), pos_y(gen)};
+    }
+    return points;
+}
+
+void bench_brush_stamp()
+{
+    mclog::tagInfo(_tag, "--- brush stamp: brush {} px ---", BRUSH_SIZE);
+
+    std::vector<uint16_t> pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 buffer = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    auto points           = make_stamp_points(100000, BRUSH_SIZE);
+
+    RasterStats stats;
+    run_stamp_case("square", points, [&](Point p, uint16_t color) { legacy_stamp(buffer, p.x, p.y, color, stats); });
+
+    Brush brush;
+    brush.setSize(BRUSH_SIZE);
+    run_stamp_case("round AA", points, [&](Point p, uint16_t color) { brush.stamp(buffer, p.x, p.y, color); });
+
+    // アプリが実際に通る経路（InkLayer のタイルに InkPaint で描く）
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    run_stamp_case("ink AA", points, [&](Point p, uint16_t color) {
+        brush.stamp(layer, p.x, p.y, InkPen::draw(color % INK_PALETTE_SIZE));
+    });
+}
+
+void bench_brush_sizes()
+{
+    mclog::tagInfo(_tag, "--- brush sizes: specialized vs generic kernel ---");
+
+    std::vector<uint16_t> pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 buffer = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    auto points           = make_stamp_points(50000, MAX_BRUSH_SIZE);
+
+    // 専用カーネルのあるサイズに加えて、共通カーネルにフォールバックするサイズも測る
+    std::vector<int> sizes(BRUSH_SIZES, BRUSH_SIZES + BRUSH_SIZE_NUM);
+    sizes.push_back(25);
+
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+    Brush brush;
+    for (int size : sizes) {
+        brush.setSize(size);
+        const BrushMaskView& mask = brush.mask();
+
+        double fixed = measure_stamps(points, [&](Point p, uint16_t color) { brush.stamp(buffer, p.x, p.y, color); });
+        double generic =
+            measure_stamps(points, [&](Point p, uint16_t color) { stamp_brush(buffer, p.x, p.y, mask, color); });
+        double ink = measure_stamps(points, [&](Point p, uint16_t color) {
+            brush.stamp(layer, p.x, p.y, InkPen::draw(color % INK_PALETTE_SIZE));
+        });
+        mclog::tagInfo(_tag, "{:>3} px {:<9} {:>10.0f} stamps/s, generic {:>10.0f} stamps/s ({:.2f}x), ink {:>10.0f}",
+                       size, brush.isSpecialized() ? "fixed" : "fallback", fixed, generic, fixed / generic, ink);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Undo history                                */
+/* -------------------------------------------------------------------------- */
+void bench_undo_history()
+{
+    const size_t frame_bytes = CANVAS_WIDTH * CANVAS_HEIGHT * sizeof(uint16_t);
+    mclog::tagInfo(_tag, "--- undo history: 1 level per stroke, full frame {} bytes ---", frame_bytes);
+
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+    UndoHistory history;
+    history.init(CANVAS_WIDTH, CANVAS_HEIGHT, SIZE_MAX);
+
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+
+    // 短いストローク（通常の描き込み）を想定
+    auto strokes = make_fast_swipes(50, 6);
+    auto start   = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < strokes.size(); i++) {
+        const Stroke& stroke = strokes[i];
+        history.beginStep();
+        BrushStroke brush;
+        history.capture(layer, tip.stampBounds(stroke[0].x, stroke[0].y));
+        brush.begin(layer, tip, InkPen::draw(i % INK_PALETTE_SIZE), stroke[0].x, stroke[0].y);
+        for (size_t j = 1; j < stroke.size(); j++) {
+            history.capture(layer, brush.lineToBounds(stroke[j].x, stroke[j].y));
+            brush.lineTo(layer, stroke[j].x, stroke[j].y);
+        }
+        history.endStep();
+    }
+    auto end  = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+
+    auto stats = history.getStats();
+    mclog::tagInfo(_tag, "{} levels: {} bytes compressed, {} bytes raw tiles ({:.1f}% of one frame), {:.2f} us/stroke",
+                   stats.undoLevels, stats.bytes, stats.rawBytes, stats.bytes * 100.0 / frame_bytes,
+                   us / strokes.size());
+
+    // すべて取り消して元の白紙（タイルなし）に戻ることを確認
+    start = std::chrono::steady_clock::now();
+    while (history.undo(layer, [](const Rect&) {})) {
+    }
+    end = std::chrono::steady_clock::now();
+    us  = std::chrono::duration<double, std::micro>(end - start).count();
+    mclog::tagInfo(_tag, "undo all: {:.2f} us/level, ink tiles left: {}", us / strokes.size(), layer.tileCount());
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Ink layer                                 */
+/* -------------------------------------------------------------------------- */
+void draw_stroke(InkLayer& layer, const Brush& tip, const InkPen& pen, const Stroke& stroke)
+{
+    BrushStroke brush;
+    brush.begin(layer, tip, pen, stroke[0].x, stroke[0].y);
+    for (size_t i = 1; i < stroke.size(); i++) {
+        brush.lineTo(layer, stroke[i].x, stroke[i].y);
+    }
+}
+
+void bench_ink_layer()
+{
+    mclog::tagInfo(_tag, "--- ink layer: photo + 1 B/px ink tiles, brush {} px ---", BRUSH_SIZE);
+
+    std::mt19937 gen(11);
+    std::vector<uint16_t> photo(CANVAS_WIDTH * CANVAS_HEIGHT);
+    for (auto& p : photo) {
+        p = (uint16_t)gen();
+    }
+    std::vector<uint16_t> pixels(photo.size());
+    PixelBuffer565 canvas = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    PixelBuffer565 source = {photo.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        layer.setPaletteColor(i, (uint16_t)(i * 0x1111));
+    }
+
+    Brush pen;
+    pen.setSize(BRUSH_SIZE);
+    Brush eraser;
+    eraser.setSize(48);
+
+    // ストロークのコスト（RGB565 に直接描く場合と比較）
+    auto strokes   = make_fast_swipes(200, 32);
+    double rgb_us  = measure_strokes(strokes,
+                                     [&](const Stroke& s) { draw_stroke(canvas, pen, 0, s); });
+    double ink_us  = measure_strokes(strokes, [&](const Stroke& s) { draw_stroke(layer, pen, InkPen::draw(3), s); });
+    size_t tiles   = layer.tileCount();
+    size_t ink_mem = layer.bytes();
+
+    // 1 ストローク分の更新領域を合成するコスト
+    Rect stroke_bounds;
+    for (const auto& p : strokes[0]) {
+        stroke_bounds.join(pen.stampBounds(p.x, p.y));
+    }
+    auto start = std::chrono::steady_clock::now();
+    layer.composite(stroke_bounds, source, 0xFFFF, canvas);
+    auto end         = std::chrono::steady_clock::now();
+    double stroke_us = std::chrono::duration<double, std::micro>(end - start).count();
+
+    // 全画面の合成（写真の差し替え時など）
+    start = std::chrono::steady_clock::now();
+    layer.composite(layer.bounds(), source, 0xFFFF, canvas);
+    end             = std::chrono::steady_clock::now();
+    double frame_us = std::chrono::duration<double, std::micro>(end - start).count();
+
+    mclog::tagInfo(_tag, "stroke rgb565 {:.2f} us, ink {:.2f} us ({:.2f}x); ink {} tiles, {} bytes ({:.1f}% of frame)",
+                   rgb_us, ink_us, ink_us / rgb_us, tiles, ink_mem, ink_mem * 100.0 / (photo.size() * 2));
+    mclog::tagInfo(_tag, "composite stroke area {}x{} {:.2f} us, full frame {:.2f} us", stroke_bounds.width(),
+                   stroke_bounds.height(), stroke_us, frame_us);
+
+    // 太い消しゴムでなぞればインクはなくなり、写真がそのまま見える
+    for (const auto& stroke : strokes) {
+        draw_stroke(layer, eraser, InkPen::eraser(), stroke);
+    }
+    layer.releaseEmptyTiles(layer.bounds());
+    layer.composite(layer.bounds(), source, 0xFFFF, canvas);
+    mclog::tagInfo(_tag, "after erasing: {} tiles left, photo intact: {}", layer.tileCount(), pixels == photo);
+}
+
+void bench_ink_format()
+{
+    mclog::tagInfo(_tag, "--- ink format: 8-bit (index + coverage) vs 4-bit (index only), brush {} px ---", BRUSH_SIZE);
+
+    std::vector<uint16_t> pixels[2];
+    Brush pen;
+    pen.setSize(BRUSH_SIZE);
+    const auto strokes = make_fast_swipes(200, 32);
+    const InkFormat formats[] = {INK_FORMAT_8BIT, INK_FORMAT_4BIT};
+    for (int f = 0; f < 2; f++) {
+        InkLayer layer;
+        layer.init(CANVAS_WIDTH, CANVAS_HEIGHT, formats[f]);
+        for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+            layer.setPaletteColor(i, (uint16_t)(i * 0x1111));
+        }
+        pixels[f].resize(CANVAS_WIDTH * CANVAS_HEIGHT);
+        PixelBuffer565 canvas = {pixels[f].data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < strokes.size(); i++) {
+            draw_stroke(layer, pen, InkPen::draw(i % INK_NIBBLE_COLORS), strokes[i]);
+        }
+        auto end         = std::chrono::steady_clock::now();
+        double stroke_us = std::chrono::duration<double, std::micro>(end - start).count() / strokes.size();
+
+        start = std::chrono::steady_clock::now();
+        layer.composite(layer.bounds(), PixelBuffer565(), 0xFFFF, canvas);
+        end             = std::chrono::steady_clock::now();
+        double frame_us = std::chrono::duration<double, std::micro>(end - start).count();
+
+        // クリアと同じく全タイルをアンドゥ用に保存する
+        UndoHistory history;
+        history.init(CANVAS_WIDTH, CANVAS_HEIGHT, SIZE_MAX);
+        start = std::chrono::steady_clock::now();
+        history.beginStep();
+        layer.forEachTile([&](int index, const Rect&) { history.captureTile(layer, index); });
+        history.endStep();
+        end            = std::chrono::steady_clock::now();
+        double snap_us = std::chrono::duration<double, std::micro>(end - start).count();
+        const auto undo = history.getStats();
+
+        // パレットの色を変えると、描いたインクは次の合成から新しい色になる
+        layer.setPaletteColor(3, 0x07E0);
+        layer.composite(layer.bounds(), PixelBuffer565(), 0xFFFF, canvas);
+        const size_t recolored = std::count(pixels[f].begin(), pixels[f].end(), 0x07E0);
+        layer.setPaletteColor(3, 3 * 0x1111);
+        layer.composite(layer.bounds(), PixelBuffer565(), 0xFFFF, canvas);
+
+        mclog::tagInfo(_tag,
+                       "{}: stroke {:.2f} us, {} tiles {} KB, composite {:.0f} us, snapshot {:.0f} us "
+                       "{} / {} KB, recolored {} px",
+                       f == 0 ? "8-bit" : "4-bit", stroke_us, layer.tileCount(), layer.bytes() / 1024, frame_us,
+                       snap_us, undo.bytes / 1024, undo.rawBytes / 1024, recolored);
+    }
+
+    // 違いは縁の画素だけ（4 ビットは合成率が半分以上の画素を塗りつぶす）
+    size_t differ = 0;
+    for (size_t i = 0; i < pixels[0].size(); i++) {
+        differ += pixels[0][i] != pixels[1][i];
+    }
+    mclog::tagInfo(_tag, "4-bit differs from 8-bit in {} px ({:.2f}%, antialiased edges)", differ,
+                   differ * 100.0 / pixels[0].size());
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Stroke log                                 */
+/* -------------------------------------------------------------------------- */
+void record_strokes(StrokeLog& log, const std::vector<Stroke>& strokes)
+{
+    std::mt19937 gen(99);
+    std::uniform_int_distribution<int> jitter(0, 2);
+    uint32_t time = 1000;
+    for (size_t i = 0; i < strokes.size(); i++) {
+        const Stroke& stroke = strokes[i];
+        log.beginStroke(time, 0, i % INK_PALETTE_SIZE, BRUSH_SIZE, 0, 0, 0, stroke[0].x, stroke[0].y);
+        for (size_t j = 1; j < stroke.size(); j++) {
+            time += 8 + jitter(gen);
+            log.addPoint(time, stroke[j].x, stroke[j].y);
+        }
+        log.endStroke(time);
+        time += 300;
+    }
+}
+
+void run_stroke_log_case(const char* name, const std::vector<Stroke>& strokes)
+{
+    StrokeLog log;
+    log.init(4 * 1024 * 1024, 4 * 1024 * 1024);
+
+    auto start = std::chrono::steady_clock::now();
+    record_strokes(log, strokes);
+    auto end         = std::chrono::steady_clock::now();
+    const auto stats = log.getStats();
+    double encode_ns = std::chrono::duration<double, std::nano>(end - start).count() / stats.points;
+
+    // 展開して元の点列と一致することを確認
+    std::vector<Point> points;
+    start = std::chrono::steady_clock::now();
+    log.forEach([&](const StrokeEvent& e) {
+        if (e.type == StrokeEvent::STROKE_BEGIN || e.type == StrokeEvent::STROKE_POINT) points.push_back({e.x, e.y});
+    });
+    end              = std::chrono::steady_clock::now();
+    double decode_ns = std::chrono::duration<double, std::nano>(end - start).count() / stats.points;
+
+    bool same = points.size() == stats.points;
+    size_t k  = 0;
+    for (const auto& stroke : strokes) {
+        for (const auto& p : stroke) {
+            same = same && k < points.size() && points[k].x == p.x && points[k].y == p.y;
+            k++;
+        }
+    }
+
+    mclog::tagInfo(_tag, "{:<12} {:>6} pts {:>7} bytes {:.2f} B/pt, encode {:.1f} ns/pt, decode {:.1f} ns/pt, exact {}",
+                   name, stats.points, stats.bytes, stats.bytesPerPoint(), encode_ns, decode_ns, same);
+}
+
+void bench_stroke_log()
+{
+    mclog::tagInfo(_tag, "--- stroke log: delta + varint, 8 ms sample interval ---");
+    run_stroke_log_case("handwriting", make_handwriting(200, 64));
+    run_stroke_log_case("fast swipe", make_fast_swipes(200, 32));
+
+    // ログから再生した描画が直接描いた結果と一致することを確認
+    auto strokes = make_handwriting(50, 64);
+    StrokeLog log;
+    log.init(1024 * 1024);
+    record_strokes(log, strokes);
+
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    InkLayer direct, replayed;
+    direct.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    replayed.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (size_t i = 0; i < strokes.size(); i++) {
+        draw_stroke(direct, tip, InkPen::draw(i % INK_PALETTE_SIZE), strokes[i]);
+    }
+
+    BrushStroke brush;
+    log.forEach([&](const StrokeEvent& e) {
+        if (e.type == StrokeEvent::STROKE_BEGIN) {
+            Brush size;
+            size.setSize(e.brushSize);
+            brush.begin(replayed, size, InkPen::draw(e.color), e.x, e.y);
+        } else if (e.type == StrokeEvent::STROKE_POINT) {
+            brush.lineTo(replayed, e.x, e.y);
+        } else if (e.type == StrokeEvent::STROKE_END) {
+            brush.end();
+        }
+    });
+
+    bool same = direct.tileCount() == replayed.tileCount();
+    for (int32_t y = 0; same && y < CANVAS_HEIGHT; y++) {
+        for (int32_t x = 0; x < CANVAS_WIDTH; x++) {
+            if (direct.at(x, y) != replayed.at(x, y)) {
+                same = false;
+                break;
+            }
+        }
+    }
+    mclog::tagInfo(_tag, "replay {} strokes from {} bytes: identical ink {}", log.getStats().strokes,
+                   log.getStats().bytes, same);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Export                                   */
+/* -------------------------------------------------------------------------- */
+// アプリと同じ手順（平滑化 → 線分）で描く
+void draw_smoothed_stroke(InkLayer& layer, const Brush& tip, const InkPen& pen, const Stroke& stroke)
+{
+    BrushStroke brush;
+    StrokeSmoother smoother;
+    brush.begin(layer, tip, pen, stroke[0].x, stroke[0].y);
+    smoother.begin(stroke[0].x, stroke[0].y, tip.size() * 0.5f);
+    auto emit = [&](const StrokePoint& p) {
+        brush.lineTo(layer, (int32_t)std::lround(p.x), (int32_t)std::lround(p.y));
+    };
+    for (size_t i = 1; i < stroke.size(); i++) {
+        smoother.addPoint(stroke[i].x, stroke[i].y, emit);
+    }
+    smoother.finish(emit);
+}
+
+// 対称描画のストロークもアプリと同じ手順で描く
+void draw_symmetric_stroke(InkLayer& layer, const Brush& tip, const InkPen& pen, const Symmetry& symmetry,
+                           const Stroke& stroke)
+{
+    SymmetryStroke brush;
+    StrokeSmoother smoother;
+    auto ignore = [](const Rect&) {};
+    brush.begin(layer, tip, pen, symmetry, stroke[0].x, stroke[0].y, ignore, ignore);
+    smoother.begin(stroke[0].x, stroke[0].y, tip.size() * 0.5f);
+    auto emit = [&](const StrokePoint& p) {
+        brush.lineTo(layer, (int32_t)std::lround(p.x), (int32_t)std::lround(p.y), ignore, ignore);
+    };
+    for (size_t i = 1; i < stroke.size(); i++) {
+        smoother.addPoint(stroke[i].x, stroke[i].y, emit);
+    }
+    smoother.finish(emit);
+    brush.end();
+}
+
+// 等倍で書き出して、直接描いたレイヤーとの差の画素数を返す
+size_t count_export_mismatch(const StrokeLog& log, const InkLayer& canvas, const PixelBuffer565& source,
+                             const InkLayer& direct, ExportStats& stats)
+{
+    std::vector<uint16_t> expected((size_t)CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 expected_buffer = {expected.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    direct.composite(direct.bounds(), source, 0xFFFF, expected_buffer);
+
+    ExportOptions options;
+    options.scale   = 1;
+    size_t mismatch = 0;
+    stats           = export_stroke_log(log, canvas, source, options, [&](int32_t y, const PixelBuffer565& band) {
+        for (int32_t row = 0; row < band.height; row++) {
+            const uint16_t* a = band.row(row);
+            const uint16_t* b = expected_buffer.row(y + row);
+            for (int32_t x = 0; x < band.width; x++) {
+                mismatch += a[x] != b[x];
+            }
+        }
+    });
+    return mismatch;
+}
+
+void bench_export()
+{
+    mclog::tagInfo(_tag, "--- export: replay stroke log in row bands ---");
+
+    std::mt19937 gen(3);
+    std::vector<uint16_t> photo(CANVAS_WIDTH * CANVAS_HEIGHT);
+    for (auto& p : photo) {
+        p = (uint16_t)gen();
+    }
+    PixelBuffer565 source = {photo.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    InkLayer canvas;
+    canvas.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        canvas.setPaletteColor(i, (uint16_t)(i * 0x1111));
+    }
+
+    // 取り消したストロークは書き出しに含まれない
+    auto strokes = make_handwriting(60, 64);
+    StrokeLog log;
+    log.init(1024 * 1024);
+    record_strokes(log, strokes);
+    log.event(StrokeEvent::UNDO, 100000);
+    log.event(StrokeEvent::UNDO, 100001);
+    log.event(StrokeEvent::REDO, 100002);
+
+    // 等倍の書き出しはアプリで描いた結果と一致する
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    InkLayer direct;
+    direct.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        direct.setPaletteColor(i, canvas.paletteColor(i));
+    }
+    for (size_t i = 0; i + 1 < strokes.size(); i++) {
+        draw_smoothed_stroke(direct, tip, InkPen::draw(i % INK_PALETTE_SIZE), strokes[i]);
+    }
+    ExportStats stats;
+    size_t mismatch = count_export_mismatch(log, canvas, source, direct, stats);
+    mclog::tagInfo(_tag, "1x export of {} strokes: {} px differ from the app rendering", stats.strokes, mismatch);
+
+    // 対称描画のコピーはキャンバスの中心ではなく、ストロークに記録した中心まわりに書き出される
+    Symmetry symmetry;
+    symmetry.setMode(SymmetryMode{3, true}, Rect{0, 0, CANVAS_WIDTH / 2 - 1, CANVAS_HEIGHT / 2 - 1});
+    StrokeLog symmetric_log;
+    symmetric_log.init(1024 * 1024);
+    InkLayer symmetric;
+    symmetric.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        symmetric.setPaletteColor(i, canvas.paletteColor(i));
+    }
+    uint32_t time = 1000;
+    for (size_t i = 0; i < std::min<size_t>(strokes.size(), 8); i++) {
+        const Stroke& stroke = strokes[i];
+        symmetric_log.beginStroke(time, 0, i % INK_PALETTE_SIZE, BRUSH_SIZE, symmetry.mode().encode(),
+                                  symmetry.centerX2(), symmetry.centerY2(), stroke[0].x, stroke[0].y);
+        for (size_t j = 1; j < stroke.size(); j++) {
+            time += 8;
+            symmetric_log.addPoint(time, stroke[j].x, stroke[j].y);
+        }
+        symmetric_log.endStroke(time);
+        draw_symmetric_stroke(symmetric, tip, InkPen::draw(i % INK_PALETTE_SIZE), symmetry, stroke);
+    }
+    mismatch = count_export_mismatch(symmetric_log, canvas, source, symmetric, stats);
+    mclog::tagInfo(_tag, "1x export of {} strokes x {} symmetric copies around ({:.1f}, {:.1f}): {} px differ",
+                   stats.strokes, symmetry.copies(), symmetry.centerX2() * 0.5f, symmetry.centerY2() * 0.5f,
+                   mismatch);
+
+    // 拡大して書き出す（塗りつぶしを 1 つ加え、出力はバンドの行数だけ数えて捨てる）
+    log.fill(100100, 3, 5, 5, Rect{0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1});
+    ExportOptions options;
+    std::vector<int> thread_nums = {1};
+    if (ExportOptions::defaultThreads() > 1) {
+        thread_nums.push_back(ExportOptions::defaultThreads());
+    }
+    for (int scale : {2, 4}) {
+        for (int threads : thread_nums) {
+            options.scale   = scale;
+            options.threads = threads;
+            stats           = export_stroke_log(log, canvas, source, options, [](int32_t, const PixelBuffer565&) {});
+            mclog::tagInfo(_tag, "{}x {}x{} in {} bands, {} threads: {:.1f} ms, {} B/thread + {} B fill (frame {} B)",
+                           scale, stats.width, stats.height, stats.bands, stats.threads, stats.milliseconds,
+                           stats.bandBytes, stats.prepassBytes, (size_t)stats.width * stats.height * 2);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Symmetry                                  */
+/* -------------------------------------------------------------------------- */
+struct SymmetryStats {
+    double us              = 0.0;
+    uint64_t invalidations = 0;
+    uint64_t pixels        = 0;  // 合成し直した画素数（重なった矩形は重複して数える）
+    uint32_t maxPerFrame   = 0;  // 1 リフレッシュの間に無効化した矩形数の最大（LVGL は 32 を超えると全画面を描き直す）
+};
+
+// 入力 2 点ごとに 1 回リフレッシュが来るものとして、更新矩形を合成・無効化する
+SymmetryStats run_symmetry_case(const SymmetryMode& mode, const std::vector<Stroke>& strokes, bool merged)
+{
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    std::vector<uint16_t> pixels(CANVAS_WIDTH * CANVAS_HEIGHT, 0xFFFF);
+    PixelBuffer565 canvas = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    PixelBuffer565 photo;
+
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    Symmetry symmetry;
+    symmetry.setMode(mode, Rect{0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1});
+    SymmetryStroke brush;
+    StrokeSmoother smoother;
+    DirtyRegion dirty_region;
+
+    SymmetryStats stats;
+    uint32_t frame_rects = 0;
+    auto invalidate      = [&](const Rect& rect) {
+        layer.composite(rect, photo, 0xFFFF, canvas);
+        stats.invalidations++;
+        stats.pixels += rect.area();
+        frame_rects++;
+    };
+    auto refresh = [&]() {
+        dirty_region.flush(invalidate);
+        stats.maxPerFrame = std::max(stats.maxPerFrame, frame_rects);
+        frame_rects       = 0;
+    };
+    auto prepare = [](const Rect&) {};
+    auto dirty   = [&](const Rect& rect) {
+        if (merged) {
+            dirty_region.add(rect);
+        } else if (!rect.isEmpty()) {
+            invalidate(rect);
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < strokes.size(); i++) {
+        const Stroke& stroke = strokes[i];
+        brush.begin(layer, tip, InkPen::draw(i % INK_PALETTE_SIZE), symmetry, stroke[0].x, stroke[0].y, prepare,
+                    dirty);
+        smoother.begin(stroke[0].x, stroke[0].y, BRUSH_SIZE * 0.5f);
+        auto line_to = [&](const StrokePoint& p) {
+            brush.lineTo(layer, std::lround(p.x), std::lround(p.y), prepare, dirty);
+        };
+        for (size_t j = 1; j < stroke.size(); j++) {
+            smoother.addPoint(stroke[j].x, stroke[j].y, line_to);
+            if (j % 2 == 0) refresh();
+        }
+        smoother.finish(line_to);
+        brush.end();
+        refresh();
+    }
+    auto end = std::chrono::steady_clock::now();
+    stats.us = std::chrono::duration<double, std::micro>(end - start).count() / strokes.size();
+    return stats;
+}
+
+void bench_symmetry()
+{
+    mclog::tagInfo(_tag, "--- symmetry: fixed-point copies, brush {} px ---", BRUSH_SIZE);
+
+    // 左右反転は誤差なく画素の位置が入れ替わる
+    Symmetry mirror;
+    mirror.setMode(SymmetryMode{1, true}, Rect{0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1});
+    bool exact = true;
+    for (int32_t x = 0; x < CANVAS_WIDTH; x++) {
+        int32_t tx, ty;
+        mirror.apply(1, x, 100, tx, ty);
+        exact = exact && tx == CANVAS_WIDTH - 1 - x && ty == 100;
+    }
+    mclog::tagInfo(_tag, "mirror maps x to {} - x exactly: {}", CANVAS_WIDTH - 1, exact);
+
+    // 中心付近に描くとコピーどうしが重なる
+    auto strokes = make_handwriting(30, 64);
+    for (auto& stroke : strokes) {
+        for (auto& p : stroke) {
+            p.x = CANVAS_WIDTH / 2 + (p.x - CANVAS_WIDTH / 2) / 3;
+            p.y = CANVAS_HEIGHT / 2 + (p.y - CANVAS_HEIGHT / 2) / 3;
+        }
+    }
+
+    const SymmetryMode modes[] = {{1, false}, {1, true}, {3, true}, {6, true}};
+    for (const auto& mode : modes) {
+        SymmetryStats each   = run_symmetry_case(mode, strokes, false);
+        SymmetryStats merged = run_symmetry_case(mode, strokes, true);
+        double num           = (double)strokes.size();
+        mclog::tagInfo(_tag,
+                       "{:>2} copies: per copy {:>7.1f} us/stroke {:>6.1f} inval {:>7.0f} px (max {:>3}/frame) | "
+                       "merged {:>7.1f} us/stroke {:>5.1f} inval {:>7.0f} px (max {:>2}/frame)",
+                       mode.copies(), each.us, each.invalidations / num, each.pixels / num, each.maxPerFrame,
+                       merged.us, merged.invalidations / num, merged.pixels / num, merged.maxPerFrame);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Shapes                                   */
+/* -------------------------------------------------------------------------- */
+struct ShapeDragStats {
+    double us       = 0.0;  // 1 回の移動あたり
+    uint64_t pixels = 0;    // 1 回の移動あたりの合成と無効化の画素数
+};
+
+enum class PreviewRestore { COVER, BOUNDS, FULL };
+
+// 前のプレビューを消して（合成し直して）新しいプレビューを描く、を 1 回の移動ごとに繰り返す
+ShapeDragStats run_shape_drag(const InkLayer& layer, const PixelBuffer565& photo, const PixelBuffer565& canvas,
+                              const std::vector<Shape>& frames, PreviewRestore restore)
+{
+    ShapeDragStats stats;
+    auto recomposite = [&](const Rect& rect) {
+        const Rect clipped = rect.intersect(canvas.bounds());
+        layer.composite(clipped, photo, 0xFFFF, canvas);
+        stats.pixels += clipped.area();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 1; i < frames.size(); i++) {
+        const Shape& prev = frames[i - 1];
+        if (restore == PreviewRestore::COVER) {
+            const ShapeCover cover = ShapeCover::of(prev);
+            for (int j = 0; j < cover.count; j++) {
+                recomposite(cover.rects[j]);
+            }
+        } else if (restore == PreviewRestore::BOUNDS) {
+            recomposite(prev.bounds());
+        } else {
+            recomposite(canvas.bounds());
+        }
+        draw_shape(canvas, frames[i], 0x001F);
+    }
+    auto end = std::chrono::steady_clock::now();
+    stats.us = std::chrono::duration<double, std::micro>(end - start).count() / (frames.size() - 1);
+    stats.pixels /= frames.size() - 1;
+    return stats;
+}
+
+void bench_shapes()
+{
+    mclog::tagInfo(_tag, "--- shapes: overlay preview over photo + ink, {} px line ---", BRUSH_SIZE);
+
+    // ストロークを描いたインクと写真を模した背景
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    const auto strokes = make_fast_swipes(20, 16);
+    for (size_t i = 0; i < strokes.size(); i++) {
+        draw_smoothed_stroke(layer, tip, InkPen::draw(i % INK_PALETTE_SIZE), strokes[i]);
+    }
+    std::vector<uint16_t> photo_pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    for (int32_t y = 0; y < CANVAS_HEIGHT; y++) {
+        for (int32_t x = 0; x < CANVAS_WIDTH; x++) {
+            photo_pixels[y * CANVAS_WIDTH + x] = (uint16_t)(((x >> 3) << 11) | ((y >> 4) << 5) | ((x + y) >> 6));
+        }
+    }
+    PixelBuffer565 photo = {photo_pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    std::vector<uint16_t> pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 canvas = {pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    static const char* names[] = {"line", "rectangle", "circle", "ellipse"};
+    for (int type = SHAPE_LINE; type <= SHAPE_ELLIPSE; type++) {
+        // 画面の 1/4 付近から終点を 120 回動かして大きな図形にする
+        std::vector<Shape> frames;
+        for (int i = 0; i <= 120; i++) {
+            Shape shape;
+            shape.type      = (ShapeType)type;
+            shape.x0        = CANVAS_WIDTH / 4;
+            shape.y0        = CANVAS_HEIGHT / 4;
+            shape.x1        = shape.x0 + (type == SHAPE_CIRCLE ? 2 : 5) * i;
+            shape.y1        = shape.y0 + (type == SHAPE_CIRCLE ? 1 : 3) * i;
+            shape.thickness = BRUSH_SIZE;
+            frames.push_back(shape);
+        }
+
+        // 描いた画素がすべて覆う矩形の中にある（プレビューの消し残しがない）
+        std::vector<uint16_t> probe(CANVAS_WIDTH * CANVAS_HEIGHT);
+        PixelBuffer565 probe_buffer = {probe.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+        uint64_t outside            = 0;
+        for (const Shape& shape : {frames[10], frames[60], frames.back()}) {
+            std::fill(probe.begin(), probe.end(), 0);
+            draw_shape(probe_buffer, shape, 0xFFFF);
+            const ShapeCover cover = ShapeCover::of(shape);
+            for (int32_t y = 0; y < CANVAS_HEIGHT; y++) {
+                for (int32_t x = 0; x < CANVAS_WIDTH; x++) {
+                    if (!probe[y * CANVAS_WIDTH + x]) continue;
+                    bool covered = false;
+                    for (int j = 0; j < cover.count && !covered; j++) {
+                        covered = cover.rects[j].intersects(Rect{x, y, x, y});
+                    }
+                    outside += !covered;
+                }
+            }
+        }
+
+        layer.composite(canvas.bounds(), photo, 0xFFFF, canvas);
+        ShapeDragStats cover  = run_shape_drag(layer, photo, canvas, frames, PreviewRestore::COVER);
+        ShapeDragStats bounds = run_shape_drag(layer, photo, canvas, frames, PreviewRestore::BOUNDS);
+        ShapeDragStats full   = run_shape_drag(layer, photo, canvas, frames, PreviewRestore::FULL);
+
+        // 確定（覆う矩形のタイルをアンドゥ用に保存してインクへ描く）
+        InkLayer committed;
+        committed.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+        UndoHistory history;
+        history.init(CANVAS_WIDTH, CANVAS_HEIGHT, 4 * 1024 * 1024);
+        auto start = std::chrono::steady_clock::now();
+        for (const Shape& shape : frames) {
+            const ShapeCover shape_cover = ShapeCover::of(shape);
+            history.beginStep();
+            for (int j = 0; j < shape_cover.count; j++) {
+                history.capture(committed, shape_cover.rects[j]);
+            }
+            draw_shape(committed, shape, InkPen::draw(1));
+            history.endStep();
+        }
+        auto end         = std::chrono::steady_clock::now();
+        double commit_us = std::chrono::duration<double, std::micro>(end - start).count() / frames.size();
+
+        mclog::tagInfo(_tag,
+                       "{:<9} move: cover {:>6.1f} us {:>7} px | bounds {:>6.1f} us {:>7} px | full {:>7.1f} us "
+                       "{:>7} px | commit {:>6.1f} us | outside cover {}",
+                       names[type], cover.us, cover.pixels, bounds.us, bounds.pixels, full.us, full.pixels,
+                       commit_us, outside);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Viewport                                  */
+/* -------------------------------------------------------------------------- */
+struct ViewStats {
+    double us       = 0.0;  // 1 リフレッシュあたり
+    uint64_t pixels = 0;    // 1 リフレッシュあたりのタイルの合成と表示で書いた画素数
+};
+
+MipPyramid::ComposeFn compose_ink(const InkLayer& layer)
+{
+    return [&layer](int index, const PixelBuffer565& out) {
+        return layer.compositeTile(index, PixelBuffer565(), 0xFFFF, out);
+    };
+}
+
+// 縮小表示のまま描く。リフレッシュごとに、変わった範囲のタイルを作り直して表示用のバッファへ反映する
+ViewStats run_view_case(const Viewport& viewport, const std::vector<Stroke>& strokes, bool incremental,
+                        std::vector<uint16_t>& view_pixels)
+{
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    view_pixels.assign(CANVAS_WIDTH * CANVAS_HEIGHT, 0);
+    PixelBuffer565 view = {view_pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    MipPyramid pyramid;
+    pyramid.init(CANVAS_WIDTH, CANVAS_HEIGHT, SIZE_MAX, 0xFFFF, compose_ink(layer));
+    pyramid.setLevel(viewport.level());
+    auto tile = [&](int index) { return pyramid.tile(index); };
+    viewport.render(view, view.bounds(), 0x3186, tile);
+    pyramid.resetStats();
+
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    BrushStroke brush;
+    StrokeSmoother smoother;
+    DirtyRegion dirty_region;
+
+    // 比較用: 毎回すべてのタイルを作り直して全画面を描く
+    ViewStats stats;
+    uint32_t refreshes = 0;
+    double us          = 0.0;
+    auto refresh       = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        if (incremental) {
+            dirty_region.flush([&](const Rect& rect) {
+                pyramid.invalidate(rect);
+                const Rect screen = viewport.toScreen(rect);
+                viewport.render(view, screen, 0x3186, tile);
+                stats.pixels += screen.area();
+            });
+        } else {
+            dirty_region.flush([](const Rect&) {});
+            pyramid.invalidateAll();
+            viewport.render(view, view.bounds(), 0x3186, tile);
+            stats.pixels += view.bounds().area();
+        }
+        auto end = std::chrono::steady_clock::now();
+        us += std::chrono::duration<double, std::micro>(end - start).count();
+        refreshes++;
+    };
+    auto dirty = [&](const Rect& rect) { dirty_region.add(rect); };
+
+    for (size_t i = 0; i < strokes.size(); i++) {
+        const Stroke& stroke = strokes[i];
+        const InkPen pen     = InkPen::draw(i % INK_PALETTE_SIZE);
+        dirty(brush.begin(layer, tip, pen, stroke[0].x, stroke[0].y));
+        smoother.begin(stroke[0].x, stroke[0].y, BRUSH_SIZE * 0.5f);
+        auto line_to = [&](const StrokePoint& p) { dirty(brush.lineTo(layer, std::lround(p.x), std::lround(p.y))); };
+        for (size_t j = 1; j < stroke.size(); j++) {
+            smoother.addPoint(stroke[j].x, stroke[j].y, line_to);
+            if (j % 2 == 0) refresh();
+        }
+        smoother.finish(line_to);
+        brush.end();
+        refresh();
+    }
+    stats.us     = us / refreshes;
+    stats.pixels = (stats.pixels + pyramid.getStats().pixels) / refreshes;
+    return stats;
+}
+
+void bench_viewport()
+{
+    mclog::tagInfo(_tag, "--- viewport: zoomed-out drawing, brush {} px ---", BRUSH_SIZE);
+
+    const auto strokes = make_handwriting(20, 64);
+    const float zooms[] = {0.5f, 0.25f, 0.125f};
+    for (float zoom : zooms) {
+        Viewport viewport;
+        viewport.init(CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH, CANVAS_HEIGHT);
+        viewport.zoomAt(zoom, CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2);
+
+        // 変わった範囲だけ反映した表示と、毎回全体から作り直した表示は一致する
+        std::vector<uint16_t> incremental_view;
+        std::vector<uint16_t> full_view;
+        ViewStats incremental = run_view_case(viewport, strokes, true, incremental_view);
+        ViewStats full        = run_view_case(viewport, strokes, false, full_view);
+        mclog::tagInfo(_tag,
+                       "zoom {:>5.3f} (level {}): incremental {:>6.1f} us {:>6} px | full rescale {:>7.1f} us "
+                       "{:>7} px | identical {}",
+                       viewport.zoom(), viewport.level(), incremental.us, incremental.pixels, full.us, full.pixels,
+                       incremental_view == full_view);
+    }
+
+    // タイルごとに縮小した段は、キャンバス全体を縮小した段と一致する
+    InkLayer layer;
+    layer.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    for (size_t i = 0; i < strokes.size(); i++) {
+        draw_stroke(layer, tip, InkPen::draw(i % INK_PALETTE_SIZE), strokes[i]);
+    }
+    std::vector<uint16_t> level_pixels[MipPyramid::MAX_LEVELS + 1];
+    PixelBuffer565 levels[MipPyramid::MAX_LEVELS + 1];
+    for (int k = 0; k <= MipPyramid::MAX_LEVELS; k++) {
+        const int32_t w = (CANVAS_WIDTH + (1 << k) - 1) >> k;
+        const int32_t h = (CANVAS_HEIGHT + (1 << k) - 1) >> k;
+        level_pixels[k].resize((size_t)w * h);
+        levels[k] = PixelBuffer565{level_pixels[k].data(), w, h, w};
+        if (k == 0) {
+            layer.composite(layer.bounds(), PixelBuffer565(), 0xFFFF, levels[0]);
+        } else {
+            downsample_565(levels[k - 1], levels[k], levels[k].bounds());
+        }
+    }
+
+    MipPyramid pyramid;
+    pyramid.init(CANVAS_WIDTH, CANVAS_HEIGHT, SIZE_MAX, 0xFFFF, compose_ink(layer));
+    for (int k = 0; k <= MipPyramid::MAX_LEVELS; k++) {
+        const PixelBuffer565& level = levels[k];
+
+        pyramid.setLevel(k);
+        const int32_t size = pyramid.tileSize();
+        bool identical     = true;
+        auto start         = std::chrono::steady_clock::now();
+        for (int i = 0; i < layer.grid().count(); i++) {
+            const uint16_t* src = pyramid.tile(i);
+            const Rect rect     = layer.grid().tileRect(i);
+            const int32_t x0 = rect.x1 >> k, y0 = rect.y1 >> k;
+            for (int32_t y = y0; y < std::min(y0 + size, level.height); y++) {
+                const int32_t w = std::min(size, level.width - x0);
+                identical &= std::memcmp(level.row(y) + x0, src + (y - y0) * size, w * sizeof(uint16_t)) == 0;
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        mclog::tagInfo(_tag, "level {} tiles from scratch: {:.2f} ms, {} cached ({} bytes), matches full rescale {}",
+                       k, std::chrono::duration<double, std::milli>(end - start).count(), pyramid.cachedCount(),
+                       pyramid.bytes(), identical);
+    }
+
+    // 倍率を変えたときの全画面の描き直し（段を変えてタイルを作り直す場合と、タイルがすでに最新の場合）
+    std::vector<uint16_t> view_pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 view = {view_pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    auto tile           = [&](int index) { return pyramid.tile(index); };
+    const float view_zooms[] = {4.0f, 1.5f, 0.7f, 0.3f, 0.125f};
+    for (float zoom : view_zooms) {
+        Viewport viewport;
+        viewport.init(CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH, CANVAS_HEIGHT);
+        viewport.zoomAt(zoom, 300, 200);
+        auto start = std::chrono::steady_clock::now();
+        pyramid.setLevel(viewport.level());
+        viewport.render(view, view.bounds(), 0x3186, tile);
+        auto end       = std::chrono::steady_clock::now();
+        double cold_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        start          = std::chrono::steady_clock::now();
+        for (int i = 0; i < 10; i++) {
+            viewport.render(view, view.bounds(), 0x3186, tile);
+        }
+        end = std::chrono::steady_clock::now();
+        mclog::tagInfo(_tag, "full view render at zoom {:>5.3f} (level {}): new level {:.2f} ms, cached {:.2f} ms",
+                       viewport.zoom(), viewport.level(), cold_ms,
+                       std::chrono::duration<double, std::milli>(end - start).count() / 10);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               Virtual canvas                               */
+/* -------------------------------------------------------------------------- */
+void bench_virtual_canvas()
+{
+    constexpr int32_t width        = 4096;
+    constexpr int32_t height       = 4096;
+    constexpr size_t ink_budget    = 1024 * 1024;
+    constexpr size_t view_budget   = 2 * 1024 * 1024;
+    const std::string path         = "/tmp/drawing_bench_tiles.bin";
+    const size_t nominal           = (size_t)width * height * sizeof(uint16_t);
+    mclog::tagInfo(_tag, "--- virtual canvas: {}x{}, screen {}x{}, ink budget {} KB, view budget {} KB ---", width,
+                   height, CANVAS_WIDTH, CANVAS_HEIGHT, ink_budget / 1024, view_budget / 1024);
+
+    TilePageFile page_file;
+    if (!page_file.open(path, InkLayer::TILE_BYTES)) {
+        mclog::tagWarn(_tag, "cannot open {}", path);
+        return;
+    }
+
+    // 上限と追い出し先を持つレイヤーと、同じ内容をすべてメモリに置く比較用のレイヤー
+    InkLayer layer;
+    layer.init(width, height);
+    layer.setPageFile(&page_file);
+    layer.setResidentBudget(ink_budget);
+    InkLayer reference;
+    reference.init(width, height);
+
+    Viewport viewport;
+    viewport.init(width, height, CANVAS_WIDTH, CANVAS_HEIGHT);
+    MipPyramid pyramid;
+    pyramid.init(width, height, view_budget, 0xFFFF, compose_ink(layer));
+    std::vector<uint16_t> view_pixels(CANVAS_WIDTH * CANVAS_HEIGHT);
+    PixelBuffer565 view = {view_pixels.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    auto tile           = [&](int index) { return pyramid.tile(index); };
+
+    // キャンバスの上を蛇行しながらずらし、表示範囲に描いてから描き直して上限まで減らす
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    const auto strokes = make_handwriting(64, 48);
+    size_t next        = 0;
+    size_t peak_ink    = 0;
+    size_t peak_view   = 0;
+    double draw_ms     = 0.0;
+    double pan_ms      = 0.0;
+    int pans           = 0;
+    for (int row = 0; row < 6; row++) {
+        for (int col = 0; col < 4; col++, pans++) {
+            const Rect visible = viewport.visibleRect();
+            auto start         = std::chrono::steady_clock::now();
+            for (int i = 0; i < 4; i++, next++) {
+                Stroke stroke = strokes[next % strokes.size()];
+                for (auto& p : stroke) {
+                    p.x += visible.x1;
+                    p.y += visible.y1;
+                }
+                const InkPen pen = InkPen::draw(next % INK_PALETTE_SIZE);
+                draw_stroke(layer, tip, pen, stroke);
+                draw_stroke(reference, tip, pen, stroke);
+                pyramid.invalidate(visible);
+            }
+            auto end = std::chrono::steady_clock::now();
+            draw_ms += std::chrono::duration<double, std::milli>(end - start).count();
+
+            start = std::chrono::steady_clock::now();
+            viewport.panBy(row % 2 == 0 ? -900.0f : 900.0f, 0.0f);
+            if (col == 3) viewport.panBy(0.0f, -650.0f);
+            pyramid.setLevel(viewport.level());
+            viewport.render(view, view.bounds(), 0x3186, tile);
+            peak_ink  = std::max(peak_ink, layer.allocatedBytes());
+            peak_view = std::max(peak_view, pyramid.bytes());
+            layer.setPinnedArea(viewport.visibleRect());
+            layer.trim();
+            pyramid.trim(viewport.visibleRect());
+            end = std::chrono::steady_clock::now();
+            pan_ms += std::chrono::duration<double, std::milli>(end - start).count();
+        }
+    }
+
+    // 全体を見渡す縮小表示でも、上限を超えた分は追い出して描ける
+    viewport.zoomAt(Viewport::MIN_ZOOM, 0.0f, 0.0f);
+    pyramid.setLevel(viewport.level());
+    auto start = std::chrono::steady_clock::now();
+    viewport.render(view, view.bounds(), 0x3186, tile);
+    auto end         = std::chrono::steady_clock::now();
+    double overview  = std::chrono::duration<double, std::milli>(end - start).count();
+    peak_ink         = std::max(peak_ink, layer.allocatedBytes());
+    peak_view        = std::max(peak_view, pyramid.bytes());
+    layer.setPinnedArea(viewport.visibleRect());
+    int overview_out = layer.trim();
+    pyramid.trim(viewport.visibleRect());
+
+    const auto& pages = layer.getPageStats();
+    mclog::tagInfo(_tag, "{} pans: draw {:.2f} ms, render + trim {:.2f} ms per pan; overview render {:.2f} ms", pans,
+                   draw_ms / pans, pan_ms / pans, overview);
+    mclog::tagInfo(_tag, "ink tiles {} (resident {}, paged {}), page out {} / in {} / peek {} / failed {}, file {} KB",
+                   layer.tileCount(), layer.residentCount(), layer.pagedCount(), pages.pageOuts, pages.pageIns,
+                   pages.peeks, pages.failures, page_file.fileBytes() / 1024);
+    mclog::tagInfo(_tag,
+                   "memory: ink {} KB (peak {} KB, all resident {} KB), view {} KB (peak {} KB) vs full canvas "
+                   "{} KB; overview paged out {}",
+                   layer.allocatedBytes() / 1024, peak_ink / 1024, reference.allocatedBytes() / 1024,
+                   pyramid.bytes() / 1024, peak_view / 1024, nominal / 1024, overview_out);
+
+    // 追い出したタイルを読み戻しても内容は変わらない（読み戻すたびに上限まで追い出し直す）
+    bool identical = layer.tileCount() == reference.tileCount();
+    layer.setPinnedArea(Rect());
+    for (int i = 0; i < reference.grid().count() && identical; i++) {
+        if (!reference.hasTile(i)) continue;
+        identical = layer.hasTile(i) && std::memcmp(layer.tile(i), reference.tile(i), InkLayer::TILE_BYTES) == 0;
+        layer.trim();
+    }
+    mclog::tagInfo(_tag, "paged tiles round-trip intact: {} (page in {})", identical, layer.getPageStats().pageIns);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Multi-touch                                */
+/* -------------------------------------------------------------------------- */
+// 2 本ずつ同時に描いたストロークを、指ごとのサンプルが交互に届く順で記録する
+void record_finger_pairs(StrokeLog& log, const std::vector<Stroke>& strokes)
+{
+    uint32_t time = 1000;
+    for (size_t i = 0; i + 1 < strokes.size(); i += 2) {
+        const Stroke& a = strokes[i];
+        const Stroke& b = strokes[i + 1];
+        log.beginStroke(time, 0, i % INK_PALETTE_SIZE, BRUSH_SIZE, 0, 0, 0, a[0].x, a[0].y, 0);
+        log.beginStroke(time, 0, (i + 1) % INK_PALETTE_SIZE, BRUSH_SIZE, 0, 0, 0, b[0].x, b[0].y, 1);
+        for (size_t j = 1; j < std::max(a.size(), b.size()); j++) {
+            time += 4;
+            if (j < a.size()) log.addPoint(time, a[j].x, a[j].y, 0);
+            if (j < b.size()) log.addPoint(time, b[j].x, b[j].y, 1);
+        }
+        log.endStroke(time, 0);
+        log.endStroke(time, 1);
+        time += 300;
+    }
+}
+
+void bench_multi_touch()
+{
+    mclog::tagInfo(_tag, "--- multi-touch: concurrent strokes and pinch ---");
+
+    // 同時に描いたストロークは指が切り替わるたびに 1 レコード増える
+    auto strokes = make_handwriting(60, 64);
+    StrokeLog sequential, paired;
+    sequential.init(1024 * 1024);
+    paired.init(1024 * 1024);
+    record_strokes(sequential, strokes);
+    record_finger_pairs(paired, strokes);
+    mclog::tagInfo(_tag, "log: one finger {:.2f} B/pt, two fingers interleaved {:.2f} B/pt",
+                   sequential.getStats().bytesPerPoint(), paired.getStats().bytesPerPoint());
+
+    // 書き出しは 1 本ずつ描いた場合と一致し、同時に描いた 2 本は 1 回のアンドゥで消える
+    InkLayer canvas;
+    canvas.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+    ExportOptions options;
+    options.scale     = 1;
+    auto export_image = [&](const StrokeLog& log, std::vector<uint16_t>& image) {
+        image.resize((size_t)CANVAS_WIDTH * CANVAS_HEIGHT);
+        return export_stroke_log(log, canvas, PixelBuffer565(), options, [&](int32_t y, const PixelBuffer565& band) {
+            for (int32_t row = 0; row < band.height; row++) {
+                std::memcpy(&image[(size_t)(y + row) * CANVAS_WIDTH], band.row(row), band.width * sizeof(uint16_t));
+            }
+        });
+    };
+    std::vector<uint16_t> sequential_image, paired_image;
+    export_image(sequential, sequential_image);
+    const uint32_t strokes_before = export_image(paired, paired_image).strokes;
+    const bool same               = sequential_image == paired_image;
+    paired.event(StrokeEvent::UNDO, 1000000);
+    const uint32_t strokes_after = export_image(paired, paired_image).strokes;
+    mclog::tagInfo(_tag, "export: {} strokes, identical to one finger {}, one undo removes {} strokes",
+                   strokes_before, same, strokes_before - strokes_after);
+
+    // 指の間隔を 200 px から 400 px に広げる（サンプルは 1 本ずつ 2 px 動く）。倍率を開始時からの比で
+    // 決めると 2 倍になるが、サンプルごとの比を掛けていくと 1 回の変化が小さく、等倍にそろえられて動かない
+    Viewport pinched, relative;
+    pinched.init(CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH, CANVAS_HEIGHT);
+    relative.init(CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH, CANVAS_HEIGHT);
+    int32_t focus_x = 0, focus_y = 0;
+    pinched.toCanvas(CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2, focus_x, focus_y);
+
+    PinchGesture pinch;
+    float xs[2] = {CANVAS_WIDTH / 2 - 100.0f, CANVAS_WIDTH / 2 + 100.0f};
+    const float y = CANVAS_HEIGHT / 2;
+    pinch.begin(0, xs[0], y, 1, xs[1], y, pinched.zoom());
+    for (int step = 0; step < 100; step++) {
+        const int finger = step % 2;
+        const float span = xs[1] - xs[0];
+        xs[finger] += finger == 0 ? -2.0f : 2.0f;
+
+        PinchGesture::Update_t update;
+        pinch.move(finger, xs[finger], y, update);
+        pinched.panBy(update.panX, update.panY);
+        pinched.zoomAt(update.zoom / pinched.zoom(), update.focusX, update.focusY);
+        relative.zoomAt((xs[1] - xs[0]) / span, (xs[0] + xs[1]) * 0.5f, y);
+    }
+    int32_t after_x = 0, after_y = 0;
+    pinched.toCanvas(CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2, after_x, after_y);
+    mclog::tagInfo(_tag, "pinch 200 -> 400 px: zoom {:.2f}, focus stays on canvas ({}, {}) -> ({}, {}); "
+                   "per-sample factors reach zoom {:.2f}", pinched.zoom(), focus_x, focus_y, after_x, after_y,
+                   relative.zoom());
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 Flood fill                                 */
+/* -------------------------------------------------------------------------- */
+void run_fill_case(const char* name, FloodFill& fill, const PixelBuffer565& buffer, const std::vector<uint16_t>& source,
+                   int32_t x, int32_t y, int tolerance)
+{
+    std::vector<uint16_t> pixels = source;
+    PixelBuffer565 target        = {pixels.data(), buffer.width, buffer.height, buffer.width};
+    uint64_t spans               = 0;
+
+    auto start  = std::chrono::steady_clock::now();
+    auto result = fill.fillSpans(target, x, y, tolerance, [&](const Rect&) { spans++; });
+    auto end    = std::chrono::steady_clock::now();
+    double ms   = std::chrono::duration<double, std::milli>(end - start).count();
+
+    mclog::tagInfo(_tag, "{:<22} {:>8} px, {:>6} spans, {:>3} overflows, {:>7.2f} ms", name, result.pixels, spans,
+                   result.overflows, ms);
+}
+
+void bench_flood_fill()
+{
+    mclog::tagInfo(_tag, "--- flood fill: {}x{} canvas ---", CANVAS_WIDTH, CANVAS_HEIGHT);
+
+    PixelBuffer565 buffer = {nullptr, CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    FloodFill fill;
+    fill.init(CANVAS_WIDTH, CANVAS_HEIGHT);
+
+    // 白紙を丸ごと塗る（最悪ケースの面積）
+    std::vector<uint16_t> blank(CANVAS_WIDTH * CANVAS_HEIGHT, 0xFFFF);
+    run_fill_case("blank, exact", fill, buffer, blank, CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2, 0);
+
+    // 写真を模したノイズ入りの背景を許容差ありで塗る
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> noise(-2, 2);
+    std::vector<uint16_t> photo(CANVAS_WIDTH * CANVAS_HEIGHT);
+    for (auto& p : photo) {
+        int g = std::clamp(40 + noise(gen), 0, 63);
+        p     = (uint16_t)((20 << 11) | (g << 5) | 20);
+    }
+    run_fill_case("noisy photo, tol 24", fill, buffer, photo, CANVAS_WIDTH / 2, CANVAS_HEIGHT / 2, 24);
+
+    // ストロークで区切られた白紙（区間が多く分岐する）
+    std::vector<uint16_t> drawn = blank;
+    PixelBuffer565 drawn_buffer = {drawn.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+    RasterStats stats;
+    for (const auto& stroke : make_fast_swipes(60, 12)) {
+        capsule_stroke(drawn_buffer, stroke, 0x0000, stats);
+    }
+    run_fill_case("strokes, exact", fill, buffer, drawn, 0, 0, 0);
+
+    // 小さいスタックでも結果は同じ（溢れた区間は拾い直す）
+    FloodFill small_fill;
+    small_fill.init(CANVAS_WIDTH, CANVAS_HEIGHT, 16);
+    run_fill_case("strokes, stack 16", small_fill, buffer, drawn, 0, 0, 0);
+}
+
+// アプリと同じく、インクのレイヤーの合成結果で領域を求めてからアンドゥ用に保存して塗り、取り消して元に戻す
+void run_ink_fill_case(const char* name, InkLayer& layer, FloodFill& fill, UndoHistory& history, const Rect& area,
+                       bool tiled)
+{
+    InkCompositePixels pixels(layer, PixelBuffer565(), 0xFFFF);
+
+    auto start  = std::chrono::steady_clock::now();
+    auto result = fill.fillSpans(pixels, 2, 2, 0, area, [](const Rect&) {});
+    auto mid    = std::chrono::steady_clock::now();
+    history.beginStep();
+    if (tiled) {
+        fill.forEachFilledTile(
+            result.bounds, layer.grid(),
+            [&](int index) {
+                history.captureTile(layer, index);
+                layer.fillTile(index, 1);
+            },
+            [&](int index, const Rect& span) {
+                history.captureTile(layer, index);
+                layer.fillSpan(span.y1, span.x1, span.x2, 1);
+            });
+    } else {
+        fill.forEachFilledTile(
+            result.bounds, layer.grid(),
+            [&](int index) {
+                const Rect rect = layer.grid().tileRect(index);
+                history.captureTile(layer, index);
+                for (int32_t y = rect.y1; y <= rect.y2; y++) {
+                    layer.fillSpan(y, rect.x1, rect.x2, 1);
+                }
+            },
+            [&](int index, const Rect& span) {
+                history.captureTile(layer, index);
+                layer.fillSpan(span.y1, span.x1, span.x2, 1);
+            });
+    }
+    history.endStep();
+    auto end         = std::chrono::steady_clock::now();
+    double search_ms = std::chrono::duration<double, std::milli>(mid - start).count();
+    double write_ms  = std::chrono::duration<double, std::milli>(end - mid).count();
+
+    const auto undo = history.getStats();
+    mclog::tagInfo(_tag, "{:<20} {:>8} px, search {:>7.1f} ms, write {:>6.1f} ms, resident {:>6} KB, solid {:>4}, "
+                   "undo {:>4} KB, levels {}", name, result.pixels, search_ms, write_ms, layer.bytes() / 1024,
+                   layer.solidCount(), undo.bytes / 1024, undo.undoLevels);
+    history.undo(layer, [](const Rect&) {});
+    history.clear();
+    layer.trim();
+}
+
+void bench_ink_fill()
+{
+    constexpr int32_t size = 4096;
+    mclog::tagInfo(_tag, "--- ink fill: {}x{} ink layer through InkCompositePixels, undo budget 1 MB ---", size, size);
+
+    InkLayer layer;
+    layer.init(size, size);
+    layer.setPaletteColor(0, 0x0000);
+    layer.setPaletteColor(1, 0xF800);
+    FloodFill fill;
+    fill.init(size, size);
+    UndoHistory history;
+    history.init(size, size, 1024 * 1024);
+
+    // 白紙のあちこちに区切りになるストロークを描く（(2, 2) は描かれない位置）
+    Brush tip;
+    tip.setSize(BRUSH_SIZE);
+    const auto strokes = make_handwriting(24, 48);
+    for (int32_t oy = 64; oy < size - CANVAS_HEIGHT; oy += 1200) {
+        for (int32_t ox = 64; ox < size - CANVAS_WIDTH; ox += 1400) {
+            for (Stroke stroke : strokes) {
+                for (auto& p : stroke) {
+                    p.x += ox;
+                    p.y += oy;
+                }
+                draw_stroke(layer, tip, InkPen::draw(0), stroke);
+            }
+        }
+    }
+    layer.trim();
+    mclog::tagInfo(_tag, "strokes: {} tiles, {} KB", layer.residentCount(), layer.bytes() / 1024);
+
+    // 白紙全体（以前のアプリと同じ範囲）を区間ごとに塗ると、縁以外のタイルもすべて確保される
+    const Rect canvas = {0, 0, size - 1, size - 1};
+    run_ink_fill_case("canvas, spans", layer, fill, history, canvas, false);
+    run_ink_fill_case("canvas, solid tiles", layer, fill, history, canvas, true);
+    run_ink_fill_case("screen, solid tiles", layer, fill, history, Rect{0, 0, CANVAS_WIDTH - 1, CANVAS_HEIGHT - 1},
+                      true);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Camera scale                                */
+/* -------------------------------------------------------------------------- */
+void bench_camera_scale()
+{
+    mclog::tagInfo(_tag, "--- camera frame scale: 640x480 -> {}x{} ---", CANVAS_WIDTH, CANVAS_HEIGHT);
+
+    // 横方向と縦方向のグラデーション（補間の段差が出やすい）
+    std::vector<uint16_t> frame(640 * 480);
+    for (int y = 0; y < 480; y++) {
+        for (int x = 0; x < 640; x++) {
+            frame[y * 640 + x] = (uint16_t)(((x * 31 / 639) << 11) | ((y * 63 / 479) << 5) | ((x + y) & 0x1F));
+        }
+    }
+    std::vector<uint16_t> canvas(CANVAS_WIDTH * CANVAS_HEIGHT);
+    const ImageScaler::Image565_t src = {frame.data(), 640, 480, 640};
+    const ImageScaler::Image565_t dst = {canvas.data(), CANVAS_WIDTH, CANVAS_HEIGHT, CANVAS_WIDTH};
+
+    static const struct {
+        ImageScaler::Policy_t policy;
+        const char* name;
+    } policies[] = {
+        {ImageScaler::POLICY_CROP, "crop"},
+        {ImageScaler::POLICY_FIT, "fit"},
+        {ImageScaler::POLICY_FILL, "fill"},
+    };
+    static const struct {
+        ImageScaler::Filter_t filter;
+        const char* name;
+    } filters[] = {{ImageScaler::FILTER_NEAREST, "nearest"}, {ImageScaler::FILTER_BILINEAR, "bilinear"}};
+
+    constexpr int REPEAT = 10;
+    ImageScaler scaler;
+    for (const auto& policy : policies) {
+        for (const auto& filter : filters) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < REPEAT; i++) {
+                scaler.scale(src, dst, policy.policy, filter.filter, 0xFFFF);
+            }
+            auto end  = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count() / REPEAT;
+
+            const auto map = ImageScaler::mapping(640, 480, CANVAS_WIDTH, CANVAS_HEIGHT, policy.policy);
+            mclog::tagInfo(_tag, "{:<5} {:<9} src {:>3}x{:<3} -> dst {:>4}x{:<3} {:>7.2f} ms", policy.name,
+                           filter.name, map.srcW, map.srcH, map.dstW, map.dstH, ms);
+        }
+    }
+}
+
+}  // namespace
+
+void drawing::run_benchmarks()
+{
+    mclog::tagInfo(_tag, "drawing benchmarks start");
+    bench_stroke_raster();
+    bench_brush_stamp();
+    bench_brush_sizes();
+    bench_ink_layer();
+    bench_ink_format();
+    bench_undo_history();
+    bench_stroke_log();
+    bench_export();
+    bench_symmetry();
+    bench_shapes();
+    bench_viewport();
+    bench_virtual_canvas();
+    bench_multi_touch();
+    bench_flood_fill();
+    bench_ink_fill();
+    bench_camera_scale();
+    mclog::tagInfo(_tag, "drawing benchmarks done");
+}
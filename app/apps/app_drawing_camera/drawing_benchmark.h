@@ -0,0 +1,17 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+
+namespace drawing {
+
+/**
+ * @brief 描画処理のベンチマークを実行して結果をログに出力する
+ *
+ * UI を起動せずに単体で実行する想定（デスクトップ版の --bench オプション）
+ */
+void run_benchmarks();
+
+}  // namespace drawing
@@ -0,0 +1,59 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "flood_fill.h"
+#include <cstring>
+
+using namespace drawing;
+
+void FloodFill::init(int32_t width, int32_t height, size_t stackCapacity)
+{
+    _width         = width;
+    _height        = height;
+    _words_per_row = (width + 31) / 32;
+    _filled.assign((size_t)_words_per_row * height, 0);
+    _stack.resize(std::max<size_t>(stackCapacity, 16));
+    _stack_size = 0;
+}
+
+void FloodFill::reset_filled(const Rect& area)
+{
+    Rect rect = area.intersect(Rect{0, 0, _width - 1, _height - 1});
+    if (rect.isEmpty()) return;
+    std::memset(&_filled[rect.y1 * _words_per_row], 0, (size_t)rect.height() * _words_per_row * sizeof(uint32_t));
+}
+
+void FloodFill::mark_filled(int32_t y, int32_t x1, int32_t x2)
+{
+    uint32_t* row = &_filled[y * _words_per_row];
+    int32_t w1    = x1 >> 5;
+    int32_t w2    = x2 >> 5;
+    uint32_t m1   = ~0u << (x1 & 31);
+    uint32_t m2   = ~0u >> (31 - (x2 & 31));
+    if (w1 == w2) {
+        row[w1] |= m1 & m2;
+        return;
+    }
+    row[w1] |= m1;
+    for (int32_t w = w1 + 1; w < w2; w++) {
+        row[w] = ~0u;
+    }
+    row[w2] |= m2;
+}
+
+bool FloodFill::is_span_filled(int32_t y, int32_t x1, int32_t x2) const
+{
+    const uint32_t* row = &_filled[y * _words_per_row];
+    int32_t w1          = x1 >> 5;
+    int32_t w2          = x2 >> 5;
+    uint32_t m1         = ~0u << (x1 & 31);
+    uint32_t m2         = ~0u >> (31 - (x2 & 31));
+    if (w1 == w2) return (row[w1] & m1 & m2) == (m1 & m2);
+    if ((row[w1] & m1) != m1 || (row[w2] & m2) != m2) return false;
+    for (int32_t w = w1 + 1; w < w2; w++) {
+        if (row[w] != ~0u) return false;
+    }
+    return true;
+}
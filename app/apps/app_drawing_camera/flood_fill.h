@@ -0,0 +1,317 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "tile_canvas.h"
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief スキャンライン単位の塗りつぶし（バケツツール）
+ *
+ * 区間（行・左右端・進行方向）を固定容量のスタックに積んで処理する。再帰やピクセル単位のキューは使わず、
+ * 必要なメモリは init() で確保したスタックと塗り済みビットマップだけ。
+ * スタックが溢れた場合は区間を捨てて続行し、後で塗り済み領域の周囲を走査して取りこぼしを拾い直すため、
+ * 容量が小さくても結果は変わらない（時間が余分にかかるだけ）。
+ */
+class FloodFill {
+public:
+    static constexpr size_t DEFAULT_STACK_CAPACITY = 8192;
+
+    struct Result_t {
+        Rect bounds;             // 塗った範囲（これだけ無効化すればよい）
+        uint32_t pixels    = 0;  // 塗ったピクセル数
+        uint32_t overflows = 0;  // スタックが溢れて拾い直した回数
+    };
+
+    /**
+     * @brief 作業領域を確保する
+     *
+     * @param width 塗る対象の最大サイズ
+     * @param height
+     * @param stackCapacity 区間スタックの容量（1 区間 8 バイト）
+     */
+    void init(int32_t width, int32_t height, size_t stackCapacity = DEFAULT_STACK_CAPACITY);
+
+    /**
+     * @brief (x, y) とつながった同じ色の領域を塗る
+     *
+     * @param tolerance 0 なら完全一致、それ以外は RGB 各チャンネル（0 ~ 255 換算）の差がこれ以下なら同じ色とみなす
+     * @param beforeWrite void(const Rect&) 各区間を塗る直前に呼ばれる（アンドゥ用の保存など）
+     */
+    template <typename BeforeWriteFn>
+    Result_t fill(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color, int tolerance,
+                  BeforeWriteFn&& beforeWrite)
+    {
+        if (!buffer.data || !contains(buffer, x, y)) return Result_t();
+
+        // 許容誤差なしで同じ色を塗っても何も変わらない
+        if (tolerance <= 0 && buffer.pixel(x, y) == color) return Result_t();
+        return fillSpans(buffer, x, y, tolerance, [&](const Rect& span) {
+            beforeWrite(span);
+            fill_span_565(buffer.row(span.y1) + span.x1, span.width(), color);
+        });
+    }
+
+    Result_t fill(const PixelBuffer565& buffer, int32_t x, int32_t y, uint16_t color, int tolerance = 0)
+    {
+        return fill(buffer, x, y, color, tolerance, [](const Rect&) {});
+    }
+
+    /**
+     * @brief (x, y) とつながった同じ色の領域を区間ごとに通知する（pixels は変更しない）
+     *
+     * 判定に使う画像と塗る先が別の場合（合成結果を見てインクのレイヤーに塗るなど）に使う。
+     * 通知した区間の画素は以降読まないので、write の中で判定元の画像が変わってもよい。
+     *
+     * @param pixels width・height と pixel(x, y) を持つ画像（PixelBuffer565、InkCompositePixels など）
+     * @param area 領域を広げる範囲（画像の外は含まない。広いキャンバスで白紙全体に広がらないように制限する）
+     * @param write void(const Rect&) 1 行の区間ごとに呼ばれる
+     */
+    template <typename Pixels, typename WriteFn>
+    Result_t fillSpans(const Pixels& pixels, int32_t x, int32_t y, int tolerance, const Rect& area, WriteFn&& write)
+    {
+        const Rect clip = area.intersect(Rect{0, 0, pixels.width - 1, pixels.height - 1});
+        if (!contains(pixels, x, y) || x < clip.x1 || x > clip.x2 || y < clip.y1 || y > clip.y2) return Result_t();
+
+        const uint16_t target = pixels.pixel(x, y);
+        if (tolerance <= 0) {
+            ExactMatch match = {target};
+            return run(pixels, x, y, clip, match, write);
+        }
+        ToleranceMatch match(target, tolerance);
+        return run(pixels, x, y, clip, match, write);
+    }
+
+    template <typename Pixels, typename WriteFn>
+    Result_t fillSpans(const Pixels& pixels, int32_t x, int32_t y, int tolerance, WriteFn&& write)
+    {
+        return fillSpans(pixels, x, y, tolerance, Rect{0, 0, pixels.width - 1, pixels.height - 1}, write);
+    }
+
+    /**
+     * @brief 直前に塗った画素をタイルごとに通知する（fillSpans() で区間を書かずに、後でタイル単位で書く場合に使う）
+     *
+     * タイル全体を塗ったタイルは 1 回の full で、それ以外はタイル内の 1 行の区間ごとに span で通知する。
+     * タイルの番号は行ごとに cols 個並ぶ順。
+     *
+     * @param bounds 直前の Result_t::bounds
+     * @param grid タイルの区切り
+     * @param full void(int index) タイル全体を塗った
+     * @param span void(int index, const Rect& span) タイル内の区間
+     */
+    template <typename FullFn, typename SpanFn>
+    void forEachFilledTile(const Rect& bounds, const TileGrid& grid, FullFn&& full, SpanFn&& span) const
+    {
+        grid.forEachTileIn(bounds, [&](int index) {
+            const Rect tile = grid.tileRect(index);
+            const Rect clip = tile.intersect(bounds);
+            if (clip.x1 == tile.x1 && clip.x2 == tile.x2 && clip.y1 == tile.y1 && clip.y2 == tile.y2) {
+                bool all = true;
+                for (int32_t y = tile.y1; y <= tile.y2 && all; y++) {
+                    all = is_span_filled(y, tile.x1, tile.x2);
+                }
+                if (all) {
+                    full(index);
+                    return;
+                }
+            }
+            for (int32_t y = clip.y1; y <= clip.y2; y++) {
+                for_each_filled_run(y, clip.x1, clip.x2, [&](int32_t x1, int32_t x2) {
+                    span(index, Rect{x1, y, x2, y});
+                });
+            }
+        });
+    }
+
+private:
+    struct Segment_t {
+        int16_t x1;
+        int16_t x2;
+        int16_t y;
+        int16_t dy;
+    };
+
+    struct ExactMatch {
+        uint16_t target;
+        bool operator()(uint16_t pixel) const
+        {
+            return pixel == target;
+        }
+    };
+
+    struct ToleranceMatch {
+        int r, g, b, tolerance;
+        ToleranceMatch(uint16_t target, int tol)
+            : r((target >> 11) << 3), g(((target >> 5) & 0x3F) << 2), b((target & 0x1F) << 3), tolerance(tol)
+        {
+        }
+        bool operator()(uint16_t pixel) const
+        {
+            return std::abs(((pixel >> 11) << 3) - r) <= tolerance &&
+                   std::abs((((pixel >> 5) & 0x3F) << 2) - g) <= tolerance &&
+                   std::abs(((pixel & 0x1F) << 3) - b) <= tolerance;
+        }
+    };
+
+    int32_t _width         = 0;
+    int32_t _height        = 0;
+    int32_t _words_per_row = 0;
+    std::vector<uint32_t> _filled;  // 塗り済みビットマップ（1 ピクセル 1 ビット）
+    std::vector<Segment_t> _stack;  // 容量固定の区間スタック
+    size_t _stack_size = 0;
+    bool _overflowed   = false;
+
+    void reset_filled(const Rect& area);
+    void mark_filled(int32_t y, int32_t x1, int32_t x2);
+    bool is_span_filled(int32_t y, int32_t x1, int32_t x2) const;
+    bool is_filled(int32_t x, int32_t y) const
+    {
+        return (_filled[y * _words_per_row + (x >> 5)] >> (x & 31)) & 1;
+    }
+
+    // 行の x1 ~ x2 で塗り済みのビットが続く区間を fn(x1, x2) で列挙する
+    template <typename Fn>
+    void for_each_filled_run(int32_t y, int32_t x1, int32_t x2, Fn&& fn) const
+    {
+        const uint32_t* row = &_filled[y * _words_per_row];
+        int32_t x           = x1;
+        while (x <= x2) {
+            // 次の塗り済みのビット
+            uint32_t word = row[x >> 5] & (~0u << (x & 31));
+            while (!word && (x | 31) < x2) {
+                x    = (x | 31) + 1;
+                word = row[x >> 5];
+            }
+            if (!word) return;
+            const int32_t start = (x & ~31) + __builtin_ctz(word);
+            if (start > x2) return;
+
+            // 続く塗っていないビット
+            x    = start;
+            word = ~row[x >> 5] & (~0u << (x & 31));
+            while (!word && (x | 31) < x2) {
+                x    = (x | 31) + 1;
+                word = ~row[x >> 5];
+            }
+            const int32_t end = word ? (x & ~31) + __builtin_ctz(word) : (x | 31) + 1;
+            fn(start, std::min(end - 1, x2));
+            x = end;
+        }
+    }
+
+    void push(int32_t x1, int32_t x2, int32_t y, int32_t dy, const Rect& area)
+    {
+        if (y < area.y1 || y > area.y2) return;
+        if (_stack_size == _stack.size()) {
+            _overflowed = true;
+            return;
+        }
+        _stack[_stack_size++] = Segment_t{(int16_t)x1, (int16_t)x2, (int16_t)y, (int16_t)dy};
+    }
+
+    template <typename Pixels>
+    bool contains(const Pixels& pixels, int32_t x, int32_t y) const
+    {
+        if (x < 0 || y < 0 || x >= pixels.width || y >= pixels.height) return false;
+        return pixels.width <= _width && pixels.height <= _height;
+    }
+
+    template <typename Pixels, typename Match, typename WriteFn>
+    Result_t run(const Pixels& pixels, int32_t seedX, int32_t seedY, const Rect& area, const Match& match,
+                 WriteFn& write)
+    {
+        Result_t result;
+
+        // 塗った色もまた一致しうる（buffer に書かない場合は常に一致する）ので、塗り済みビットマップで二度塗りを防ぐ
+        auto inside = [&](int32_t x, int32_t y) {
+            return x >= area.x1 && x <= area.x2 && !is_filled(x, y) && match(pixels.pixel(x, y));
+        };
+        auto paint = [&](int32_t y, int32_t x1, int32_t x2) {
+            Rect span = {x1, y, x2, y};
+            write(span);
+            mark_filled(y, x1, x2);
+            result.bounds.join(span);
+            result.pixels += x2 - x1 + 1;
+        };
+
+        reset_filled(area);
+        _stack_size = 0;
+        _overflowed = false;
+        push(seedX, seedX, seedY, 1, area);
+        push(seedX, seedX, seedY - 1, -1, area);
+
+        while (true) {
+            while (_stack_size > 0) {
+                Segment_t seg = _stack[--_stack_size];
+                int32_t x1 = seg.x1, x2 = seg.x2, y = seg.y, dy = seg.dy;
+
+                // 左に伸ばす
+                int32_t x = x1;
+                if (inside(x, y)) {
+                    while (inside(x - 1, y)) x--;
+                    if (x < x1) {
+                        paint(y, x, x1 - 1);
+                        push(x, x1 - 1, y - dy, -dy, area);
+                    }
+                }
+
+                // 親区間の範囲を右へ走査して、連続する区間ごとに塗る
+                while (x1 <= x2) {
+                    int32_t run_end = x1;
+                    while (inside(run_end, y)) run_end++;
+                    if (run_end > x1) paint(y, x1, run_end - 1);
+                    x1 = run_end;
+                    if (x1 > x) push(x, x1 - 1, y + dy, dy, area);
+                    if (x1 - 1 > x2) push(x2 + 1, x1 - 1, y - dy, -dy, area);
+                    x1++;
+                    while (x1 < x2 && !inside(x1, y)) x1++;
+                    x = x1;
+                }
+            }
+
+            if (!_overflowed) break;
+
+            // 捨てた区間を拾い直す：塗り済み領域に接していて、まだ塗れる区間を種として積み直す
+            result.overflows++;
+            _overflowed = false;
+            collect_seeds(result.bounds, inside, area);
+        }
+        return result;
+    }
+
+    template <typename Inside>
+    void collect_seeds(const Rect& bounds, Inside& inside, const Rect& area)
+    {
+        const int32_t y1 = std::max<int32_t>(area.y1, bounds.y1 - 1);
+        const int32_t y2 = std::min<int32_t>(area.y2, bounds.y2 + 1);
+        for (int32_t y = y1; y <= y2; y++) {
+            int32_t x = bounds.x1 - 1;
+            while (x <= bounds.x2 + 1) {
+                if (!inside(x, y)) {
+                    x++;
+                    continue;
+                }
+                int32_t run_start = x;
+                bool touches      = false;
+                while (inside(x, y)) {
+                    touches |= (y > area.y1 && is_filled(x, y - 1)) || (y < area.y2 && is_filled(x, y + 1));
+                    x++;
+                }
+                touches |= (run_start > area.x1 && is_filled(run_start - 1, y)) || (x <= area.x2 && is_filled(x, y));
+                if (touches) {
+                    push(run_start, x - 1, y, 1, area);
+                    push(run_start, x - 1, y - 1, -1, area);
+                }
+            }
+        }
+    }
+};
+
+}  // namespace drawing
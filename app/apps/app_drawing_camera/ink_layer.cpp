@@ -0,0 +1,429 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "ink_layer.h"
+#include "brush.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+using namespace drawing;
+
+namespace {
+
+// インクの被覆率（0 ~ 15）を合成率（0 ~ 32）に変換する表
+struct InkAlphaTable {
+    uint8_t value[INK_COVERAGE_MAX + 1] = {};
+
+    constexpr InkAlphaTable()
+    {
+        for (int c = 0; c <= INK_COVERAGE_MAX; c++) {
+            value[c] = (c * 32 + INK_COVERAGE_MAX / 2) / INK_COVERAGE_MAX;
+        }
+    }
+};
+constexpr InkAlphaTable INK_ALPHA = {};
+
+bool is_tile_empty(const uint8_t* data, int bytes)
+{
+    const uint32_t* words = reinterpret_cast<const uint32_t*>(data);
+    for (int i = 0; i < bytes / 4; i++) {
+        if (words[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 1 タイル内の 1 行の区間を合成する
+ *
+ * @param cells インクのセル（nullptr ならインクなし）
+ * @param photo 写真の画素（先頭から covered 画素だけ写真があり、残りは paper）
+ */
+void composite_span(const uint8_t* cells, const uint16_t* photo, int32_t covered, int32_t count, uint16_t paper,
+                    const uint16_t* palette, const uint32_t* fg, uint16_t* dst)
+{
+    // インクのないタイルは下地をそのまま写す
+    if (!cells) {
+        if (covered > 0) std::memcpy(dst, photo, covered * sizeof(uint16_t));
+        fill_span_565(dst + covered, count - covered, paper);
+        return;
+    }
+
+    for (int32_t i = 0; i < count; i++) {
+        const uint8_t cell = cells[i];
+        const uint16_t bg  = i < covered ? photo[i] : paper;
+        if (cell == 0) {
+            dst[i] = bg;
+            continue;
+        }
+        const int index    = ink_cell_index(cell);
+        const int coverage = ink_cell_coverage(cell);
+        dst[i] = coverage == INK_COVERAGE_MAX ? palette[index] : blend_565(bg, fg[index], INK_ALPHA.value[coverage]);
+    }
+}
+
+/**
+ * @brief INK_FORMAT_4BIT の 1 タイル内の 1 行の区間を合成する（表を引くだけで混色はしない）
+ *
+ * @param row タイルの行（nullptr ならインクなし）
+ * @param x 区間の先頭のタイル内の列
+ * @param lut 4 ビットの値ごとの色（0 は使わない）
+ */
+void composite_span_4bit(const uint8_t* row, int32_t x, const uint16_t* photo, int32_t covered, int32_t count,
+                         uint16_t paper, const uint16_t* lut, uint16_t* dst)
+{
+    if (!row) {
+        composite_span(nullptr, photo, covered, count, paper, nullptr, nullptr, dst);
+        return;
+    }
+
+    // 2 画素ずつ 1 バイトを読み、インクのないバイトは下地を写す（奇数の端だけ 1 画素ずつ）
+    auto pixel = [&](int32_t i, int nibble) { return nibble ? lut[nibble] : (i < covered ? photo[i] : paper); };
+    int32_t i = 0;
+    if (x & 1) {
+        dst[0] = pixel(0, get_ink_nibble(row, x));
+        i      = 1;
+    }
+    const uint8_t* bytes = row + ((x + i) >> 1);
+    for (; i + 1 < count; i += 2) {
+        const uint8_t byte = *bytes++;
+        dst[i]             = pixel(i, byte & 0x0F);
+        dst[i + 1]         = pixel(i + 1, byte >> 4);
+    }
+    if (i < count) dst[i] = pixel(i, *bytes & 0x0F);
+}
+
+// 4 ビットの値からパレットの色を引く表（値はパレット番号 + 1）
+void make_nibble_lut(const uint16_t* palette, uint16_t* lut)
+{
+    lut[0] = 0;
+    for (int i = 1; i < 16; i++) {
+        lut[i] = palette[i - 1];
+    }
+}
+
+void fill_nibbles(uint8_t* row, int32_t x, int32_t count, int value)
+{
+    if (count > 0 && (x & 1)) {
+        set_ink_nibble(row, x++, value);
+        count--;
+    }
+    std::memset(row + (x >> 1), value * 0x11, count >> 1);
+    if (count & 1) set_ink_nibble(row, x + count - 1, value);
+}
+
+}  // namespace
+
+void InkLayer::init(int32_t width, int32_t height, InkFormat format)
+{
+    clear();
+    _format = format;
+    _grid.resize(width, height);
+    _pool.init(tileBytes());
+    _tiles.assign(_grid.count(), nullptr);
+    _pages.assign(_grid.count(), -1);
+    _solid.assign(_grid.count(), -1);
+    _solid_data.clear();
+    _tile_count  = 0;
+    _paged_count = 0;
+    _solid_count = 0;
+}
+
+uint8_t* InkLayer::acquireTile(int index)
+{
+    if (uint8_t* data = writable_data(index)) return data;
+
+    uint8_t* data = _pool.acquire();
+    std::memset(data, 0, tileBytes());
+    _tiles[index] = data;
+    _tile_count++;
+    return data;
+}
+
+void InkLayer::releaseTile(int index)
+{
+    if (_solid[index] >= 0) {
+        _solid[index] = -1;
+        _solid_count--;
+        return;
+    }
+    if (_pages[index] >= 0) {
+        _page_file->discard(_pages[index]);
+        _pages[index] = -1;
+        _paged_count--;
+        return;
+    }
+    if (!_tiles[index]) return;
+    _pool.release(_tiles[index]);
+    _tiles[index] = nullptr;
+    _tile_count--;
+}
+
+void InkLayer::fillTile(int index, int paletteIndex)
+{
+    setSolidTile(index, _format == INK_FORMAT_4BIT ? (uint8_t)((paletteIndex + 1) * 0x11)
+                                                   : make_ink_cell(paletteIndex, INK_COVERAGE_MAX));
+}
+
+void InkLayer::setSolidTile(int index, uint8_t byte)
+{
+    releaseTile(index);
+    if (byte == 0) return;
+    _solid[index] = byte;
+    _solid_count++;
+}
+
+void InkLayer::releaseEmptyTiles(const Rect& area)
+{
+    _grid.forEachTileIn(area, [&](int index) {
+        if (_tiles[index] && is_tile_empty(_tiles[index], tileBytes())) releaseTile(index);
+    });
+}
+
+void InkLayer::clear()
+{
+    for (int i = 0; i < _grid.count(); i++) {
+        releaseTile(i);
+    }
+}
+
+void InkLayer::fillSpan(int32_t y, int32_t x1, int32_t x2, int index)
+{
+    // 同じ色の単色タイルは塗っても変わらないので、通常のタイルに戻さない
+    if (_format == INK_FORMAT_4BIT) {
+        forEachTileSpan(y, x1, x2 - x1 + 1, [&](int32_t x, int32_t count, int tile) {
+            if (_solid[tile] == (index + 1) * 0x11) return;
+            fill_nibbles(rowForWrite(y, tile), x % TILE_SIZE, count, index + 1);
+        });
+        return;
+    }
+
+    const uint8_t cell = make_ink_cell(index, INK_COVERAGE_MAX);
+    forEachTileSpan(y, x1, x2 - x1 + 1, [&](int32_t x, int32_t count, int tile) {
+        if (_solid[tile] == cell) return;
+        std::memset(cellsForWrite(x, y, tile), cell, count);
+    });
+}
+
+void InkLayer::clearSpan(int32_t y, int32_t x1, int32_t x2)
+{
+    forEachTileSpan(y, x1, x2 - x1 + 1, [&](int32_t x, int32_t count, int tile) {
+        uint8_t* row = rowIfAllocated(y, tile);
+        if (!row) return;
+        if (_format == INK_FORMAT_4BIT) {
+            fill_nibbles(row, x % TILE_SIZE, count, 0);
+        } else {
+            std::memset(row + x % TILE_SIZE, 0, count);
+        }
+    });
+}
+
+void InkLayer::composite(const Rect& area, const PixelBuffer565& photo, uint16_t paper,
+                         const PixelBuffer565& out) const
+{
+    if (!out.data) return;
+    const Rect clip = area.intersect(bounds()).intersect(out.bounds());
+    if (clip.isEmpty()) return;
+
+    // パレットは合成のたびに展開する（色を変えれば既存のインクもそのまま新しい色になる）
+    uint32_t fg[INK_PALETTE_SIZE];
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        fg[i] = expand_565(_palette[i]);
+    }
+    uint16_t lut[16];
+    make_nibble_lut(_palette, lut);
+
+    for (int32_t y = clip.y1; y <= clip.y2; y++) {
+        uint16_t* dst        = out.row(y);
+        const uint16_t* base = photo.data && y < photo.height ? photo.row(y) : nullptr;
+
+        forEachTileSpan(y, clip.x1, clip.width(), [&](int32_t x, int32_t count, int tile) {
+            const uint8_t* data   = tile_data(tile);
+            const uint8_t* row    = data ? data + (y % TILE_SIZE) * rowBytes() : nullptr;
+            const int32_t covered = base ? std::max<int32_t>(0, std::min<int32_t>(count, photo.width - x)) : 0;
+            const uint16_t* bg    = covered > 0 ? base + x : nullptr;
+            if (_format == INK_FORMAT_4BIT) {
+                composite_span_4bit(row, x % TILE_SIZE, bg, covered, count, paper, lut, dst + x);
+            } else {
+                composite_span(row ? row + x % TILE_SIZE : nullptr, bg, covered, count, paper, _palette, fg, dst + x);
+            }
+        });
+    }
+}
+
+bool InkLayer::compositeTile(int index, const PixelBuffer565& photo, uint16_t paper, const PixelBuffer565& out) const
+{
+    const Rect rect     = _grid.tileRect(index);
+    const uint8_t* data = _tiles[index] ? _tiles[index] : _solid[index] >= 0 ? solid_data(_solid[index]) : peek(index);
+    const bool on_photo = photo.data && rect.x1 < photo.width && rect.y1 < photo.height;
+    if (!data && !on_photo) return false;
+
+    uint32_t fg[INK_PALETTE_SIZE];
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        fg[i] = expand_565(_palette[i]);
+    }
+    uint16_t lut[16];
+    make_nibble_lut(_palette, lut);
+
+    const int32_t width   = rect.width();
+    const int32_t covered = on_photo ? std::min(width, photo.width - rect.x1) : 0;
+    for (int32_t y = rect.y1; y <= rect.y2; y++) {
+        const bool photo_row = on_photo && y < photo.height;
+        const uint8_t* row   = data ? data + (y - rect.y1) * rowBytes() : nullptr;
+        const uint16_t* bg   = photo_row ? photo.row(y) + rect.x1 : nullptr;
+        if (_format == INK_FORMAT_4BIT) {
+            composite_span_4bit(row, 0, bg, photo_row ? covered : 0, width, paper, lut, out.row(y - rect.y1));
+        } else {
+            composite_span(row, bg, photo_row ? covered : 0, width, paper, _palette, fg, out.row(y - rect.y1));
+        }
+    }
+    return true;
+}
+
+uint16_t InkLayer::blend_cell(uint8_t cell, uint16_t bg) const
+{
+    return blend_565(bg, expand_565(_palette[ink_cell_index(cell)]), INK_ALPHA.value[ink_cell_coverage(cell)]);
+}
+
+void InkLayer::compositeOver(const Rect& area, const PixelBuffer565& out) const
+{
+    if (!out.data) return;
+    const Rect clip = area.intersect(bounds()).intersect(out.bounds());
+    if (clip.isEmpty()) return;
+
+    uint32_t fg[INK_PALETTE_SIZE];
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        fg[i] = expand_565(_palette[i]);
+    }
+    uint16_t lut[16];
+    make_nibble_lut(_palette, lut);
+
+    for (int32_t y = clip.y1; y <= clip.y2; y++) {
+        uint16_t* dst = out.row(y);
+        forEachTileSpan(y, clip.x1, clip.width(), [&](int32_t x, int32_t count, int tile) {
+            const uint8_t* data = tile_data(tile);
+            if (!data) return;
+
+            const uint8_t* row = data + (y % TILE_SIZE) * rowBytes();
+            uint16_t* d        = dst + x;
+            if (_format == INK_FORMAT_4BIT) {
+                for (int32_t i = 0; i < count; i++) {
+                    const int nibble = get_ink_nibble(row, x % TILE_SIZE + i);
+                    if (nibble) d[i] = lut[nibble];
+                }
+                return;
+            }
+
+            const uint8_t* cells = row + x % TILE_SIZE;
+            for (int32_t i = 0; i < count; i++) {
+                const uint8_t cell = cells[i];
+                if (cell == 0) continue;
+                const int index    = ink_cell_index(cell);
+                const int coverage = ink_cell_coverage(cell);
+                d[i] = coverage == INK_COVERAGE_MAX ? _palette[index]
+                                                    : blend_565(d[i], fg[index], INK_ALPHA.value[coverage]);
+            }
+        });
+    }
+}
+
+int InkLayer::trim()
+{
+    int evicted = 0;
+    if (bytes() > _resident_budget) {
+        // 固定範囲から遠いタイルから追い出す（固定範囲と重なるタイルは残す）
+        std::vector<std::pair<int, int>> candidates;
+        for (int i = 0; i < _grid.count(); i++) {
+            if (!_tiles[i]) continue;
+            const int distance = _grid.tileDistance(i, _pinned);
+            if (distance > 0) candidates.emplace_back(distance, i);
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<int, int>>());
+
+        for (const auto& candidate : candidates) {
+            if (bytes() <= _resident_budget || !page_out(candidate.second)) break;
+            evicted++;
+        }
+    }
+
+    // 追い出しや解放で空いたブロックを詰め直してメモリを返す
+    _pool.shrink(_tiles);
+    return evicted;
+}
+
+const uint8_t* InkLayer::solid_data(uint8_t byte) const
+{
+    if (_solid_data.empty()) _solid_data.resize(256);
+    std::unique_ptr<uint8_t[]>& data = _solid_data[byte];
+    if (!data) {
+        data.reset(new uint8_t[tileBytes()]);
+        std::memset(data.get(), byte, tileBytes());
+    }
+    return data.get();
+}
+
+uint8_t* InkLayer::unshare_solid(int index)
+{
+    const uint8_t byte = (uint8_t)_solid[index];
+    _solid[index]      = -1;
+    _solid_count--;
+
+    uint8_t* data = _pool.acquire();
+    std::memset(data, byte, tileBytes());
+    _tiles[index] = data;
+    _tile_count++;
+    return data;
+}
+
+const uint8_t* InkLayer::peek(int index) const
+{
+    if (_pages[index] < 0) return nullptr;
+
+    _peek.resize(tileBytes());
+    if (!_page_file->peek(_pages[index], _peek.data())) {
+        _page_stats.failures++;
+        return nullptr;
+    }
+    _page_stats.peeks++;
+    return _peek.data();
+}
+
+uint8_t* InkLayer::page_in(int index)
+{
+    uint8_t* data = _pool.acquire();
+    if (!_page_file->read(_pages[index], data)) {
+        std::memset(data, 0, tileBytes());
+        _page_stats.failures++;
+    }
+    _pages[index] = -1;
+    _paged_count--;
+    _tiles[index] = data;
+    _tile_count++;
+    _page_stats.pageIns++;
+    return data;
+}
+
+bool InkLayer::page_out(int index)
+{
+    // インクが残っていないタイルは書き出さずに解放する
+    if (is_tile_empty(_tiles[index], tileBytes())) {
+        releaseTile(index);
+        return true;
+    }
+    if (!_page_file || !_page_file->isOpen()) return false;
+
+    const int32_t record = _page_file->write(_tiles[index]);
+    if (record < 0) {
+        _page_stats.failures++;
+        return false;
+    }
+    _pool.release(_tiles[index]);
+    _tiles[index] = nullptr;
+    _pages[index] = record;
+    _tile_count--;
+    _paged_count++;
+    _page_stats.pageOuts++;
+    return true;
+}
@@ -0,0 +1,595 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "tile_canvas.h"
+#include "tile_pool.h"
+#include "tile_page_file.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace drawing {
+
+/* -------------------------------------------------------------------------- */
+/*                                  Ink cell                                  */
+/* -------------------------------------------------------------------------- */
+// 1 ピクセル 1 バイト：上位 4 ビットがパレット番号、下位 4 ビットが被覆率（0 ~ 15）。0 は何も描かれていない
+static constexpr int INK_PALETTE_SIZE = 16;
+static constexpr int INK_COVERAGE_MAX = 15;
+
+inline uint8_t make_ink_cell(int index, int coverage)
+{
+    return coverage == 0 ? 0 : (uint8_t)((index << 4) | coverage);
+}
+inline int ink_cell_index(uint8_t cell)
+{
+    return cell >> 4;
+}
+inline int ink_cell_coverage(uint8_t cell)
+{
+    return cell & 0x0F;
+}
+
+/**
+ * @brief 合成率（0 ~ 32）をインクの被覆率（0 ~ 15）に変換する
+ *
+ */
+constexpr int alpha_to_ink_coverage(uint32_t alpha)
+{
+    return (alpha * INK_COVERAGE_MAX + 16) >> 5;
+}
+
+/**
+ * @brief 8 ビットの被覆率をインクの被覆率に変換する
+ *
+ */
+inline int coverage_to_ink_coverage(uint32_t coverage)
+{
+    return (coverage * INK_COVERAGE_MAX + 127) / 255;
+}
+
+namespace detail {
+
+// 被覆率 a のインクに b を重ねたときの被覆率（a + b - ab）
+struct InkUnionTable {
+    uint8_t value[INK_COVERAGE_MAX + 1][INK_COVERAGE_MAX + 1] = {};
+
+    constexpr InkUnionTable()
+    {
+        for (int a = 0; a <= INK_COVERAGE_MAX; a++) {
+            for (int b = 0; b <= INK_COVERAGE_MAX; b++) {
+                value[a][b] = a + ((INK_COVERAGE_MAX - a) * b + INK_COVERAGE_MAX / 2) / INK_COVERAGE_MAX;
+            }
+        }
+    }
+};
+static constexpr InkUnionTable INK_UNION = {};
+
+}  // namespace detail
+
+/**
+ * @brief インクを重ねる
+ *
+ * 1 ピクセルに持てる色は 1 つなので、違う色が重なった場合は被覆率の大きいほうの色を残す
+ * （違う色どうしの縁の中間色は失われるが、写真との境界のアンチエイリアスは保たれる）。
+ */
+inline uint8_t merge_ink_cell(uint8_t cell, int index, int coverage)
+{
+    const int old_coverage = ink_cell_coverage(cell);
+    const int old_index    = ink_cell_index(cell);
+    const int merged       = detail::INK_UNION.value[old_coverage][coverage];
+    if (old_coverage == 0 || old_index == index || coverage >= old_coverage) {
+        return make_ink_cell(index, merged);
+    }
+    return make_ink_cell(old_index, merged);
+}
+
+/**
+ * @brief インクを消す（被覆率 coverage の分だけ減らす）
+ *
+ */
+inline uint8_t erase_ink_cell(uint8_t cell, int coverage)
+{
+    const int remain = (ink_cell_coverage(cell) * (INK_COVERAGE_MAX - coverage) + INK_COVERAGE_MAX / 2) /
+                       INK_COVERAGE_MAX;
+    return make_ink_cell(ink_cell_index(cell), remain);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Ink nibble                                */
+/* -------------------------------------------------------------------------- */
+// INK_FORMAT_4BIT では 1 ピクセル 4 ビット（偶数列が下位）：パレット番号 + 1 を持ち、0 は何も描かれていない。
+// 被覆率は持たないので、ブラシの縁は合成率が半分以上の画素だけを塗る（消す）
+static constexpr int INK_NIBBLE_ALPHA  = 16;                    // 合成率（0 ~ 32）のしきい値
+static constexpr int INK_NIBBLE_COLORS = INK_PALETTE_SIZE - 1;  // 使えるパレット番号の数
+
+inline int get_ink_nibble(const uint8_t* row, int32_t x)
+{
+    return (row[x >> 1] >> ((x & 1) * 4)) & 0x0F;
+}
+inline void set_ink_nibble(uint8_t* row, int32_t x, int value)
+{
+    const int shift = (x & 1) * 4;
+    row[x >> 1]     = (uint8_t)((row[x >> 1] & ~(0x0F << shift)) | (value << shift));
+}
+
+/**
+ * @brief インクの持ち方
+ *
+ */
+enum InkFormat {
+    INK_FORMAT_8BIT,  // パレット番号と被覆率（縁をアンチエイリアスする）
+    INK_FORMAT_4BIT,  // パレット番号だけ（8BIT の半分のメモリ。パレット番号は INK_NIBBLE_COLORS 未満）
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                  InkLayer                                  */
+/* -------------------------------------------------------------------------- */
+/**
+ * @brief 写真の上に重ねるインクのレイヤー
+ *
+ * パレット番号と被覆率を 1 ピクセル 1 バイトで持ち、TileGrid のタイル単位で最初の書き込み時に確保する
+ * （未確保のタイルはインクなし）。表示用の RGB565 は composite() で必要な領域だけ作り直すので、
+ * 写真とインクはそれぞれ独立して残り、クリアはタイルの解放だけで済む。
+ *
+ * INK_FORMAT_4BIT では被覆率を持たずに 2 ピクセル 1 バイトで持つ。セルへの書き込みは InkPaint などの Paint と
+ * fillSpan() / clearSpan() が形式ごとに行い、読み出しは at() が 8BIT のセルにそろえて返す。
+ *
+ * キャンバスが画面より大きい場合は、メモリ上のタイルが上限を超えたときに trim() で表示範囲から遠いタイルを
+ * ページファイルへ追い出せる。追い出したタイルも確保済みとして扱い、次に触れたときに読み戻す。
+ *
+ * 全体が同じバイトのタイル（広い塗りつぶしの内側など）は単色タイルとしてバイトだけを持ち、メモリを確保しない。
+ * 読むときは値ごとに 1 枚だけ持つ共有のタイルを返し、書き込むときに初めて通常のタイルにする。
+ */
+class InkLayer {
+public:
+    static constexpr int TILE_SIZE  = TileGrid::TILE_SIZE;
+    static constexpr int TILE_BYTES = TILE_SIZE * TILE_SIZE;  // INK_FORMAT_8BIT のタイルの大きさ
+
+    struct PageStats_t {
+        uint32_t pageOuts = 0;
+        uint32_t pageIns  = 0;
+        uint32_t peeks    = 0;  // 合成のために読み戻さずに読んだ回数
+        uint32_t failures = 0;  // 読み書きに失敗した回数（読めなかったタイルはインクなしになる）
+    };
+
+    InkLayer() = default;
+    InkLayer(const InkLayer&)            = delete;
+    InkLayer& operator=(const InkLayer&) = delete;
+
+    void init(int32_t width, int32_t height, InkFormat format = INK_FORMAT_8BIT);
+
+    int32_t width() const
+    {
+        return _grid.width();
+    }
+    int32_t height() const
+    {
+        return _grid.height();
+    }
+    Rect bounds() const
+    {
+        return Rect{0, 0, width() - 1, height() - 1};
+    }
+    const TileGrid& grid() const
+    {
+        return _grid;
+    }
+    InkFormat format() const
+    {
+        return _format;
+    }
+
+    /**
+     * @brief 1 タイルのバイト数と、タイルの 1 行のバイト数
+     *
+     */
+    int tileBytes() const
+    {
+        return TILE_SIZE * rowBytes();
+    }
+    int rowBytes() const
+    {
+        return _format == INK_FORMAT_4BIT ? TILE_SIZE / 2 : TILE_SIZE;
+    }
+
+    /**
+     * @brief パレットの色を設定する（既存のインクも次の合成から新しい色になる）
+     *
+     */
+    void setPaletteColor(int index, uint16_t color)
+    {
+        _palette[index] = color;
+    }
+    uint16_t paletteColor(int index) const
+    {
+        return _palette[index];
+    }
+
+    /* --------------------------------- Tiles -------------------------------- */
+    bool hasTile(int index) const
+    {
+        return _tiles[index] != nullptr || _pages[index] >= 0 || _solid[index] >= 0;
+    }
+    const uint8_t* tile(int index) const
+    {
+        return tile_data(index);
+    }
+
+    /**
+     * @brief タイルを取得する（未確保なら空で確保する）
+     *
+     * @return uint8_t* tileBytes()（端のタイルも同じ大きさで確保し、範囲外は使わない）
+     */
+    uint8_t* acquireTile(int index);
+
+    /**
+     * @brief タイルを解放する（インクなしに戻る）
+     *
+     */
+    void releaseTile(int index);
+
+    /**
+     * @brief タイル全体をパレット番号 index の被覆率いっぱいのインクにする（単色タイルにしてメモリは確保しない）
+     *
+     */
+    void fillTile(int index, int paletteIndex);
+
+    /**
+     * @brief タイルを全体が byte の単色タイルにする（0 なら解放。アンドゥの書き戻し用）
+     *
+     */
+    void setSolidTile(int index, uint8_t byte);
+
+    /**
+     * @brief 単色タイルのバイト（単色タイルでなければ -1）
+     *
+     */
+    int solidByte(int index) const
+    {
+        return _solid[index];
+    }
+
+    /**
+     * @brief 領域内のインクがなくなったタイルを解放する（消しゴムの後など）
+     *
+     */
+    void releaseEmptyTiles(const Rect& area);
+
+    /**
+     * @brief すべてのタイルを解放する
+     *
+     */
+    void clear();
+
+    /**
+     * @brief 確保済みのタイル数（追い出したタイルと単色タイルを含む）
+     *
+     */
+    int tileCount() const
+    {
+        return _tile_count + _paged_count + _solid_count;
+    }
+    int residentCount() const
+    {
+        return _tile_count;
+    }
+    int pagedCount() const
+    {
+        return _paged_count;
+    }
+    int solidCount() const
+    {
+        return _solid_count;
+    }
+
+    /**
+     * @brief メモリ上のタイルのバイト数（単色タイルは含まない）
+     *
+     */
+    size_t bytes() const
+    {
+        return (size_t)_tile_count * tileBytes();
+    }
+
+    /**
+     * @brief タイル用に確保しているメモリ（空きのブロックを含む）
+     *
+     */
+    size_t allocatedBytes() const
+    {
+        return _pool.bytes();
+    }
+
+    /**
+     * @brief 確保済みのタイルを列挙する
+     *
+     * @param fn void(int index, const Rect& tileRect)
+     */
+    template <typename Fn>
+    void forEachTile(Fn&& fn) const
+    {
+        for (int i = 0; i < _grid.count(); i++) {
+            if (hasTile(i)) fn(i, _grid.tileRect(i));
+        }
+    }
+
+    /* --------------------------------- Cells -------------------------------- */
+    int tileIndex(int32_t x, int32_t y) const
+    {
+        return (y / TILE_SIZE) * _grid.cols() + x / TILE_SIZE;
+    }
+
+    /**
+     * @brief セルを読む（INK_FORMAT_4BIT では被覆率いっぱいの 8BIT のセルにして返す）
+     *
+     */
+    uint8_t at(int32_t x, int32_t y) const
+    {
+        return cellIn(tile_data(tileIndex(x, y)), x, y);
+    }
+
+    /**
+     * @brief (x, y) を含むタイルのデータ（tile() の戻り値、nullptr ならインクなし）からセルを読む
+     *
+     */
+    uint8_t cellIn(const uint8_t* data, int32_t x, int32_t y) const
+    {
+        if (!data) return 0;
+        const uint8_t* row = data + (y % TILE_SIZE) * rowBytes();
+        if (_format == INK_FORMAT_8BIT) return row[x % TILE_SIZE];
+        const int nibble = get_ink_nibble(row, x % TILE_SIZE);
+        return nibble ? make_ink_cell(nibble - 1, INK_COVERAGE_MAX) : 0;
+    }
+
+    /**
+     * @brief 1 行の区間をタイルの境界で分けて列挙する
+     *
+     * @param fn void(int32_t x, int32_t count, int tileIndex)
+     */
+    template <typename Fn>
+    void forEachTileSpan(int32_t y, int32_t x, int32_t count, Fn&& fn) const
+    {
+        while (count > 0) {
+            const int32_t n = std::min<int32_t>(count, TILE_SIZE - x % TILE_SIZE);
+            fn(x, n, tileIndex(x, y));
+            x += n;
+            count -= n;
+        }
+    }
+
+    /**
+     * @brief 書き込み用にタイルの y の行を取得する（タイルは必要なら確保する。列はタイル内の x）
+     *
+     */
+    uint8_t* rowForWrite(int32_t y, int tileIndex)
+    {
+        uint8_t* data = _tiles[tileIndex];
+        if (!data) data = acquireTile(tileIndex);
+        return data + (y % TILE_SIZE) * rowBytes();
+    }
+
+    /**
+     * @brief メモリ上にある通常のタイルの y の行を取得する（未確保・単色・追い出し済みなら nullptr）
+     *
+     */
+    uint8_t* residentRow(int32_t y, int tileIndex)
+    {
+        uint8_t* data = _tiles[tileIndex];
+        return data ? data + (y % TILE_SIZE) * rowBytes() : nullptr;
+    }
+
+    /**
+     * @brief 確保済みのタイルの y の行を取得する（未確保なら nullptr）
+     *
+     */
+    uint8_t* rowIfAllocated(int32_t y, int tileIndex)
+    {
+        uint8_t* data = writable_data(tileIndex);
+        return data ? data + (y % TILE_SIZE) * rowBytes() : nullptr;
+    }
+
+    /**
+     * @brief 書き込み用に (x, y) から同じタイル内で続くセルを取得する（INK_FORMAT_8BIT のみ）
+     *
+     */
+    uint8_t* cellsForWrite(int32_t x, int32_t y, int tileIndex)
+    {
+        return rowForWrite(y, tileIndex) + x % TILE_SIZE;
+    }
+
+    /**
+     * @brief 確保済みのタイルのセルを取得する（INK_FORMAT_8BIT のみ。未確保なら nullptr）
+     *
+     */
+    uint8_t* cellsIfAllocated(int32_t x, int32_t y, int tileIndex)
+    {
+        uint8_t* row = rowIfAllocated(y, tileIndex);
+        return row ? row + x % TILE_SIZE : nullptr;
+    }
+
+    /**
+     * @brief 1 行の区間を被覆率いっぱいのインクで塗る（塗りつぶし用）
+     *
+     */
+    void fillSpan(int32_t y, int32_t x1, int32_t x2, int index);
+
+    /**
+     * @brief 1 行の区間のインクを消す（未確保のタイルは触らない）
+     *
+     */
+    void clearSpan(int32_t y, int32_t x1, int32_t x2);
+
+    /* ------------------------------- Composite ------------------------------ */
+    /**
+     * @brief 領域を合成して out に書き込む
+     *
+     * @param photo 下地の写真（data が nullptr なら paper の単色）。キャンバスの左上に置き、写真の外は paper
+     * @param paper 写真がない場所の下地の色
+     * @param out 表示用のバッファ（キャンバスと同じ座標）
+     */
+    void composite(const Rect& area, const PixelBuffer565& photo, uint16_t paper, const PixelBuffer565& out) const;
+
+    /**
+     * @brief 1 枚のタイルを合成して out の左上から書き込む
+     *
+     * 追い出したタイルは読み戻さずにファイルから読むので、縮小表示で全体を合成してもメモリ上のタイルは増えない。
+     * @param out TILE_SIZE 四方以上（端のタイルはキャンバスの内側だけ書く）
+     * @return false インクも写真もなく paper の単色になる（out には何も書かない）
+     */
+    bool compositeTile(int index, const PixelBuffer565& photo, uint16_t paper, const PixelBuffer565& out) const;
+
+    /**
+     * @brief 1 画素だけ合成する（composite() と同じ結果）
+     *
+     */
+    uint16_t compositePixel(int32_t x, int32_t y, const PixelBuffer565& photo, uint16_t paper) const
+    {
+        const uint16_t bg = photo.data && x < photo.width && y < photo.height ? photo.row(y)[x] : paper;
+        return compositeCell(at(x, y), bg);
+    }
+
+    /**
+     * @brief 1 つのセルを下地の色 bg に重ねる
+     *
+     */
+    uint16_t compositeCell(uint8_t cell, uint16_t bg) const
+    {
+        if (cell == 0) return bg;
+        if (ink_cell_coverage(cell) == INK_COVERAGE_MAX) return _palette[ink_cell_index(cell)];
+        return blend_cell(cell, bg);
+    }
+
+    /**
+     * @brief out の現在の内容を下地としてインクを重ねる（インクのないタイルは触らない）
+     *
+     */
+    void compositeOver(const Rect& area, const PixelBuffer565& out) const;
+
+    /* -------------------------------- Paging -------------------------------- */
+    /**
+     * @brief 追い出し先のファイルを設定する（nullptr なら追い出さない）
+     *
+     * タイルを追い出している間は変えないこと。
+     */
+    void setPageFile(TilePageFile* file)
+    {
+        _page_file = file;
+    }
+
+    /**
+     * @brief メモリ上に置くタイルの上限
+     *
+     */
+    void setResidentBudget(size_t bytes)
+    {
+        _resident_budget = bytes;
+    }
+
+    /**
+     * @brief 追い出さない範囲（表示中の範囲など）
+     *
+     */
+    void setPinnedArea(const Rect& area)
+    {
+        _pinned = area;
+    }
+
+    /**
+     * @brief メモリ上のタイルが上限を超えていれば、固定範囲の外で遠いタイルから追い出す
+     *
+     * 空いたメモリはタイルを詰め直して返すので、タイルのセルのポインタを持ったまま呼ばないこと。
+     * @return int 追い出したタイル数
+     */
+    int trim();
+
+    const PageStats_t& getPageStats() const
+    {
+        return _page_stats;
+    }
+
+private:
+    TileGrid _grid;
+    TilePool _pool;
+    std::vector<uint8_t*> _tiles;  // タイル番号ごとのデータ（nullptr なら未確保か追い出し中）
+    std::vector<int32_t> _pages;   // タイル番号ごとのページファイルのレコード（-1 なら追い出していない）
+    std::vector<int16_t> _solid;   // タイル番号ごとの単色タイルのバイト（-1 なら単色タイルではない）
+    int _tile_count                     = 0;
+    int _paged_count                    = 0;
+    int _solid_count                    = 0;
+    InkFormat _format                   = INK_FORMAT_8BIT;
+    uint16_t _palette[INK_PALETTE_SIZE] = {};
+    TilePageFile* _page_file            = nullptr;
+    size_t _resident_budget             = SIZE_MAX;
+    Rect _pinned;
+    mutable PageStats_t _page_stats;
+    mutable std::vector<uint8_t> _peek;  // 追い出したタイルを合成するときの読み込み先
+    mutable std::vector<std::unique_ptr<uint8_t[]>> _solid_data;  // 単色タイルを読むときの共有のタイル（値ごと）
+
+    // 追い出したタイルは読むだけの操作でも読み戻す（内容は変わらないので const のまま扱う）
+    const uint8_t* tile_data(int index) const
+    {
+        const uint8_t* data = _tiles[index];
+        if (data) return data;
+        if (_solid_count > 0 && _solid[index] >= 0) return solid_data(_solid[index]);
+        if (_paged_count > 0 && _pages[index] >= 0) data = const_cast<InkLayer*>(this)->page_in(index);
+        return data;
+    }
+
+    // 書き込む前に、追い出したタイルは読み戻し、単色タイルは通常のタイルにする（未確保なら nullptr）
+    uint8_t* writable_data(int index)
+    {
+        if (_tiles[index]) return _tiles[index];
+        if (_solid[index] >= 0) return unshare_solid(index);
+        return _pages[index] >= 0 ? page_in(index) : nullptr;
+    }
+    uint16_t blend_cell(uint8_t cell, uint16_t bg) const;
+    const uint8_t* solid_data(uint8_t byte) const;
+    uint8_t* unshare_solid(int index);
+    const uint8_t* peek(int index) const;
+    uint8_t* page_in(int index);
+    bool page_out(int index);
+};
+
+/**
+ * @brief 合成結果を 1 画素ずつ求める画像（塗りつぶしの判定用）
+ *
+ * キャンバス全体を合成したバッファを持たずに、インクと写真から直接求める。
+ * 走査は同じタイルの中で続くので、直前に読んだタイルを覚えておきタイルが変わったときだけ引き直す。
+ * そのため 1 回の塗りつぶしごとに作り直すこと（間に描いたインクは読めない。塗った区間は読まないので、
+ * 塗りつぶしの途中でレイヤーに書くのはよい）。
+ */
+class InkCompositePixels {
+public:
+    InkCompositePixels(const InkLayer& layer, const PixelBuffer565& photo, uint16_t paper)
+        : width(layer.width()), height(layer.height()), _layer(layer), _photo(photo), _paper(paper)
+    {
+    }
+
+    const int32_t width;
+    const int32_t height;
+
+    uint16_t pixel(int32_t x, int32_t y) const
+    {
+        const int index = _layer.tileIndex(x, y);
+        if (index != _tile_index) {
+            _tile_index = index;
+            _tile       = _layer.tile(index);
+        }
+        const uint16_t bg = _photo.data && x < _photo.width && y < _photo.height ? _photo.row(y)[x] : _paper;
+        return _layer.compositeCell(_layer.cellIn(_tile, x, y), bg);
+    }
+
+private:
+    const InkLayer& _layer;
+    PixelBuffer565 _photo;
+    uint16_t _paper;
+    mutable int _tile_index      = -1;
+    mutable const uint8_t* _tile = nullptr;
+};
+
+}  // namespace drawing
@@ -0,0 +1,140 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "mip_pyramid.h"
+#include "brush.h"
+#include <algorithm>
+#include <functional>
+
+using namespace drawing;
+
+// 4 画素の和を 4 で割るときの丸め（expand_565 の各成分に 2 を足す）
+static constexpr uint32_t DOWNSAMPLE_ROUND = (2u << 21) | (2u << 11) | 2u;
+
+void drawing::downsample_565(const PixelBuffer565& src, const PixelBuffer565& dst, const Rect& dstRect)
+{
+    const Rect area = dstRect.intersect(dst.bounds());
+    if (area.isEmpty()) return;
+
+    // 成分ごとに 2 ビットの余裕があるので、展開したまま 4 画素を足してから割る
+    const int32_t last_x = src.width - 1;
+    for (int32_t y = area.y1; y <= area.y2; y++) {
+        const uint16_t* s0 = src.row(std::min(2 * y, src.height - 1));
+        const uint16_t* s1 = src.row(std::min(2 * y + 1, src.height - 1));
+        uint16_t* d        = dst.row(y);
+        for (int32_t x = area.x1; x <= area.x2; x++) {
+            const int32_t x0 = std::min(2 * x, last_x);
+            const int32_t x1 = std::min(2 * x + 1, last_x);
+            uint32_t sum     = expand_565(s0[x0]) + expand_565(s0[x1]) + expand_565(s1[x0]) + expand_565(s1[x1]);
+            sum              = ((sum + DOWNSAMPLE_ROUND) >> 2) & RGB565_BLEND_MASK;
+            d[x]             = (uint16_t)(sum | (sum >> 16));
+        }
+    }
+}
+
+void MipPyramid::init(int32_t width, int32_t height, size_t budgetBytes, uint16_t background, ComposeFn compose)
+{
+    _grid.resize(width, height);
+    _budget  = budgetBytes;
+    _compose = std::move(compose);
+    _tiles.assign(_grid.count(), nullptr);
+    _valid.resize(_grid.count());
+    _solid.assign(TILE_SIZE * TILE_SIZE, background);
+
+    // 等倍のタイルと、最後の段の手前までの縮小の途中を置く
+    size_t scratch = 0;
+    for (int i = 0; i < MAX_LEVELS; i++) {
+        scratch += (size_t)(TILE_SIZE >> i) * (TILE_SIZE >> i);
+    }
+    _scratch.assign(scratch, 0);
+
+    _level = -1;
+    setLevel(0);
+    resetStats();
+}
+
+void MipPyramid::setLevel(int level)
+{
+    level = std::max(0, std::min(level, MAX_LEVELS));
+    if (level == _level) return;
+
+    _level = level;
+    _pool.init((size_t)tileSize() * tileSize() * sizeof(uint16_t));
+    std::fill(_tiles.begin(), _tiles.end(), nullptr);
+    _valid.clear();
+}
+
+void MipPyramid::invalidate(const Rect& rect)
+{
+    _grid.forEachTileIn(rect, [&](int index) { _valid.reset(index); });
+}
+
+void MipPyramid::invalidateAll()
+{
+    _valid.clear();
+}
+
+const uint16_t* MipPyramid::tile(int index)
+{
+    if (_valid.test(index)) {
+        return _tiles[index] ? reinterpret_cast<const uint16_t*>(_tiles[index]) : _solid.data();
+    }
+    _valid.set(index);
+
+    // 等倍の段はタイルのバッファに直接作り、それ以外は作業領域に作ってから 1 段ずつ縮小する
+    if (!_tiles[index]) _tiles[index] = _pool.acquire();
+    uint16_t* pixels = reinterpret_cast<uint16_t*>(_tiles[index]);
+    const Rect rect  = _grid.tileRect(index);
+    PixelBuffer565 src = {_level == 0 ? pixels : _scratch.data(), rect.width(), rect.height(), TILE_SIZE};
+    _stats.tiles++;
+    _stats.pixels += rect.area();
+    if (!_compose(index, src)) {
+        release(index);
+        _valid.set(index);
+        return _solid.data();
+    }
+
+    uint16_t* next = _scratch.data() + TILE_SIZE * TILE_SIZE;
+    for (int i = 1; i <= _level; i++) {
+        const int32_t size = TILE_SIZE >> i;
+        PixelBuffer565 dst = {i == _level ? pixels : next, (src.width + 1) / 2, (src.height + 1) / 2, size};
+        downsample_565(src, dst, dst.bounds());
+        src = dst;
+        next += size * size;
+    }
+    return pixels;
+}
+
+void MipPyramid::trim(const Rect& keep)
+{
+    if (_pool.bytes() > _budget) {
+        // 表示中の範囲から遠いタイルから捨てる（次に表示したときに作り直す）
+        std::vector<std::pair<int, int>> candidates;
+        for (int i = 0; i < _grid.count(); i++) {
+            if (!_tiles[i]) continue;
+            const int distance = _grid.tileDistance(i, keep);
+            if (distance > 0) candidates.emplace_back(distance, i);
+        }
+        std::sort(candidates.begin(), candidates.end(), std::greater<std::pair<int, int>>());
+
+        const size_t tile_bytes = _pool.blockBytes();
+        size_t used             = _pool.usedCount() * tile_bytes;
+        for (const auto& candidate : candidates) {
+            if (used <= _budget) break;
+            release(candidate.second);
+            used -= tile_bytes;
+        }
+    }
+    _pool.shrink(_tiles);
+}
+
+void MipPyramid::release(int index)
+{
+    if (_tiles[index]) {
+        _pool.release(_tiles[index]);
+        _tiles[index] = nullptr;
+    }
+    _valid.reset(index);
+}
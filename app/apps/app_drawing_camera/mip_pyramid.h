@@ -0,0 +1,137 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "tile_canvas.h"
+#include "tile_pool.h"
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief 表示用画像のタイル単位のキャッシュ（等倍と縮小版 1/2・1/4・1/8）
+ *
+ * キャンバス全体の合成結果は持たず、表示に使う段のタイルだけを必要になったときに作って保持する。
+ * タイルは等倍の画像を compose 関数で作ってから段まで 2x2 の平均で縮小する（タイルは 8 の倍数なので、
+ * キャンバス全体を縮小した場合と同じ画素になる）。インクも写真もないタイルは下地の単色として画素を持たない。
+ * 変わった範囲はタイル単位で記録しておき、次に読むときに作り直す。段を変えると保持しているタイルは捨てる。
+ */
+class MipPyramid {
+public:
+    static constexpr int MAX_LEVELS = 3;
+    static constexpr int TILE_SIZE  = TileGrid::TILE_SIZE;
+
+    struct Stats_t {
+        uint32_t tiles  = 0;  // 作り直したタイル数
+        uint64_t pixels = 0;  // 作り直したタイルの等倍の画素数
+    };
+
+    /**
+     * @brief タイルの等倍の画像を作る関数
+     *
+     * bool(int index, const PixelBuffer565& out)：out はタイルの大きさで、タイルの左上から書く。
+     * 下地の単色だけになる場合は何も書かずに false を返す。
+     */
+    using ComposeFn = std::function<bool(int index, const PixelBuffer565& out)>;
+
+    /**
+     * @param width キャンバスの大きさ
+     * @param height
+     * @param budgetBytes 保持する画素の上限（超えた分は trim() で捨てる）
+     * @param background compose が false を返したタイルの色
+     * @param compose
+     */
+    void init(int32_t width, int32_t height, size_t budgetBytes, uint16_t background, ComposeFn compose);
+
+    /**
+     * @brief 読む段を選ぶ（変えると保持しているタイルを捨てる）
+     *
+     * @param level 0 ~ MAX_LEVELS（0 は等倍）
+     */
+    void setLevel(int level);
+    int level() const
+    {
+        return _level;
+    }
+
+    /**
+     * @brief 現在の段のタイルの一辺（画素）
+     *
+     */
+    int32_t tileSize() const
+    {
+        return TILE_SIZE >> _level;
+    }
+
+    /**
+     * @brief 等倍の画像が変わった範囲を記録する
+     *
+     * @param rect 等倍の座標
+     */
+    void invalidate(const Rect& rect);
+    void invalidateAll();
+
+    /**
+     * @brief 現在の段のタイルを最新にして画素を返す
+     *
+     * @return const uint16_t* tileSize() 四方（行の間隔も tileSize()）。次に trim() か setLevel() を呼ぶまで有効
+     */
+    const uint16_t* tile(int index);
+
+    /**
+     * @brief 保持している画素が上限を超えていれば、keep から遠いタイルから捨てる
+     *
+     * @param keep 残す範囲（等倍の座標。表示中の範囲）
+     */
+    void trim(const Rect& keep);
+
+    /**
+     * @brief 画素を持っているタイル数
+     *
+     */
+    int cachedCount() const
+    {
+        return (int)_pool.usedCount();
+    }
+    size_t bytes() const
+    {
+        return _pool.bytes();
+    }
+
+    const Stats_t& getStats() const
+    {
+        return _stats;
+    }
+    void resetStats()
+    {
+        _stats = Stats_t();
+    }
+
+private:
+    TileGrid _grid;
+    TilePool _pool;
+    ComposeFn _compose;
+    size_t _budget = 0;
+    int _level     = 0;
+    std::vector<uint8_t*> _tiles;    // タイル番号ごとの画素（nullptr なら未作成か単色）
+    TileBitmap _valid;               // 最新のタイル
+    std::vector<uint16_t> _scratch;  // 等倍のタイルと縮小の途中の段
+    std::vector<uint16_t> _solid;    // 単色のタイルとして返す画素
+    Stats_t _stats;
+
+    void release(int index);
+};
+
+/**
+ * @brief 2x2 の平均で半分の大きさにする（奇数の端は最後の画素を繰り返す）
+ *
+ * @param dstRect dst 側の範囲
+ */
+void downsample_565(const PixelBuffer565& src, const PixelBuffer565& dst, const Rect& dstRect);
+
+}  // namespace drawing
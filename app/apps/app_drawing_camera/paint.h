@@ -0,0 +1,260 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "brush.h"
+#include "ink_layer.h"
+#include <cstring>
+
+namespace drawing {
+
+/* -------------------------------------------------------------------------- */
+/*                                    Paint                                   */
+/* -------------------------------------------------------------------------- */
+// ブラシのカーネルや図形のラスタライザは形（区間と合成率）だけを求め、何をどこに書くかは Paint が決める。
+// row(y) で行ごとの書き込み先を一度だけ求め、fill / blend / put はその行の x から書き込む。
+// fillRun / blendRun はブラシのマスクのように長さや合成率の並びがコンパイル時に決まっている場合に使う。
+// いずれも範囲外への書き込みは確認しないので、呼び出し側で bounds() にクリップしておく。
+
+// 単色で塗る
+struct SolidPaint {
+    using Row = uint16_t*;
+
+    const PixelBuffer565& buffer;
+    uint16_t color;
+    uint32_t fg;
+
+    SolidPaint(const PixelBuffer565& target, uint16_t solidColor)
+        : buffer(target), color(solidColor), fg(expand_565(solidColor))
+    {
+    }
+    Rect bounds() const
+    {
+        return buffer.bounds();
+    }
+    Row row(int32_t y) const
+    {
+        return buffer.row(y);
+    }
+    void fill(Row row, int32_t x, int32_t count) const
+    {
+        fill_span_565(row + x, count, color);
+    }
+    void blend(Row row, int32_t x, const uint8_t* alpha, int32_t count) const
+    {
+        blend_span_565(row + x, alpha, count, fg);
+    }
+    // 長さが定数なので fill_span_565 の分岐が畳まれ、8 画素ずつの書き込みに展開される
+    template <int N>
+    void fillRun(Row row, int32_t x) const
+    {
+        fill_span_565(row + x, N, color);
+    }
+    // 合成率ごとに式を定数で展開する（0 は書かず、32 は単色で書く）
+    template <uint8_t... Alpha>
+    void blendRun(Row row, int32_t x) const
+    {
+        uint16_t* ptr = row + x;
+        (blendPixel<Alpha>(ptr++), ...);
+    }
+    template <uint8_t Alpha>
+    void blendPixel(uint16_t* ptr) const
+    {
+        if constexpr (Alpha >= 32) {
+            *ptr = color;
+        } else if constexpr (Alpha > 0) {
+            *ptr = blend_565_scaled(*ptr, fg * Alpha, Alpha);
+        }
+    }
+    void put(Row row, int32_t x, uint32_t coverage) const
+    {
+        row[x] = coverage >= 255 ? color : blend_565(row[x], fg, coverage_to_alpha(coverage));
+    }
+};
+
+// インクのレイヤーにパレット番号で描く（タイルは書き込むときに確保する。INK_FORMAT_4BIT では縁を 2 値にする）
+struct InkPaint {
+    using Row = int32_t;
+
+    InkLayer& layer;
+    int index;
+
+    Rect bounds() const
+    {
+        return layer.bounds();
+    }
+    Row row(int32_t y) const
+    {
+        return y;
+    }
+    void fill(Row y, int32_t x, int32_t count) const
+    {
+        if (layer.format() == INK_FORMAT_4BIT) {
+            layer.fillSpan(y, x, x + count - 1, index);
+            return;
+        }
+
+        // 確保済みのタイルにかかる部分はその行に直接書く（それ以外は単色タイルを崩さない fillSpan に任せる）
+        const uint8_t cell = make_ink_cell(index, INK_COVERAGE_MAX);
+        layer.forEachTileSpan(y, x, count, [&](int32_t sx, int32_t n, int tile) {
+            if (uint8_t* row = layer.residentRow(y, tile)) {
+                std::memset(row + sx % InkLayer::TILE_SIZE, cell, n);
+            } else {
+                layer.fillSpan(y, sx, sx + n - 1, index);
+            }
+        });
+    }
+    void blend(Row y, int32_t x, const uint8_t* alpha, int32_t count) const
+    {
+        if (layer.format() == INK_FORMAT_4BIT) {
+            layer.forEachTileSpan(y, x, count, [&](int32_t sx, int32_t n, int tile) {
+                uint8_t* row     = layer.rowForWrite(y, tile);
+                const uint8_t* a = alpha + (sx - x);
+                const int32_t tx = sx % InkLayer::TILE_SIZE;
+                for (int32_t i = 0; i < n; i++) {
+                    if (a[i] >= INK_NIBBLE_ALPHA) set_ink_nibble(row, tx + i, index + 1);
+                }
+            });
+            return;
+        }
+
+        layer.forEachTileSpan(y, x, count, [&](int32_t sx, int32_t n, int tile) {
+            uint8_t* cells     = layer.cellsForWrite(sx, y, tile);
+            const uint8_t* a   = alpha + (sx - x);
+            for (int32_t i = 0; i < n; i++) {
+                const int coverage = alpha_to_ink_coverage(a[i]);
+                if (coverage) cells[i] = merge_ink_cell(cells[i], index, coverage);
+            }
+        });
+    }
+    template <int N>
+    void fillRun(Row y, int32_t x) const
+    {
+        fill(y, x, N);
+    }
+    // 1 枚のタイルに収まる区間（ほとんどがそう）はタイルの行に直接、合成率ごとに式を定数で展開して書く
+    template <uint8_t... Alpha>
+    void blendRun(Row y, int32_t x) const
+    {
+        constexpr int32_t count = sizeof...(Alpha);
+        if constexpr (count > 0) {
+            const int32_t tx = x % InkLayer::TILE_SIZE;
+            if (tx + count > InkLayer::TILE_SIZE) {
+                static constexpr uint8_t alpha[] = {Alpha...};
+                blend(y, x, alpha, count);
+                return;
+            }
+            uint8_t* row = tile_row(y, x);
+            if (layer.format() == INK_FORMAT_4BIT) {
+                int32_t i = tx;
+                (blendNibble<Alpha>(row, i++), ...);
+            } else {
+                uint8_t* cell = row + tx;
+                (blendCell<Alpha>(cell++), ...);
+            }
+        }
+    }
+    template <uint8_t Alpha>
+    void blendNibble(uint8_t* row, int32_t tx) const
+    {
+        if constexpr (Alpha >= INK_NIBBLE_ALPHA) set_ink_nibble(row, tx, index + 1);
+    }
+    template <uint8_t Alpha>
+    void blendCell(uint8_t* cell) const
+    {
+        constexpr int coverage = alpha_to_ink_coverage(Alpha);
+        if constexpr (coverage > 0) *cell = merge_ink_cell(*cell, index, coverage);
+    }
+    void put(Row y, int32_t x, uint32_t coverage) const
+    {
+        if (layer.format() == INK_FORMAT_4BIT) {
+            if (coverage < 128) return;
+            set_ink_nibble(tile_row(y, x), x % InkLayer::TILE_SIZE, index + 1);
+            return;
+        }
+
+        const int c = coverage_to_ink_coverage(coverage);
+        if (c == 0) return;
+        uint8_t* cell = tile_row(y, x) + x % InkLayer::TILE_SIZE;
+        *cell         = merge_ink_cell(*cell, index, c);
+    }
+
+    // (x, y) を含むタイルの y の行（タイルは必要なら確保する）
+    uint8_t* tile_row(int32_t y, int32_t x) const
+    {
+        return layer.rowForWrite(y, layer.tileIndex(x, y));
+    }
+};
+
+// インクを消す（未確保のタイルにはもともとインクがないので何もしない）
+struct InkErasePaint {
+    using Row = int32_t;
+
+    InkLayer& layer;
+
+    Rect bounds() const
+    {
+        return layer.bounds();
+    }
+    Row row(int32_t y) const
+    {
+        return y;
+    }
+    void fill(Row y, int32_t x, int32_t count) const
+    {
+        layer.clearSpan(y, x, x + count - 1);
+    }
+    void blend(Row y, int32_t x, const uint8_t* alpha, int32_t count) const
+    {
+        if (layer.format() == INK_FORMAT_4BIT) {
+            layer.forEachTileSpan(y, x, count, [&](int32_t sx, int32_t n, int tile) {
+                uint8_t* row = layer.rowIfAllocated(y, tile);
+                if (!row) return;
+                const uint8_t* a = alpha + (sx - x);
+                const int32_t tx = sx % InkLayer::TILE_SIZE;
+                for (int32_t i = 0; i < n; i++) {
+                    if (a[i] >= INK_NIBBLE_ALPHA) set_ink_nibble(row, tx + i, 0);
+                }
+            });
+            return;
+        }
+
+        layer.forEachTileSpan(y, x, count, [&](int32_t sx, int32_t n, int tile) {
+            uint8_t* cells = layer.cellsIfAllocated(sx, y, tile);
+            if (!cells) return;
+            const uint8_t* a = alpha + (sx - x);
+            for (int32_t i = 0; i < n; i++) {
+                if (cells[i]) cells[i] = erase_ink_cell(cells[i], alpha_to_ink_coverage(a[i]));
+            }
+        });
+    }
+    template <int N>
+    void fillRun(Row y, int32_t x) const
+    {
+        fill(y, x, N);
+    }
+    template <uint8_t... Alpha>
+    void blendRun(Row y, int32_t x) const
+    {
+        if constexpr (sizeof...(Alpha) > 0) {
+            static constexpr uint8_t alpha[] = {Alpha...};
+            blend(y, x, alpha, sizeof...(Alpha));
+        }
+    }
+    void put(Row y, int32_t x, uint32_t coverage) const
+    {
+        if (layer.format() == INK_FORMAT_4BIT) {
+            uint8_t* row = layer.rowIfAllocated(y, layer.tileIndex(x, y));
+            if (row && coverage >= 128) set_ink_nibble(row, x % InkLayer::TILE_SIZE, 0);
+            return;
+        }
+
+        uint8_t* cell = layer.cellsIfAllocated(x, y, layer.tileIndex(x, y));
+        if (cell && *cell) *cell = erase_ink_cell(*cell, coverage_to_ink_coverage(coverage));
+    }
+};
+
+}  // namespace drawing
@@ -0,0 +1,47 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "pinch_gesture.h"
+#include <cmath>
+
+using namespace drawing;
+
+void PinchGesture::begin(uint8_t idA, float xA, float yA, uint8_t idB, float xB, float yB, float zoom)
+{
+    _active     = true;
+    _id[0]      = idA;
+    _id[1]      = idB;
+    _x[0]       = xA;
+    _y[0]       = yA;
+    _x[1]       = xB;
+    _y[1]       = yB;
+    _mid_x      = (xA + xB) * 0.5f;
+    _mid_y      = (yA + yB) * 0.5f;
+    _start_span = std::hypot(xB - xA, yB - yA);
+    _start_zoom = zoom;
+}
+
+bool PinchGesture::move(uint8_t id, float x, float y, Update_t& out)
+{
+    if (!involves(id)) return false;
+    const int i = id == _id[0] ? 0 : 1;
+    _x[i]       = x;
+    _y[i]       = y;
+
+    const float mid_x = (_x[0] + _x[1]) * 0.5f;
+    const float mid_y = (_y[0] + _y[1]) * 0.5f;
+    const float span  = std::hypot(_x[1] - _x[0], _y[1] - _y[0]);
+    out.zoom          = _start_zoom;
+    if (_start_span >= MIN_SPAN && span >= MIN_SPAN) {
+        out.zoom = _start_zoom * span / _start_span;
+    }
+    out.focusX = mid_x;
+    out.focusY = mid_y;
+    out.panX   = mid_x - _mid_x;
+    out.panY   = mid_y - _mid_y;
+    _mid_x     = mid_x;
+    _mid_y     = mid_y;
+    return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+
+namespace drawing {
+
+/**
+ * @brief 2 本指のピンチとドラッグを表示倍率と位置にする
+ *
+ * 2 本の指の中点の移動をパン、指の間隔の変化をズームとし、ズームの中心は移動後の中点にする。
+ * 倍率は開始時の倍率と指の間隔からの比で求めるので、小さな変化が積み重なっても誤差がたまらず、
+ * Viewport が等倍の近くで倍率をそろえても抜け出せる。
+ */
+class PinchGesture {
+public:
+    static constexpr float MIN_SPAN = 16.0f;  // これより指が近いと間隔の比が不安定なので倍率を変えない
+
+    struct Update_t {
+        float zoom   = 1.0f;  // 表示倍率（相対値ではなく、この倍率にする）
+        float focusX = 0.0f;  // ズームの中心（画面座標）
+        float focusY = 0.0f;
+        float panX   = 0.0f;  // 前回からの中点の移動
+        float panY   = 0.0f;
+    };
+
+    /**
+     * @brief 2 本の指で開始する
+     *
+     * @param zoom 開始時の表示倍率
+     */
+    void begin(uint8_t idA, float xA, float yA, uint8_t idB, float xB, float yB, float zoom);
+
+    /**
+     * @brief 指の移動を反映する
+     *
+     * @return true ピンチ中の指で、out を更新した
+     */
+    bool move(uint8_t id, float x, float y, Update_t& out);
+
+    void end()
+    {
+        _active = false;
+    }
+    bool isActive() const
+    {
+        return _active;
+    }
+    bool involves(uint8_t id) const
+    {
+        return _active && (id == _id[0] || id == _id[1]);
+    }
+
+private:
+    bool _active      = false;
+    uint8_t _id[2]    = {};
+    float _x[2]       = {};
+    float _y[2]       = {};
+    float _mid_x      = 0.0f;  // 前回の中点
+    float _mid_y      = 0.0f;
+    float _start_span = 0.0f;
+    float _start_zoom = 1.0f;
+};
+
+}  // namespace drawing
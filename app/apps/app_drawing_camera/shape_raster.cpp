@@ -0,0 +1,502 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "shape_raster.h"
+#include "paint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+using namespace drawing;
+
+namespace {
+
+/* -------------------------------------------------------------------------- */
+/*                                   Plotter                                  */
+/* -------------------------------------------------------------------------- */
+// imlib の imlib_set_pixel / imlib_set_pixel_aa / xLine / yLine に相当する書き込み（範囲外は捨てる）
+template <typename Paint>
+struct Plotter {
+    const Paint& paint;
+    Rect clip;
+
+    bool contains(int32_t x, int32_t y) const
+    {
+        return x >= clip.x1 && x <= clip.x2 && y >= clip.y1 && y <= clip.y2;
+    }
+    void pixel(int32_t x, int32_t y) const
+    {
+        if (contains(x, y)) paint.put(paint.row(y), x, 255);
+    }
+    // err は imlib と同じく元の色の割合（0 ならインクの色、256 以上なら何もしない）
+    void pixelAA(int32_t x, int32_t y, int err) const
+    {
+        if (err >= 256 || !contains(x, y)) return;
+        paint.put(paint.row(y), x, err <= 1 ? 255 : 256 - err);
+    }
+    // 被覆率（0 ~ 1）で書く
+    void pixelCoverage(int32_t x, int32_t y, float coverage) const
+    {
+        const int c = (int)(coverage * 255.0f + 0.5f);
+        if (c > 0 && contains(x, y)) paint.put(paint.row(y), x, std::min(c, 255));
+    }
+    void xLine(int32_t x1, int32_t x2, int32_t y) const
+    {
+        if (y < clip.y1 || y > clip.y2) return;
+        x1 = std::max(x1, clip.x1);
+        x2 = std::min(x2, clip.x2);
+        if (x1 <= x2) paint.fill(paint.row(y), x1, x2 - x1 + 1);
+    }
+    void yLine(int32_t x, int32_t y1, int32_t y2) const
+    {
+        if (x < clip.x1 || x > clip.x2) return;
+        y1 = std::max(y1, clip.y1);
+        y2 = std::min(y2, clip.y2);
+        for (int32_t y = y1; y <= y2; y++) {
+            paint.fill(paint.row(y), x, 1);
+        }
+    }
+};
+
+struct Box {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+};
+
+// 2 点を対角とする矩形（両端の画素を含む）
+Box drag_box(const Shape& shape)
+{
+    return Box{std::min(shape.x0, shape.x1), std::min(shape.y0, shape.y1), std::abs(shape.x1 - shape.x0) + 1,
+               std::abs(shape.y1 - shape.y0) + 1};
+}
+
+int32_t circle_radius(const Shape& shape)
+{
+    const float dx = (float)(shape.x1 - shape.x0);
+    const float dy = (float)(shape.y1 - shape.y0);
+    return (int32_t)std::lround(std::sqrt(dx * dx + dy * dy));
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    Line                                    */
+/* -------------------------------------------------------------------------- */
+// imlib_draw_thin_line（1 画素幅のアンチエイリアス付き直線）
+template <typename Paint>
+void draw_thin_line(const Plotter<Paint>& p, int x0, int y0, int x1, int y1)
+{
+    const int dx = std::abs(x1 - x0);
+    const int sx = x0 < x1 ? 1 : -1;
+    const int dy = std::abs(y1 - y0);
+    const int sy = y0 < y1 ? 1 : -1;
+    int err      = dx - dy;
+    const int ed = dx + dy == 0 ? 1 : (int)std::sqrt((float)(dx * dx + dy * dy));
+
+    for (;;) {
+        p.pixelAA(x0, y0, 256 * std::abs(err - dx + dy) / ed);
+        const int e2 = err;
+        const int x2 = x0;
+        if (2 * e2 >= -dx) {
+            if (x0 == x1) break;
+            if (e2 + dy < ed) p.pixelAA(x0, y0 + sy, 256 * (e2 + dy) / ed);
+            err -= dy;
+            x0 += sx;
+        }
+        if (2 * e2 <= dy) {
+            if (y0 == y1) break;
+            if (dx - e2 < ed) p.pixelAA(x2 + sx, y0, 256 * (dx - e2) / ed);
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// imlib_draw_line（太さ th のアンチエイリアス付き直線、幅の方向の走査ごとに両端の 1 画素だけ合成する）
+template <typename Paint>
+void draw_line(const Plotter<Paint>& p, int x0, int y0, int x1, int y1, int th)
+{
+    const int ex = std::abs(x1 - x0);
+    const int sx = x0 < x1 ? 1 : -1;
+    const int ey = std::abs(y1 - y0);
+    const int sy = y0 < y1 ? 1 : -1;
+    int e2       = (int)std::sqrt((float)(ex * ex + ey * ey));  // 長さ
+
+    if (th <= 1 || e2 == 0) {
+        draw_thin_line(p, x0, y0, x1, y1);
+        return;
+    }
+
+    const int dx = ex * 256 / e2;
+    const int dy = ey * 256 / e2;
+    th           = 256 * (th - 1);
+
+    if (dx < dy) {
+        // 縦長の線は行ごとに横方向へ塗る
+        x1      = (e2 + th / 2) / dy;  // 開始位置のずれ
+        int err = x1 * dy - th / 2;    // 誤差を幅の分ずらす
+        for (x0 -= x1 * sx;; y0 += sy) {
+            x1 = x0;
+            p.pixelAA(x1, y0, err);
+            int run_start = x1 + sx;
+            for (e2 = dy - err - th; e2 + dy < 256; e2 += dy) {
+                x1 += sx;
+            }
+            if (x1 != x0) p.xLine(std::min(run_start, x1), std::max(run_start, x1), y0);
+            p.pixelAA(x1 + sx, y0, e2);
+            if (y0 == y1) break;
+            err += dx;
+            if (err > 256) {
+                err -= dy;
+                x0 += sx;
+            }
+        }
+    } else {
+        // 横長の線は列ごとに縦方向へ塗る
+        y1      = (e2 + th / 2) / dx;
+        int err = y1 * dx - th / 2;
+        for (y0 -= y1 * sy;; x0 += sx) {
+            y1 = y0;
+            p.pixelAA(x0, y1, err);
+            int run_start = y1 + sy;
+            for (e2 = dx - err - th; e2 + dx < 256; e2 += dx) {
+                y1 += sy;
+            }
+            if (y1 != y0) p.yLine(x0, std::min(run_start, y1), std::max(run_start, y1));
+            p.pixelAA(x0, y1 + sy, e2);
+            if (x0 == x1) break;
+            err += dy;
+            if (err > 256) {
+                err -= dx;
+                y0 += sy;
+            }
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  Rectangle                                 */
+/* -------------------------------------------------------------------------- */
+// imlib_draw_rectangle の枠（辺に沿った帯なのでアンチエイリアスは不要、行ごとの区間で塗る）
+template <typename Paint>
+void draw_rectangle(const Plotter<Paint>& p, const Box& box, int thickness)
+{
+    const int t0    = thickness / 2;
+    const int t1    = (thickness - 1) / 2;
+    const int32_t k = box.y + box.h - 1;
+    const int32_t r = box.x + box.w - 1;
+
+    for (int32_t y = box.y - t0; y <= box.y + t1; y++) {
+        p.xLine(box.x - t0, r + t1, y);
+    }
+    for (int32_t y = std::max(box.y + t1 + 1, k - t0); y <= k + t1; y++) {
+        p.xLine(box.x - t0, r + t1, y);
+    }
+    for (int32_t y = box.y + t1 + 1; y < k - t0; y++) {
+        p.xLine(box.x - t0, std::min(box.x + t1, r - t0 - 1), y);
+        p.xLine(std::max(r - t0, box.x + t1 + 1), r + t1, y);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Circle                                   */
+/* -------------------------------------------------------------------------- */
+// imlib_draw_circle_thin（1 画素幅のアンチエイリアス付きの円）
+template <typename Paint>
+void draw_circle_thin(const Plotter<Paint>& p, int cx, int cy, int r)
+{
+    int x   = r;
+    int y   = 0;
+    int err = 2 - 2 * r;
+    r       = 1 - err;
+    for (;;) {
+        int i = 256 * std::abs(err + 2 * (x + y) - 2) / r;
+        p.pixelAA(cx + x, cy - y, i);
+        p.pixelAA(cx + y, cy + x, i);
+        p.pixelAA(cx - x, cy + y, i);
+        p.pixelAA(cx - y, cy - x, i);
+        if (x == 0) break;
+
+        const int e2 = err;
+        int x2       = x;
+        if (err > y) {
+            // 外側の画素
+            i = 256 * (err + 2 * x - 1) / r;
+            if (i < 256) {
+                p.pixelAA(cx + x, cy - y + 1, i);
+                p.pixelAA(cx + y - 1, cy + x, i);
+                p.pixelAA(cx - x, cy + y - 1, i);
+                p.pixelAA(cx - y + 1, cy - x, i);
+            }
+            err -= --x * 2 - 1;
+        }
+        if (e2 <= x2--) {
+            // 内側の画素
+            i = 256 * (1 - 2 * y - e2) / r;
+            if (i < 256) {
+                p.pixelAA(cx + x2, cy - y, i);
+                p.pixelAA(cx + y, cy + x2, i);
+                p.pixelAA(cx - x2, cy + y, i);
+                p.pixelAA(cx - y, cy - x2, i);
+            }
+            err -= --y * 2 - 1;
+        }
+    }
+}
+
+// imlib_draw_circle の枠（内外 2 本の円の間を 8 分円ごとの区間で塗り、両方の縁をアンチエイリアスする）
+template <typename Paint>
+void draw_circle(const Plotter<Paint>& p, int cx, int cy, int r, int thickness)
+{
+    if (r <= 0) {
+        p.pixel(cx, cy);
+        return;
+    }
+    if (thickness <= 1) {
+        draw_circle_thin(p, cx, cy, r);
+        return;
+    }
+
+    const int t0     = thickness / 2;
+    const int t1     = (thickness - 1) / 2;
+    int xo           = r + t0;
+    int xi           = std::max(r - t1, 0);
+    const int xi_tmp = xi;
+    int y            = 0;
+    int erro         = 1 - xo;
+    int erri         = 1 - xi;
+
+    while (xo >= y) {
+        p.xLine(cx + xi, cx + xo, cy + y);
+        p.yLine(cx + y, cy + xi, cy + xo);
+        p.xLine(cx - xo, cx - xi, cy + y);
+        p.yLine(cx - y, cy + xi, cy + xo);
+        p.xLine(cx - xo, cx - xi, cy - y);
+        p.yLine(cx - y, cy - xo, cy - xi);
+        p.xLine(cx + xi, cx + xo, cy - y);
+        p.yLine(cx + y, cy - xo, cy - xi);
+
+        y++;
+        if (erro < 0) {
+            erro += 2 * y + 1;
+        } else {
+            xo--;
+            erro += 2 * (y - xo + 1);
+        }
+        if (y > xi_tmp) {
+            xi = y;
+        } else if (erri < 0) {
+            erri += 2 * y + 1;
+        } else {
+            xi--;
+            erri += 2 * (y - xi + 1);
+        }
+    }
+
+    draw_circle_thin(p, cx, cy, r + t0);
+    draw_circle_thin(p, cx, cy, xi_tmp);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Ellipse                                  */
+/* -------------------------------------------------------------------------- */
+// 中心から dy の行で、半径 (a, b) の楕円が取る半幅（行が楕円の外なら -1）
+float ellipse_half_width(float a, float b, float dy)
+{
+    if (a <= 0.0f || b <= 0.0f || dy >= b) return -1.0f;
+    return a * std::sqrt(1.0f - (dy * dy) / (b * b));
+}
+
+// 楕円の輪郭までの符号付き距離の近似（外側が正、F / |∇F|）
+float ellipse_distance(float a, float b, float dx, float dy)
+{
+    const float f  = (dx * dx) / (a * a) + (dy * dy) / (b * b) - 1.0f;
+    const float gx = 2.0f * dx / (a * a);
+    const float gy = 2.0f * dy / (b * b);
+    const float g  = std::sqrt(gx * gx + gy * gy);
+    return g > 0.0f ? f / g : -std::min(a, b);
+}
+
+// imlib_draw_ellipse は輪郭の点ごとに太さ分の円を塗るので太い線では遅く、アンチエイリアスもない。
+// 円と同じく内外 2 本の楕円の間を塗る方式にし、行ごとに縁の近くだけ距離から被覆率を求める。
+template <typename Paint>
+void draw_ellipse(const Plotter<Paint>& p, const Box& box, int thickness)
+{
+    const float cx   = box.x + (box.w - 1) * 0.5f;
+    const float cy   = box.y + (box.h - 1) * 0.5f;
+    const float a    = (box.w - 1) * 0.5f;
+    const float b    = (box.h - 1) * 0.5f;
+    const float half = thickness * 0.5f;
+    const float ao   = a + half;
+    const float bo   = b + half;
+    const float ai   = a - half;
+    const float bi   = b - half;
+    const bool hole  = ai > 0.0f && bi > 0.0f;
+
+    auto coverage = [&](float dx, float dy) {
+        float c = std::min(std::max(0.5f - ellipse_distance(ao, bo, dx, dy), 0.0f), 1.0f);
+        if (hole) c *= 1.0f - std::min(std::max(0.5f - ellipse_distance(ai, bi, dx, dy), 0.0f), 1.0f);
+        return c;
+    };
+
+    const int32_t y1 = std::max<int32_t>((int32_t)std::floor(cy - bo - 1.0f), p.clip.y1);
+    const int32_t y2 = std::min<int32_t>((int32_t)std::ceil(cy + bo + 1.0f), p.clip.y2);
+    for (int32_t y = y1; y <= y2; y++) {
+        const float dy = std::fabs(y - cy);
+
+        // 前後の行を含めて輪郭が通る半幅の範囲（この範囲の画素だけ被覆率を求め、間は単色で塗る）
+        const float o_max = ellipse_half_width(ao, bo, std::max(dy - 1.0f, 0.0f)) + 1.0f;
+        const float o_min = ellipse_half_width(ao, bo, dy + 1.0f) - 1.0f;
+        const float i_max = hole ? ellipse_half_width(ai, bi, std::max(dy - 1.0f, 0.0f)) + 1.0f : -1.0f;
+        const float i_min = hole ? ellipse_half_width(ai, bi, dy + 1.0f) - 1.0f : -1.0f;
+        if (o_max < 0.0f) continue;
+
+        for (int side = -1; side <= 1; side += 2) {
+            // 左右それぞれ中心に近い側から外へ（中心の画素は右側で扱う）
+            const int32_t first = side > 0 ? (int32_t)std::ceil(cx + std::max(i_min, 0.0f))
+                                           : std::min((int32_t)std::floor(cx - std::max(i_min, 0.0f)),
+                                                      (int32_t)std::ceil(cx) - 1);
+            const int32_t last  = side > 0 ? (int32_t)std::floor(cx + o_max) : (int32_t)std::ceil(cx - o_max);
+            const int32_t step  = side;
+            int32_t run         = INT32_MIN;
+
+            for (int32_t x = first; side > 0 ? x <= last : x >= last; x += step) {
+                const float dx = std::fabs(x - cx);
+                if (dx > i_max && dx < o_min) {
+                    if (run == INT32_MIN) run = x;
+                    continue;
+                }
+                if (run != INT32_MIN) {
+                    p.xLine(std::min(run, x - step), std::max(run, x - step), y);
+                    run = INT32_MIN;
+                }
+                p.pixelCoverage(x, y, coverage(dx, dy));
+            }
+            if (run != INT32_MIN) p.xLine(std::min(run, last), std::max(run, last), y);
+        }
+    }
+}
+
+template <typename Paint>
+Rect draw_shape_impl(const Shape& shape, const Paint& paint)
+{
+    const Plotter<Paint> p = {paint, paint.bounds()};
+    const int thickness    = std::max<int32_t>(1, shape.thickness);
+    switch (shape.type) {
+        case SHAPE_LINE:
+            draw_line(p, shape.x0, shape.y0, shape.x1, shape.y1, thickness);
+            break;
+        case SHAPE_RECTANGLE:
+            draw_rectangle(p, drag_box(shape), thickness);
+            break;
+        case SHAPE_CIRCLE:
+            draw_circle(p, shape.x0, shape.y0, circle_radius(shape), thickness);
+            break;
+        case SHAPE_ELLIPSE:
+            draw_ellipse(p, drag_box(shape), thickness);
+            break;
+    }
+    return shape.bounds().intersect(p.clip);
+}
+
+}  // namespace
+
+/* -------------------------------------------------------------------------- */
+/*                                    Shape                                   */
+/* -------------------------------------------------------------------------- */
+Rect Shape::bounds() const
+{
+    // 太さの半分にアンチエイリアスの縁と丸めの分を足す（斜めの直線は幅の方向の走査が太さの √2 倍まで伸びる）
+    const int32_t t      = std::max<int32_t>(1, thickness);
+    const int32_t margin = t / 2 + 2;
+    switch (type) {
+        case SHAPE_LINE: {
+            const int32_t m = t + 2;
+            return Rect{std::min(x0, x1) - m, std::min(y0, y1) - m, std::max(x0, x1) + m, std::max(y0, y1) + m};
+        }
+        case SHAPE_CIRCLE: {
+            const int32_t r = circle_radius(*this) + margin;
+            return Rect{x0 - r, y0 - r, x0 + r, y0 + r};
+        }
+        case SHAPE_RECTANGLE:
+        case SHAPE_ELLIPSE:
+        default:
+            return Rect{std::min(x0, x1) - margin, std::min(y0, y1) - margin, std::max(x0, x1) + margin,
+                        std::max(y0, y1) + margin};
+    }
+}
+
+ShapeCover ShapeCover::of(const Shape& shape)
+{
+    ShapeCover cover;
+    const int32_t t      = std::max<int32_t>(1, shape.thickness);
+    const int32_t margin = t / 2 + 2;
+    auto add             = [&](const Rect& rect) { cover.rects[cover.count++] = rect; };
+
+    switch (shape.type) {
+        case SHAPE_LINE: {
+            // 線を等分し、それぞれの区間の外接矩形を太さの分広げる
+            const int32_t m = t + 2;
+            const int n     = std::max(1, std::min<int>(MAX_RECTS, (std::abs(shape.x1 - shape.x0) +
+                                                                    std::abs(shape.y1 - shape.y0)) / (4 * m) + 1));
+            for (int i = 0; i < n; i++) {
+                const int32_t ax = shape.x0 + (shape.x1 - shape.x0) * i / n;
+                const int32_t ay = shape.y0 + (shape.y1 - shape.y0) * i / n;
+                const int32_t bx = shape.x0 + (shape.x1 - shape.x0) * (i + 1) / n;
+                const int32_t by = shape.y0 + (shape.y1 - shape.y0) * (i + 1) / n;
+                add(Rect{std::min(ax, bx) - m, std::min(ay, by) - m, std::max(ax, bx) + m, std::max(ay, by) + m});
+            }
+            break;
+        }
+        case SHAPE_RECTANGLE: {
+            // 4 辺の帯
+            const Rect r = {std::min(shape.x0, shape.x1), std::min(shape.y0, shape.y1), std::max(shape.x0, shape.x1),
+                            std::max(shape.y0, shape.y1)};
+            add(Rect{r.x1 - margin, r.y1 - margin, r.x2 + margin, r.y1 + margin});
+            add(Rect{r.x1 - margin, r.y2 - margin, r.x2 + margin, r.y2 + margin});
+            add(Rect{r.x1 - margin, r.y1 - margin, r.x1 + margin, r.y2 + margin});
+            add(Rect{r.x2 - margin, r.y1 - margin, r.x2 + margin, r.y2 + margin});
+            break;
+        }
+        case SHAPE_CIRCLE:
+        case SHAPE_ELLIPSE: {
+            // 45 度ごとの弧に分ける（各弧の中では座標が単調なので、両端の外接矩形を広げれば弧を覆える）
+            float cx = (float)shape.x0, cy = (float)shape.y0, a = (float)circle_radius(shape), b = a;
+            if (shape.type == SHAPE_ELLIPSE) {
+                const Box box = drag_box(shape);
+                cx            = box.x + (box.w - 1) * 0.5f;
+                cy            = box.y + (box.h - 1) * 0.5f;
+                a             = (box.w - 1) * 0.5f;
+                b             = (box.h - 1) * 0.5f;
+            }
+            for (int i = 0; i < MAX_RECTS; i++) {
+                const float t0  = (float)(2.0 * M_PI * i / MAX_RECTS);
+                const float t1  = (float)(2.0 * M_PI * (i + 1) / MAX_RECTS);
+                const float ax  = cx + a * std::cos(t0);
+                const float ay  = cy + b * std::sin(t0);
+                const float bx  = cx + a * std::cos(t1);
+                const float by  = cy + b * std::sin(t1);
+                const Rect rect = {(int32_t)std::floor(std::min(ax, bx)) - margin,
+                                   (int32_t)std::floor(std::min(ay, by)) - margin,
+                                   (int32_t)std::ceil(std::max(ax, bx)) + margin,
+                                   (int32_t)std::ceil(std::max(ay, by)) + margin};
+                add(rect);
+            }
+            break;
+        }
+    }
+    return cover;
+}
+
+Rect drawing::draw_shape(const PixelBuffer565& buffer, const Shape& shape, uint16_t color)
+{
+    return draw_shape_impl(shape, SolidPaint(buffer, color));
+}
+
+Rect drawing::draw_shape(InkLayer& layer, const Shape& shape, const InkPen& pen)
+{
+    if (pen.erase) return draw_shape_impl(shape, InkErasePaint{layer});
+    return draw_shape_impl(shape, InkPaint{layer, pen.index});
+}
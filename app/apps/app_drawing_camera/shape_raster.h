@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "brush.h"
+#include "ink_layer.h"
+#include <cstdint>
+
+namespace drawing {
+
+enum ShapeType : uint8_t { SHAPE_LINE, SHAPE_RECTANGLE, SHAPE_CIRCLE, SHAPE_ELLIPSE };
+
+/**
+ * @brief ドラッグで決まる図形（始点・終点と線の太さ）
+ *
+ * 直線は始点から終点まで、矩形と楕円は 2 点を対角とする矩形に収まる形、円は始点を中心に終点を通る形。
+ */
+struct Shape {
+    ShapeType type    = SHAPE_LINE;
+    int32_t x0        = 0;
+    int32_t y0        = 0;
+    int32_t x1        = 0;
+    int32_t y1        = 0;
+    int32_t thickness = 1;
+
+    /**
+     * @brief 描画する可能性のある範囲（アンチエイリアスの縁を含む）
+     *
+     */
+    Rect bounds() const;
+};
+
+/**
+ * @brief 図形の線が通る範囲を覆う、外接矩形より小さな矩形の組
+ *
+ * 円や楕円の内側のように線が通らない部分を含まないので、大きな図形でも画面の更新量は線の長さに比例する。
+ * プレビューの消去（その範囲だけ合成し直す）と無効化、確定時のアンドゥ用の保存に使う。
+ */
+struct ShapeCover {
+    static constexpr int MAX_RECTS = 8;
+
+    Rect rects[MAX_RECTS];
+    int count = 0;
+
+    static ShapeCover of(const Shape& shape);
+};
+
+/**
+ * @brief 図形を描く（OpenMV imlib の draw.c の直線・矩形・円を移植したもの）
+ *
+ * 書き込み先は Paint で切り替え、プレビューは表示用の RGB565 に、確定した図形はインクのレイヤーに描く。
+ *
+ * @return Rect 書き込んだ可能性のある範囲（バッファ内にクリップ済み）
+ */
+Rect draw_shape(const PixelBuffer565& buffer, const Shape& shape, uint16_t color);
+Rect draw_shape(InkLayer& layer, const Shape& shape, const InkPen& pen);
+
+}  // namespace drawing
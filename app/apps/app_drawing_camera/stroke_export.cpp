@@ -0,0 +1,521 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "stroke_export.h"
+#include "brush.h"
+#include "stroke_smoother.h"
+#include "symmetry.h"
+#include "shape_raster.h"
+#include "flood_fill.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace drawing;
+
+int ExportOptions::defaultThreads()
+{
+#ifdef PLATFORM_BUILD_DESKTOP
+    return std::max(1u, std::thread::hardware_concurrency());
+#else
+    // 実機では作業領域を増やさないように 1 スレッドで描く
+    return 1;
+#endif
+}
+
+namespace {
+
+struct ScriptPoint {
+    int32_t x;
+    int32_t y;
+};
+
+struct ScriptStroke {
+    uint8_t tool   = StrokeEvent::TOOL_PEN;
+    uint8_t color  = 0;
+    uint8_t size     = 0;
+    uint8_t symmetry = 0;  // SymmetryMode::encode()
+    int32_t centerX2 = 0;  // 等倍での対称の中心の座標の 2 倍
+    int32_t centerY2 = 0;
+    uint32_t first   = 0;  // ScriptPoint の位置
+    uint32_t count   = 0;
+    Rect bounds;           // 等倍での範囲（平滑化による膨らみと対称なコピーを含む）
+};
+
+struct ScriptSpan {
+    int16_t y;
+    int16_t x1;
+    int16_t x2;
+};
+
+struct ScriptFill {
+    uint8_t color = 0;
+    int32_t x     = 0;
+    int32_t y     = 0;
+    Rect area;                      // 領域を広げた範囲（描画時と同じ）
+    std::vector<ScriptSpan> spans;  // 等倍で求めた塗る区間
+};
+
+struct ScriptShape {
+    Shape shape;  // 等倍での図形
+    uint8_t color = 0;
+};
+
+struct ScriptOp {
+    enum Kind : uint8_t { STROKE, FILL, CLEAR, SHAPE };
+    Kind kind;
+    uint32_t index;      // strokes か fills か shapes の位置
+    uint32_t count = 1;  // STROKE では同時に描いたストロークの数（1 回のアンドゥ単位）
+};
+
+// アンドゥ・リドゥ・クリアを反映した、最終的に見えている操作の列
+struct Script {
+    std::vector<ScriptPoint> points;
+    std::vector<ScriptStroke> strokes;
+    std::vector<ScriptFill> fills;
+    std::vector<ScriptShape> shapes;
+    std::vector<ScriptOp> ops;
+};
+
+Script build_script(const StrokeLog& log)
+{
+    Script script;
+    std::vector<ScriptOp> done;
+    std::vector<ScriptOp> undone;
+
+    // 同時に描いたストロークは指ごとに点をためておき、閉じた順に points へ移す。
+    // 重なって描かれたストロークの組は、アプリと同じく最後の指が離れたときに 1 つの操作になる
+    std::vector<ScriptPoint> open_points[StrokeLog::MAX_FINGERS];
+    int open_stroke[StrokeLog::MAX_FINGERS];
+    std::fill(std::begin(open_stroke), std::end(open_stroke), -1);
+    int open_count       = 0;
+    uint32_t group_first = 0;
+
+    auto push_op = [&](ScriptOp op) {
+        done.push_back(op);
+        undone.clear();
+    };
+    auto end_stroke = [&](int finger) {
+        if (open_stroke[finger] < 0) return;
+        ScriptStroke& stroke = script.strokes[open_stroke[finger]];
+        stroke.first         = script.points.size();
+        stroke.count         = open_points[finger].size();
+        script.points.insert(script.points.end(), open_points[finger].begin(), open_points[finger].end());
+        open_points[finger].clear();
+        open_stroke[finger] = -1;
+        if (--open_count == 0) {
+            push_op(ScriptOp{ScriptOp::STROKE, group_first, (uint32_t)script.strokes.size() - group_first});
+        }
+    };
+    auto close_stroke = [&]() {
+        for (int finger = 0; finger < StrokeLog::MAX_FINGERS; finger++) {
+            end_stroke(finger);
+        }
+    };
+
+    log.forEach([&](const StrokeEvent& e) {
+        switch (e.type) {
+            case StrokeEvent::STROKE_BEGIN: {
+                end_stroke(e.finger);
+                if (open_count == 0) group_first = script.strokes.size();
+                ScriptStroke stroke;
+                stroke.tool     = e.tool;
+                stroke.color    = e.color;
+                stroke.size     = e.brushSize;
+                stroke.symmetry = e.symmetry;
+                stroke.centerX2 = e.centerX2;
+                stroke.centerY2 = e.centerY2;
+                script.strokes.push_back(stroke);
+                open_stroke[e.finger] = (int)script.strokes.size() - 1;
+                open_points[e.finger].push_back(ScriptPoint{e.x, e.y});
+                open_count++;
+                break;
+            }
+            case StrokeEvent::STROKE_POINT:
+                if (open_stroke[e.finger] >= 0) open_points[e.finger].push_back(ScriptPoint{e.x, e.y});
+                break;
+            case StrokeEvent::STROKE_END:
+                end_stroke(e.finger);
+                break;
+            case StrokeEvent::STROKE_CANCEL:
+                // 組の途中で取り消されたので、組のストロークはどれも残らない
+                for (int finger = 0; finger < StrokeLog::MAX_FINGERS; finger++) {
+                    open_points[finger].clear();
+                    open_stroke[finger] = -1;
+                }
+                open_count = 0;
+                script.strokes.resize(group_first);
+                break;
+            case StrokeEvent::FILL: {
+                close_stroke();
+                ScriptFill fill;
+                fill.color = e.color;
+                fill.x     = e.x;
+                fill.y     = e.y;
+                fill.area  = e.area;
+                script.fills.push_back(std::move(fill));
+                push_op(ScriptOp{ScriptOp::FILL, (uint32_t)script.fills.size() - 1});
+                break;
+            }
+            case StrokeEvent::SHAPE: {
+                close_stroke();
+                ScriptShape shape;
+                shape.shape.type      = (ShapeType)e.shape;
+                shape.shape.x0        = e.x;
+                shape.shape.y0        = e.y;
+                shape.shape.x1        = e.endX;
+                shape.shape.y1        = e.endY;
+                shape.shape.thickness = e.brushSize;
+                shape.color           = e.color;
+                script.shapes.push_back(shape);
+                push_op(ScriptOp{ScriptOp::SHAPE, (uint32_t)script.shapes.size() - 1});
+                break;
+            }
+            case StrokeEvent::CLEAR:
+                close_stroke();
+                push_op(ScriptOp{ScriptOp::CLEAR, 0});
+                break;
+            case StrokeEvent::UNDO:
+                close_stroke();
+                if (!done.empty()) {
+                    undone.push_back(done.back());
+                    done.pop_back();
+                }
+                break;
+            case StrokeEvent::REDO:
+                close_stroke();
+                if (!undone.empty()) {
+                    done.push_back(undone.back());
+                    undone.pop_back();
+                }
+                break;
+            case StrokeEvent::PHOTO:
+                // 写真を差し替えるとインクも履歴も消える
+                close_stroke();
+                done.clear();
+                undone.clear();
+                break;
+            default:
+                break;
+        }
+    });
+    close_stroke();
+
+    // 最後のクリアより前の操作は見えない
+    auto is_clear   = [](const ScriptOp& op) { return op.kind == ScriptOp::CLEAR; };
+    auto last_clear = std::find_if(done.rbegin(), done.rend(), is_clear);
+    script.ops.assign(last_clear.base(), done.end());
+
+    Symmetry symmetry;
+    for (ScriptStroke& stroke : script.strokes) {
+        // Catmull-Rom は入力点の外側に少し膨らむので、ブラシの直径分の余裕を持たせる
+        Rect bounds;
+        for (uint32_t j = stroke.first; j < stroke.first + stroke.count; j++) {
+            const ScriptPoint& p = script.points[j];
+            bounds.join(Rect{p.x - stroke.size, p.y - stroke.size, p.x + stroke.size, p.y + stroke.size});
+        }
+        symmetry.setMode(SymmetryMode::decode(stroke.symmetry), stroke.centerX2, stroke.centerY2);
+        for (int c = 0; c < symmetry.copies(); c++) {
+            stroke.bounds.join(symmetry.applyBounds(c, bounds));
+        }
+    }
+    return script;
+}
+
+/**
+ * @brief 描画時と同じ手順（平滑化 → 線分）で 1 本のストロークを描き直す
+ *
+ */
+class StrokeReplayer {
+public:
+    void draw(InkLayer& layer, const Script& script, const ScriptStroke& stroke, int scale, int32_t offsetY,
+              float spacing)
+    {
+        Brush& brush = brush_for(std::min(stroke.size * scale, MAX_BRUSH_SIZE));
+        InkPen pen   = stroke.tool == StrokeEvent::TOOL_ERASER ? InkPen::eraser() : InkPen::draw(stroke.color);
+
+        // 対称なコピーは記録した中心を拡大した位置のまわりに変換し、バンドの位置へずらす
+        const int32_t center_x2 = stroke.centerX2 * scale;
+        const int32_t center_y2 = stroke.centerY2 * scale;
+        if (stroke.symmetry != _symmetry_code || center_x2 != _symmetry.centerX2() ||
+            center_y2 != _symmetry.centerY2()) {
+            _symmetry_code = stroke.symmetry;
+            _symmetry.setMode(SymmetryMode::decode(stroke.symmetry), center_x2, center_y2);
+        }
+        _symmetry.setOffset(0, offsetY);
+
+        auto ignore              = [](const Rect&) {};
+        const ScriptPoint& start = script.points[stroke.first];
+        _stroke.begin(layer, brush, pen, _symmetry, start.x * scale, start.y * scale, ignore, ignore);
+        _smoother.begin(start.x * scale, start.y * scale, brush.size() * 0.5f * spacing);
+
+        auto emit = [&](const StrokePoint& p) {
+            _stroke.lineTo(layer, (int32_t)std::lround(p.x), (int32_t)std::lround(p.y), ignore, ignore);
+        };
+        for (uint32_t i = 1; i < stroke.count; i++) {
+            const ScriptPoint& p = script.points[stroke.first + i];
+            _smoother.addPoint(p.x * scale, p.y * scale, emit);
+        }
+        _smoother.finish(emit);
+        _stroke.end();
+    }
+
+private:
+    // 専用カーネルのないサイズはマスクの生成に時間がかかるので、サイズごとに使い回す
+    std::unique_ptr<Brush> _brushes[MAX_BRUSH_SIZE + 1];
+    int _symmetry_code = -1;
+    Symmetry _symmetry;
+    SymmetryStroke _stroke;
+    StrokeSmoother _smoother;
+
+    Brush& brush_for(int size)
+    {
+        size = std::max(1, size);
+        if (!_brushes[size]) {
+            _brushes[size].reset(new Brush());
+            _brushes[size]->setSize(size);
+        }
+        return *_brushes[size];
+    }
+};
+
+// 拡大後の座標と太さで、バンドの位置へずらした図形
+Shape scale_shape(const Shape& shape, int scale, int32_t offsetY)
+{
+    Shape scaled     = shape;
+    scaled.x0        = shape.x0 * scale;
+    scaled.y0        = shape.y0 * scale - offsetY;
+    scaled.x1        = shape.x1 * scale;
+    scaled.y1        = shape.y1 * scale - offsetY;
+    scaled.thickness = shape.thickness * scale;
+    return scaled;
+}
+
+void copy_palette(const InkLayer& from, InkLayer& to)
+{
+    for (int i = 0; i < INK_PALETTE_SIZE; i++) {
+        to.setPaletteColor(i, from.paletteColor(i));
+    }
+}
+
+/**
+ * @brief 等倍で操作を再生して、塗りつぶしの区間を求める
+ *
+ * @return size_t 使った作業領域のバイト数
+ */
+size_t resolve_fills(Script& script, const InkLayer& canvas, const PixelBuffer565& photo, const ExportOptions& options)
+{
+    const int32_t width  = canvas.width();
+    const int32_t height = canvas.height();
+
+    InkLayer ink;
+    ink.init(width, height, canvas.format());
+    copy_palette(canvas, ink);
+    FloodFill flood_fill;
+    flood_fill.init(width, height);
+    StrokeReplayer replayer;
+
+    size_t peak_tiles = 0;
+    for (const ScriptOp& op : script.ops) {
+        if (op.kind == ScriptOp::STROKE) {
+            for (uint32_t i = op.index; i < op.index + op.count; i++) {
+                replayer.draw(ink, script, script.strokes[i], 1, 0, options.spacing);
+            }
+        } else if (op.kind == ScriptOp::SHAPE) {
+            const ScriptShape& shape = script.shapes[op.index];
+            draw_shape(ink, shape.shape, InkPen::draw(shape.color));
+        } else if (op.kind == ScriptOp::FILL) {
+            // 描画時と同じく、見えている画像（インクと写真の合成結果）で同じ範囲に領域を求め、タイルごとに塗る
+            ScriptFill& fill = script.fills[op.index];
+            InkCompositePixels composite(ink, photo, options.paper);
+            auto record_span = [&](const Rect& span) {
+                fill.spans.push_back(ScriptSpan{(int16_t)span.y1, (int16_t)span.x1, (int16_t)span.x2});
+            };
+            const auto result = flood_fill.fillSpans(composite, fill.x, fill.y, options.fillTolerance, fill.area,
+                                                     record_span);
+            flood_fill.forEachFilledTile(
+                result.bounds, ink.grid(), [&](int index) { ink.fillTile(index, fill.color); },
+                [&](int, const Rect& span) { ink.fillSpan(span.y1, span.x1, span.x2, fill.color); });
+        }
+        peak_tiles = std::max<size_t>(peak_tiles, ink.residentCount());
+    }
+
+    size_t spans = 0;
+    for (const auto& fill : script.fills) {
+        spans += fill.spans.size();
+    }
+    return peak_tiles * ink.tileBytes() + (size_t)((width + 31) / 32) * height * sizeof(uint32_t) +
+           spans * sizeof(ScriptSpan);
+}
+
+/**
+ * @brief 1 スレッド分のバンドの作業領域
+ *
+ */
+class BandRenderer {
+public:
+    BandRenderer(const Script& script, const InkLayer& canvas, const PixelBuffer565& photo,
+                 const ExportOptions& options)
+        : _script(script),
+          _photo(photo),
+          _options(options),
+          _width(canvas.width() * options.scale),
+          _height(canvas.height() * options.scale)
+    {
+        _ink.init(_width, options.bandHeight, canvas.format());
+        copy_palette(canvas, _ink);
+        _pixels.resize((size_t)_width * options.bandHeight);
+    }
+
+    PixelBuffer565 render(int32_t y0)
+    {
+        const int scale = _options.scale;
+        const int32_t h = std::min(_options.bandHeight, _height - y0);
+        const Rect band = {0, y0, _width - 1, y0 + h - 1};
+        _ink.clear();
+
+        for (const ScriptOp& op : _script.ops) {
+            if (op.kind == ScriptOp::STROKE) {
+                for (uint32_t i = op.index; i < op.index + op.count; i++) {
+                    const ScriptStroke& stroke = _script.strokes[i];
+                    const Rect& b              = stroke.bounds;
+                    if (b.y2 * scale + scale - 1 < band.y1 || b.y1 * scale > band.y2) continue;
+                    _replayer.draw(_ink, _script, stroke, scale, y0, _options.spacing);
+                }
+            } else if (op.kind == ScriptOp::SHAPE) {
+                const ScriptShape& shape = _script.shapes[op.index];
+                const Shape scaled       = scale_shape(shape.shape, scale, y0);
+                if (!scaled.bounds().intersects(_ink.bounds())) continue;
+                draw_shape(_ink, scaled, InkPen::draw(shape.color));
+            } else if (op.kind == ScriptOp::FILL) {
+                const ScriptFill& fill = _script.fills[op.index];
+                for (const ScriptSpan& span : fill.spans) {
+                    const int32_t sy1 = std::max<int32_t>(span.y * scale, y0);
+                    const int32_t sy2 = std::min<int32_t>(span.y * scale + scale - 1, band.y2);
+                    for (int32_t y = sy1; y <= sy2; y++) {
+                        _ink.fillSpan(y - y0, span.x1 * scale, span.x2 * scale + scale - 1, fill.color);
+                    }
+                }
+            }
+        }
+        _peak_tiles = std::max<size_t>(_peak_tiles, _ink.tileCount());
+
+        // 写真を最近傍で拡大した上にインクを重ねる（写真の外は下地の色）
+        PixelBuffer565 out = {_pixels.data(), _width, h, _width};
+        for (int32_t y = 0; y < h; y++) {
+            uint16_t* dst    = out.row(y);
+            const int32_t py = (y0 + y) / scale;
+            if (!_photo.data || py >= _photo.height) {
+                fill_span_565(dst, _width, _options.paper);
+                continue;
+            }
+            const uint16_t* src   = _photo.row(py);
+            const int32_t covered = std::min(_width, _photo.width * scale);
+            for (int32_t x = 0; x < covered; x++) {
+                dst[x] = src[x / scale];
+            }
+            fill_span_565(dst + covered, _width - covered, _options.paper);
+        }
+        _ink.compositeOver(out.bounds(), out);
+        return out;
+    }
+
+    size_t bytes() const
+    {
+        return _pixels.size() * sizeof(uint16_t) + _peak_tiles * _ink.tileBytes();
+    }
+
+private:
+    const Script& _script;
+    PixelBuffer565 _photo;
+    const ExportOptions& _options;
+    int32_t _width     = 0;
+    int32_t _height    = 0;
+    size_t _peak_tiles = 0;
+    InkLayer _ink;
+    std::vector<uint16_t> _pixels;
+    StrokeReplayer _replayer;
+};
+
+}  // namespace
+
+ExportStats drawing::export_stroke_log(const StrokeLog& log, const InkLayer& canvas, const PixelBuffer565& photo,
+                                       const ExportOptions& options, const ExportBandFn& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    ExportOptions opt = options;
+    opt.scale         = std::max(1, opt.scale);
+    opt.bandHeight    = std::max<int32_t>(1, opt.bandHeight);
+    opt.threads       = std::max(1, opt.threads);
+
+    const bool has_photo = photo.data && photo.width <= canvas.width() && photo.height <= canvas.height();
+    PixelBuffer565 base  = has_photo ? photo : PixelBuffer565();
+
+    Script script = build_script(log);
+
+    ExportStats stats;
+    stats.width  = canvas.width() * opt.scale;
+    stats.height = canvas.height() * opt.scale;
+    stats.bands  = (stats.height + opt.bandHeight - 1) / opt.bandHeight;
+    for (const ScriptOp& op : script.ops) {
+        stats.strokes += op.kind == ScriptOp::STROKE ? op.count : 0;
+        stats.fills += op.kind == ScriptOp::FILL;
+        stats.shapes += op.kind == ScriptOp::SHAPE;
+    }
+    if (stats.bands == 0) return stats;
+    if (stats.fills > 0) {
+        stats.prepassBytes = resolve_fills(script, canvas, base, opt);
+    }
+
+    // 各スレッドは次のバンドを取って描き、自分の番が来たら順に出力する
+    const int threads = std::min(opt.threads, stats.bands);
+    std::atomic<int> next_band(0);
+    int emit_band = 0;
+    std::mutex mutex;
+    std::condition_variable emitted;
+    std::vector<size_t> band_bytes(threads, 0);
+
+    auto worker = [&](int id) {
+        BandRenderer renderer(script, canvas, base, opt);
+        while (true) {
+            const int band = next_band++;
+            if (band >= stats.bands) break;
+            const int32_t y    = band * opt.bandHeight;
+            PixelBuffer565 out = renderer.render(y);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            emitted.wait(lock, [&]() { return emit_band == band; });
+            fn(y, out);
+            emit_band++;
+            emitted.notify_all();
+        }
+        band_bytes[id] = renderer.bytes();
+    };
+
+    if (threads <= 1) {
+        worker(0);
+    } else {
+        std::vector<std::thread> pool;
+        for (int i = 0; i < threads; i++) {
+            pool.emplace_back(worker, i);
+        }
+        for (auto& thread : pool) {
+            thread.join();
+        }
+    }
+
+    stats.threads      = threads;
+    stats.bandBytes    = *std::max_element(band_bytes.begin(), band_bytes.end());
+    auto end           = std::chrono::steady_clock::now();
+    stats.milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    return stats;
+}
@@ -0,0 +1,72 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "stroke_log.h"
+#include "ink_layer.h"
+#include <cstdint>
+#include <functional>
+
+namespace drawing {
+
+/**
+ * @brief 書き出しの設定
+ *
+ */
+struct ExportOptions {
+    int scale          = 2;       // キャンバスに対する倍率
+    int32_t bandHeight = 64;      // 1 バンドの行数（作業領域はこれと出力の幅で決まる）
+    int threads        = 1;       // バンドを並列に描くスレッド数
+    float spacing      = 1.0f;    // 補間点の間隔（ブラシ半径比、描画時と同じ値にする）
+    int fillTolerance  = 0;       // 塗りつぶしの許容差（描画時と同じ値にする）
+    uint16_t paper     = 0xFFFF;  // 写真がない場合の下地の色
+
+    /**
+     * @brief 既定のスレッド数（デスクトップでは CPU 数、実機では 1）
+     *
+     */
+    static int defaultThreads();
+};
+
+struct ExportStats {
+    int32_t width       = 0;
+    int32_t height      = 0;
+    int bands           = 0;
+    int threads         = 0;
+    uint32_t strokes    = 0;  // 再生したストローク数（取り消されたものは含まない）
+    uint32_t fills      = 0;
+    uint32_t shapes     = 0;
+    size_t bandBytes    = 0;  // 1 スレッドあたりの作業領域の最大
+    size_t prepassBytes = 0;  // 塗りつぶしの領域を求めるための等倍の作業領域（塗りつぶしがなければ 0）
+    double milliseconds = 0.0;
+};
+
+/**
+ * @brief バンドの出力先
+ *
+ * バンドは上から順に 1 回ずつ呼ばれる（複数スレッドで描く場合も呼び出しは直列で、順序は保たれる）。
+ * band は呼び出しの間だけ有効。
+ */
+using ExportBandFn = std::function<void(int32_t y, const PixelBuffer565& band)>;
+
+/**
+ * @brief 操作ログを任意の倍率で描き直し、行のバンドごとに出力する
+ *
+ * ログからアンドゥ・リドゥ・クリアを反映した最終的な操作列を作り、バンドごとにそのバンドにかかる
+ * ストロークと図形だけを拡大した座標と太さで描き直す（平滑化も拡大後の座標で行うので、線は拡大後の解像度で滑らか）。
+ * 写真は最近傍で拡大する。塗りつぶしは形を持たないので等倍で領域を求め、その区間を拡大して塗る。
+ * 必要なメモリはバンドの大きさとスレッド数で決まり、出力の高さによらない。
+ *
+ * @param log
+ * @param canvas 等倍のキャンバス（大きさとパレットを使う。描かれている内容は使わない）
+ * @param photo 等倍の写真（キャンバスの左上に置き、写真の外と data が nullptr の場合は options.paper の単色）
+ * @param options
+ * @param fn
+ */
+ExportStats export_stroke_log(const StrokeLog& log, const InkLayer& canvas, const PixelBuffer565& photo,
+                              const ExportOptions& options, const ExportBandFn& fn);
+
+}  // namespace drawing
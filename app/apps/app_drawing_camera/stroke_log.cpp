@@ -0,0 +1,304 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "stroke_log.h"
+#include <algorithm>
+
+using namespace drawing;
+
+// 先頭の varint の最下位ビット（1 なら点以外のイベント、続く 4 ビットが種類）
+static constexpr uint32_t RECORD_CONTROL_FLAG = 1;
+static constexpr int RECORD_TYPE_BITS         = 4;
+static constexpr uint32_t MAX_DELTA_MS        = (1u << (31 - RECORD_TYPE_BITS)) - 1;
+
+// SymmetryMode::encode() が回転 2 以上か鏡映ありなら、コピーの位置を決める中心もストロークに記録する
+static bool has_symmetry_center(uint8_t symmetry)
+{
+    return (symmetry & 0x1F) > 1;
+}
+
+void StrokeLog::init(size_t maxBytes, size_t preallocBytes, size_t chunkBytes)
+{
+    _chunk_bytes = std::max(chunkBytes, MAX_RECORD_BYTES);
+    _max_chunks  = std::max<size_t>(1, maxBytes / _chunk_bytes);
+
+    // 追加でチャンクを確保しても配列が再配置されないように、上限分の枠を先に取る
+    _chunks.clear();
+    _chunks.reserve(_max_chunks);
+    size_t prealloc = std::min(_max_chunks, std::max<size_t>(1, (preallocBytes + _chunk_bytes - 1) / _chunk_bytes));
+    for (size_t i = 0; i < prealloc; i++) {
+        _chunks.push_back(Chunk_t{std::unique_ptr<uint8_t[]>(new uint8_t[_chunk_bytes]), 0});
+    }
+    clear();
+}
+
+void StrokeLog::clear()
+{
+    for (auto& chunk : _chunks) {
+        chunk.used = 0;
+    }
+    _chunk_index    = 0;
+    _stats          = Stats_t();
+    _stats.reserved = _chunks.size() * _chunk_bytes;
+    _base_time      = 0;
+    _last_time      = 0;
+    _open_fingers   = 0;
+    _finger         = 0;
+    _empty          = true;
+    std::fill(std::begin(_last_x), std::end(_last_x), 0);
+    std::fill(std::begin(_last_y), std::end(_last_y), 0);
+}
+
+void StrokeLog::beginStroke(uint32_t timeMs, uint8_t tool, uint8_t color, uint8_t brushSize, uint8_t symmetry,
+                            int32_t centerX2, int32_t centerY2, int32_t x, int32_t y, uint8_t finger)
+{
+    if (!select_finger(finger, timeMs)) return;
+    uint8_t* out = reserve_record();
+    if (!out) return;
+
+    out    = encode_header(out, StrokeEvent::STROKE_BEGIN, timeMs);
+    *out++ = tool;
+    *out++ = color;
+    *out++ = brushSize;
+    *out++ = symmetry;
+    if (has_symmetry_center(symmetry)) {
+        out = encode_varint(zigzag_encode(centerX2), out);
+        out = encode_varint(zigzag_encode(centerY2), out);
+    }
+    out = encode_varint(zigzag_encode(x), out);
+    out = encode_varint(zigzag_encode(y), out);
+    commit_record(out);
+
+    _last_x[finger] = x;
+    _last_y[finger] = y;
+    _open_fingers |= 1u << finger;
+    _stats.strokes++;
+    _stats.points++;
+}
+
+void StrokeLog::addPoint(uint32_t timeMs, int32_t x, int32_t y, uint8_t finger)
+{
+    if (finger >= MAX_FINGERS || !(_open_fingers & (1u << finger)) || !select_finger(finger, timeMs)) return;
+    uint8_t* out = reserve_record();
+    if (!out) return;
+
+    // 点は種類を持たず、経過時間と座標の差分だけ
+    uint32_t dt = std::min(timeMs - std::min(timeMs, _last_time), MAX_DELTA_MS);
+    out         = encode_varint(dt << 1, out);
+    out         = encode_varint(zigzag_encode(x - _last_x[finger]), out);
+    out         = encode_varint(zigzag_encode(y - _last_y[finger]), out);
+    commit_record(out);
+
+    _last_time      = std::max(timeMs, _last_time);
+    _last_x[finger] = x;
+    _last_y[finger] = y;
+    _stats.points++;
+}
+
+void StrokeLog::endStroke(uint32_t timeMs, uint8_t finger)
+{
+    if (finger >= MAX_FINGERS || !(_open_fingers & (1u << finger))) return;
+    _open_fingers &= ~(1u << finger);
+    if (select_finger(finger, timeMs)) event(StrokeEvent::STROKE_END, timeMs);
+}
+
+void StrokeLog::cancelStrokes(uint32_t timeMs)
+{
+    if (!_open_fingers) return;
+    _open_fingers = 0;
+    event(StrokeEvent::STROKE_CANCEL, timeMs);
+}
+
+void StrokeLog::fill(uint32_t timeMs, uint8_t color, int32_t x, int32_t y, const Rect& area)
+{
+    uint8_t* out = reserve_record();
+    if (!out) return;
+
+    // 範囲は左上と大きさ（空の範囲は大きさ 0）
+    out    = encode_header(out, StrokeEvent::FILL, timeMs);
+    *out++ = color;
+    out    = encode_varint(zigzag_encode(x), out);
+    out    = encode_varint(zigzag_encode(y), out);
+    out    = encode_varint(zigzag_encode(area.x1), out);
+    out    = encode_varint(zigzag_encode(area.y1), out);
+    out    = encode_varint(std::max<int32_t>(0, area.width()), out);
+    out    = encode_varint(std::max<int32_t>(0, area.height()), out);
+    commit_record(out);
+}
+
+void StrokeLog::shape(uint32_t timeMs, uint8_t shape, uint8_t color, uint8_t thickness, int32_t x0, int32_t y0,
+                      int32_t x1, int32_t y1)
+{
+    uint8_t* out = reserve_record();
+    if (!out) return;
+
+    // 終点は始点からの差分（小さな図形ほど短くなる）
+    out    = encode_header(out, StrokeEvent::SHAPE, timeMs);
+    *out++ = shape;
+    *out++ = color;
+    *out++ = thickness;
+    out    = encode_varint(zigzag_encode(x0), out);
+    out    = encode_varint(zigzag_encode(y0), out);
+    out    = encode_varint(zigzag_encode(x1 - x0), out);
+    out    = encode_varint(zigzag_encode(y1 - y0), out);
+    commit_record(out);
+}
+
+void StrokeLog::event(StrokeEvent::Type type, uint32_t timeMs)
+{
+    uint8_t* out = reserve_record();
+    if (!out) return;
+    commit_record(encode_header(out, type, timeMs));
+}
+
+uint8_t* StrokeLog::reserve_record()
+{
+    if (_chunks.empty()) {
+        _stats.dropped++;
+        return nullptr;
+    }
+
+    // レコードはチャンクをまたがないので、最大長が入らなければ次のチャンクへ
+    Chunk_t* chunk = &_chunks[_chunk_index];
+    if (chunk->used + MAX_RECORD_BYTES > _chunk_bytes) {
+        if (_chunk_index + 1 >= _max_chunks) {
+            _stats.dropped++;
+            return nullptr;
+        }
+        _chunk_index++;
+        if (_chunk_index == _chunks.size()) {
+            _chunks.push_back(Chunk_t{std::unique_ptr<uint8_t[]>(new uint8_t[_chunk_bytes]), 0});
+            _stats.reserved += _chunk_bytes;
+        }
+        chunk = &_chunks[_chunk_index];
+    }
+    return chunk->data.get() + chunk->used;
+}
+
+void StrokeLog::commit_record(uint8_t* end)
+{
+    Chunk_t& chunk = _chunks[_chunk_index];
+    size_t bytes   = end - (chunk.data.get() + chunk.used);
+    chunk.used += bytes;
+    _stats.bytes += bytes;
+    _stats.events++;
+}
+
+uint8_t* StrokeLog::encode_header(uint8_t* out, StrokeEvent::Type type, uint32_t timeMs)
+{
+    // 最初のレコードの時刻を基準にする
+    if (_empty) {
+        _base_time = timeMs;
+        _last_time = timeMs;
+        _empty     = false;
+    }
+    uint32_t dt = std::min(timeMs - std::min(timeMs, _last_time), MAX_DELTA_MS);
+    _last_time  = std::max(timeMs, _last_time);
+    return encode_varint((((dt << RECORD_TYPE_BITS) | type) << 1) | RECORD_CONTROL_FLAG, out);
+}
+
+bool StrokeLog::select_finger(uint8_t finger, uint32_t timeMs)
+{
+    if (finger >= MAX_FINGERS) return false;
+    if (finger == _finger) return true;
+
+    uint8_t* out = reserve_record();
+    if (!out) return false;
+    out    = encode_header(out, StrokeEvent::STROKE_FINGER, timeMs);
+    *out++ = finger;
+    commit_record(out);
+    _finger = finger;
+    return true;
+}
+
+const uint8_t* StrokeLog::decode_record(const uint8_t* src, StrokeEvent& event, DecodeState_t& state)
+{
+    uint32_t header = 0;
+    uint32_t value  = 0;
+    src             = decode_varint(src, header);
+    int32_t& x      = state.x[state.finger];
+    int32_t& y      = state.y[state.finger];
+    event.finger    = state.finger;
+
+    if (!(header & RECORD_CONTROL_FLAG)) {
+        state.time += header >> 1;
+        src = decode_varint(src, value);
+        x += zigzag_decode(value);
+        src = decode_varint(src, value);
+        y += zigzag_decode(value);
+
+        event.type   = StrokeEvent::STROKE_POINT;
+        event.timeMs = state.time;
+        event.x      = x;
+        event.y      = y;
+        return src;
+    }
+
+    header >>= 1;
+    state.time += header >> RECORD_TYPE_BITS;
+    event.type   = (StrokeEvent::Type)(header & ((1u << RECORD_TYPE_BITS) - 1));
+    event.timeMs = state.time;
+
+    // 塗りつぶしと図形の座標はストロークの差分の基準を変えない
+    event.x = x;
+    event.y = y;
+    switch (event.type) {
+        case StrokeEvent::STROKE_BEGIN:
+            event.tool      = *src++;
+            event.color     = *src++;
+            event.brushSize = *src++;
+            event.symmetry  = *src++;
+            event.centerX2  = 0;
+            event.centerY2  = 0;
+            if (has_symmetry_center(event.symmetry)) {
+                src            = decode_varint(src, value);
+                event.centerX2 = zigzag_decode(value);
+                src            = decode_varint(src, value);
+                event.centerY2 = zigzag_decode(value);
+            }
+            src     = decode_varint(src, value);
+            x       = zigzag_decode(value);
+            src     = decode_varint(src, value);
+            y       = zigzag_decode(value);
+            event.x = x;
+            event.y = y;
+            break;
+        case StrokeEvent::FILL:
+            event.color   = *src++;
+            src           = decode_varint(src, value);
+            event.x       = zigzag_decode(value);
+            src           = decode_varint(src, value);
+            event.y       = zigzag_decode(value);
+            src           = decode_varint(src, value);
+            event.area.x1 = zigzag_decode(value);
+            src           = decode_varint(src, value);
+            event.area.y1 = zigzag_decode(value);
+            src           = decode_varint(src, value);
+            event.area.x2 = event.area.x1 + (int32_t)value - 1;
+            src           = decode_varint(src, value);
+            event.area.y2 = event.area.y1 + (int32_t)value - 1;
+            break;
+        case StrokeEvent::SHAPE:
+            event.shape     = *src++;
+            event.color     = *src++;
+            event.brushSize = *src++;
+            src             = decode_varint(src, value);
+            event.x         = zigzag_decode(value);
+            src             = decode_varint(src, value);
+            event.y         = zigzag_decode(value);
+            src             = decode_varint(src, value);
+            event.endX      = event.x + zigzag_decode(value);
+            src             = decode_varint(src, value);
+            event.endY      = event.y + zigzag_decode(value);
+            break;
+        case StrokeEvent::STROKE_FINGER:
+            state.finger = std::min<uint8_t>(*src++, MAX_FINGERS - 1);
+            event.finger = state.finger;
+            break;
+        default:
+            break;
+    }
+    return src;
+}
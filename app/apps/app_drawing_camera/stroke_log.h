@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace drawing {
+
+/* -------------------------------------------------------------------------- */
+/*                                   Varint                                   */
+/* -------------------------------------------------------------------------- */
+// 7 ビットずつ下位から書き、続きがあるバイトは最上位ビットを立てる
+inline uint8_t* encode_varint(uint32_t value, uint8_t* out)
+{
+    while (value >= 0x80) {
+        *out++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *out++ = (uint8_t)value;
+    return out;
+}
+
+inline const uint8_t* decode_varint(const uint8_t* src, uint32_t& value)
+{
+    value     = 0;
+    int shift = 0;
+    while (*src & 0x80) {
+        value |= (uint32_t)(*src++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)*src++ << shift;
+    return src;
+}
+
+// 符号付きの差分を小さな非負整数にする（0, -1, 1, -2, ... → 0, 1, 2, 3, ...）
+inline uint32_t zigzag_encode(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+inline int32_t zigzag_decode(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                  StrokeLog                                 */
+/* -------------------------------------------------------------------------- */
+struct StrokeEvent {
+    enum Type : uint8_t {
+        STROKE_BEGIN,  // tool, color, brushSize, symmetry, (centerX2, centerY2), x, y
+        STROKE_POINT,  // x, y
+        STROKE_END,
+        FILL,   // color, x, y, area
+        CLEAR,  // インクをすべて消した
+        UNDO,
+        REDO,
+        PHOTO,          // 写真を差し替えた（インクと履歴も破棄される）
+        SHAPE,          // shape, color, brushSize, x, y, endX, endY
+        STROKE_FINGER,  // finger（以降のストロークのレコードはこの指のもの。forEach() では渡さない）
+        STROKE_CANCEL,  // 描きかけのストロークをすべて取り消した（2 本指の操作に切り替えたとき）
+    };
+    enum Tool : uint8_t { TOOL_PEN, TOOL_ERASER };
+
+    Type type         = STROKE_POINT;
+    uint32_t timeMs   = 0;  // 記録時刻（ミリ秒）
+    int32_t x         = 0;
+    int32_t y         = 0;
+    uint8_t tool      = TOOL_PEN;
+    uint8_t color     = 0;  // パレット番号
+    uint8_t brushSize = 0;  // 直径ピクセル
+    uint8_t symmetry  = 0;  // 対称描画のモード（SymmetryMode::encode()、0 なら対称なし）
+    int32_t centerX2  = 0;  // 対称の中心の座標の 2 倍（対称なしなら記録せず 0）
+    int32_t centerY2  = 0;
+    uint8_t shape     = 0;  // 図形の種類（ShapeType）
+    int32_t endX      = 0;  // 図形の終点
+    int32_t endY      = 0;
+    Rect area;              // 塗りつぶしを広げた範囲
+    uint8_t finger    = 0;  // ストロークを描いた指（同時に描いたストロークの区別）
+};
+
+/**
+ * @brief ストロークの操作ログ（再生・解像度を変えた再描画・再現性のあるベンチマーク用）
+ *
+ * 入力点を前の点との差分と経過時間にして varint で詰める。1 レコードは先頭の varint で種類を表し、
+ * 最下位ビットが 0 なら点（(経過時間 << 1) に続けて zigzag の dx, dy）、1 なら点以外のイベント。
+ * 通常の入力では 1 点 3 バイトになる。
+ *
+ * 複数の指で同時に描いたストロークは、指が切り替わるところにだけ STROKE_FINGER を挟み、座標の差分は
+ * 指ごとの直前の点からとる（1 本指だけならレコードは増えない）。
+ *
+ * 書き込み先は固定サイズのチャンクを並べたアリーナで、レコードはチャンクをまたがない。
+ * チャンクは init() で確保した分から使い、足りなくなったときだけ 1 チャンク追加するので、
+ * 点ごとのヒープ確保はない。上限に達した後のレコードは捨てて数だけ数える。
+ */
+class StrokeLog {
+public:
+    static constexpr size_t DEFAULT_CHUNK_BYTES = 32 * 1024;  // 16KB を超えるので ESP32 では PSRAM に置かれる
+    static constexpr size_t MAX_RECORD_BYTES    = 48;
+    static constexpr int MAX_FINGERS            = 8;          // 同時に開けるストロークの数
+
+    struct Stats_t {
+        size_t bytes     = 0;  // 記録したデータのバイト数
+        size_t reserved  = 0;  // 確保済みのチャンクのバイト数
+        uint32_t strokes = 0;
+        uint32_t points  = 0;  // STROKE_BEGIN の点を含む
+        uint32_t events  = 0;  // 全レコード数
+        uint32_t dropped = 0;  // 上限に達して捨てたレコード数
+        float bytesPerPoint() const
+        {
+            return points ? (float)bytes / points : 0.0f;
+        }
+    };
+
+    /**
+     * @brief アリーナを確保する
+     *
+     * @param maxBytes 記録できる上限
+     * @param preallocBytes 最初に確保しておく量
+     * @param chunkBytes 1 チャンクの大きさ
+     */
+    void init(size_t maxBytes, size_t preallocBytes = DEFAULT_CHUNK_BYTES, size_t chunkBytes = DEFAULT_CHUNK_BYTES);
+
+    /**
+     * @brief 記録を消す（確保済みのチャンクは再利用する）
+     *
+     */
+    void clear();
+
+    /**
+     * @brief ストロークを記録する
+     *
+     * @param centerX2 対称の中心の座標の 2 倍（Symmetry::centerX2()。対称なしのモードでは記録しない）
+     * @param finger 指の番号（0 ~ MAX_FINGERS - 1）。指ごとに別のストロークとして並行して開ける
+     */
+    void beginStroke(uint32_t timeMs, uint8_t tool, uint8_t color, uint8_t brushSize, uint8_t symmetry,
+                     int32_t centerX2, int32_t centerY2, int32_t x, int32_t y, uint8_t finger = 0);
+    void addPoint(uint32_t timeMs, int32_t x, int32_t y, uint8_t finger = 0);
+    void endStroke(uint32_t timeMs, uint8_t finger = 0);
+
+    /**
+     * @brief 開いているストロークをすべて取り消したことを記録して閉じる
+     *
+     */
+    void cancelStrokes(uint32_t timeMs);
+    /**
+     * @brief 塗りつぶしを記録する
+     *
+     * @param area 領域を広げた範囲（再生時も同じ範囲で塗る）
+     */
+    void fill(uint32_t timeMs, uint8_t color, int32_t x, int32_t y, const Rect& area);
+    void shape(uint32_t timeMs, uint8_t shape, uint8_t color, uint8_t thickness, int32_t x0, int32_t y0, int32_t x1,
+               int32_t y1);
+
+    /**
+     * @brief 引数のないイベントを記録する（CLEAR・UNDO・REDO・PHOTO）
+     *
+     */
+    void event(StrokeEvent::Type type, uint32_t timeMs);
+
+    bool isStrokeOpen() const
+    {
+        return _open_fingers != 0;
+    }
+    const Stats_t& getStats() const
+    {
+        return _stats;
+    }
+
+    /**
+     * @brief 記録した順にイベントを展開する
+     *
+     * @param fn void(const StrokeEvent&)
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        StrokeEvent event;
+        DecodeState_t state;
+        state.time = _base_time;
+        for (size_t c = 0; c <= _chunk_index && c < _chunks.size(); c++) {
+            const uint8_t* src = _chunks[c].data.get();
+            const uint8_t* end = src + _chunks[c].used;
+            while (src < end) {
+                src = decode_record(src, event, state);
+                if (event.type != StrokeEvent::STROKE_FINGER) fn(event);
+            }
+        }
+    }
+
+private:
+    struct Chunk_t {
+        std::unique_ptr<uint8_t[]> data;
+        size_t used = 0;
+    };
+
+    // 展開中の時刻と、指ごとの直前の点
+    struct DecodeState_t {
+        uint32_t time          = 0;
+        uint8_t finger         = 0;
+        int32_t x[MAX_FINGERS] = {};
+        int32_t y[MAX_FINGERS] = {};
+    };
+
+    std::vector<Chunk_t> _chunks;
+    size_t _chunk_index = 0;  // 書き込み中のチャンク
+    size_t _chunk_bytes = DEFAULT_CHUNK_BYTES;
+    size_t _max_chunks  = 0;
+    Stats_t _stats;
+
+    // 差分の基準（時刻は最初のレコードから、座標は指ごとにストローク内の直前の点から）
+    uint32_t _base_time          = 0;
+    uint32_t _last_time          = 0;
+    int32_t _last_x[MAX_FINGERS] = {};
+    int32_t _last_y[MAX_FINGERS] = {};
+    uint32_t _open_fingers       = 0;  // ストロークを開いている指のビット
+    uint8_t _finger              = 0;  // 直前のストロークのレコードの指
+    bool _empty                  = true;
+
+    uint8_t* reserve_record();
+    void commit_record(uint8_t* end);
+    uint8_t* encode_header(uint8_t* out, StrokeEvent::Type type, uint32_t timeMs);
+    bool select_finger(uint8_t finger, uint32_t timeMs);
+
+    static const uint8_t* decode_record(const uint8_t* src, StrokeEvent& event, DecodeState_t& state);
+};
+
+}  // namespace drawing
@@ -0,0 +1,431 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief 矩形領域（lv_area_t と同じく両端を含む）
+ *
+ */
+struct Rect {
+    int32_t x1 = 0;
+    int32_t y1 = 0;
+    int32_t x2 = -1;
+    int32_t y2 = -1;
+
+    bool isEmpty() const
+    {
+        return x2 < x1 || y2 < y1;
+    }
+    int32_t width() const
+    {
+        return x2 - x1 + 1;
+    }
+    int32_t height() const
+    {
+        return y2 - y1 + 1;
+    }
+    int64_t area() const
+    {
+        return isEmpty() ? 0 : (int64_t)width() * height();
+    }
+
+    // 空の矩形は単位元として扱う
+    void join(const Rect& other)
+    {
+        if (other.isEmpty()) return;
+        if (isEmpty()) {
+            *this = other;
+            return;
+        }
+        x1 = std::min(x1, other.x1);
+        y1 = std::min(y1, other.y1);
+        x2 = std::max(x2, other.x2);
+        y2 = std::max(y2, other.y2);
+    }
+    void joinSpan(int32_t y, int32_t xl, int32_t xr)
+    {
+        join(Rect{xl, y, xr, y});
+    }
+    Rect intersect(const Rect& other) const
+    {
+        return Rect{std::max(x1, other.x1), std::max(y1, other.y1), std::min(x2, other.x2), std::min(y2, other.y2)};
+    }
+    bool intersects(const Rect& other) const
+    {
+        return !intersect(other).isEmpty();
+    }
+};
+
+/**
+ * @brief RGB565 ピクセルバッファのビュー（stride はピクセル単位）
+ *
+ */
+struct PixelBuffer565 {
+    uint16_t* data = nullptr;
+    int32_t width  = 0;
+    int32_t height = 0;
+    int32_t stride = 0;
+
+    uint16_t* row(int32_t y) const
+    {
+        return data + (int64_t)y * stride;
+    }
+    uint16_t pixel(int32_t x, int32_t y) const
+    {
+        return row(y)[x];
+    }
+    Rect bounds() const
+    {
+        return Rect{0, 0, width - 1, height - 1};
+    }
+};
+
+/**
+ * @brief 太線セグメント（両端が半円のカプセル形状）
+ *
+ * startCap が false の場合は始点を中心とする円に含まれるピクセルを除外する。連続した線分の継ぎ目で
+ * 前のセグメントの終点キャップと同じピクセルを二度書きしないために使う。
+ */
+struct Capsule {
+    float x0      = 0.0f;
+    float y0      = 0.0f;
+    float x1      = 0.0f;
+    float y1      = 0.0f;
+    float radius  = 0.0f;
+    bool startCap = true;
+};
+
+namespace detail {
+
+inline int32_t floor_to_int(float v)
+{
+    int32_t i = (int32_t)v;
+    return i - (v < (float)i);
+}
+
+inline int32_t ceil_to_int(float v)
+{
+    int32_t i = (int32_t)v;
+    return i + (v > (float)i);
+}
+
+// カプセルの行ごとの計算は 16.16 固定小数点の整数で行う
+constexpr int FX_SHIFT   = 16;
+constexpr int64_t FX_ONE = (int64_t)1 << FX_SHIFT;
+
+// 準備の計算は float のまま（ESP32-P4 の FPU は単精度のみ）
+inline int64_t to_fx(float v)
+{
+    // 極端な傾き（ほぼ水平・垂直な線分）でも加算を繰り返して溢れないように丸める
+    constexpr float FX_LIMIT = (float)((int64_t)1 << 46);
+    const float fx           = std::clamp(v * (float)FX_ONE, -FX_LIMIT, FX_LIMIT);
+    return fx >= 0.0f ? (int64_t)(fx + 0.5f) : -(int64_t)(0.5f - fx);
+}
+
+inline int32_t fx_ceil(int64_t v)
+{
+    return (int32_t)((v + FX_ONE - 1) >> FX_SHIFT);
+}
+
+inline int32_t fx_floor(int64_t v)
+{
+    return (int32_t)(v >> FX_SHIFT);
+}
+
+// 端点円の行ごとの半幅（16.16）。行は中心の y の整数部からの相対位置で引く。
+// 半幅は半径と中心の y の小数部だけで決まるので、同じ太さで整数座標のストロークでは平方根を計算し直さずに使い回す
+struct CapTable {
+    float radius  = -1.0f;
+    int64_t frac  = -1;  // 中心の y の小数部（16.16）
+    int32_t k_min = 0;   // half[0] の行（中心の整数部からの相対位置）
+    std::vector<int64_t> half;
+
+    void prepare(float r, int64_t fracFx)
+    {
+        if (r == radius && fracFx == frac) return;
+        radius          = r;
+        frac            = fracFx;
+        const float f   = (float)fracFx / FX_ONE;
+        k_min           = ceil_to_int(f - r);
+        const int32_t n = std::max(0, floor_to_int(f + r) - k_min + 1);
+        half.resize(n);
+        for (int32_t i = 0; i < n; i++) {
+            const float dy = (float)(k_min + i) - f;
+            const float h2 = r * r - dy * dy;
+            half[i]        = h2 < 0.0f ? -1 : to_fx(std::sqrt(h2));
+        }
+    }
+};
+
+// 1 本のカプセルの端点円。行の範囲外や円にかからない行では get() が false を返す
+struct CapRows {
+    const CapTable* table = nullptr;
+    int32_t row0          = 0;  // table->half[0] の行
+    int64_t cx            = 0;
+
+    void init(const CapTable& t, int32_t base, float x)
+    {
+        table = &t;
+        row0  = base + t.k_min;
+        cx    = to_fx(x);
+    }
+
+    bool get(int32_t y, int64_t& lo, int64_t& hi) const
+    {
+        const uint32_t i = (uint32_t)(y - row0);
+        if (i >= table->half.size() || table->half[i] < 0) return false;
+        lo = cx - table->half[i];
+        hi = cx + table->half[i];
+        return true;
+    }
+};
+
+// 端点円の半幅表（始点と終点で中心の小数部が違う場合に 2 つ使う）。スレッドごとに持つ
+inline CapTable& cap_table(int slot)
+{
+    static thread_local CapTable tables[2];
+    return tables[slot];
+}
+
+// カプセル胴体（線分を太らせた長方形）と水平線の交差区間。各境界は y に対して一次式なので、
+// 境界線の x を行ごとに傾きだけ足していけば 1 行あたり加算と比較だけで済む。行は init() の y から 1 行ずつ順に next() で進める
+struct BodyEdges {
+    enum Kind { NONE, FIXED, SLANTED };
+    Kind kind         = NONE;
+    int32_t row_beg   = 0;  // FIXED の行範囲
+    int32_t row_end   = -1;
+    int64_t lo        = 0;  // FIXED の区間
+    int64_t hi        = 0;
+    int64_t dot       = 0;  // 射影 0 の境界線の x（現在の行）
+    int64_t dot_step  = 0;
+    int64_t dot_off   = 0;  // 射影 l2 の境界線までの x 方向距離
+    int64_t side      = 0;  // 中心線の x（現在の行）
+    int64_t side_step = 0;
+    int64_t side_off  = 0;  // 側面の境界線までの x 方向距離
+
+    void init(float ax, float ay, float bx, float by, float r, int32_t y)
+    {
+        const float dx = bx - ax;
+        const float dy = by - ay;
+        const float l2 = dx * dx + dy * dy;
+        if (l2 == 0.0f) return;
+
+        if (dx == 0.0f) {
+            kind    = FIXED;
+            row_beg = ceil_to_int(std::min(ay, by));
+            row_end = floor_to_int(std::max(ay, by));
+            lo      = to_fx(ax - r);
+            hi      = to_fx(ax + r);
+        } else if (dy == 0.0f) {
+            kind    = FIXED;
+            row_beg = ceil_to_int(ay - r);
+            row_end = floor_to_int(ay + r);
+            lo      = to_fx(std::min(ax, bx));
+            hi      = to_fx(std::max(ax, bx));
+        } else {
+            kind                   = SLANTED;
+            const float ry         = (float)y - ay;
+            const float slope_dot  = -dy / dx;
+            const float slope_side = dx / dy;
+            dot                    = to_fx(ax + ry * slope_dot);
+            dot_step               = to_fx(slope_dot);
+            dot_off                = to_fx(l2 / dx);
+            side                   = to_fx(ax + ry * slope_side);
+            side_step              = to_fx(slope_side);
+            side_off               = to_fx(r * std::sqrt(l2) / std::fabs(dy));
+        }
+    }
+
+    bool next(int32_t y, int64_t& out_lo, int64_t& out_hi)
+    {
+        if (kind == FIXED) {
+            out_lo = lo;
+            out_hi = hi;
+            return y >= row_beg && y <= row_end;
+        }
+        if (kind == NONE) return false;
+
+        const int64_t dot1 = dot + dot_off;
+        out_lo             = std::max(std::min(dot, dot1), side - side_off);
+        out_hi             = std::min(std::max(dot, dot1), side + side_off);
+        dot += dot_step;
+        side += side_step;
+        return out_lo <= out_hi;
+    }
+};
+
+}  // namespace detail
+
+/**
+ * @brief カプセルが覆う可能性のある範囲（書き込み前に領域を知りたい場合に使う）
+ *
+ */
+inline Rect capsule_bounds(const Capsule& capsule)
+{
+    return Rect{detail::floor_to_int(std::min(capsule.x0, capsule.x1) - capsule.radius),
+                detail::floor_to_int(std::min(capsule.y0, capsule.y1) - capsule.radius),
+                detail::ceil_to_int(std::max(capsule.x0, capsule.x1) + capsule.radius),
+                detail::ceil_to_int(std::max(capsule.y0, capsule.y1) + capsule.radius)};
+}
+
+/**
+ * @brief カプセルが覆うピクセルをスキャンラインごとの区間として列挙する
+ *
+ * ピクセル中心が線分からの距離 radius 以内にあるものを覆われているとみなす。
+ * カプセルは凸形状なので各行の被覆は一つの区間になる。始点キャップを省略した場合は
+ * 始点円を除いた左右最大二つの区間になる。いずれの場合も各ピクセルは一度だけ列挙される。
+ *
+ * @param clip 列挙範囲（バッファ範囲など）
+ * @param capsule
+ * @param fn void(int32_t y, int32_t xl, int32_t xr) 両端を含む区間
+ * @return Rect 列挙した区間をすべて含む矩形（無効化領域としてそのまま使える）
+ */
+template <typename SpanFn>
+Rect for_each_capsule_span(const Rect& clip, const Capsule& capsule, SpanFn&& fn)
+{
+    Rect bounds;
+
+    const float r  = capsule.radius;
+    const float dx = capsule.x1 - capsule.x0;
+    const float dy = capsule.y1 - capsule.y0;
+    const float l2 = dx * dx + dy * dy;
+
+    // 長さ 0 で始点キャップ省略なら描くものはない
+    if (l2 == 0.0f && !capsule.startCap) {
+        return bounds;
+    }
+
+    const int32_t y_beg = std::max(clip.y1, detail::ceil_to_int(std::min(capsule.y0, capsule.y1) - r));
+    const int32_t y_end = std::min(clip.y2, detail::floor_to_int(std::max(capsule.y0, capsule.y1) + r));
+
+    // 行ごとの計算は固定小数点の加算と表引きだけにする（平方根と浮動小数点は線分ごとの準備だけ）
+    detail::BodyEdges body;
+    body.init(capsule.x0, capsule.y0, capsule.x1, capsule.y1, r, y_beg);
+
+    const int32_t base0  = detail::floor_to_int(capsule.y0);
+    const int32_t base1  = detail::floor_to_int(capsule.y1);
+    const int64_t frac0  = detail::to_fx(capsule.y0 - base0);
+    const int64_t frac1  = detail::to_fx(capsule.y1 - base1);
+    detail::CapTable& t0 = detail::cap_table(0);
+    detail::CapTable& t1 = frac1 == frac0 ? t0 : detail::cap_table(1);
+    t0.prepare(r, frac0);
+    t1.prepare(r, frac1);
+    detail::CapRows cap0;
+    detail::CapRows cap1;
+    cap0.init(t0, base0, capsule.x0);
+    cap1.init(t1, base1, capsule.x1);
+
+    auto emit = [&](int32_t y, int32_t xl, int32_t xr) {
+        xl = std::max(clip.x1, xl);
+        xr = std::min(clip.x2, xr);
+        if (xl > xr) return;
+
+        fn(y, xl, xr);
+
+        if (bounds.isEmpty()) {
+            bounds = Rect{xl, y, xr, y};
+        } else {
+            bounds.x1 = std::min(bounds.x1, xl);
+            bounds.x2 = std::max(bounds.x2, xr);
+            bounds.y2 = y;
+        }
+    };
+
+    for (int32_t y = y_beg; y <= y_end; y++) {
+        int64_t lo = INT64_MAX;
+        int64_t hi = INT64_MIN;
+        int64_t cap0_lo, cap0_hi;
+        const bool on_cap0 = cap0.get(y, cap0_lo, cap0_hi);
+        if (on_cap0) {
+            lo = cap0_lo;
+            hi = cap0_hi;
+        }
+        int64_t span_lo, span_hi;
+        if (cap1.get(y, span_lo, span_hi)) {
+            lo = std::min(lo, span_lo);
+            hi = std::max(hi, span_hi);
+        }
+
+        // 胴体部分：線分への射影が [0, l2]、かつ垂直距離が r 以内
+        if (body.next(y, span_lo, span_hi)) {
+            lo = std::min(lo, span_lo);
+            hi = std::max(hi, span_hi);
+        }
+
+        if (lo > hi) continue;
+
+        int32_t xl = detail::fx_ceil(lo);
+        int32_t xr = detail::fx_floor(hi);
+
+        if (capsule.startCap || !on_cap0) {
+            emit(y, xl, xr);
+        } else {
+            // 始点円（描画済み）を除いた左右の区間
+            emit(y, xl, detail::fx_ceil(cap0_lo) - 1);
+            emit(y, detail::fx_floor(cap0_hi) + 1, xr);
+        }
+    }
+
+    return bounds;
+}
+
+/**
+ * @brief 1 行分のピクセルを単色で塗る（8 ピクセル単位で展開）
+ *
+ * 端数は末尾の 8（または 4、2）ピクセルを重ねて書き直して埋める。長さが行ごとに変わるカプセルの区間でも、
+ * 端数の 1 ピクセルずつのループで分岐予測を外さない
+ */
+inline void fill_span_565(uint16_t* ptr, int32_t count, uint16_t color)
+{
+    if (count >= 8) {
+        uint16_t* last = ptr + count - 8;
+        while (ptr < last) {
+            ptr[0] = color;
+            ptr[1] = color;
+            ptr[2] = color;
+            ptr[3] = color;
+            ptr[4] = color;
+            ptr[5] = color;
+            ptr[6] = color;
+            ptr[7] = color;
+            ptr += 8;
+        }
+        last[0] = color;
+        last[1] = color;
+        last[2] = color;
+        last[3] = color;
+        last[4] = color;
+        last[5] = color;
+        last[6] = color;
+        last[7] = color;
+    } else if (count >= 4) {
+        uint16_t* last = ptr + count - 4;
+        ptr[0]         = color;
+        ptr[1]         = color;
+        ptr[2]         = color;
+        ptr[3]         = color;
+        last[0]        = color;
+        last[1]        = color;
+        last[2]        = color;
+        last[3]        = color;
+    } else if (count >= 2) {
+        ptr[0]         = color;
+        ptr[1]         = color;
+        ptr[count - 2] = color;
+        ptr[count - 1] = color;
+    } else if (count == 1) {
+        ptr[0] = color;
+    }
+}
+
+}  // namespace drawing
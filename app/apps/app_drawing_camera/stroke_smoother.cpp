@@ -0,0 +1,58 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "stroke_smoother.h"
+#include <utility>
+
+using namespace drawing;
+
+/* -------------------------------------------------------------------------- */
+/*                              CatmullRomSegment                             */
+/* -------------------------------------------------------------------------- */
+// 点間距離の平方根をノット間隔とする（centripetal）。一様パラメータより尖りやループが出にくい
+static float knot_interval(const StrokePoint& a, const StrokePoint& b)
+{
+    return std::sqrt(std::hypot(b.x - a.x, b.y - a.y));
+}
+
+CatmullRomSegment::CatmullRomSegment(const StrokePoint& p0, const StrokePoint& p1, const StrokePoint& p2,
+                                     const StrokePoint& p3)
+{
+    float dt0 = knot_interval(p0, p1);
+    float dt1 = knot_interval(p1, p2);
+    float dt2 = knot_interval(p2, p3);
+
+    // 重複した端点（ストロークの始点・終点）は隣の間隔で代用する
+    if (dt1 < 1e-4f) dt1 = 1.0f;
+    if (dt0 < 1e-4f) dt0 = dt1;
+    if (dt2 < 1e-4f) dt2 = dt1;
+
+    // p1, p2 での接線（区間 [0, 1] に正規化）
+    auto tangent = [&](float a0, float a1, float a2, float a3) {
+        float m1 = ((a1 - a0) / dt0 - (a2 - a0) / (dt0 + dt1) + (a2 - a1) / dt1) * dt1;
+        float m2 = ((a2 - a1) / dt1 - (a3 - a1) / (dt1 + dt2) + (a3 - a2) / dt2) * dt1;
+        return std::make_pair(m1, m2);
+    };
+    auto [mx1, mx2] = tangent(p0.x, p1.x, p2.x, p3.x);
+    auto [my1, my2] = tangent(p0.y, p1.y, p2.y, p3.y);
+
+    // エルミート補間の係数
+    c0 = p1;
+    c1 = StrokePoint{mx1, my1};
+    c2 = StrokePoint{-3.0f * p1.x + 3.0f * p2.x - 2.0f * mx1 - mx2, -3.0f * p1.y + 3.0f * p2.y - 2.0f * my1 - my2};
+    c3 = StrokePoint{2.0f * p1.x - 2.0f * p2.x + mx1 + mx2, 2.0f * p1.y - 2.0f * p2.y + my1 + my2};
+}
+
+/* -------------------------------------------------------------------------- */
+/*                               StrokeSmoother                               */
+/* -------------------------------------------------------------------------- */
+void StrokeSmoother::begin(float x, float y, float spacing)
+{
+    _points[0]    = StrokePoint{x, y};
+    _point_num    = 1;
+    _spacing      = std::max(spacing, 0.5f);
+    _carry        = 0.0f;
+    _last_emitted = _points[0];
+}
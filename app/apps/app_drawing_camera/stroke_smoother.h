@@ -0,0 +1,149 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace drawing {
+
+struct StrokePoint {
+    float x = 0.0f;
+    float y = 0.0f;
+};
+
+/**
+ * @brief Catmull-Rom（centripetal）曲線の 1 区間（p1 から p2 まで）
+ *
+ * 端点の前後の点 p0, p3 で接線を決める。u = 0 で p1、u = 1 で p2 を通る三次多項式。
+ */
+struct CatmullRomSegment {
+    StrokePoint c0;
+    StrokePoint c1;
+    StrokePoint c2;
+    StrokePoint c3;
+
+    CatmullRomSegment(const StrokePoint& p0, const StrokePoint& p1, const StrokePoint& p2, const StrokePoint& p3);
+
+    StrokePoint at(float u) const
+    {
+        return StrokePoint{((c3.x * u + c2.x) * u + c1.x) * u + c0.x, ((c3.y * u + c2.y) * u + c1.y) * u + c0.y};
+    }
+};
+
+/**
+ * @brief ストロークの入力点を滑らかにし、弧長で等間隔な点列にする
+ *
+ * 直近の入力点を最大 4 点保持し、前後の点がそろって形が確定した区間だけを出力する。
+ * そのため出力は入力より 1 区間遅れるが、1 回の addPoint() の処理量は一定に保たれる
+ * （区間の分割数は MAX_SUBDIVISIONS で上限）。残りの区間は finish() で出力する。
+ * 開始点は出力しないので、呼び出し側で begin() と同じ点を描くこと。
+ */
+class StrokeSmoother {
+public:
+    static constexpr int MAX_SUBDIVISIONS = 64;     // 1 区間を折れ線近似する最大分割数
+    static constexpr float MIN_DISTANCE   = 0.75f;  // これより近い入力点は捨てる（ほぼ静止中のノイズ）
+
+    /**
+     * @brief ストロークを開始する
+     *
+     * @param x
+     * @param y
+     * @param spacing 出力点の弧長間隔（ピクセル）
+     */
+    void begin(float x, float y, float spacing);
+
+    /**
+     * @brief 入力点を追加し、確定した区間の点を出力する
+     *
+     * @param fn void(const StrokePoint&)
+     */
+    template <typename EmitFn>
+    void addPoint(float x, float y, EmitFn&& fn)
+    {
+        if (!isActive()) return;
+
+        const StrokePoint& last = _points[_point_num - 1];
+        float dx                = x - last.x;
+        float dy                = y - last.y;
+        if (dx * dx + dy * dy < MIN_DISTANCE * MIN_DISTANCE) return;
+
+        if (_point_num == 4) {
+            std::copy(_points + 1, _points + 4, _points);
+            _point_num = 3;
+        }
+        _points[_point_num++] = StrokePoint{x, y};
+
+        // 最初の区間は始点を前の点の代わりにする
+        if (_point_num == 3) {
+            emit_segment(CatmullRomSegment(_points[0], _points[0], _points[1], _points[2]), fn);
+        } else if (_point_num == 4) {
+            emit_segment(CatmullRomSegment(_points[0], _points[1], _points[2], _points[3]), fn);
+        }
+    }
+
+    /**
+     * @brief 未確定の最後の区間を出力してストロークを終える（終点は必ず出力する）
+     *
+     * @param fn void(const StrokePoint&)
+     */
+    template <typename EmitFn>
+    void finish(EmitFn&& fn)
+    {
+        if (!isActive()) return;
+
+        if (_point_num >= 2) {
+            const StrokePoint& p1 = _points[_point_num - 2];
+            const StrokePoint& p2 = _points[_point_num - 1];
+            const StrokePoint& p0 = _point_num >= 3 ? _points[_point_num - 3] : p1;
+            emit_segment(CatmullRomSegment(p0, p1, p2, p2), fn);
+
+            if (_last_emitted.x != p2.x || _last_emitted.y != p2.y) {
+                fn(p2);
+            }
+        }
+        _point_num = 0;
+    }
+
+    bool isActive() const
+    {
+        return _point_num > 0;
+    }
+
+private:
+    StrokePoint _points[4];
+    int _point_num = 0;
+    float _spacing = 1.0f;
+    float _carry   = 0.0f;  // 最後に出力した点からの弧長
+    StrokePoint _last_emitted;
+
+    // 区間を折れ線で近似しながら弧長を積算し、spacing ごとに点を出力する
+    template <typename EmitFn>
+    void emit_segment(const CatmullRomSegment& segment, EmitFn&& fn)
+    {
+        StrokePoint end = segment.at(1.0f);
+        float chord     = std::hypot(end.x - segment.c0.x, end.y - segment.c0.y);
+        int steps       = std::clamp((int)std::ceil(chord * 2.0f / _spacing), 1, MAX_SUBDIVISIONS);
+
+        StrokePoint prev = segment.c0;
+        for (int i = 1; i <= steps; i++) {
+            StrokePoint cur = segment.at((float)i / steps);
+            float length    = std::hypot(cur.x - prev.x, cur.y - prev.y);
+            float from      = 0.0f;
+            while (_carry + (length - from) >= _spacing) {
+                from += _spacing - _carry;
+                float t       = from / length;
+                _last_emitted = StrokePoint{prev.x + (cur.x - prev.x) * t, prev.y + (cur.y - prev.y) * t};
+                _carry        = 0.0f;
+                fn(_last_emitted);
+            }
+            _carry += length - from;
+            prev = cur;
+        }
+    }
+};
+
+}  // namespace drawing
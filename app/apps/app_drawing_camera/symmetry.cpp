@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "symmetry.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace drawing;
+
+void Symmetry::setMode(const SymmetryMode& mode, int32_t centerX2, int32_t centerY2)
+{
+    _mode       = mode;
+    _mode.folds = std::max<int>(1, std::min<int>(mode.folds, MAX_COPIES / (mode.mirror ? 2 : 1)));
+    _copies     = _mode.copies();
+    _center_x   = (int64_t)centerX2 << (FIXED_SHIFT - 1);
+    _center_y   = (int64_t)centerY2 << (FIXED_SHIFT - 1);
+
+    // 0 .. folds-1 が回転、続く folds 個が左右反転してから回転したもの
+    for (int i = 0; i < _copies; i++) {
+        const int fold   = i % _mode.folds;
+        const bool flip  = i >= _mode.folds;
+        const double rad = 2.0 * M_PI * fold / _mode.folds;
+        const int32_t c  = (int32_t)std::lround(std::cos(rad) * (1 << FIXED_SHIFT));
+        const int32_t s  = (int32_t)std::lround(std::sin(rad) * (1 << FIXED_SHIFT));
+
+        Transform_t& t = _transforms[i];
+        t.m00          = flip ? -c : c;
+        t.m01          = -s;
+        t.m10          = flip ? -s : s;
+        t.m11          = c;
+    }
+}
+
+Rect Symmetry::applyBounds(int index, const Rect& rect) const
+{
+    if (rect.isEmpty()) return rect;
+
+    Rect bounds;
+    const int32_t xs[2] = {rect.x1, rect.x2};
+    const int32_t ys[2] = {rect.y1, rect.y2};
+    for (int32_t x : xs) {
+        for (int32_t y : ys) {
+            int32_t tx, ty;
+            apply(index, x, y, tx, ty);
+            bounds.join(Rect{tx, ty, tx, ty});
+        }
+    }
+    return bounds;
+}
@@ -0,0 +1,205 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "brush.h"
+#include <cstdint>
+
+namespace drawing {
+
+/**
+ * @brief 対称描画のモード（回転の数と鏡映の有無）
+ *
+ */
+struct SymmetryMode {
+    uint8_t folds = 1;      // 回転対称の数（1 なら回転しない）
+    bool mirror   = false;  // 各回転に左右反転したコピーを加える
+
+    int copies() const
+    {
+        return folds * (mirror ? 2 : 1);
+    }
+    bool isOff() const
+    {
+        return copies() <= 1;
+    }
+
+    // 操作ログ用の 1 バイト表現（下位 4 ビットが回転の数、ビット 4 が鏡映）
+    uint8_t encode() const
+    {
+        return (uint8_t)((folds & 0x0F) | (mirror ? 0x10 : 0));
+    }
+    static SymmetryMode decode(uint8_t value)
+    {
+        SymmetryMode mode;
+        mode.folds  = (value & 0x0F) ? (value & 0x0F) : 1;
+        mode.mirror = (value & 0x10) != 0;
+        return mode;
+    }
+};
+
+/**
+ * @brief 対称描画の変換（指定した中心まわりの固定小数点 2x2 行列）
+ *
+ * 行列はモードを切り替えたときに一度だけ計算し、描画中は整数の積和だけで各コピーの座標を求める。
+ * 0 番目のコピーは常に恒等変換なので、対称描画を使わない場合も同じ経路で描ける。
+ */
+class Symmetry {
+public:
+    static constexpr int MAX_COPIES  = 12;
+    static constexpr int FIXED_SHIFT = 16;
+
+    struct Transform_t {
+        int32_t m00 = 1 << FIXED_SHIFT;
+        int32_t m01 = 0;
+        int32_t m10 = 0;
+        int32_t m11 = 1 << FIXED_SHIFT;
+    };
+
+    /**
+     * @brief モードを設定して変換行列を作る（コピー数が MAX_COPIES を超える場合は回転の数を減らす）
+     *
+     * @param mode
+     * @param centerX2 中心の x 座標の 2 倍（画素の境目にも置けるように半画素単位で持つ）
+     * @param centerY2 中心の y 座標の 2 倍
+     */
+    void setMode(const SymmetryMode& mode, int32_t centerX2, int32_t centerY2);
+
+    /**
+     * @brief area の中心まわりでモードを設定する（表示範囲や写真の範囲を渡す）
+     *
+     */
+    void setMode(const SymmetryMode& mode, const Rect& area)
+    {
+        setMode(mode, area.x1 + area.x2, area.y1 + area.y2);
+    }
+
+    /**
+     * @brief 変換後の座標からさらにずらす量（キャンバスの一部だけを描く場合に使う）
+     *
+     */
+    void setOffset(int32_t dx, int32_t dy)
+    {
+        _offset_x = dx;
+        _offset_y = dy;
+    }
+
+    const SymmetryMode& mode() const
+    {
+        return _mode;
+    }
+    int copies() const
+    {
+        return _copies;
+    }
+    int32_t centerX2() const
+    {
+        return (int32_t)(_center_x >> (FIXED_SHIFT - 1));
+    }
+    int32_t centerY2() const
+    {
+        return (int32_t)(_center_y >> (FIXED_SHIFT - 1));
+    }
+    const Transform_t& transform(int index) const
+    {
+        return _transforms[index];
+    }
+
+    /**
+     * @brief index 番目のコピーの座標
+     *
+     */
+    void apply(int index, int32_t x, int32_t y, int32_t& outX, int32_t& outY) const
+    {
+        // 中心は画素の中央（幅が偶数なら半画素の位置）にあるので、固定小数点のまま差を取る
+        const Transform_t& t = _transforms[index];
+        const int64_t dx     = ((int64_t)x << FIXED_SHIFT) - _center_x;
+        const int64_t dy     = ((int64_t)y << FIXED_SHIFT) - _center_y;
+        const int64_t tx     = ((t.m00 * dx + t.m01 * dy) >> FIXED_SHIFT) + _center_x;
+        const int64_t ty     = ((t.m10 * dx + t.m11 * dy) >> FIXED_SHIFT) + _center_y;
+        outX                 = (int32_t)((tx + HALF) >> FIXED_SHIFT) - _offset_x;
+        outY                 = (int32_t)((ty + HALF) >> FIXED_SHIFT) - _offset_y;
+    }
+
+    /**
+     * @brief index 番目のコピーで rect が移る範囲（4 隅を変換した外接矩形）
+     *
+     */
+    Rect applyBounds(int index, const Rect& rect) const;
+
+private:
+    static constexpr int64_t HALF = (int64_t)1 << (FIXED_SHIFT - 1);
+
+    SymmetryMode _mode;
+    int _copies       = 1;
+    int64_t _center_x = 0;
+    int64_t _center_y = 0;
+    int32_t _offset_x = 0;
+    int32_t _offset_y = 0;
+    Transform_t _transforms[MAX_COPIES];
+};
+
+/**
+ * @brief 入力の 1 本の線を対称なすべてのコピーへ同時に描くストローク
+ *
+ * 平滑化した点ごとに全コピーの線分をまとめて描く。コピーごとに書き込む前の範囲を prepare に、
+ * 書き込んだ範囲を dirty に渡すので、呼び出し側は 1 つの更新領域にまとめて無効化できる。
+ */
+class SymmetryStroke {
+public:
+    /**
+     * @brief ストロークを開始して各コピーの最初の点を押す
+     *
+     * @param prepare void(const Rect&) 書き込む前に呼ばれる（アンドゥ用の保存など）
+     * @param dirty void(const Rect&) 書き込んだ範囲
+     */
+    template <typename PrepareFn, typename DirtyFn>
+    void begin(InkLayer& layer, const Brush& brush, const InkPen& pen, const Symmetry& symmetry, int32_t x,
+               int32_t y, PrepareFn&& prepare, DirtyFn&& dirty)
+    {
+        _symmetry = &symmetry;
+        for (int i = 0; i < symmetry.copies(); i++) {
+            int32_t tx, ty;
+            symmetry.apply(i, x, y, tx, ty);
+            prepare(brush.stampBounds(tx, ty));
+            dirty(_strokes[i].begin(layer, brush, pen, tx, ty));
+        }
+    }
+
+    /**
+     * @brief 各コピーの最後の点から線分を描く
+     *
+     */
+    template <typename PrepareFn, typename DirtyFn>
+    void lineTo(InkLayer& layer, int32_t x, int32_t y, PrepareFn&& prepare, DirtyFn&& dirty)
+    {
+        if (!isActive()) return;
+        for (int i = 0; i < _symmetry->copies(); i++) {
+            int32_t tx, ty;
+            _symmetry->apply(i, x, y, tx, ty);
+            prepare(_strokes[i].lineToBounds(tx, ty));
+            dirty(_strokes[i].lineTo(layer, tx, ty));
+        }
+    }
+
+    void end()
+    {
+        for (auto& stroke : _strokes) {
+            stroke.end();
+        }
+        _symmetry = nullptr;
+    }
+    bool isActive() const
+    {
+        return _symmetry && _strokes[0].isActive();
+    }
+
+private:
+    const Symmetry* _symmetry = nullptr;
+    BrushStroke _strokes[Symmetry::MAX_COPIES];
+};
+
+}  // namespace drawing
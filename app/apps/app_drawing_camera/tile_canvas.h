@@ -0,0 +1,178 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include <cstdint>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief キャンバスを固定サイズのタイルに分割して扱うためのグリッド
+ *
+ * ピクセルは LVGL が参照する一枚のバッファのまま持ち、タイルは論理的な区切りとして使う。
+ */
+class TileGrid {
+public:
+    static constexpr int TILE_SIZE = 64;
+
+    TileGrid() = default;
+    TileGrid(int32_t width, int32_t height)
+    {
+        resize(width, height);
+    }
+
+    void resize(int32_t width, int32_t height)
+    {
+        _width  = width;
+        _height = height;
+        _cols   = (width + TILE_SIZE - 1) / TILE_SIZE;
+        _rows   = (height + TILE_SIZE - 1) / TILE_SIZE;
+    }
+
+    int32_t width() const
+    {
+        return _width;
+    }
+    int32_t height() const
+    {
+        return _height;
+    }
+    int cols() const
+    {
+        return _cols;
+    }
+    int rows() const
+    {
+        return _rows;
+    }
+    int count() const
+    {
+        return _cols * _rows;
+    }
+
+    /**
+     * @brief タイルの領域（キャンバス端でクリップ済み）
+     *
+     */
+    Rect tileRect(int index) const
+    {
+        int32_t x = (index % _cols) * TILE_SIZE;
+        int32_t y = (index / _cols) * TILE_SIZE;
+        return Rect{x, y, std::min(x + TILE_SIZE, _width) - 1, std::min(y + TILE_SIZE, _height) - 1};
+    }
+
+    /**
+     * @brief 領域と重なるタイルを列挙する
+     *
+     * @param fn void(int index)
+     */
+    template <typename Fn>
+    void forEachTileIn(const Rect& rect, Fn&& fn) const
+    {
+        Rect clipped = rect.intersect(Rect{0, 0, _width - 1, _height - 1});
+        if (clipped.isEmpty()) return;
+        for (int ty = clipped.y1 / TILE_SIZE; ty <= clipped.y2 / TILE_SIZE; ty++) {
+            for (int tx = clipped.x1 / TILE_SIZE; tx <= clipped.x2 / TILE_SIZE; tx++) {
+                fn(ty * _cols + tx);
+            }
+        }
+    }
+
+    /**
+     * @brief タイルから領域までのタイル単位の距離（重なれば 0、領域が空なら 1）
+     *
+     */
+    int tileDistance(int index, const Rect& rect) const
+    {
+        const Rect clipped = rect.intersect(Rect{0, 0, _width - 1, _height - 1});
+        if (clipped.isEmpty()) return 1;
+        const int tx = index % _cols;
+        const int ty = index / _cols;
+        const int dx = std::max({clipped.x1 / TILE_SIZE - tx, tx - clipped.x2 / TILE_SIZE, 0});
+        const int dy = std::max({clipped.y1 / TILE_SIZE - ty, ty - clipped.y2 / TILE_SIZE, 0});
+        return std::max(dx, dy);
+    }
+
+private:
+    int32_t _width  = 0;
+    int32_t _height = 0;
+    int _cols       = 0;
+    int _rows       = 0;
+};
+
+/**
+ * @brief タイル単位のビットマップ
+ *
+ */
+class TileBitmap {
+public:
+    void resize(int count)
+    {
+        _count = count;
+        _words.assign((count + 31) / 32, 0);
+    }
+    int size() const
+    {
+        return _count;
+    }
+
+    void set(int index)
+    {
+        _words[index >> 5] |= 1u << (index & 31);
+    }
+    void reset(int index)
+    {
+        _words[index >> 5] &= ~(1u << (index & 31));
+    }
+    bool test(int index) const
+    {
+        return _words[index >> 5] & (1u << (index & 31));
+    }
+    void clear()
+    {
+        std::fill(_words.begin(), _words.end(), 0);
+    }
+    bool any() const
+    {
+        for (auto word : _words) {
+            if (word) return true;
+        }
+        return false;
+    }
+    int countSet() const
+    {
+        int num = 0;
+        for (auto word : _words) {
+            num += __builtin_popcount(word);
+        }
+        return num;
+    }
+
+    /**
+     * @brief 立っているビットを列挙する
+     *
+     * @param fn void(int index)
+     */
+    template <typename Fn>
+    void forEachSet(Fn&& fn) const
+    {
+        for (size_t w = 0; w < _words.size(); w++) {
+            uint32_t word = _words[w];
+            while (word) {
+                int bit = __builtin_ctz(word);
+                fn((int)(w * 32 + bit));
+                word &= word - 1;
+            }
+        }
+    }
+
+private:
+    std::vector<uint32_t> _words;
+    int _count = 0;
+};
+
+}  // namespace drawing
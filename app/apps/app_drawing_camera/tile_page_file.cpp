@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "tile_page_file.h"
+
+using namespace drawing;
+
+bool TilePageFile::open(const std::string& path, size_t recordBytes)
+{
+    close();
+    _file = std::fopen(path.c_str(), "w+b");
+    if (!_file) return false;
+
+    // 1 レコードずつ読み書きするので、stdio のバッファは使わない
+    std::setvbuf(_file, nullptr, _IONBF, 0);
+    _path         = path;
+    _record_bytes = recordBytes;
+    _records      = 0;
+    _free.clear();
+    return true;
+}
+
+void TilePageFile::close()
+{
+    if (!_file) return;
+    std::fclose(_file);
+    std::remove(_path.c_str());
+    _file = nullptr;
+    _path.clear();
+    _records = 0;
+    _free.clear();
+}
+
+int32_t TilePageFile::write(const void* data)
+{
+    if (!_file) return -1;
+
+    const bool reuse     = !_free.empty();
+    const int32_t record = reuse ? _free.back() : _records;
+    if (std::fseek(_file, (long)record * (long)_record_bytes, SEEK_SET) != 0 ||
+        std::fwrite(data, 1, _record_bytes, _file) != _record_bytes) {
+        return -1;
+    }
+
+    if (reuse) {
+        _free.pop_back();
+    } else {
+        _records++;
+    }
+    return record;
+}
+
+bool TilePageFile::read(int32_t record, void* data)
+{
+    if (!_file || record < 0 || record >= _records) return false;
+
+    const bool ok = peek(record, data);
+    _free.push_back(record);
+    return ok;
+}
+
+bool TilePageFile::peek(int32_t record, void* data)
+{
+    if (!_file || record < 0 || record >= _records) return false;
+
+    return std::fseek(_file, (long)record * (long)_record_bytes, SEEK_SET) == 0 &&
+           std::fread(data, 1, _record_bytes, _file) == _record_bytes;
+}
+
+void TilePageFile::discard(int32_t record)
+{
+    if (record >= 0 && record < _records) _free.push_back(record);
+}
@@ -0,0 +1,90 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief 追い出したタイルを置くファイル（実機では SD カード、デスクトップでは一時ディレクトリ）
+ *
+ * 同じ大きさのレコードを並べただけのファイルで、レコード番号で読み書きする。空いたレコードは次の書き込みで
+ * 使い回すので、ファイルの大きさは同時に追い出しているタイルの最大数で決まる。ファイルは close() で削除する。
+ */
+class TilePageFile {
+public:
+    TilePageFile() = default;
+    ~TilePageFile()
+    {
+        close();
+    }
+    TilePageFile(const TilePageFile&)            = delete;
+    TilePageFile& operator=(const TilePageFile&) = delete;
+
+    /**
+     * @brief ファイルを作る（既にあれば中身を捨てる）
+     *
+     * @param recordBytes 1 レコードの大きさ
+     */
+    bool open(const std::string& path, size_t recordBytes);
+    void close();
+
+    bool isOpen() const
+    {
+        return _file != nullptr;
+    }
+    const std::string& path() const
+    {
+        return _path;
+    }
+
+    /**
+     * @brief レコードに書き込む
+     *
+     * @return int32_t レコード番号（失敗したら -1）
+     */
+    int32_t write(const void* data);
+
+    /**
+     * @brief レコードを読み出して空きに戻す
+     *
+     */
+    bool read(int32_t record, void* data);
+
+    /**
+     * @brief レコードを読み出す（空きには戻さない）
+     *
+     */
+    bool peek(int32_t record, void* data);
+
+    /**
+     * @brief 読まずに空きに戻す（追い出したタイルを破棄する場合）
+     *
+     */
+    void discard(int32_t record);
+
+    int32_t usedCount() const
+    {
+        return _records - (int32_t)_free.size();
+    }
+    size_t fileBytes() const
+    {
+        return (size_t)_records * _record_bytes;
+    }
+
+private:
+    std::FILE* _file     = nullptr;
+    std::string _path;
+    size_t _record_bytes = 0;
+    int32_t _records     = 0;  // ファイル上のレコード数
+    std::vector<int32_t> _free;
+};
+
+}  // namespace drawing
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "tile_pool.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace drawing;
+
+void TilePool::init(size_t blockBytes)
+{
+    _block_bytes     = blockBytes;
+    _blocks_per_slab = std::max<size_t>(1, SLAB_BYTES / blockBytes);
+    _slabs.clear();
+    _free.clear();
+}
+
+uint8_t* TilePool::acquire()
+{
+    if (_free.empty()) {
+        std::unique_ptr<uint8_t[]> slab(new uint8_t[_block_bytes * _blocks_per_slab]);
+        for (size_t i = _blocks_per_slab; i-- > 0;) {
+            _free.push_back(slab.get() + i * _block_bytes);
+        }
+        _slabs.push_back(std::move(slab));
+    }
+
+    uint8_t* block = _free.back();
+    _free.pop_back();
+    return block;
+}
+
+void TilePool::release(uint8_t* block)
+{
+    _free.push_back(block);
+}
+
+size_t TilePool::shrink(std::vector<uint8_t*>& blocks)
+{
+    if (_free.size() < _blocks_per_slab) return 0;
+
+    // ブロックからスラブを引けるように、スラブを先頭アドレス順に並べる
+    const size_t slab_num   = _slabs.size();
+    const size_t slab_bytes = _block_bytes * _blocks_per_slab;
+    std::vector<size_t> order(slab_num);
+    for (size_t i = 0; i < slab_num; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return _slabs[a].get() < _slabs[b].get(); });
+    auto slab_of = [&](const uint8_t* block) {
+        auto it = std::upper_bound(order.begin(), order.end(), block,
+                                   [&](const uint8_t* p, size_t slab) { return p < _slabs[slab].get(); });
+        return *(it - 1);
+    };
+
+    // 使用中のブロックが多いスラブから、使用中の数を収めるのに必要なだけ残す
+    std::vector<size_t> live(slab_num, 0);
+    std::vector<uint8_t> used(slab_num * _blocks_per_slab, 0);
+    size_t used_num = 0;
+    for (uint8_t* block : blocks) {
+        if (!block) continue;
+        const size_t slab = slab_of(block);
+        live[slab]++;
+        used[slab * _blocks_per_slab + (block - _slabs[slab].get()) / _block_bytes] = 1;
+        used_num++;
+    }
+    const size_t keep_num = (used_num + _blocks_per_slab - 1) / _blocks_per_slab;
+    std::vector<size_t> by_live = order;
+    std::stable_sort(by_live.begin(), by_live.end(), [&](size_t a, size_t b) { return live[a] > live[b]; });
+    std::vector<uint8_t> keep(slab_num, 0);
+    for (size_t i = 0; i < keep_num; i++) {
+        keep[by_live[i]] = 1;
+    }
+
+    // 残すスラブの空きへ、解放するスラブのブロックを移す
+    std::vector<uint8_t*> vacant;
+    for (size_t slab = 0; slab < slab_num; slab++) {
+        if (!keep[slab]) continue;
+        for (size_t i = _blocks_per_slab; i-- > 0;) {
+            if (!used[slab * _blocks_per_slab + i]) vacant.push_back(_slabs[slab].get() + i * _block_bytes);
+        }
+    }
+    for (uint8_t*& block : blocks) {
+        if (!block || keep[slab_of(block)]) continue;
+        uint8_t* dest = vacant.back();
+        vacant.pop_back();
+        std::memcpy(dest, block, _block_bytes);
+        block = dest;
+    }
+
+    std::vector<std::unique_ptr<uint8_t[]>> slabs;
+    for (size_t slab = 0; slab < slab_num; slab++) {
+        if (keep[slab]) slabs.push_back(std::move(_slabs[slab]));
+    }
+    const size_t freed = (slab_num - slabs.size()) * slab_bytes;
+    _slabs             = std::move(slabs);
+    _free              = std::move(vacant);
+    return freed;
+}
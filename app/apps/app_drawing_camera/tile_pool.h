@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief 同じ大きさのブロック（タイル 1 枚分）をまとめて確保するプール
+ *
+ * ESP32 では 16KB 未満の malloc は内部 RAM から確保されるため、ブロックはスラブ単位で確保して PSRAM に置く。
+ * 解放したブロックはスラブに戻すだけなので、メモリを返すには shrink() で使用中のブロックを詰め直す。
+ */
+class TilePool {
+public:
+    static constexpr size_t SLAB_BYTES = 64 * 1024;
+
+    TilePool() = default;
+    TilePool(const TilePool&)            = delete;
+    TilePool& operator=(const TilePool&) = delete;
+
+    /**
+     * @brief ブロックの大きさを決める（確保済みのスラブはすべて解放する）
+     *
+     */
+    void init(size_t blockBytes);
+
+    /**
+     * @brief ブロックを取得する（内容は不定）
+     *
+     */
+    uint8_t* acquire();
+    void release(uint8_t* block);
+
+    /**
+     * @brief 使用中のブロックを空きの少ないスラブへ移し、すべて空いたスラブを解放する
+     *
+     * @param blocks 使用中のブロックの表（nullptr は未使用）。移したブロックはこの表の上で書き換える
+     * @return size_t 解放したバイト数
+     */
+    size_t shrink(std::vector<uint8_t*>& blocks);
+
+    size_t blockBytes() const
+    {
+        return _block_bytes;
+    }
+    size_t usedCount() const
+    {
+        return _slabs.size() * _blocks_per_slab - _free.size();
+    }
+    size_t freeCount() const
+    {
+        return _free.size();
+    }
+    size_t blocksPerSlab() const
+    {
+        return _blocks_per_slab;
+    }
+
+    /**
+     * @brief スラブとして確保しているバイト数
+     *
+     */
+    size_t bytes() const
+    {
+        return _slabs.size() * _blocks_per_slab * _block_bytes;
+    }
+
+private:
+    size_t _block_bytes     = 0;
+    size_t _blocks_per_slab = 0;
+    std::vector<std::unique_ptr<uint8_t[]>> _slabs;
+    std::vector<uint8_t*> _free;
+};
+
+}  // namespace drawing
@@ -0,0 +1,200 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "undo_history.h"
+#include <cstring>
+
+using namespace drawing;
+
+static constexpr uint8_t RLE_RUN_FLAG   = 0x80;
+static constexpr int32_t RLE_MAX_LENGTH = 0x80;
+static constexpr int32_t RLE_MIN_RUN    = 3;  // これより短い繰り返しはリテラルのほうが小さい
+
+/* -------------------------------------------------------------------------- */
+/*                                     RLE                                    */
+/* -------------------------------------------------------------------------- */
+void drawing::rle_encode_8(const uint8_t* cells, int32_t count, std::vector<uint8_t>& out)
+{
+    int32_t i = 0;
+    while (i < count) {
+        // ランの長さを数える
+        int32_t run = 1;
+        while (i + run < count && run < RLE_MAX_LENGTH && cells[i + run] == cells[i]) {
+            run++;
+        }
+        if (run >= RLE_MIN_RUN) {
+            out.push_back(RLE_RUN_FLAG | (uint8_t)(run - 1));
+            out.push_back(cells[i]);
+            i += run;
+            continue;
+        }
+
+        // 次のランが始まるまでをリテラルとしてまとめる
+        int32_t literal = run;
+        while (i + literal < count && literal < RLE_MAX_LENGTH) {
+            const uint8_t* p = cells + i + literal;
+            int32_t remain   = count - (i + literal);
+            if (remain >= RLE_MIN_RUN && p[0] == p[1] && p[0] == p[2]) break;
+            literal++;
+        }
+        out.push_back((uint8_t)(literal - 1));
+        out.insert(out.end(), cells + i, cells + i + literal);
+        i += literal;
+    }
+}
+
+const uint8_t* drawing::rle_decode_8(const uint8_t* src, uint8_t* cells, int32_t count)
+{
+    while (count > 0) {
+        uint8_t header = *src++;
+        int32_t length = (header & (RLE_RUN_FLAG - 1)) + 1;
+        if (header & RLE_RUN_FLAG) {
+            std::memset(cells, *src++, length);
+        } else {
+            std::memcpy(cells, src, length);
+            src += length;
+        }
+        cells += length;
+        count -= length;
+    }
+    return src;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                UndoHistory                                 */
+/* -------------------------------------------------------------------------- */
+void UndoHistory::init(int32_t width, int32_t height, size_t budgetBytes)
+{
+    _grid.resize(width, height);
+    _captured.resize(_grid.count());
+    _budget = budgetBytes;
+    clear();
+}
+
+void UndoHistory::setBudget(size_t budgetBytes)
+{
+    _budget = budgetBytes;
+    enforce_budget();
+}
+
+void UndoHistory::beginStep()
+{
+    if (_step_open) endStep();
+
+    // 新しい操作をしたらやり直し履歴は無効
+    for (const auto& step : _redo) {
+        _total_bytes -= step.bytes;
+    }
+    _redo.clear();
+
+    _current   = Step_t();
+    _step_open = true;
+}
+
+void UndoHistory::capture(const InkLayer& layer, const Rect& area)
+{
+    if (!_step_open) return;
+    _grid.forEachTileIn(area, [&](int index) { captureTile(layer, index); });
+}
+
+void UndoHistory::captureTile(const InkLayer& layer, int index)
+{
+    if (!_step_open || _captured.test(index)) return;
+    _captured.set(index);
+
+    TileSnapshot_t tile;
+    tile.index = index;
+    encode_tile(layer, index, tile);
+
+    _current.bytes += tile.data.size();
+    _total_bytes += tile.data.size();
+    _current.tiles.push_back(std::move(tile));
+}
+
+void UndoHistory::endStep()
+{
+    if (!_step_open) return;
+    _step_open = false;
+    _captured.clear();
+
+    if (_current.tiles.empty()) return;
+    _undo.push_back(std::move(_current));
+    _current = Step_t();
+    enforce_budget();
+}
+
+void UndoHistory::clear()
+{
+    _undo.clear();
+    _redo.clear();
+    _current   = Step_t();
+    _step_open = false;
+    _captured.clear();
+    _total_bytes = 0;
+}
+
+UndoHistory::Stats_t UndoHistory::getStats() const
+{
+    Stats_t stats;
+    stats.bytes      = _total_bytes;
+    stats.undoLevels = _undo.size();
+    stats.redoLevels = _redo.size();
+    stats.evicted    = _evicted;
+
+    auto add_raw = [&](const Step_t& step) {
+        stats.rawBytes += step.tiles.size() * _tile_bytes;
+    };
+    for (const auto& step : _undo) add_raw(step);
+    for (const auto& step : _redo) add_raw(step);
+    add_raw(_current);
+    return stats;
+}
+
+void UndoHistory::encode_tile(const InkLayer& layer, int index, TileSnapshot_t& out)
+{
+    // タイルは連続したセル列なので、そのまま圧縮する（行をまたいだランもまとめられる）
+    out.data.clear();
+    out.allocated = layer.hasTile(index);
+    out.solid     = layer.solidByte(index);
+    _tile_bytes   = layer.tileBytes();
+    if (out.allocated && out.solid < 0) {
+        rle_encode_8(layer.tile(index), _tile_bytes, out.data);
+    }
+    out.data.shrink_to_fit();
+}
+
+void UndoHistory::swap_tile(InkLayer& layer, TileSnapshot_t& tile)
+{
+    TileSnapshot_t current;
+    current.index = tile.index;
+    encode_tile(layer, tile.index, current);
+
+    if (tile.solid >= 0) {
+        layer.setSolidTile(tile.index, (uint8_t)tile.solid);
+    } else if (tile.allocated) {
+        rle_decode_8(tile.data.data(), layer.acquireTile(tile.index), layer.tileBytes());
+    } else {
+        layer.releaseTile(tile.index);
+    }
+
+    tile = std::move(current);
+}
+
+void UndoHistory::enforce_budget()
+{
+    // 古い取り消し履歴から破棄し、それでも足りなければ遠いやり直し履歴を破棄する。
+    // 直前の操作とその次のやり直しは 1 ステップだけでバジェットを超えていても残す（大きな塗りつぶしなどを
+    // 終えた直後にその操作自身が消えて、取り消せなくなるのを防ぐ。超過は次の操作で古い側として破棄される）
+    while (_total_bytes > _budget && _undo.size() > 1) {
+        _total_bytes -= _undo.front().bytes;
+        _undo.pop_front();
+        _evicted++;
+    }
+    while (_total_bytes > _budget && _redo.size() > 1) {
+        _total_bytes -= _redo.front().bytes;
+        _redo.erase(_redo.begin());
+        _evicted++;
+    }
+}
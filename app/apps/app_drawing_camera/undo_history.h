@@ -0,0 +1,204 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "tile_canvas.h"
+#include "ink_layer.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief インクのセル列を RLE 圧縮する
+ *
+ * 先頭バイトの最上位ビットが 1 なら下位 7 ビット + 1 回だけ次のバイトを繰り返す（ラン）、
+ * 0 なら下位 7 ビット + 1 バイトがそのまま続く（リテラル）。
+ *
+ * @param out 末尾に追記する
+ */
+void rle_encode_8(const uint8_t* cells, int32_t count, std::vector<uint8_t>& out);
+
+/**
+ * @brief rle_encode_8() で圧縮したデータを展開する
+ *
+ * @return const uint8_t* 読み終えた位置
+ */
+const uint8_t* rle_decode_8(const uint8_t* src, uint8_t* cells, int32_t count);
+
+/**
+ * @brief タイル単位のコピーオンライトによるアンドゥ・リドゥ履歴
+ *
+ * InkLayer のタイルを対象とする（写真は描画で変わらないので保存しない）。1 ストローク（またはクリアなどの操作）を
+ * 1 ステップとし、ステップ中に初めて書き込まれるタイルだけを書き込み前に RLE 圧縮して保存する。
+ * 未確保のタイルと単色タイルはデータなしで保存する。使用量がバジェットを超えたら古いステップから破棄する（直前の操作と
+ * 次のやり直しは、それだけでバジェットを超えていても残す）。
+ * アンドゥ・リドゥは保存済みのタイルと現在のタイルを入れ替えるので、必要なメモリは操作の面積に比例する。
+ */
+class UndoHistory {
+public:
+    struct Stats_t {
+        size_t bytes    = 0;  // 保存中の圧縮データの合計
+        size_t rawBytes = 0;  // 圧縮前に換算した合計
+        int undoLevels  = 0;
+        int redoLevels  = 0;
+        int evicted     = 0;  // バジェット超過で破棄したステップ数
+    };
+
+    void init(int32_t width, int32_t height, size_t budgetBytes);
+
+    /**
+     * @brief 履歴に使うメモリの上限（超えたら古いステップから破棄。直前のステップは超えていても残す）
+     *
+     * @param budgetBytes
+     */
+    void setBudget(size_t budgetBytes);
+
+    /**
+     * @brief 操作の開始（リドゥ履歴は破棄される）
+     *
+     */
+    void beginStep();
+
+    /**
+     * @brief 書き込み予定の領域を通知する（初めて触れるタイルの書き込み前の状態を保存）
+     *
+     * @param layer
+     * @param area 書き込む可能性のある範囲
+     */
+    void capture(const InkLayer& layer, const Rect& area);
+
+    /**
+     * @brief 単一のタイルを保存する（クリアなど、タイル単位で処理する操作用）
+     *
+     */
+    void captureTile(const InkLayer& layer, int index);
+
+    /**
+     * @brief 操作の終了（何も保存されていなければステップは残さない）
+     *
+     */
+    void endStep();
+
+    /**
+     * @brief 開いている操作を取り消して閉じる（書き込む前の状態に戻し、履歴には残さない）
+     *
+     * @param layer
+     * @param fn void(const Rect&) 書き戻したタイルごとに呼ばれる（無効化用）
+     * @return true 取り消した
+     */
+    template <typename Fn>
+    bool cancelStep(InkLayer& layer, Fn&& fn)
+    {
+        if (!_step_open) return false;
+        swap_step(layer, _current, fn);
+        _total_bytes -= _current.bytes;
+        _current   = Step_t();
+        _step_open = false;
+        _captured.clear();
+        return true;
+    }
+
+    bool isStepOpen() const
+    {
+        return _step_open;
+    }
+    bool canUndo() const
+    {
+        return !_undo.empty();
+    }
+    bool canRedo() const
+    {
+        return !_redo.empty();
+    }
+
+    /**
+     * @brief 直前の操作を取り消す
+     *
+     * @param layer
+     * @param fn void(const Rect&) 書き戻したタイルごとに呼ばれる（無効化用）
+     * @return true 取り消した
+     */
+    template <typename Fn>
+    bool undo(InkLayer& layer, Fn&& fn)
+    {
+        if (_step_open || _undo.empty()) return false;
+        _redo.push_back(std::move(_undo.back()));
+        _undo.pop_back();
+        swap_step(layer, _redo.back(), fn);
+        return true;
+    }
+
+    /**
+     * @brief 取り消した操作をやり直す
+     *
+     * @param layer
+     * @param fn void(const Rect&) 書き戻したタイルごとに呼ばれる（無効化用）
+     * @return true やり直した
+     */
+    template <typename Fn>
+    bool redo(InkLayer& layer, Fn&& fn)
+    {
+        if (_step_open || _redo.empty()) return false;
+        _undo.push_back(std::move(_redo.back()));
+        _redo.pop_back();
+        swap_step(layer, _undo.back(), fn);
+        return true;
+    }
+
+    /**
+     * @brief 履歴をすべて破棄する（背景画像の差し替え時など）
+     *
+     */
+    void clear();
+
+    Stats_t getStats() const;
+
+private:
+    struct TileSnapshot_t {
+        int index      = 0;
+        bool allocated = false;     // false ならタイルは未確保（インクなし）
+        int16_t solid  = -1;        // 単色タイルのバイト（-1 なら data に保存）
+        std::vector<uint8_t> data;  // RLE 圧縮したタイルのセル
+    };
+    struct Step_t {
+        std::vector<TileSnapshot_t> tiles;
+        size_t bytes = 0;
+    };
+
+    TileGrid _grid;
+    TileBitmap _captured;  // 現在のステップで保存済みのタイル
+    std::deque<Step_t> _undo;
+    std::vector<Step_t> _redo;
+    Step_t _current;
+    bool _step_open     = false;
+    size_t _budget      = 0;
+    size_t _total_bytes = 0;
+    int _evicted        = 0;
+    int _tile_bytes     = InkLayer::TILE_BYTES;  // 保存したタイルの展開後の大きさ
+
+    void encode_tile(const InkLayer& layer, int index, TileSnapshot_t& out);
+    void swap_tile(InkLayer& layer, TileSnapshot_t& tile);
+    void enforce_budget();
+
+    template <typename Fn>
+    void swap_step(InkLayer& layer, Step_t& step, Fn& fn)
+    {
+        // 現在の内容と保存した内容を入れ替える（同じステップがそのまま逆操作になる）
+        _total_bytes -= step.bytes;
+        step.bytes = 0;
+        for (auto& tile : step.tiles) {
+            swap_tile(layer, tile);
+            step.bytes += tile.data.size();
+            fn(_grid.tileRect(tile.index));
+        }
+        _total_bytes += step.bytes;
+        enforce_budget();
+    }
+};
+
+}  // namespace drawing
@@ -0,0 +1,148 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "viewport.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace drawing;
+
+// この範囲の倍率は等倍として扱う（ホイールの刻みの誤差で等倍に戻れなくならないように）
+static constexpr float ZOOM_SNAP = 0.02f;
+
+void Viewport::init(int32_t canvasWidth, int32_t canvasHeight, int32_t screenWidth, int32_t screenHeight)
+{
+    _canvas_width  = canvasWidth;
+    _canvas_height = canvasHeight;
+    _screen_width  = screenWidth;
+    _screen_height = screenHeight;
+    _tile_cols     = TileGrid(canvasWidth, canvasHeight).cols();
+    _col_map.assign(screenWidth, -1);
+    _row_map.assign(screenHeight, -1);
+    _col_tile_end.assign(screenWidth, -1);
+    reset();
+}
+
+void Viewport::reset()
+{
+    _zoom     = 1.0f;
+    _offset_x = 0.0f;
+    _offset_y = 0.0f;
+    clamp_offset();
+    update_maps();
+}
+
+bool Viewport::zoomAt(float factor, float screenX, float screenY)
+{
+    float zoom = std::max(MIN_ZOOM, std::min(MAX_ZOOM, _zoom * factor));
+    if (std::fabs(zoom - 1.0f) < ZOOM_SNAP) zoom = 1.0f;
+    if (zoom == _zoom) return false;
+
+    // 注目点の下にあるキャンバス座標が変わらないようにずらす
+    const float cx = (screenX - _offset_x) / _zoom;
+    const float cy = (screenY - _offset_y) / _zoom;
+    _zoom          = zoom;
+    _offset_x      = screenX - cx * zoom;
+    _offset_y      = screenY - cy * zoom;
+    clamp_offset();
+    update_maps();
+    return true;
+}
+
+bool Viewport::panBy(float dx, float dy)
+{
+    const float x = _offset_x;
+    const float y = _offset_y;
+    _offset_x += dx;
+    _offset_y += dy;
+    clamp_offset();
+    if (x == _offset_x && y == _offset_y) return false;
+    update_maps();
+    return true;
+}
+
+bool Viewport::toCanvas(int32_t screenX, int32_t screenY, int32_t& canvasX, int32_t& canvasY) const
+{
+    canvasX = (int32_t)std::floor((screenX + 0.5f - _offset_x) / _zoom);
+    canvasY = (int32_t)std::floor((screenY + 0.5f - _offset_y) / _zoom);
+    return canvasX >= 0 && canvasX < _canvas_width && canvasY >= 0 && canvasY < _canvas_height;
+}
+
+Rect Viewport::visibleRect() const
+{
+    if (_col_first > _col_last || _row_first > _row_last) return Rect();
+    const Rect level = {_col_map[_col_first], _row_map[_row_first], _col_map[_col_last], _row_map[_row_last]};
+    const Rect rect  = {level.x1 << _level, level.y1 << _level, ((level.x2 + 1) << _level) - 1,
+                        ((level.y2 + 1) << _level) - 1};
+    return rect.intersect(Rect{0, 0, _canvas_width - 1, _canvas_height - 1});
+}
+
+Rect Viewport::toScreen(const Rect& canvasRect) const
+{
+    if (canvasRect.isEmpty()) return Rect();
+
+    // 段の画素は 2^level 画素ぶんの範囲を表すので、その単位に広げてから画面へ写す（丸め誤差の分 1 画素広げる）
+    const int32_t unit = 1 << _level;
+    const float x1     = (float)((canvasRect.x1 >> _level) * unit);
+    const float y1     = (float)((canvasRect.y1 >> _level) * unit);
+    const float x2     = (float)(((canvasRect.x2 >> _level) + 1) * unit);
+    const float y2     = (float)(((canvasRect.y2 >> _level) + 1) * unit);
+    const Rect screen  = {(int32_t)std::ceil(x1 * _zoom + _offset_x - 0.5f) - 1,
+                          (int32_t)std::ceil(y1 * _zoom + _offset_y - 0.5f) - 1,
+                          (int32_t)std::ceil(x2 * _zoom + _offset_x - 0.5f),
+                          (int32_t)std::ceil(y2 * _zoom + _offset_y - 0.5f)};
+    return screen.intersect(Rect{0, 0, _screen_width - 1, _screen_height - 1});
+}
+
+void Viewport::clamp_offset()
+{
+    // 画面より大きい方向は端が画面の内側に入らないように、小さい方向は中央に置く
+    auto clamp_axis = [](float offset, float scaled, int32_t screen) {
+        if (scaled <= screen) return std::round((screen - scaled) * 0.5f);
+        return std::max(screen - scaled, std::min(0.0f, offset));
+    };
+    _offset_x = clamp_axis(_offset_x, _canvas_width * _zoom, _screen_width);
+    _offset_y = clamp_axis(_offset_y, _canvas_height * _zoom, _screen_height);
+}
+
+void Viewport::update_maps()
+{
+    // 縮小率に最も近い段を使う（段の倍率の 1/√2 ~ √2 倍の範囲は最近傍で拡大縮小する）
+    _level = std::max(0, std::min(MipPyramid::MAX_LEVELS, (int)std::floor(std::log2(1.0f / _zoom) + 0.5f)));
+
+    const float scale    = _zoom * (float)(1 << _level);
+    const int32_t width  = (_canvas_width + (1 << _level) - 1) >> _level;
+    const int32_t height = (_canvas_height + (1 << _level) - 1) >> _level;
+    auto map_axis        = [&](int32_t screen, float offset, int32_t size) {
+        const int32_t v = (int32_t)std::floor((screen + 0.5f - offset) / scale);
+        return v >= 0 && v < size ? v : -1;
+    };
+
+    _col_first = _screen_width;
+    _col_last  = -1;
+    for (int32_t x = 0; x < _screen_width; x++) {
+        _col_map[x] = map_axis(x, _offset_x, width);
+        if (_col_map[x] >= 0) {
+            _col_first = std::min(_col_first, x);
+            _col_last  = x;
+        }
+    }
+    _row_first = _screen_height;
+    _row_last  = -1;
+    for (int32_t y = 0; y < _screen_height; y++) {
+        _row_map[y] = map_axis(y, _offset_y, height);
+        if (_row_map[y] >= 0) {
+            _row_first = std::min(_row_first, y);
+            _row_last  = y;
+        }
+    }
+
+    // 列ごとに、同じタイルを読む列が続く最後の列（表は単調なので後ろから求める）
+    const int shift = TILE_SHIFT - _level;
+    for (int32_t x = _col_last; x >= _col_first; x--) {
+        const bool same  = x < _col_last && (_col_map[x + 1] >> shift) == (_col_map[x] >> shift);
+        _col_tile_end[x] = same ? _col_tile_end[x + 1] : x;
+    }
+}
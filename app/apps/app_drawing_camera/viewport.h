@@ -0,0 +1,172 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include "stroke_raster.h"
+#include "mip_pyramid.h"
+#include <cstdint>
+#include <vector>
+
+namespace drawing {
+
+/**
+ * @brief キャンバスの表示倍率と位置（画面座標 = キャンバス座標 × zoom + offset）
+ *
+ * 画面の各列・各行がどの画素を表示するかを変更のたびに表にしておき、描画は表を引くだけにする（最近傍）。
+ * 縮小表示では倍率に近い MipPyramid の段から読むので、表はその段の座標で持つ。画素はタイル単位で読むので、
+ * キャンバスが画面より大きくてもキャンバス全体の画像は要らない。
+ * 全画面を描き直す場合も一部だけ描き直す場合も同じ表を使うので、結果は一致する。
+ */
+class Viewport {
+public:
+    static constexpr float MIN_ZOOM = 1.0f / 8.0f;
+    static constexpr float MAX_ZOOM = 8.0f;
+    static constexpr int TILE_SHIFT = 6;
+    static_assert((1 << TILE_SHIFT) == TileGrid::TILE_SIZE, "TILE_SHIFT must match the tile size");
+
+    /**
+     * @param canvasWidth キャンバス（等倍の画像）の大きさ
+     * @param canvasHeight
+     * @param screenWidth 表示先の大きさ
+     * @param screenHeight
+     */
+    void init(int32_t canvasWidth, int32_t canvasHeight, int32_t screenWidth, int32_t screenHeight);
+
+    /**
+     * @brief 等倍に戻す（画面より大きい方向は左上、小さい方向は中央に置く）
+     *
+     */
+    void reset();
+
+    /**
+     * @brief 画面上の 1 点を動かさずに倍率を factor 倍にする
+     *
+     * 倍率は MIN_ZOOM ~ MAX_ZOOM に制限し、等倍の近くでは等倍にそろえる。
+     * @return true 表示が変わった
+     */
+    bool zoomAt(float factor, float screenX, float screenY);
+
+    /**
+     * @brief 画面上でずらす（キャンバスが画面より小さい方向は中央に固定）
+     *
+     * @return true 表示が変わった
+     */
+    bool panBy(float dx, float dy);
+
+    float zoom() const
+    {
+        return _zoom;
+    }
+
+    /**
+     * @brief 表示に使う MipPyramid の段（0 は等倍の画像）
+     *
+     */
+    int level() const
+    {
+        return _level;
+    }
+
+    /**
+     * @brief 画面に写っているキャンバスの範囲
+     *
+     */
+    Rect visibleRect() const;
+
+    /**
+     * @brief 画面座標をキャンバス座標にする
+     *
+     * @return true キャンバスの内側
+     */
+    bool toCanvas(int32_t screenX, int32_t screenY, int32_t& canvasX, int32_t& canvasY) const;
+
+    /**
+     * @brief キャンバスの範囲が変わったときに描き直す画面の範囲（画面内にクリップ済み）
+     *
+     */
+    Rect toScreen(const Rect& canvasRect) const;
+
+    /**
+     * @brief キャンバス上の点（画素の中心）の画面座標
+     *
+     */
+    float toScreenX(float canvasX) const
+    {
+        return (canvasX + 0.5f) * _zoom + _offset_x - 0.5f;
+    }
+    float toScreenY(float canvasY) const
+    {
+        return (canvasY + 0.5f) * _zoom + _offset_y - 0.5f;
+    }
+
+    /**
+     * @brief 画面の範囲を描く
+     *
+     * @param out 画面の大きさのバッファ
+     * @param area 描く範囲（画面座標）
+     * @param backdrop キャンバスの外側の色
+     * @param tile const uint16_t*(int index) level() の段のタイルの画素（一辺も行の間隔も TILE_SIZE >> level()）
+     */
+    template <typename TileFn>
+    void render(const PixelBuffer565& out, const Rect& area, uint16_t backdrop, TileFn&& tile) const
+    {
+        const Rect clip = area.intersect(out.bounds()).intersect(Rect{0, 0, _screen_width - 1, _screen_height - 1});
+        if (clip.isEmpty()) return;
+
+        // キャンバスの内側の列だけ表を引き、外側は背景色で塗る（タイルは同じタイルが続く列ごとに一度だけ引く）
+        const int shift     = TILE_SHIFT - _level;
+        const int32_t size  = 1 << shift;
+        const int32_t first = std::max(clip.x1, _col_first);
+        const int32_t last  = std::min(clip.x2, _col_last);
+        const int32_t* map  = _col_map.data();
+        for (int32_t y = clip.y1; y <= clip.y2; y++) {
+            uint16_t* dst    = out.row(y);
+            const int32_t sy = _row_map[y];
+            if (sy < 0 || first > last) {
+                fill_span_565(dst + clip.x1, clip.width(), backdrop);
+                continue;
+            }
+            fill_span_565(dst + clip.x1, first - clip.x1, backdrop);
+            fill_span_565(dst + last + 1, clip.x2 - last, backdrop);
+
+            const int row_tile   = (sy >> shift) * _tile_cols;
+            const int32_t offset = (sy & (size - 1)) * size;
+            for (int32_t x = first; x <= last;) {
+                const int32_t tx    = map[x] >> shift;
+                const int32_t x0    = tx << shift;
+                const int32_t end   = std::min(last, _col_tile_end[x]);
+                const uint16_t* src = tile(row_tile + tx) + offset;
+                for (; x <= end; x++) {
+                    dst[x] = src[map[x] - x0];
+                }
+            }
+        }
+    }
+
+private:
+    int32_t _canvas_width  = 0;
+    int32_t _canvas_height = 0;
+    int32_t _screen_width  = 0;
+    int32_t _screen_height = 0;
+    float _zoom            = 1.0f;
+    float _offset_x        = 0.0f;
+    float _offset_y        = 0.0f;
+    int _level             = 0;
+    int _tile_cols         = 0;
+
+    // 画面の列・行ごとに読む段の座標（キャンバスの外は -1）と、内側になる範囲
+    std::vector<int32_t> _col_map;
+    std::vector<int32_t> _row_map;
+    std::vector<int32_t> _col_tile_end;  // 同じタイルを読む最後の列
+    int32_t _col_first = 0;
+    int32_t _col_last  = -1;
+    int32_t _row_first = 0;
+    int32_t _row_last  = -1;
+
+    void clamp_offset();
+    void update_maps();
+};
+
+}  // namespace drawing
@@ -57,3 +57,25 @@ bool hal::Check()
     }
     return false;
 }
+
+/* -------------------------------------------------------------------------- */
+/*                                Input latency                               */
+/* -------------------------------------------------------------------------- */
+static void latency_flush_event_cb(lv_event_t* e)
+{
+    // 一帧可能分多次 flush，只在最后一块送出后记录
+    auto display = static_cast<lv_display_t*>(lv_event_get_target(e));
+    if (!lv_display_flush_is_last(display)) {
+        return;
+    }
+    auto hal = static_cast<hal::HalBase*>(lv_event_get_user_data(e));
+    hal->latencyTrace.markFlush(hal->micros());
+}
+
+void hal::HalBase::hookLatencyFlush(lv_display_t* display)
+{
+    if (!display) {
+        return;
+    }
+    lv_display_add_event_cb(display, latency_flush_event_cb, LV_EVENT_FLUSH_FINISH, this);
+}
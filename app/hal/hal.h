@@ -11,6 +11,10 @@
 #include <lvgl.h>
 #include <mutex>
 #include <vector>
+#include "utils/spsc_ring/spsc_ring.h"
+#include "utils/latency_trace/latency_trace.h"
+#include "utils/triple_buffer/triple_buffer.h"
+#include "utils/image_scale/image_scale.h"
 
 /**
  * @brief Hardware abstraction layer
@@ -52,6 +56,10 @@ public:
     {
         return 0;
     }
+    virtual uint64_t micros()
+    {
+        return (uint64_t)millis() * 1000;
+    }
     virtual int getCpuTemp()
     {
         return 0.0f;
@@ -83,6 +91,70 @@ public:
     {
     }
 
+    /* ------------------------------ Input latency ----------------------------- */
+    // Marked by the app as drawn touch samples move through the pipeline, and by the display flush hook
+    LatencyTrace latencyTrace;
+    /**
+     * @brief Install an LVGL display event that marks the end of each frame flush in latencyTrace
+     *
+     * Called by the platform once the display exists. The mark is taken when the flush callback of the last area
+     * of a frame returns (the panel driver has the pixels).
+     *
+     * @param display
+     */
+    void hookLatencyFlush(lv_display_t* display);
+    /**
+     * @brief Latency histograms (min / p50 / p99 / max per stage) collected since the last reset, call with the
+     * LVGL lock held
+     *
+     * @return LatencyTrace::Stats_t
+     */
+    LatencyTrace::Stats_t getLatencyStats()
+    {
+        return latencyTrace.getStats();
+    }
+
+    /* ---------------------------------- Touch --------------------------------- */
+    static constexpr int MAX_TOUCH_POINTS = 5;  // Fingers tracked at once (the GT911 reports up to 5)
+    struct TouchSample_t {
+        int32_t x            = 0;  // Display coordinate (after rotation)
+        int32_t y            = 0;
+        bool pressed         = false;
+        uint64_t timestampUs = 0;  // micros() at the time the sample was read
+        uint8_t id           = 0;  // Finger ID (0 ~ MAX_TOUCH_POINTS - 1), stable from press to release
+    };
+    // Filled by the platform's touch polling path, drained by the app. Each finger has its own press / move /
+    // release sequence; samples of different fingers are interleaved in the order they were read.
+    SpscRing<TouchSample_t, 256> touchSamples;
+    struct ViewGesture_t {
+        int32_t x  = 0;     // Focus point in display coordinates
+        int32_t y  = 0;
+        float zoom = 1.0f;  // Scale factor to apply around the focus point
+        float panX = 0.0f;  // Pan in display pixels
+        float panY = 0.0f;
+    };
+    // Zoom / pan requests from gestures that are not drawing input (mouse wheel, pinch), drained by the app
+    SpscRing<ViewGesture_t, 32> viewGestures;
+    /**
+     * @brief Start or stop pushing raw touch samples into touchSamples (and view gestures into viewGestures)
+     *
+     * @param enable
+     * @return true if the platform supports touch sampling
+     */
+    virtual bool setTouchSampling(bool enable)
+    {
+        return false;
+    }
+    /**
+     * @brief Number of fingers the platform can report at once through touchSamples
+     *
+     * @return int 1 if only a single pointer is available
+     */
+    virtual int getMaxTouchPoints()
+    {
+        return 1;
+    }
+
     /* ---------------------------------- Power --------------------------------- */
     struct PMData_t {
         float busVoltage   = 0.0f;
@@ -164,16 +236,107 @@ public:
     }
 
     /* --------------------------------- Camera --------------------------------- */
+    enum CameraState_t {
+        CAMERA_OFF = 0,    // Device closed, no task
+        CAMERA_PAUSED,     // Warm: task, buffers and 2D engine client kept, stream stopped
+        CAMERA_STREAMING,  // Frames go to the preview canvas
+    };
+    /**
+     * @brief Stream camera frames into the canvas (opens the camera when off, resumes it when paused)
+     *
+     * @param imgCanvas
+     */
     virtual void startCameraCapture(lv_obj_t* imgCanvas)
     {
     }
+    /**
+     * @brief Pause the stream and keep the camera warm for the next startCameraCapture()
+     *
+     */
     virtual void stopCameraCapture()
     {
     }
+    /**
+     * @brief Close the camera and release what it keeps while paused (waits for the camera task to finish)
+     *
+     */
+    virtual void powerOffCamera()
+    {
+    }
     virtual bool isCameraCapturing()
     {
         return false;
     }
+    virtual CameraState_t getCameraState()
+    {
+        return CAMERA_OFF;
+    }
+    struct CameraStartStats_t {
+        LatencyHistogram::Summary_t cold;  // startCameraCapture() from off -> first frame
+        LatencyHistogram::Summary_t warm;  // startCameraCapture() from paused -> first frame
+        uint32_t resumeFailures = 0;       // Warm starts whose stream did not restart (the camera is left paused)
+    };
+    /**
+     * @brief Start-to-first-frame latency of every start so far
+     *
+     * @return CameraStartStats_t
+     */
+    virtual CameraStartStats_t getCameraStartStats()
+    {
+        return {};
+    }
+    /**
+     * @brief Preview frame counters since the last startCameraCapture() (frames are exchanged through a triple
+     * buffer and swapped into the canvas at the start of an LVGL refresh)
+     *
+     * @return TripleBuffer::Stats_t
+     */
+    virtual TripleBuffer::Stats_t getCameraFrameStats()
+    {
+        return {};
+    }
+    struct CameraFrame_t {
+        uint16_t* data = nullptr;  // RGB565
+        int32_t width  = 0;
+        int32_t height = 0;
+        int32_t stride = 0;  // In pixels
+    };
+    /**
+     * @brief Take the preview frame on screen out of the camera pipeline without copying it
+     *
+     * The caller owns the buffer until releaseCameraFrame(); the pipeline carries on with a buffer from its pool.
+     * Call with the LVGL lock held while capturing.
+     *
+     * @param frame
+     * @return false if no frame has been shown since startCameraCapture()
+     */
+    virtual bool takeCameraFrame(CameraFrame_t& frame)
+    {
+        return false;
+    }
+    /**
+     * @brief Give a frame from takeCameraFrame() back to the pipeline's pool (any thread)
+     *
+     * Clears the frame's pixels, so call it outside the LVGL lock.
+     *
+     * @param frame
+     */
+    virtual void releaseCameraFrame(const CameraFrame_t& frame)
+    {
+    }
+    /**
+     * @brief Scale an RGB565 image into another of a different size (e.g. a camera frame that does not match the
+     * canvas), see ImageScaler
+     *
+     * Software by default. Platforms with a 2D engine override it and fall back to this when the engine cannot do
+     * the scale. Blocks until done, any thread.
+     */
+    virtual void scaleImage(const ImageScaler::Image565_t& src, const ImageScaler::Image565_t& dst,
+                            ImageScaler::Policy_t policy, ImageScaler::Filter_t filter, uint16_t fill)
+    {
+        ImageScaler scaler;
+        scaler.scale(src, dst, policy, filter, fill);
+    }
 
     /* ---------------------------------- USB-A --------------------------------- */
     struct HidMouseData_t {
@@ -272,6 +435,16 @@ public:
         return {};
     }
 
+    /**
+     * @brief Directory for temporary files written while an app runs (e.g. paged-out canvas tiles)
+     *
+     * @return Empty if no writable storage is available
+     */
+    virtual std::string getScratchDir()
+    {
+        return "";
+    }
+
     /* -------------------------------- Interface ------------------------------- */
     virtual bool usbCDetect()
     {
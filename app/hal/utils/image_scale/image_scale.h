@@ -0,0 +1,261 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * @brief Scaled copy of an RGB565 image into another of a different size, in fixed point
+ *
+ * A placement policy decides which part of the source lands where in the destination, then the source rectangle is
+ * resampled into the destination rectangle with nearest or bilinear filtering. Column positions and weights are
+ * computed once per call. For bilinear filtering each source row is filtered horizontally once and kept while the
+ * output rows that need it are written, so upscaling reads every source pixel once. Pixels outside the placed
+ * rectangle get the fill color.
+ *
+ * Keeps its line buffers between calls; one instance must not be used from two threads at once.
+ */
+class ImageScaler {
+public:
+    enum Filter_t {
+        FILTER_NEAREST = 0,
+        FILTER_BILINEAR,
+    };
+
+    enum Policy_t {
+        POLICY_CROP = 0,  // 1:1, centered, cropped where it does not fit
+        POLICY_FIT,       // Scaled to fit inside, aspect kept, the rest filled
+        POLICY_FILL,      // Scaled to cover, aspect kept, the overflow cropped (centered)
+    };
+
+    struct Image565_t {
+        uint16_t* data = nullptr;
+        int32_t width  = 0;
+        int32_t height = 0;
+        int32_t stride = 0;  // In pixels
+    };
+
+    /**
+     * @brief Source rectangle and where it goes in the destination
+     *
+     */
+    struct Mapping_t {
+        int32_t srcX = 0;
+        int32_t srcY = 0;
+        int32_t srcW = 0;
+        int32_t srcH = 0;
+        int32_t dstX = 0;
+        int32_t dstY = 0;
+        int32_t dstW = 0;
+        int32_t dstH = 0;
+    };
+
+    static Mapping_t mapping(int32_t srcWidth, int32_t srcHeight, int32_t dstWidth, int32_t dstHeight,
+                             Policy_t policy)
+    {
+        Mapping_t map;
+        map.srcW = srcWidth;
+        map.srcH = srcHeight;
+        map.dstW = dstWidth;
+        map.dstH = dstHeight;
+        if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return Mapping_t();
+
+        // Width limited if dstWidth / srcWidth <= dstHeight / srcHeight
+        const bool width_limited = (int64_t)dstWidth * srcHeight <= (int64_t)dstHeight * srcWidth;
+        if (policy == POLICY_CROP) {
+            map.srcW = map.dstW = std::min(srcWidth, dstWidth);
+            map.srcH = map.dstH = std::min(srcHeight, dstHeight);
+        } else if (policy == POLICY_FIT) {
+            if (width_limited) {
+                map.dstH = std::max<int32_t>(1, rounded_div((int64_t)srcHeight * dstWidth, srcWidth));
+            } else {
+                map.dstW = std::max<int32_t>(1, rounded_div((int64_t)srcWidth * dstHeight, srcHeight));
+            }
+        } else {
+            if (width_limited) {
+                map.srcW = std::max<int32_t>(1, rounded_div((int64_t)dstWidth * srcHeight, dstHeight));
+            } else {
+                map.srcH = std::max<int32_t>(1, rounded_div((int64_t)dstHeight * srcWidth, dstWidth));
+            }
+        }
+        map.srcX = (srcWidth - map.srcW) / 2;
+        map.srcY = (srcHeight - map.srcH) / 2;
+        map.dstX = (dstWidth - map.dstW) / 2;
+        map.dstY = (dstHeight - map.dstH) / 2;
+        return map;
+    }
+
+    /**
+     * @brief Place src into dst by the policy and fill the rest of dst
+     *
+     */
+    void scale(const Image565_t& src, const Image565_t& dst, Policy_t policy, Filter_t filter, uint16_t fill)
+    {
+        const Mapping_t map = mapping(src.width, src.height, dst.width, dst.height, policy);
+        blit(src, dst, map, filter);
+        fillBorder(dst, map, fill);
+    }
+
+    /**
+     * @brief Resample the source rectangle of the mapping into its destination rectangle (nothing else is written)
+     *
+     */
+    void blit(const Image565_t& src, const Image565_t& dst, const Mapping_t& map, Filter_t filter)
+    {
+        if (!src.data || !dst.data || map.srcW <= 0 || map.srcH <= 0 || map.dstW <= 0 || map.dstH <= 0) return;
+
+        // Same size: plain row copies
+        if (map.srcW == map.dstW && map.srcH == map.dstH) {
+            for (int32_t y = 0; y < map.dstH; y++) {
+                std::memcpy(dst.data + (int64_t)(map.dstY + y) * dst.stride + map.dstX,
+                            src.data + (int64_t)(map.srcY + y) * src.stride + map.srcX,
+                            map.dstW * sizeof(uint16_t));
+            }
+            return;
+        }
+
+        build_table(_cols, map.srcW, map.dstW);
+        if (filter == FILTER_NEAREST) {
+            blit_nearest(src, dst, map);
+        } else {
+            build_table(_rows, map.srcH, map.dstH);
+            blit_bilinear(src, dst, map);
+        }
+    }
+
+    /**
+     * @brief Fill dst outside the destination rectangle of the mapping
+     *
+     */
+    static void fillBorder(const Image565_t& dst, const Mapping_t& map, uint16_t fill)
+    {
+        if (!dst.data) return;
+        for (int32_t y = 0; y < dst.height; y++) {
+            uint16_t* row = dst.data + (int64_t)y * dst.stride;
+            if (y < map.dstY || y >= map.dstY + map.dstH) {
+                std::fill(row, row + dst.width, fill);
+            } else {
+                std::fill(row, row + map.dstX, fill);
+                std::fill(row + map.dstX + map.dstW, row + dst.width, fill);
+            }
+        }
+    }
+
+private:
+    static constexpr int WEIGHT_BITS = 8;  // Bilinear weights 0 ~ 256
+    static constexpr int WEIGHT_ONE  = 1 << WEIGHT_BITS;
+
+    // Source position of one output column (or row), relative to the source rectangle
+    struct Tap_t {
+        int32_t i0;   // Left / upper sample
+        int32_t i1;   // Right / lower sample
+        uint16_t w1;  // Weight of i1, 0 ~ WEIGHT_ONE
+        int32_t nearest;
+    };
+
+    static int32_t rounded_div(int64_t a, int64_t b)
+    {
+        return (int32_t)((a + b / 2) / b);
+    }
+
+    // Pixel centers line up: output i samples source (i + 0.5) * srcLen / dstLen - 0.5, in 16.16 fixed point
+    static void build_table(std::vector<Tap_t>& table, int32_t srcLen, int32_t dstLen)
+    {
+        table.resize(dstLen);
+        for (int32_t i = 0; i < dstLen; i++) {
+            const int64_t center = ((int64_t)(2 * i + 1) * srcLen << 15) / dstLen;
+            const int64_t pos    = std::clamp<int64_t>(center - 0x8000, 0, (int64_t)(srcLen - 1) << 16);
+            Tap_t& tap           = table[i];
+            tap.i0               = (int32_t)(pos >> 16);
+            tap.i1               = std::min(tap.i0 + 1, srcLen - 1);
+            tap.w1               = (uint16_t)((pos >> (16 - WEIGHT_BITS)) & (WEIGHT_ONE - 1));
+            tap.nearest          = std::min((int32_t)(center >> 16), srcLen - 1);
+        }
+    }
+
+    void blit_nearest(const Image565_t& src, const Image565_t& dst, const Mapping_t& map)
+    {
+        int32_t last_sy = -1;
+        for (int32_t y = 0; y < map.dstH; y++) {
+            const int32_t sy = std::min((int32_t)((((int64_t)(2 * y + 1) * map.srcH) / map.dstH) >> 1), map.srcH - 1);
+            uint16_t* out    = dst.data + (int64_t)(map.dstY + y) * dst.stride + map.dstX;
+            // Upscaled rows repeat the row above
+            if (sy == last_sy) {
+                std::memcpy(out, out - dst.stride, map.dstW * sizeof(uint16_t));
+                continue;
+            }
+            const uint16_t* in = src.data + (int64_t)(map.srcY + sy) * src.stride + map.srcX;
+            for (int32_t x = 0; x < map.dstW; x++) {
+                out[x] = in[_cols[x].nearest];
+            }
+            last_sy = sy;
+        }
+    }
+
+    // One source row filtered horizontally: r, g, b per output column, scaled by WEIGHT_ONE
+    void filter_row(const uint16_t* in, uint16_t* line, int32_t width) const
+    {
+        for (int32_t x = 0; x < width; x++) {
+            const Tap_t& tap = _cols[x];
+            const uint32_t a = in[tap.i0];
+            const uint32_t b = in[tap.i1];
+            const uint32_t w = tap.w1;
+            line[x * 3]      = (uint16_t)((a >> 11) * (WEIGHT_ONE - w) + (b >> 11) * w);
+            line[x * 3 + 1]  = (uint16_t)(((a >> 5) & 0x3F) * (WEIGHT_ONE - w) + ((b >> 5) & 0x3F) * w);
+            line[x * 3 + 2]  = (uint16_t)((a & 0x1F) * (WEIGHT_ONE - w) + (b & 0x1F) * w);
+        }
+    }
+
+    void blit_bilinear(const Image565_t& src, const Image565_t& dst, const Mapping_t& map)
+    {
+        const int32_t width = map.dstW;
+        _lines.resize((size_t)width * 3 * 2);
+        uint16_t* lines[2]   = {_lines.data(), _lines.data() + (size_t)width * 3};
+        int32_t line_rows[2] = {-1, -1};  // Source row held by each line
+
+        auto source_line = [&](int32_t sy) -> const uint16_t* {
+            for (int i = 0; i < 2; i++) {
+                if (line_rows[i] == sy) return lines[i];
+            }
+            // Replace the line that is not the other row in use
+            const int slot = line_rows[0] < line_rows[1] ? 0 : 1;
+            filter_row(src.data + (int64_t)(map.srcY + sy) * src.stride + map.srcX, lines[slot], width);
+            line_rows[slot] = sy;
+            return lines[slot];
+        };
+
+        constexpr uint32_t ROUND = 1u << (2 * WEIGHT_BITS - 1);
+        for (int32_t y = 0; y < map.dstH; y++) {
+            const Tap_t& tap    = _rows[y];
+            const uint16_t* top = source_line(tap.i0);
+            uint16_t* out       = dst.data + (int64_t)(map.dstY + y) * dst.stride + map.dstX;
+            if (tap.w1 == 0 || tap.i1 == tap.i0) {
+                for (int32_t x = 0; x < width; x++) {
+                    const uint32_t r = (top[x * 3] + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+                    const uint32_t g = (top[x * 3 + 1] + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+                    const uint32_t b = (top[x * 3 + 2] + WEIGHT_ONE / 2) >> WEIGHT_BITS;
+                    out[x]           = (uint16_t)((r << 11) | (g << 5) | b);
+                }
+                continue;
+            }
+            const uint16_t* bottom = source_line(tap.i1);
+            const uint32_t w1      = tap.w1;
+            const uint32_t w0      = WEIGHT_ONE - w1;
+            for (int32_t x = 0; x < width; x++) {
+                const uint32_t r = (top[x * 3] * w0 + bottom[x * 3] * w1 + ROUND) >> (2 * WEIGHT_BITS);
+                const uint32_t g = (top[x * 3 + 1] * w0 + bottom[x * 3 + 1] * w1 + ROUND) >> (2 * WEIGHT_BITS);
+                const uint32_t b = (top[x * 3 + 2] * w0 + bottom[x * 3 + 2] * w1 + ROUND) >> (2 * WEIGHT_BITS);
+                out[x]           = (uint16_t)((r << 11) | (g << 5) | b);
+            }
+        }
+    }
+
+    std::vector<Tap_t> _cols;
+    std::vector<Tap_t> _rows;
+    std::vector<uint16_t> _lines;
+};
@@ -0,0 +1,234 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Histogram of durations in microseconds with log-scaled buckets
+ *
+ * Values below 16 us get one bucket each, larger values 8 buckets per power of two, so a percentile is off by at
+ * most 1/8 of its value. min and max are exact.
+ */
+class LatencyHistogram {
+public:
+    struct Summary_t {
+        uint32_t count = 0;
+        uint32_t minUs = 0;
+        uint32_t p50Us = 0;
+        uint32_t p99Us = 0;
+        uint32_t maxUs = 0;
+    };
+
+    void add(uint64_t us)
+    {
+        const uint32_t value = (uint32_t)std::min<uint64_t>(us, MAX_US);
+        _buckets[bucket_of(value)]++;
+        _min = _count == 0 ? value : std::min(_min, value);
+        _max = std::max(_max, value);
+        _count++;
+    }
+
+    void reset()
+    {
+        *this = LatencyHistogram();
+    }
+
+    uint32_t count() const
+    {
+        return _count;
+    }
+
+    /**
+     * @brief Upper bound of the bucket holding the given fraction of the values (clamped to min / max)
+     *
+     * @param fraction 0.0 ~ 1.0
+     */
+    uint32_t percentile(float fraction) const
+    {
+        if (_count == 0) return 0;
+        const uint32_t rank = std::max<uint32_t>(1, (uint32_t)(fraction * _count + 0.5f));
+        uint32_t seen       = 0;
+        for (int i = 0; i < BUCKET_NUM; i++) {
+            seen += _buckets[i];
+            if (seen >= rank) return std::clamp(upper_of(i), _min, _max);
+        }
+        return _max;
+    }
+
+    Summary_t summary() const
+    {
+        Summary_t s;
+        s.count = _count;
+        s.minUs = _min;
+        s.p50Us = percentile(0.50f);
+        s.p99Us = percentile(0.99f);
+        s.maxUs = _max;
+        return s;
+    }
+
+private:
+    static constexpr int LINEAR_BITS = 4;                     // 0 ~ 15 us map 1:1
+    static constexpr int SUB_BITS    = 3;                     // 8 buckets per power of two above that
+    static constexpr int MAX_BITS    = 24;
+    static constexpr uint32_t MAX_US = (1u << MAX_BITS) - 1;  // ~16.7 s, longer values are clamped
+    static constexpr int BUCKET_NUM  = (1 << LINEAR_BITS) + (MAX_BITS - LINEAR_BITS) * (1 << SUB_BITS);
+
+    static int msb(uint32_t value)
+    {
+        int bit = 0;
+        while (value >>= 1) {
+            bit++;
+        }
+        return bit;
+    }
+    static int bucket_of(uint32_t value)
+    {
+        if (value < (1u << LINEAR_BITS)) return (int)value;
+        const int bit = msb(value);
+        const int sub = (int)(value >> (bit - SUB_BITS)) & ((1 << SUB_BITS) - 1);
+        return (1 << LINEAR_BITS) + (bit - LINEAR_BITS) * (1 << SUB_BITS) + sub;
+    }
+    static uint32_t upper_of(int bucket)
+    {
+        if (bucket < (1 << LINEAR_BITS)) return (uint32_t)bucket;
+        const int bit = (bucket - (1 << LINEAR_BITS)) / (1 << SUB_BITS) + LINEAR_BITS;
+        const int sub = (bucket - (1 << LINEAR_BITS)) % (1 << SUB_BITS);
+        return (1u << bit) + ((uint32_t)(sub + 1) << (bit - SUB_BITS)) - 1;
+    }
+
+    uint32_t _buckets[BUCKET_NUM] = {};
+    uint32_t _count               = 0;
+    uint32_t _min                 = 0;
+    uint32_t _max                 = 0;
+};
+
+/**
+ * @brief End-to-end latency of drawn input, split into the stages a touch sample passes on its way to the panel
+ *
+ * Each mark moves the oldest touch sample that has not reached the next stage yet, so one frame that carries many
+ * samples is measured from the earliest of them. Not thread safe: call every mark with the LVGL lock held (the app
+ * draws under the lock and the flush event runs inside lv_timer_handler()).
+ */
+class LatencyTrace {
+public:
+    enum Stage_t {
+        STAGE_INPUT = 0,   // Sample read -> picked up by the app (queueing in touchSamples)
+        STAGE_RASTER,      // Picked up -> ink rasterized
+        STAGE_INVALIDATE,  // Rasterized -> view composed and area invalidated (waits for the next refresh)
+        STAGE_FLUSH,       // Invalidated -> display flush of the frame finished (LVGL render + flush)
+        STAGE_TOTAL,       // Sample read -> display flush finished
+        STAGE_NUM,
+    };
+
+    struct Stats_t {
+        LatencyHistogram::Summary_t stages[STAGE_NUM];
+    };
+
+    /**
+     * @brief A touch sample was picked up from the queue
+     *
+     * @param acquiredUs micros() when the sample was read
+     * @param nowUs
+     */
+    void markSample(uint64_t acquiredUs, uint64_t nowUs)
+    {
+        _histograms[STAGE_INPUT].add(nowUs - std::min(nowUs, acquiredUs));
+        if (_sample.pending) return;
+        _sample = {true, acquiredUs, nowUs};
+    }
+
+    /**
+     * @brief Ink for the pending samples was written
+     *
+     */
+    void markRaster(uint64_t nowUs)
+    {
+        advance(_sample, _raster, STAGE_RASTER, nowUs);
+    }
+
+    /**
+     * @brief The rasterized area was invalidated on screen
+     *
+     */
+    void markInvalidate(uint64_t nowUs)
+    {
+        advance(_raster, _invalidate, STAGE_INVALIDATE, nowUs);
+    }
+
+    /**
+     * @brief The last area of a frame was flushed to the display
+     *
+     */
+    void markFlush(uint64_t nowUs)
+    {
+        if (!_invalidate.pending) return;
+        _histograms[STAGE_FLUSH].add(nowUs - _invalidate.stageUs);
+        _histograms[STAGE_TOTAL].add(nowUs - std::min(nowUs, _invalidate.acquiredUs));
+        _invalidate.pending = false;
+    }
+
+    /**
+     * @brief Drop samples in flight (e.g. when the input is not drawn)
+     *
+     */
+    void cancel()
+    {
+        _sample.pending     = false;
+        _raster.pending     = false;
+        _invalidate.pending = false;
+    }
+
+    void reset()
+    {
+        cancel();
+        for (auto& histogram : _histograms) {
+            histogram.reset();
+        }
+    }
+
+    uint32_t count() const
+    {
+        return _histograms[STAGE_TOTAL].count();
+    }
+
+    Stats_t getStats() const
+    {
+        Stats_t stats;
+        for (int i = 0; i < STAGE_NUM; i++) {
+            stats.stages[i] = _histograms[i].summary();
+        }
+        return stats;
+    }
+
+    static const char* stageName(int stage)
+    {
+        static const char* names[STAGE_NUM] = {"input", "raster", "invalidate", "flush", "total"};
+        return stage >= 0 && stage < STAGE_NUM ? names[stage] : "";
+    }
+
+private:
+    struct Pending_t {
+        bool pending        = false;
+        uint64_t acquiredUs = 0;  // Oldest touch sample in this stage
+        uint64_t stageUs    = 0;  // When it entered this stage
+    };
+
+    void advance(Pending_t& from, Pending_t& to, Stage_t stage, uint64_t nowUs)
+    {
+        if (!from.pending) return;
+        _histograms[stage].add(nowUs - std::min(nowUs, from.stageUs));
+        // Samples already waiting in the next stage are older, keep their origin
+        if (!to.pending) to = {true, from.acquiredUs, nowUs};
+        from.pending = false;
+    }
+
+    Pending_t _sample;
+    Pending_t _raster;
+    Pending_t _invalidate;
+    LatencyHistogram _histograms[STAGE_NUM];
+};
@@ -0,0 +1,116 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring buffer
+ *
+ * push() must only be called from one producer thread and pop() / drain() / clear() from one consumer thread.
+ * When the ring is full new items are dropped (the producer never touches the read index) and counted.
+ *
+ * @tparam T trivially copyable item
+ * @tparam Capacity power of two
+ */
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    /**
+     * @brief Producer side
+     *
+     * @param item
+     * @return true pushed
+     * @return false ring is full, item dropped
+     */
+    bool push(const T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & MASK] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side
+     *
+     * @param item
+     * @return true popped
+     * @return false ring is empty
+     */
+    bool pop(T& item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = _items[tail & MASK];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side, hand out up to maxNum items in order and release them in one go
+     *
+     * @param fn void(const T&)
+     * @param maxNum
+     * @return size_t number of items handed out
+     */
+    template <typename Fn>
+    size_t drain(Fn&& fn, size_t maxNum = Capacity)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t num  = std::min(_head.load(std::memory_order_acquire) - tail, maxNum);
+        for (size_t i = 0; i < num; i++) {
+            fn(_items[(tail + i) & MASK]);
+        }
+        _tail.store(tail + num, std::memory_order_release);
+        return num;
+    }
+
+    /**
+     * @brief Consumer side, discard everything pushed so far
+     *
+     */
+    void clear()
+    {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+    size_t size() const
+    {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    uint32_t dropped() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    // Keep the indices on separate cache lines so producer and consumer do not false-share
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<size_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+    T _items[Capacity];
+};
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Lock-free exchange of three buffers between one producer and one consumer
+ *
+ * The producer owns the back buffer and writes a whole frame into it, then publish() swaps it with the ready
+ * buffer. The consumer owns the front buffer and acquire() swaps in the ready buffer if a new frame was published
+ * since the last acquire(). Each side only ever touches the buffer it owns, so a frame is never written while it is
+ * read. Only buffer indices (0 ~ 2) are exchanged; the buffers themselves live with the caller.
+ *
+ * publish() must only be called from one producer thread and acquire() from one consumer thread.
+ */
+class TripleBuffer {
+public:
+    struct Stats_t {
+        uint32_t published  = 0;  // Frames the producer finished
+        uint32_t displayed  = 0;  // Frames the consumer swapped in
+        uint32_t dropped    = 0;  // Frames replaced by a newer one before the consumer saw them
+        uint32_t duplicated = 0;  // Consumer updates without a new frame (the last frame is shown again)
+    };
+
+    /**
+     * @brief Producer side, index of the buffer to write the next frame into
+     *
+     */
+    int back() const
+    {
+        return _back;
+    }
+
+    /**
+     * @brief Producer side, hand the back buffer over as the newest frame and take the old ready buffer
+     *
+     * @return false if the frame it replaced had not been acquired (dropped)
+     */
+    bool publish()
+    {
+        const uint8_t old = _ready.exchange((uint8_t)(_back | FRESH), std::memory_order_acq_rel);
+        _back             = old & INDEX_MASK;
+        _published.fetch_add(1, std::memory_order_relaxed);
+        if (old & FRESH) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Consumer side, index of the buffer being displayed
+     *
+     */
+    int front() const
+    {
+        return _front;
+    }
+
+    /**
+     * @brief Consumer side, swap in the newest frame if there is one
+     *
+     * @return true front() changed
+     */
+    bool acquire()
+    {
+        if (!(_ready.load(std::memory_order_acquire) & FRESH)) {
+            _duplicated.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        const uint8_t old = _ready.exchange((uint8_t)_front, std::memory_order_acq_rel);
+        _front            = old & INDEX_MASK;
+        _displayed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Consumer side, drop a published frame without showing it (e.g. a stale frame of an earlier session)
+     *
+     */
+    void discard()
+    {
+        _ready.fetch_and((uint8_t)~FRESH, std::memory_order_acq_rel);
+    }
+
+    void resetStats()
+    {
+        _published.store(0, std::memory_order_relaxed);
+        _displayed.store(0, std::memory_order_relaxed);
+        _dropped.store(0, std::memory_order_relaxed);
+        _duplicated.store(0, std::memory_order_relaxed);
+    }
+
+    Stats_t getStats() const
+    {
+        Stats_t stats;
+        stats.published  = _published.load(std::memory_order_relaxed);
+        stats.displayed  = _displayed.load(std::memory_order_relaxed);
+        stats.dropped    = _dropped.load(std::memory_order_relaxed);
+        stats.duplicated = _duplicated.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t FRESH      = 0x04;  // Ready buffer holds a frame not acquired yet
+
+    int _back  = 0;  // Producer only
+    int _front = 1;  // Consumer only
+    alignas(64) std::atomic<uint8_t> _ready{2};
+    std::atomic<uint32_t> _published{0};
+    std::atomic<uint32_t> _displayed{0};
+    std::atomic<uint32_t> _dropped{0};
+    std::atomic<uint32_t> _duplicated{0};
+};
@@ -0,0 +1,315 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "../hal_desktop.h"
+#include "../utils/camera_source/camera_source.h"
+#include <mooncake_log.h>
+#include <lvgl.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Same frame the Tab5 camera task hands to the preview canvas
+#define CAMERA_WIDTH  1280
+#define CAMERA_HEIGHT 720
+
+static const std::string _tag = "camera";
+
+static lv_obj_t* camera_canvas;
+
+// Preview frames: the thread writes the back buffer, the canvas shows the front buffer (see TripleBuffer).
+// Kept after the thread exits so the canvas never points at freed memory.
+static uint16_t* img_show[3] = {};
+static TripleBuffer camera_frames;
+
+// Frame buffers that neither the preview nor the app uses; takeCameraFrame() refills the preview from here
+static std::vector<uint16_t*> camera_frame_pool;
+static std::mutex camera_pool_mutex;
+static std::atomic<bool> camera_preview_active{false};
+static bool camera_refr_hooked = false;
+
+// Task control, same values as the Tab5 camera task queue
+#define TASK_CONTROL_PAUSE  0
+#define TASK_CONTROL_RESUME 1
+#define TASK_CONTROL_EXIT   2
+struct CameraControl_t {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<int> queue;
+};
+static CameraControl_t camera_ctrl;
+
+// State the caller asked for (pause / resume run in the thread in queue order), guarded by camera_mutex
+static hal::HalBase::CameraState_t camera_state = hal::HalBase::CAMERA_OFF;
+static bool camera_thread_running               = false;
+static std::condition_variable camera_thread_exit;
+static std::mutex camera_mutex;
+
+// Start-to-first-frame latency (cold: source opened and thread started, warm: resumed from pause)
+static uint64_t camera_start_us = 0;
+static bool camera_start_cold   = false;
+static bool camera_first_frame  = false;  // Waiting for the first frame after this start
+static LatencyHistogram camera_cold_start;
+static LatencyHistogram camera_warm_start;
+
+// Always returns a black buffer: releaseCameraFrame() clears buffers on their way back to the pool (callers release
+// outside the LVGL lock), so taking one under the lock costs no pixel writes
+static uint16_t* acquire_frame_buffer()
+{
+    std::lock_guard<std::mutex> lock(camera_pool_mutex);
+    if (camera_frame_pool.empty()) {
+        return new uint16_t[CAMERA_WIDTH * CAMERA_HEIGHT]();
+    }
+    uint16_t* buffer = camera_frame_pool.back();
+    camera_frame_pool.pop_back();
+    return buffer;
+}
+
+static void send_camera_control(int control)
+{
+    {
+        std::lock_guard<std::mutex> lock(camera_ctrl.mutex);
+        camera_ctrl.queue.push_back(control);
+    }
+    camera_ctrl.cv.notify_one();
+}
+
+// Blocks until a control arrives if wait is set
+static bool receive_camera_control(int& control, bool wait)
+{
+    std::unique_lock<std::mutex> lock(camera_ctrl.mutex);
+    if (wait) {
+        camera_ctrl.cv.wait(lock, [] { return !camera_ctrl.queue.empty(); });
+    }
+    if (camera_ctrl.queue.empty()) return false;
+    control = camera_ctrl.queue.front();
+    camera_ctrl.queue.pop_front();
+    return true;
+}
+
+// Runs on the LVGL thread at the start of every refresh, so the canvas only changes buffer between two renders
+static void camera_refr_start_cb(lv_event_t* e)
+{
+    if (!camera_preview_active.load(std::memory_order_relaxed) || !camera_canvas) return;
+    if (camera_frames.acquire()) {
+        lv_canvas_set_buffer(camera_canvas, img_show[camera_frames.front()], CAMERA_WIDTH, CAMERA_HEIGHT,
+                             LV_COLOR_FORMAT_RGB565);
+    }
+}
+
+static void log_preview_stats()
+{
+    const auto stats = camera_frames.getStats();
+    mclog::tagInfo(_tag, "preview frames: published {}, displayed {}, dropped {}, duplicated {}", stats.published,
+                   stats.displayed, stats.dropped, stats.duplicated);
+}
+
+// Stand-in for app_camera_display() on Tab5: lives from the first start until powerOffCamera(). A frame is written
+// into the back buffer and published, the LVGL refresh swaps it into the canvas. While paused the thread only waits
+// on the control queue, so a resume does not open the source or start a thread again.
+static void app_camera_display(HalDesktop* hal, std::unique_ptr<CameraSource> source, int fps)
+{
+    using clock       = std::chrono::steady_clock;
+    const auto period = std::chrono::microseconds(1000000 / fps);
+    auto next_frame   = clock::now();
+    auto stream_start = clock::now();
+    clock::duration streamed{0};
+    uint32_t frames  = 0;
+    uint64_t read_us = 0;
+    bool streaming   = true;
+
+    while (true) {
+        int control = 0;
+        if (receive_camera_control(control, !streaming)) {
+            if (control == TASK_CONTROL_EXIT) {
+                break;
+            } else if (control == TASK_CONTROL_PAUSE && streaming) {
+                mclog::tagInfo(_tag, "task pause");
+                log_preview_stats();
+                streamed += clock::now() - stream_start;
+                streaming = false;
+            } else if (control == TASK_CONTROL_RESUME && !streaming) {
+                mclog::tagInfo(_tag, "task resume");
+                stream_start = next_frame = clock::now();
+                streaming    = true;
+            }
+            continue;
+        }
+
+        const uint64_t t0 = hal->micros();
+        if (!source->read(img_show[camera_frames.back()])) {
+            mclog::tagError(_tag, "failed to read camera frame");
+            break;
+        }
+        read_us += hal->micros() - t0;
+        frames++;
+        camera_frames.publish();
+
+        {
+            std::lock_guard<std::mutex> lock(camera_mutex);
+            if (camera_first_frame) {
+                const uint64_t us = hal->micros() - camera_start_us;
+                (camera_start_cold ? camera_cold_start : camera_warm_start).add(us);
+                camera_first_frame = false;
+                mclog::tagInfo(_tag, "first frame after {:.1f} ms ({} start)", us / 1000.0f,
+                               camera_start_cold ? "cold" : "warm");
+            }
+        }
+
+        // Keep the frame rate; a source slower than the period runs as fast as it can
+        next_frame += period;
+        const auto now = clock::now();
+        if (next_frame < now) next_frame = now;
+        std::this_thread::sleep_until(next_frame);
+    }
+
+    if (streaming) streamed += clock::now() - stream_start;
+    const float seconds = std::chrono::duration<float>(streamed).count();
+    mclog::tagInfo(_tag, "task exit: {} frames in {:.1f} s streaming ({:.1f} fps), read {:.2f} ms/frame", frames,
+                   seconds, seconds > 0.0f ? frames / seconds : 0.0f, frames > 0 ? read_us / 1000.0f / frames : 0.0f);
+
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    camera_state          = hal::HalBase::CAMERA_OFF;
+    camera_thread_running = false;
+    camera_thread_exit.notify_all();
+}
+
+void HalDesktop::startCameraCapture(lv_obj_t* imgCanvas)
+{
+    mclog::tagInfo(_tag, "start camera capture");
+
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    if (camera_state == CAMERA_STREAMING) return;
+
+    // Cold start: open the source, a paused thread keeps its own
+    std::unique_ptr<CameraSource> source;
+    if (camera_state == CAMERA_OFF) {
+        source = CameraSource::open(_camera_source, CAMERA_WIDTH, CAMERA_HEIGHT);
+        if (!source) {
+            mclog::tagError(_tag, "no camera source: {}", _camera_source);
+            return;
+        }
+        mclog::tagInfo(_tag, "camera source: {} at {} fps", source->describe(), _camera_fps);
+    }
+
+    // Called with the LVGL lock held: show the front buffer until the first new frame arrives
+    camera_canvas = imgCanvas;
+    for (auto& buffer : img_show) {
+        if (!buffer) buffer = acquire_frame_buffer();
+    }
+    camera_frames.discard();
+    camera_frames.resetStats();
+    lv_canvas_set_buffer(camera_canvas, img_show[camera_frames.front()], CAMERA_WIDTH, CAMERA_HEIGHT,
+                         LV_COLOR_FORMAT_RGB565);
+    if (!camera_refr_hooked) {
+        lv_display_add_event_cb(lv_obj_get_display(camera_canvas), camera_refr_start_cb, LV_EVENT_REFR_START, nullptr);
+        camera_refr_hooked = true;
+    }
+    camera_preview_active = true;
+
+    camera_start_us    = micros();
+    camera_start_cold  = camera_state == CAMERA_OFF;
+    camera_first_frame = true;
+    if (source) {
+        {
+            std::lock_guard<std::mutex> ctrl_lock(camera_ctrl.mutex);
+            camera_ctrl.queue.clear();
+        }
+        // Not joined: powerOffCamera() waits for camera_thread_exit instead, and a paused thread may be left
+        // blocked when the program exits
+        camera_thread_running = true;
+        std::thread(app_camera_display, this, std::move(source), std::max(1, _camera_fps)).detach();
+    } else {
+        send_camera_control(TASK_CONTROL_RESUME);
+    }
+    camera_state = CAMERA_STREAMING;
+}
+
+void HalDesktop::stopCameraCapture()
+{
+    mclog::tagInfo(_tag, "stop camera capture");
+
+    // The canvas keeps the last frame it swapped in; frames published after this are not shown
+    camera_preview_active = false;
+
+    // Only pause, the thread and the source are kept until powerOffCamera()
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    if (camera_state != CAMERA_STREAMING) return;
+    send_camera_control(TASK_CONTROL_PAUSE);
+    camera_state = CAMERA_PAUSED;
+}
+
+void HalDesktop::powerOffCamera()
+{
+    camera_preview_active = false;
+
+    std::unique_lock<std::mutex> lock(camera_mutex);
+    if (camera_state == CAMERA_OFF && !camera_thread_running) return;
+    mclog::tagInfo(_tag, "power off camera");
+    send_camera_control(TASK_CONTROL_EXIT);
+
+    // The thread does not need the LVGL lock to exit, so this may wait with it held
+    if (!camera_thread_exit.wait_for(lock, std::chrono::seconds(2), [] { return !camera_thread_running; })) {
+        mclog::tagError(_tag, "camera thread did not exit");
+    }
+}
+
+bool HalDesktop::isCameraCapturing()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    return camera_state == CAMERA_STREAMING;
+}
+
+hal::HalBase::CameraState_t HalDesktop::getCameraState()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    return camera_state;
+}
+
+hal::HalBase::CameraStartStats_t HalDesktop::getCameraStartStats()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    CameraStartStats_t stats;
+    stats.cold = camera_cold_start.summary();
+    stats.warm = camera_warm_start.summary();
+    return stats;
+}
+
+TripleBuffer::Stats_t HalDesktop::getCameraFrameStats()
+{
+    return camera_frames.getStats();
+}
+
+bool HalDesktop::takeCameraFrame(CameraFrame_t& frame)
+{
+    // The front buffer belongs to the LVGL side (the caller holds the lock), so it can be swapped for a pool buffer
+    // while the thread keeps writing the other two. The taken buffer now belongs to the app (and goes back to the pool
+    // when released), so the canvas switches to the black replacement right away until the next frame is swapped in.
+    if (!camera_canvas || camera_frames.getStats().displayed == 0) return false;
+
+    const int index = camera_frames.front();
+    frame.data      = img_show[index];
+    frame.width     = CAMERA_WIDTH;
+    frame.height    = CAMERA_HEIGHT;
+    frame.stride    = CAMERA_WIDTH;
+    img_show[index] = acquire_frame_buffer();
+    lv_canvas_set_buffer(camera_canvas, img_show[index], CAMERA_WIDTH, CAMERA_HEIGHT, LV_COLOR_FORMAT_RGB565);
+    return true;
+}
+
+void HalDesktop::releaseCameraFrame(const CameraFrame_t& frame)
+{
+    if (!frame.data) return;
+
+    // The buffer still holds a photo the app used, which would flash on the canvas before the first new frame
+    std::fill(frame.data, frame.data + CAMERA_WIDTH * CAMERA_HEIGHT, 0);
+    std::lock_guard<std::mutex> lock(camera_pool_mutex);
+    camera_frame_pool.push_back(frame.data);
+}
@@ -14,7 +14,8 @@
 // https://github.com/lvgl/lv_port_pc_vscode/blob/master/main/src/main.c
 
 static const std::string _tag = "lvgl";
-static std::mutex _lvgl_mutex;
+// Recursive: app code running inside lv_timer_handler() (event callbacks) also takes LvglLockGuard
+static std::recursive_mutex _lvgl_mutex;
 
 void HalDesktop::lvgl_init()
 {
@@ -26,10 +27,12 @@ void HalDesktop::lvgl_init()
 
     auto display = lv_sdl_window_create(HAL_SCREEN_WIDTH, HAL_SCREEN_HEIGHT);
     lv_display_set_default(display);
+    hookLatencyFlush(display);
 
     lvTouchpad = lv_sdl_mouse_create();
     lv_indev_set_group(lvTouchpad, lv_group_get_default());
     lv_indev_set_display(lvTouchpad, display);
+    touch_init();
 
     // // LV_IMAGE_DECLARE(mouse_cursor_icon); /*Declare the image file.*/
     // lv_obj_t* cursor_obj;
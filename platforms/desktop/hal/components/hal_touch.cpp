@@ -0,0 +1,209 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "../hal_desktop.h"
+#include <SDL2/SDL.h>
+#include <mooncake_log.h>
+#include <lvgl.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+static const std::string _tag = "touch";
+static std::atomic<bool> _touch_sampling{false};
+static constexpr float WHEEL_ZOOM_STEP = 1.25f;  // Zoom factor per wheel notch
+static constexpr uint32_t TRACE_INTERVAL_MS = 4;  // Sample rate of replayed traces (same as the Tab5 poll task)
+
+// The LVGL SDL mouse driver only keeps the last position per indev read. SDL calls event watchers for every event
+// as it is queued, so every intermediate motion event ends up in the ring buffer. Events are pumped by a single
+// thread (the LVGL timer thread), which is the single producer of the ring.
+static int sdl_mouse_event_watch(void* userdata, SDL_Event* event)
+{
+    if (!_touch_sampling.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+
+    // Wheel zooms around the cursor, right-button drag pans (stand-ins for pinch and two-finger drag)
+    auto hal = static_cast<HalDesktop*>(userdata);
+    hal::HalBase::ViewGesture_t gesture;
+    switch (event->type) {
+        case SDL_MOUSEWHEEL:
+            if (event->wheel.y == 0) return 0;
+            SDL_GetMouseState(&gesture.x, &gesture.y);
+            gesture.zoom = std::pow(WHEEL_ZOOM_STEP, (float)event->wheel.y);
+            hal->viewGestures.push(gesture);
+            return 0;
+        case SDL_MOUSEMOTION:
+            if (!(event->motion.state & SDL_BUTTON_RMASK)) break;
+            gesture.x    = event->motion.x;
+            gesture.y    = event->motion.y;
+            gesture.panX = (float)event->motion.xrel;
+            gesture.panY = (float)event->motion.yrel;
+            hal->viewGestures.push(gesture);
+            return 0;
+        default:
+            break;
+    }
+
+    hal::HalBase::TouchSample_t sample;
+    switch (event->type) {
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            if (event->button.button != SDL_BUTTON_LEFT) return 0;
+            sample.x       = event->button.x;
+            sample.y       = event->button.y;
+            sample.pressed = event->type == SDL_MOUSEBUTTONDOWN;
+            break;
+        case SDL_MOUSEMOTION:
+            if (!(event->motion.state & SDL_BUTTON_LMASK)) return 0;
+            sample.x       = event->motion.x;
+            sample.y       = event->motion.y;
+            sample.pressed = true;
+            break;
+        default:
+            return 0;
+    }
+
+    sample.timestampUs = hal->micros();
+    hal->touchSamples.push(sample);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                             Multi-touch traces                             */
+/* -------------------------------------------------------------------------- */
+// Stand-in for the Tab5 multi-touch controller. A trace file holds keyframes per finger, one per line:
+//   <time_ms> <id> <x> <y>   finger is down at (x, y) (the first keyframe of a finger presses it)
+//   <time_ms> <id> up        finger is released
+// Lines starting with '#' are comments. Between two keyframes of the same finger the position is interpolated at
+// TRACE_INTERVAL_MS, so a few keyframes become the same dense sample stream the touch controller produces.
+// The trace is replayed from the start every time touch sampling is enabled.
+struct TouchTrace_t {
+    std::vector<hal::HalBase::TouchSample_t> samples;  // timestampUs is relative to the start of the trace
+    size_t next      = 0;
+    uint64_t startUs = 0;
+    int fingers      = 0;
+};
+static TouchTrace_t _trace;
+static std::atomic<bool> _trace_restart{false};
+
+static bool load_touch_trace(const std::string& path, TouchTrace_t& trace)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+
+    constexpr int MAX_POINTS = hal::HalBase::MAX_TOUCH_POINTS;
+    hal::HalBase::TouchSample_t last[MAX_POINTS];  // Last keyframe of each finger
+    std::string line;
+    int line_num = 0;
+    while (std::getline(file, line)) {
+        line_num++;
+        std::istringstream fields(line);
+        uint32_t time_ms = 0;
+        int id           = 0;
+        if (line.empty() || line[0] == '#' || !(fields >> time_ms >> id)) continue;
+        if (id < 0 || id >= MAX_POINTS) {
+            mclog::tagWarn(_tag, "touch trace line {}: finger id {} out of range", line_num, id);
+            continue;
+        }
+
+        hal::HalBase::TouchSample_t key;
+        key.id          = id;
+        key.timestampUs = (uint64_t)time_ms * 1000;
+        std::string x_field;
+        fields >> x_field;
+        if (x_field == "up") {
+            if (!last[id].pressed) continue;
+            key.x = last[id].x;
+            key.y = last[id].y;
+        } else if (!(std::istringstream(x_field) >> key.x) || !(fields >> key.y)) {
+            mclog::tagWarn(_tag, "touch trace line {}: expected '<time_ms> <id> <x> <y>' or '<time_ms> <id> up'",
+                           line_num);
+            continue;
+        } else {
+            key.pressed = true;
+        }
+
+        // Fill the gap since the previous keyframe of a finger that stays down
+        if (last[id].pressed && key.timestampUs > last[id].timestampUs) {
+            const uint64_t span = key.timestampUs - last[id].timestampUs;
+            for (uint64_t t = TRACE_INTERVAL_MS * 1000; t < span; t += TRACE_INTERVAL_MS * 1000) {
+                const float f                      = (float)t / (float)span;
+                hal::HalBase::TouchSample_t sample = last[id];
+                sample.timestampUs += t;
+                sample.x = last[id].x + (int32_t)std::lround((key.x - last[id].x) * f);
+                sample.y = last[id].y + (int32_t)std::lround((key.y - last[id].y) * f);
+                trace.samples.push_back(sample);
+            }
+        }
+        trace.samples.push_back(key);
+        trace.fingers = std::max(trace.fingers, id + 1);
+        last[id]      = key;
+    }
+
+    // Keyframes of different fingers are listed in any order; release whatever is still down at the end
+    std::stable_sort(trace.samples.begin(), trace.samples.end(),
+                     [](const auto& a, const auto& b) { return a.timestampUs < b.timestampUs; });
+    for (const auto& finger : last) {
+        if (!finger.pressed) continue;
+        hal::HalBase::TouchSample_t release = finger;
+        release.pressed                     = false;
+        release.timestampUs                 = trace.samples.back().timestampUs;
+        trace.samples.push_back(release);
+    }
+    return true;
+}
+
+// Runs on the LVGL timer thread, which also pumps the SDL events, so the ring keeps a single producer
+static void touch_trace_timer_cb(lv_timer_t* timer)
+{
+    auto hal = static_cast<HalDesktop*>(lv_timer_get_user_data(timer));
+    if (_trace_restart.exchange(false)) {
+        _trace.next    = 0;
+        _trace.startUs = hal->micros();
+    }
+    if (!_touch_sampling.load(std::memory_order_relaxed)) return;
+
+    const uint64_t elapsed = hal->micros() - _trace.startUs;
+    while (_trace.next < _trace.samples.size() && _trace.samples[_trace.next].timestampUs <= elapsed) {
+        hal::HalBase::TouchSample_t sample = _trace.samples[_trace.next++];
+        sample.timestampUs += _trace.startUs;
+        hal->touchSamples.push(sample);
+    }
+}
+
+void HalDesktop::touch_init()
+{
+    mclog::tagInfo(_tag, "touch init");
+    SDL_AddEventWatch(sdl_mouse_event_watch, this);
+
+    if (_touch_trace_path.empty()) return;
+    if (!load_touch_trace(_touch_trace_path, _trace) || _trace.samples.empty()) {
+        mclog::tagError(_tag, "failed to load touch trace: {}", _touch_trace_path);
+        _trace = TouchTrace_t();
+        return;
+    }
+    mclog::tagInfo(_tag, "touch trace: {}, {} fingers, {} samples over {} ms", _touch_trace_path, _trace.fingers,
+                   _trace.samples.size(), _trace.samples.back().timestampUs / 1000);
+    _trace.next = _trace.samples.size();
+    lv_timer_create(touch_trace_timer_cb, TRACE_INTERVAL_MS, this);
+}
+
+bool HalDesktop::setTouchSampling(bool enable)
+{
+    _touch_sampling.store(enable, std::memory_order_relaxed);
+    _trace_restart.store(enable);
+    mclog::tagInfo(_tag, "touch sampling: {}", enable);
+    return true;
+}
+
+int HalDesktop::getMaxTouchPoints()
+{
+    // The mouse is a single pointer; a trace can drive several fingers
+    return _trace.fingers > 1 ? hal::HalBase::MAX_TOUCH_POINTS : 1;
+}
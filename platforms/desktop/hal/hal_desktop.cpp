@@ -31,6 +31,14 @@ uint32_t HalDesktop::millis()
     return SDL_GetTicks();
 }
 
+uint64_t HalDesktop::micros()
+{
+    // Split to avoid overflowing the multiplication on high resolution counters
+    uint64_t counter   = SDL_GetPerformanceCounter();
+    uint64_t frequency = SDL_GetPerformanceFrequency();
+    return counter / frequency * 1000000 + counter % frequency * 1000000 / frequency;
+}
+
 int HalDesktop::getCpuTemp()
 {
     static std::random_device rd;
@@ -157,6 +165,13 @@ std::vector<hal::HalBase::FileEntry_t> HalDesktop::scanSdCard(const std::string&
     return file_entries;
 }
 
+std::string HalDesktop::getScratchDir()
+{
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::temp_directory_path(error);
+    return error ? "" : path.string();
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                  Interface                                 */
 /* -------------------------------------------------------------------------- */
@@ -8,6 +8,17 @@
 
 class HalDesktop : public hal::HalBase {
 public:
+    /**
+     * @param touchTracePath Multi-touch trace to replay into touchSamples (empty to use the mouse only)
+     * @param cameraSource Frames for the camera stand-in: "pattern" (or empty) for a test pattern, a directory of
+     * frames or a single frame / video file (see CameraSource::open())
+     * @param cameraFps Frame rate of the camera stand-in
+     */
+    explicit HalDesktop(std::string touchTracePath = "", std::string cameraSource = "", int cameraFps = 30)
+        : _touch_trace_path(std::move(touchTracePath)), _camera_source(std::move(cameraSource)), _camera_fps(cameraFps)
+    {
+    }
+
     std::string type() override
     {
         return "Desktop";
@@ -17,6 +28,7 @@ public:
 
     void delay(uint32_t ms) override;
     uint32_t millis() override;
+    uint64_t micros() override;
     int getCpuTemp() override;
 
     void setDisplayBrightness(uint8_t brightness) override;
@@ -25,6 +37,9 @@ public:
     void lvglLock() override;
     void lvglUnlock() override;
 
+    bool setTouchSampling(bool enable) override;
+    int getMaxTouchPoints() override;
+
     void setSpeakerVolume(uint8_t volume) override;
     uint8_t getSpeakerVolume() override;
     void audioPlay(std::vector<int16_t>& data, bool async = true) override;
@@ -54,6 +69,17 @@ public:
 
     bool isSdCardMounted() override;
     std::vector<FileEntry_t> scanSdCard(const std::string& dirPath) override;
+    std::string getScratchDir() override;
+
+    void startCameraCapture(lv_obj_t* imgCanvas) override;
+    void stopCameraCapture() override;
+    bool isCameraCapturing() override;
+    void powerOffCamera() override;
+    CameraState_t getCameraState() override;
+    CameraStartStats_t getCameraStartStats() override;
+    TripleBuffer::Stats_t getCameraFrameStats() override;
+    bool takeCameraFrame(CameraFrame_t& frame) override;
+    void releaseCameraFrame(const CameraFrame_t& frame) override;
 
     bool usbCDetect() override;
     bool usbADetect() override;
@@ -70,6 +96,10 @@ private:
     bool _ext_5v_enable             = true;
     bool _usba_5v_enable            = true;
     bool _ext_antenna_enable        = false;
+    std::string _touch_trace_path;
+    std::string _camera_source;
+    int _camera_fps = 30;
 
     void lvgl_init();
+    void touch_init();
 };
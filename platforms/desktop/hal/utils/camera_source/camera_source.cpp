@@ -0,0 +1,341 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "camera_source.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+static const std::string _tag = "camera";
+
+static inline uint16_t rgb_to_565(int r, int g, int b)
+{
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+static inline int clamp_u8(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// BT.601 limited range, 8-bit fixed point
+static inline uint16_t yuv_to_565(int y, int u, int v)
+{
+    const int c = (y - 16) * 298;
+    const int d = u - 128;
+    const int e = v - 128;
+    return rgb_to_565(clamp_u8((c + 409 * e + 128) >> 8), clamp_u8((c - 100 * d - 208 * e + 128) >> 8),
+                      clamp_u8((c + 516 * d + 128) >> 8));
+}
+
+void camera_place_image(ImageScaler& scaler, const CameraImage_t& image, uint16_t* out, int width, int height)
+{
+    // Same path as HalBase::scaleImage(), a frame of the camera size is copied as is
+    const ImageScaler::Image565_t src = {const_cast<uint16_t*>(image.pixels.data()), image.width, image.height,
+                                         image.width};
+    scaler.scale(src, {out, width, height, width}, ImageScaler::POLICY_FIT, ImageScaler::FILTER_BILINEAR, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                Test pattern                                */
+/* -------------------------------------------------------------------------- */
+// Color bars over a gray ramp, with a box that sweeps across the frame so dropped or repeated frames are visible
+class PatternSource : public CameraSource {
+public:
+    PatternSource(int width, int height) : CameraSource(width, height)
+    {
+    }
+
+    bool read(uint16_t* out) override
+    {
+        static const uint16_t bars[] = {
+            rgb_to_565(192, 192, 192), rgb_to_565(192, 192, 0), rgb_to_565(0, 192, 192), rgb_to_565(0, 192, 0),
+            rgb_to_565(192, 0, 192),   rgb_to_565(192, 0, 0),   rgb_to_565(0, 0, 192),   rgb_to_565(16, 16, 16),
+        };
+        constexpr int BAR_NUM = sizeof(bars) / sizeof(bars[0]);
+
+        const int bar_h = _height * 2 / 3;
+        for (int y = 0; y < _height; y++) {
+            uint16_t* row = out + (size_t)y * _width;
+            if (y < bar_h) {
+                for (int x = 0; x < _width; x++) {
+                    row[x] = bars[x * BAR_NUM / _width];
+                }
+            } else {
+                for (int x = 0; x < _width; x++) {
+                    const int level = x * 255 / (_width - 1);
+                    row[x]          = rgb_to_565(level, level, level);
+                }
+            }
+        }
+
+        // One sweep every 4 s at 30 fps
+        const int box    = _height / 6;
+        const int period = 120;
+        const int phase  = (int)(_frame % period);
+        const int box_x  = (_width - box) * (phase < period / 2 ? phase : period - phase) / (period / 2);
+        const int box_y  = (bar_h - box) / 2;
+        for (int y = box_y; y < box_y + box; y++) {
+            std::fill(out + (size_t)y * _width + box_x, out + (size_t)y * _width + box_x + box, 0xFFFF);
+        }
+        _frame++;
+        return true;
+    }
+
+    std::string describe() const override
+    {
+        return "test pattern";
+    }
+
+private:
+    uint64_t _frame = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+/*                                 File frames                                */
+/* -------------------------------------------------------------------------- */
+static bool skip_ppm_space(std::istream& in)
+{
+    int c = in.peek();
+    while (c == '#' || std::isspace(c)) {
+        if (c == '#') {
+            std::string comment;
+            std::getline(in, comment);
+        } else {
+            in.get();
+        }
+        c = in.peek();
+    }
+    return (bool)in;
+}
+
+static bool load_ppm(const std::string& path, CameraImage_t& image)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::string magic;
+    int maxval = 0;
+    if (!(in >> magic) || magic != "P6") return false;
+    if (!skip_ppm_space(in) || !(in >> image.width) || !skip_ppm_space(in) || !(in >> image.height) ||
+        !skip_ppm_space(in) || !(in >> maxval)) {
+        return false;
+    }
+    if (image.width <= 0 || image.height <= 0 || maxval <= 0 || maxval > 255) return false;
+    in.get();
+
+    std::vector<uint8_t> rgb((size_t)image.width * image.height * 3);
+    if (!in.read((char*)rgb.data(), rgb.size())) return false;
+    image.pixels.resize((size_t)image.width * image.height);
+    for (size_t i = 0; i < image.pixels.size(); i++) {
+        image.pixels[i] =
+            rgb_to_565(rgb[i * 3] * 255 / maxval, rgb[i * 3 + 1] * 255 / maxval, rgb[i * 3 + 2] * 255 / maxval);
+    }
+    return true;
+}
+
+static bool load_rgb565(const std::string& path, int width, int height, CameraImage_t& image)
+{
+    // "<name>_<w>x<h>.rgb565" overrides the size
+    const std::string stem = std::filesystem::path(path).stem().string();
+    const size_t sep       = stem.rfind('_');
+    int w                  = 0;
+    int h                  = 0;
+    if (sep != std::string::npos && std::sscanf(stem.c_str() + sep + 1, "%dx%d", &w, &h) == 2 && w > 0 && h > 0) {
+        width  = w;
+        height = h;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    image.width  = width;
+    image.height = height;
+    image.pixels.resize((size_t)width * height);
+    return (bool)in.read((char*)image.pixels.data(), image.pixels.size() * sizeof(uint16_t));
+}
+
+// YUV4MPEG2 stream, read one frame at a time
+class Y4mReader {
+public:
+    bool open(const std::string& path)
+    {
+        _in.open(path, std::ios::binary);
+        std::string header;
+        if (!std::getline(_in, header) || header.rfind("YUV4MPEG2", 0) != 0) return false;
+
+        std::istringstream fields(header.substr(9));
+        std::string field;
+        std::string chroma = "420";
+        while (fields >> field) {
+            if (field[0] == 'W') _width = std::atoi(field.c_str() + 1);
+            if (field[0] == 'H') _height = std::atoi(field.c_str() + 1);
+            if (field[0] == 'C') chroma = field.substr(1);
+        }
+        if (_width <= 0 || _height <= 0) return false;
+
+        if (chroma.rfind("420", 0) == 0) {
+            _shift_x = _shift_y = 1;
+        } else if (chroma == "422") {
+            _shift_x = 1;
+        } else if (chroma == "mono") {
+            _mono = true;
+        } else if (chroma != "444") {
+            mclog::tagError(_tag, "{}: unsupported y4m chroma {}", path, chroma);
+            return false;
+        }
+        _data_start = _in.tellg();
+        return true;
+    }
+
+    bool read(CameraImage_t& image)
+    {
+        std::string frame;
+        if (!std::getline(_in, frame) || frame.rfind("FRAME", 0) != 0) {
+            // End of the stream, start over
+            _in.clear();
+            _in.seekg(_data_start);
+            if (!std::getline(_in, frame) || frame.rfind("FRAME", 0) != 0) return false;
+        }
+
+        const int chroma_w = (_width + (1 << _shift_x) - 1) >> _shift_x;
+        const int chroma_h = (_height + (1 << _shift_y) - 1) >> _shift_y;
+        _plane.resize((size_t)_width * _height + (_mono ? 0 : (size_t)chroma_w * chroma_h * 2));
+        if (!_in.read((char*)_plane.data(), _plane.size())) return false;
+
+        image.width  = _width;
+        image.height = _height;
+        image.pixels.resize((size_t)_width * _height);
+        const uint8_t* y_plane = _plane.data();
+        const uint8_t* u_plane = y_plane + (size_t)_width * _height;
+        const uint8_t* v_plane = u_plane + (size_t)chroma_w * chroma_h;
+        for (int y = 0; y < _height; y++) {
+            const uint8_t* y_row = y_plane + (size_t)y * _width;
+            const uint8_t* u_row = u_plane + (size_t)(y >> _shift_y) * chroma_w;
+            const uint8_t* v_row = v_plane + (size_t)(y >> _shift_y) * chroma_w;
+            uint16_t* out        = image.pixels.data() + (size_t)y * _width;
+            for (int x = 0; x < _width; x++) {
+                out[x] = _mono ? yuv_to_565(y_row[x], 128, 128)
+                               : yuv_to_565(y_row[x], u_row[x >> _shift_x], v_row[x >> _shift_x]);
+            }
+        }
+        return true;
+    }
+
+    bool atEnd()
+    {
+        return _in.peek() == std::char_traits<char>::eof();
+    }
+
+private:
+    std::ifstream _in;
+    std::streampos _data_start;
+    int _width   = 0;
+    int _height  = 0;
+    int _shift_x = 0;  // Chroma subsampling
+    int _shift_y = 0;
+    bool _mono   = false;
+    std::vector<uint8_t> _plane;
+};
+
+static std::string lower_extension(const std::filesystem::path& path)
+{
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+static bool is_frame_file(const std::filesystem::path& path)
+{
+    const std::string ext = lower_extension(path);
+    return ext == ".ppm" || ext == ".rgb565" || ext == ".raw" || ext == ".y4m";
+}
+
+// Plays the files in order: an image is one frame, a y4m file all of its frames
+class FileSource : public CameraSource {
+public:
+    FileSource(std::vector<std::string> files, int width, int height)
+        : CameraSource(width, height), _files(std::move(files))
+    {
+    }
+
+    bool read(uint16_t* out) override
+    {
+        // Skip files that fail to load, but give up after one full round
+        for (size_t tries = 0; tries < _files.size(); tries++) {
+            if (read_current()) {
+                camera_place_image(_scaler, _image, out, _width, _height);
+                return true;
+            }
+            mclog::tagWarn(_tag, "failed to read frame from {}", _files[_index]);
+            next_file();
+        }
+        return false;
+    }
+
+    std::string describe() const override
+    {
+        return std::to_string(_files.size()) + " file(s) from " +
+               std::filesystem::path(_files.front()).parent_path().string();
+    }
+
+private:
+    std::vector<std::string> _files;
+    size_t _index = 0;
+    std::unique_ptr<Y4mReader> _video;  // Open while the current file is a y4m file
+    CameraImage_t _image;
+    ImageScaler _scaler;
+
+    void next_file()
+    {
+        _video.reset();
+        _index = (_index + 1) % _files.size();
+    }
+
+    bool read_current()
+    {
+        const std::string& path = _files[_index];
+        const std::string ext   = lower_extension(path);
+        if (ext != ".y4m") {
+            bool ok = ext == ".ppm" ? load_ppm(path, _image) : load_rgb565(path, _width, _height, _image);
+            next_file();
+            return ok;
+        }
+
+        if (!_video) {
+            _video = std::make_unique<Y4mReader>();
+            if (!_video->open(path)) return false;
+        }
+        if (!_video->read(_image)) return false;
+        // A y4m file among other files plays once and moves on, on its own it loops
+        if (_files.size() > 1 && _video->atEnd()) next_file();
+        return true;
+    }
+};
+
+std::unique_ptr<CameraSource> CameraSource::open(const std::string& spec, int width, int height)
+{
+    if (spec.empty() || spec == "pattern") {
+        return std::make_unique<PatternSource>(width, height);
+    }
+
+    std::error_code error;
+    std::vector<std::string> files;
+    if (std::filesystem::is_directory(spec, error)) {
+        for (const auto& entry : std::filesystem::directory_iterator(spec, error)) {
+            if (entry.is_regular_file() && is_frame_file(entry.path())) files.push_back(entry.path().string());
+        }
+        std::sort(files.begin(), files.end());
+    } else if (std::filesystem::is_regular_file(spec, error) && is_frame_file(spec)) {
+        files.push_back(spec);
+    }
+
+    if (files.empty()) {
+        mclog::tagError(_tag, "no camera frames in {}", spec);
+        return nullptr;
+    }
+    return std::make_unique<FileSource>(std::move(files), width, height);
+}
@@ -0,0 +1,67 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#pragma once
+#include <hal/utils/image_scale/image_scale.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Frame generator standing in for the Tab5 MIPI-CSI camera on desktop
+ *
+ * Frames come from a procedural test pattern or from files, and are handed out as RGB565 at the size the camera
+ * delivers on Tab5. Files that have another size are scaled to fit, with black bars.
+ */
+class CameraSource {
+public:
+    virtual ~CameraSource() = default;
+
+    /**
+     * @brief Open a source
+     *
+     * @param spec "pattern" (or empty) for the test pattern, a directory of frames, or a single frame / video file.
+     * Supported files: binary PPM (.ppm), raw little-endian RGB565 (.rgb565 / .raw, "<name>_<w>x<h>.rgb565" for
+     * sizes other than the camera size) and YUV4MPEG2 video (.y4m, 4:2:0 / 4:2:2 / 4:4:4 / mono). A directory is
+     * played in file name order.
+     * @return nullptr if nothing playable was found
+     */
+    static std::unique_ptr<CameraSource> open(const std::string& spec, int width, int height);
+
+    /**
+     * @brief Write the next frame (loops back to the first frame at the end)
+     *
+     * @param out width x height pixels, rows packed
+     * @return false if the frame could not be read
+     */
+    virtual bool read(uint16_t* out) = 0;
+
+    virtual std::string describe() const = 0;
+
+protected:
+    CameraSource(int width, int height) : _width(width), _height(height)
+    {
+    }
+
+    int _width  = 0;
+    int _height = 0;
+};
+
+/**
+ * @brief Decoded frame of a file source
+ *
+ */
+struct CameraImage_t {
+    int width  = 0;
+    int height = 0;
+    std::vector<uint16_t> pixels;  // RGB565, rows packed
+};
+
+/**
+ * @brief Scale an image to fit a black frame of another size (aspect kept, bilinear)
+ *
+ */
+void camera_place_image(ImageScaler& scaler, const CameraImage_t& image, uint16_t* out, int width, int height);
@@ -7,15 +7,40 @@
 #include <app.h>
 #include <memory>
 #include <hal/hal.h>
+#include <apps/app_drawing_camera/drawing_benchmark.h>
+#include <cstdlib>
+#include <string>
 
-int main()
+int main(int argc, char* argv[])
 {
+    // 基准测试模式：不启动 UI，直接运行绘图基准测试
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        drawing::run_benchmarks();
+        return 0;
+    }
+
+    // 多点触控模拟：--touch-trace <file> 回放触控轨迹文件
+    // 摄像头模拟：--camera <pattern|目录|文件> 图像来源，--camera-fps <n> 帧率
+    std::string touch_trace;
+    std::string camera_source;
+    int camera_fps = 30;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--touch-trace") {
+            touch_trace = argv[i + 1];
+        } else if (option == "--camera") {
+            camera_source = argv[i + 1];
+        } else if (option == "--camera-fps") {
+            camera_fps = std::atoi(argv[i + 1]);
+        }
+    }
+
     // 应用层初始化回调
     app::InitCallback_t callback;
 
-    callback.onHalInjection = []() {
+    callback.onHalInjection = [touch_trace, camera_source, camera_fps]() {
         // 注入桌面平台的硬件抽象
-        hal::Inject(std::make_unique<HalDesktop>());
+        hal::Inject(std::make_unique<HalDesktop>(touch_trace, camera_source, camera_fps));
     };
 
     // 启动应用层
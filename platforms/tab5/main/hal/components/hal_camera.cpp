@@ -27,21 +27,53 @@
 #include "esp_video_device.h"
 #include "driver/i2c_master.h"
 #include "driver/ppa.h"
+#include "esp_cache.h"
 #include "imlib.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <atomic>
+#include <mutex>
 
 #define CAMERA_WIDTH  1280
 #define CAMERA_HEIGHT 720
 
 static lv_obj_t* camera_canvas;
+
+// Preview frames: the task writes the back buffer, the canvas shows the front buffer (see TripleBuffer).
+// Allocated on the first capture and kept, so the canvas never points at freed memory.
+#define CAMERA_PREVIEW_BUFFER_COUNT 3
+static uint8_t* img_show_data[CAMERA_PREVIEW_BUFFER_COUNT] = {};
+static TripleBuffer camera_frames;
+
+// 预览和应用都没有在用的帧缓冲，takeCameraFrame() 从这里给预览补一块
+static std::vector<uint8_t*> camera_frame_pool;
+static std::mutex camera_pool_mutex;
+
+// 取出的缓冲总是黑色：池里的缓冲在 releaseCameraFrame() 放回时已经清零（调用方在 LVGL 锁外释放），
+// 这里在锁内只是取一块，不再写 1.8 MB 的 PSRAM
+static uint8_t* acquire_frame_buffer()
+{
+    std::lock_guard<std::mutex> lock(camera_pool_mutex);
+    if (camera_frame_pool.empty()) {
+        return (uint8_t*)heap_caps_calloc(CAMERA_WIDTH * CAMERA_HEIGHT * 2, 1, MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
+    }
+    uint8_t* buffer = camera_frame_pool.back();
+    camera_frame_pool.pop_back();
+    return buffer;
+}
+
+static std::atomic<bool> camera_preview_active{false};
+static bool camera_refr_hooked = false;
 // extern uint8_t* frame_buf;
-static QueueHandle_t queue_camera_ctrl = NULL;
+static QueueHandle_t queue_camera_ctrl    = NULL;
+static SemaphoreHandle_t camera_task_exit = NULL;  // 任务退出时给出
 // 定义任务控制标志
 #define TASK_CONTROL_PAUSE  0
 #define TASK_CONTROL_RESUME 1
 #define TASK_CONTROL_EXIT   2
 
-static bool is_camera_capturing = false;
+// 调用方请求的状态（暂停和恢复在任务里按队列顺序执行，恢复失败时由任务改回暂停）
+static hal::HalBase::CameraState_t camera_state = hal::HalBase::CAMERA_OFF;
 static std::mutex camera_mutex;
 
 static const char* TAG = "camera";
@@ -59,6 +91,7 @@ typedef struct cam {
     uint32_t height;
     uint32_t pixel_format;
     uint8_t* buffer[EXAMPLE_VIDEO_BUFFER_COUNT];
+    uint32_t length[EXAMPLE_VIDEO_BUFFER_COUNT];
 } cam_t;
 
 /*
@@ -183,6 +216,7 @@ static esp_err_t new_cam(int cam_fd, cam_t** ret_wc)
             goto errout;
         }
 
+        wc->length[i] = buf.length;
         wc->buffer[i] = (uint8_t*)mmap(NULL, buf.length, PROT_READ | PROT_WRITE, MAP_SHARED, wc->fd, buf.m.offset);
         if (!wc->buffer[i]) {
             ESP_LOGE(TAG, "failed to map buffer");
@@ -211,11 +245,76 @@ errout:
     return ret;
 }
 
+// Runs in the LVGL task at the start of every refresh, so the canvas only changes buffer between two renders
+static void camera_refr_start_cb(lv_event_t* e)
+{
+    if (!camera_preview_active.load(std::memory_order_relaxed) || !camera_canvas) return;
+    if (camera_frames.acquire()) {
+        lv_canvas_set_buffer(camera_canvas, img_show_data[camera_frames.front()], CAMERA_WIDTH, CAMERA_HEIGHT,
+                             LV_COLOR_FORMAT_RGB565);
+    }
+}
+
 // static HumanFaceDetect* human_face_detector;
-static bool cam_is_initial = false;
-static cam_t* camera       = NULL;
+static bool video_is_initial = false;
+static cam_t* camera         = NULL;
+
+// 启动到第一帧的耗时（冷启动：打开设备并开始数据流；热启动：从暂停恢复）
+static uint64_t camera_start_us = 0;
+static bool camera_start_cold   = false;
+static bool camera_first_frame  = false;  // 等待这次启动后的第一帧
+static LatencyHistogram camera_cold_start;
+static LatencyHistogram camera_warm_start;
+static uint32_t camera_resume_failures = 0;
+
+static void set_camera_state(hal::HalBase::CameraState_t state)
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    camera_state = state;
+}
 
-void app_camera_display(void* arg)
+// 恢复数据流失败：设备保持打开，状态回到暂停，下一次 startCameraCapture() 会再试。
+// 控制命令都在 camera_mutex 下入队，队列里还有后来的命令时由它们决定状态
+static void camera_resume_failed()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    camera_resume_failures++;
+    camera_first_frame = false;
+    if (uxQueueMessagesWaiting(queue_camera_ctrl) == 0) {
+        camera_state = hal::HalBase::CAMERA_PAUSED;
+    }
+    ESP_LOGE(TAG, "camera resume failed, stays paused (%" PRIu32 " failures)", camera_resume_failures);
+}
+
+// STREAMOFF 会把缓冲从队列里全部取出，重新入队后再开始（缓冲一直保持映射）
+static bool camera_stream_on(cam_t* cam)
+{
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    for (int i = 0; i < ARRAY_SIZE(cam->buffer); i++) {
+        struct v4l2_buffer buf;
+        memset(&buf, 0, sizeof(buf));
+        buf.type   = type;
+        buf.memory = MEMORY_TYPE;
+        buf.index  = i;
+        // 驱动在 STREAMOFF 时没有取出的缓冲会入队失败，忽略即可
+        ioctl(cam->fd, VIDIOC_QBUF, &buf);
+    }
+    if (ioctl(cam->fd, VIDIOC_STREAMON, &type) != 0) {
+        ESP_LOGE(TAG, "failed to start stream");
+        return false;
+    }
+    return true;
+}
+
+static void camera_stream_off(cam_t* cam)
+{
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (ioctl(cam->fd, VIDIOC_STREAMOFF, &type) != 0) {
+        ESP_LOGE(TAG, "failed to stop stream");
+    }
+}
+
+static bool camera_open()
 {
     /* camera config */
     static esp_video_init_csi_config_t csi_config = {
@@ -236,43 +335,58 @@ void app_camera_display(void* arg)
         .jpeg = NULL,         // No JPEG configuration
     };
 
-    if (!cam_is_initial) {
-        camera = (cam_t*)malloc(sizeof(cam_t));
+    // esp_video_init() 只能调用一次，设备可以反复打开关闭
+    if (!video_is_initial) {
         printf("\n============= video init ==============\n");
-        cam_is_initial = true;
         ESP_ERROR_CHECK(esp_video_init(&cam_config));
-        printf("\n============= video open ==============\n");
-        int video_cam_fd = app_video_open(CAM_DEV_PATH, EXAMPLE_VIDEO_FMT_RGB565);
-        if (video_cam_fd < 0) {
-            ESP_LOGE(TAG, "video cam open failed");
-            return;
-        }
-        ESP_ERROR_CHECK(new_cam(video_cam_fd, &camera));
+        video_is_initial = true;
+    }
+    printf("\n============= video open ==============\n");
+    int video_cam_fd = app_video_open(CAM_DEV_PATH, EXAMPLE_VIDEO_FMT_RGB565);
+    if (video_cam_fd < 0) {
+        ESP_LOGE(TAG, "video cam open failed");
+        return false;
     }
+    if (new_cam(video_cam_fd, &camera) != ESP_OK) {
+        close(video_cam_fd);
+        camera = NULL;
+        return false;
+    }
+    return true;
+}
+
+static void camera_close(bool streaming)
+{
+    if (streaming) {
+        camera_stream_off(camera);
+    }
+    for (int i = 0; i < ARRAY_SIZE(camera->buffer); i++) {
+        munmap(camera->buffer[i], camera->length[i]);
+    }
+    close(camera->fd);
+    free(camera);
+    camera = NULL;
+}
+
+// 相机服务任务：第一次 startCameraCapture() 时创建，之后一直保留到 powerOffCamera()。
+// 暂停时只停掉数据流并阻塞在控制队列上，V4L2 缓冲保持映射、PPA client 保持注册，恢复时不需要重新创建任务
+void app_camera_display(void* arg)
+{
+    const uint64_t open_start_us = esp_timer_get_time();
+    if (!camera_open()) {
+        set_camera_state(hal::HalBase::CAMERA_OFF);
+        xSemaphoreGive(camera_task_exit);
+        vTaskDelete(NULL);
+        return;
+    }
+    ESP_LOGI(TAG, "camera opened in %" PRIu32 " ms", (uint32_t)((esp_timer_get_time() - open_start_us) / 1000));
 
     struct v4l2_buffer buf;
 
     /* */
     uint16_t screen_width  = 1280;  // 640;//lcd_height();
     uint16_t screen_height = 720;   // 480;//lcd_width();
-    uint8_t* img_show_data = NULL;
     uint32_t img_show_size = screen_width * screen_height * 2;
-    // uint32_t img_offset = 280 * 720 * 2;
-    uint32_t img_offset = 0;
-    static image_t* img_show;  // 初始化静态变量时不能使用非常量表达式
-    if (img_show == NULL) {
-        img_show    = (image_t*)malloc(sizeof(image_t));
-        img_show->w = 720,            // screen_width;
-                                      // img_show->h = 720, // screen_height;
-            img_show->h      = 1280,  // screen_height;
-            img_show->pixfmt = PIXFORMAT_RGB565;
-        img_show->size       = img_show->w * img_show->h * img_show->bpp;
-        img_show_data        = (uint8_t*)heap_caps_calloc(img_show_size, 1, MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM);
-        img_show->data       = img_show_data + img_offset;
-        if (img_show->data == NULL) {
-            ESP_LOGE(TAG, "malloc for img_show->data failed");
-        }
-    }
 
     ppa_client_handle_t ppa_srm_handle = NULL;
     ppa_client_config_t ppa_srm_config = {
@@ -281,8 +395,30 @@ void app_camera_display(void* arg)
     };
     ESP_ERROR_CHECK(ppa_register_client(&ppa_srm_config, &ppa_srm_handle));
 
+    bool streaming   = true;
     int task_control = 0;
     while (1) {
+        // 暂停中只等控制命令，不占 CPU
+        if (xQueueReceive(queue_camera_ctrl, &task_control, streaming ? 0 : portMAX_DELAY) == pdPASS) {
+            if (task_control == TASK_CONTROL_EXIT) {
+                break;
+            } else if (task_control == TASK_CONTROL_PAUSE && streaming) {
+                ESP_LOGI(TAG, "task pause");
+                auto stats = camera_frames.getStats();
+                mclog::tagInfo(TAG, "preview frames: published {}, displayed {}, dropped {}, duplicated {}",
+                               stats.published, stats.displayed, stats.dropped, stats.duplicated);
+                camera_stream_off(camera);
+                streaming = false;
+            } else if (task_control == TASK_CONTROL_RESUME && !streaming) {
+                ESP_LOGI(TAG, "task resume");
+                streaming = camera_stream_on(camera);
+                if (!streaming) {
+                    camera_resume_failed();
+                }
+            }
+            continue;
+        }
+
         memset(&buf, 0, sizeof(buf));
         buf.type   = V4L2_BUF_TYPE_VIDEO_CAPTURE;
         buf.memory = MEMORY_TYPE;
@@ -299,7 +435,7 @@ void app_camera_display(void* arg)
                                                                .block_offset_x = 0,
                                                                .block_offset_y = 0,
                                                                .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
-                                            .out            = {.buffer         = img_show_data,
+                                            .out            = {.buffer         = img_show_data[camera_frames.back()],
                                                                .buffer_size    = img_show_size,
                                                                .pic_w          = 1280,
                                                                .pic_h          = 720,
@@ -318,47 +454,38 @@ void app_camera_display(void* arg)
 
         // auto detect_results = human_face_detector->run(dl_img); // format: hwc
 
-        bsp_display_lock(0);
-        lv_canvas_set_buffer(camera_canvas, img_show->data, CAMERA_WIDTH, CAMERA_HEIGHT, LV_COLOR_FORMAT_RGB565);
-        bsp_display_unlock();
+        // 不再在这里持有 LVGL 锁换缓冲，由下一次刷新开始时换入最新的一帧
+        camera_frames.publish();
+
+        {
+            std::lock_guard<std::mutex> lock(camera_mutex);
+            if (camera_first_frame) {
+                const uint64_t us = esp_timer_get_time() - camera_start_us;
+                (camera_start_cold ? camera_cold_start : camera_warm_start).add(us);
+                camera_first_frame = false;
+                mclog::tagInfo(TAG, "first frame after {:.1f} ms ({} start)", us / 1000.0f,
+                               camera_start_cold ? "cold" : "warm");
+            }
+        }
 
         if (ioctl(camera->fd, VIDIOC_QBUF, &buf) != 0) {
             ESP_LOGE(TAG, "failed to free video frame");
         }
 
-        if (xQueueReceive(queue_camera_ctrl, &task_control, 0) == pdPASS) {
-            if (task_control == TASK_CONTROL_PAUSE) {
-                ESP_LOGI(TAG, "task pause");
-                if (xQueueReceive(queue_camera_ctrl, &task_control, portMAX_DELAY) == pdPASS) {
-                    if (task_control == TASK_CONTROL_EXIT) {
-                        break;
-                    } else {
-                        ESP_LOGI(TAG, "task resume");
-                    }
-                }
-            }
-        }
-
         vTaskDelay(pdMS_TO_TICKS(10));
     }
 
     ESP_LOGI(TAG, "task exit");
     ppa_unregister_client(ppa_srm_handle);
     // delete human_face_detector;
-    if (img_show_data) {
-        heap_caps_free(img_show_data);
-        img_show_data = NULL;
-    }
-    if (img_show) {
-        heap_caps_free(img_show);
-        img_show = NULL;
-    }
-    // close(camera->fd);
+    camera_close(streaming);
 
-    camera_mutex.lock();
-    is_camera_capturing = false;
-    camera_mutex.unlock();
+    auto stats = camera_frames.getStats();
+    mclog::tagInfo(TAG, "preview frames: published {}, displayed {}, dropped {}, duplicated {}", stats.published,
+                   stats.displayed, stats.dropped, stats.duplicated);
 
+    set_camera_state(hal::HalBase::CAMERA_OFF);
+    xSemaphoreGive(camera_task_exit);
     vTaskDelete(NULL);
 }
 
@@ -366,30 +493,213 @@ void HalEsp32::startCameraCapture(lv_obj_t* imgCanvas)
 {
     mclog::tagInfo(TAG, "start camera capture");
 
+    // 预览缓冲只在第一次申请（被应用取走的从池里补上），之后一直保留
+    for (int i = 0; i < CAMERA_PREVIEW_BUFFER_COUNT; i++) {
+        if (img_show_data[i]) continue;
+        img_show_data[i] = acquire_frame_buffer();
+        if (img_show_data[i] == NULL) {
+            ESP_LOGE(TAG, "malloc for img_show_data failed");
+            return;
+        }
+    }
+
+    // 调用方持有 LVGL 锁：在第一帧到来之前显示 front 缓冲
     camera_canvas = imgCanvas;
+    camera_frames.discard();
+    camera_frames.resetStats();
+    lv_canvas_set_buffer(camera_canvas, img_show_data[camera_frames.front()], CAMERA_WIDTH, CAMERA_HEIGHT,
+                         LV_COLOR_FORMAT_RGB565);
+    if (!camera_refr_hooked) {
+        lv_display_add_event_cb(lv_obj_get_display(camera_canvas), camera_refr_start_cb, LV_EVENT_REFR_START, NULL);
+        camera_refr_hooked = true;
+    }
+    camera_preview_active = true;
 
-    queue_camera_ctrl = xQueueCreate(10, sizeof(int));
     if (queue_camera_ctrl == NULL) {
-        ESP_LOGD(TAG, "Failed to create semaphore\n");
+        queue_camera_ctrl = xQueueCreate(10, sizeof(int));
+        camera_task_exit  = xSemaphoreCreateBinary();
+        if (queue_camera_ctrl == NULL || camera_task_exit == NULL) {
+            ESP_LOGE(TAG, "failed to create camera task queue");
+            return;
+        }
     }
 
-    is_camera_capturing = true;
-    xTaskCreatePinnedToCore(app_camera_display, "cam", 8 * 1024, NULL, 5, NULL, 1);
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    if (camera_state == CAMERA_STREAMING) return;
+    camera_start_us    = esp_timer_get_time();
+    camera_start_cold  = camera_state == CAMERA_OFF;
+    camera_first_frame = true;
+    if (camera_state == CAMERA_OFF) {
+        // 冷启动：创建常驻任务，由任务打开设备
+        xQueueReset(queue_camera_ctrl);
+        xSemaphoreTake(camera_task_exit, 0);
+        xTaskCreatePinnedToCore(app_camera_display, "cam", 8 * 1024, NULL, 5, NULL, 1);
+    } else {
+        // 热启动：任务还在，恢复数据流即可（失败时任务把状态改回暂停）
+        int control_state = TASK_CONTROL_RESUME;
+        xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
+    }
+    camera_state = CAMERA_STREAMING;
 }
 
 void HalEsp32::stopCameraCapture()
 {
     mclog::tagInfo(TAG, "stop camera capture");
 
-    int control_state = 0;  // pause
-    xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
+    // 画布保留最后换入的一帧，之后发布的帧不再显示
+    camera_preview_active = false;
 
-    control_state = 2;  // exit
+    // 只暂停，任务和缓冲保留到 powerOffCamera()
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    if (camera_state != CAMERA_STREAMING) return;
+    int control_state = TASK_CONTROL_PAUSE;
     xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
+    camera_state = CAMERA_PAUSED;
+}
+
+void HalEsp32::powerOffCamera()
+{
+    camera_preview_active = false;
+    {
+        std::lock_guard<std::mutex> lock(camera_mutex);
+        if (camera_state == CAMERA_OFF) return;
+        int control_state = TASK_CONTROL_EXIT;
+        xQueueSend(queue_camera_ctrl, &control_state, portMAX_DELAY);
+    }
+
+    // 任务不需要 LVGL 锁就能退出，持有锁时也可以等
+    mclog::tagInfo(TAG, "power off camera");
+    if (xSemaphoreTake(camera_task_exit, pdMS_TO_TICKS(2000)) != pdTRUE) {
+        ESP_LOGE(TAG, "camera task did not exit");
+    }
 }
 
 bool HalEsp32::isCameraCapturing()
 {
     std::lock_guard<std::mutex> lock(camera_mutex);
-    return is_camera_capturing;
+    return camera_state == CAMERA_STREAMING;
+}
+
+hal::HalBase::CameraState_t HalEsp32::getCameraState()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    return camera_state;
+}
+
+hal::HalBase::CameraStartStats_t HalEsp32::getCameraStartStats()
+{
+    std::lock_guard<std::mutex> lock(camera_mutex);
+    CameraStartStats_t stats;
+    stats.cold           = camera_cold_start.summary();
+    stats.warm           = camera_warm_start.summary();
+    stats.resumeFailures = camera_resume_failures;
+    return stats;
+}
+
+TripleBuffer::Stats_t HalEsp32::getCameraFrameStats()
+{
+    return camera_frames.getStats();
+}
+
+bool HalEsp32::takeCameraFrame(CameraFrame_t& frame)
+{
+    // front 缓冲归 LVGL 一侧所有（调用方持有锁），换成池里的缓冲即可，采集任务继续写另外两块。
+    // 被取走的缓冲之后归应用所有（释放后还会回到池里），画布马上改为显示换上的黑色缓冲，直到下一帧换入
+    if (!camera_canvas || camera_frames.getStats().displayed == 0) return false;
+
+    uint8_t* fresh = acquire_frame_buffer();
+    if (fresh == NULL) {
+        ESP_LOGE(TAG, "malloc for camera frame failed");
+        return false;
+    }
+    const int index      = camera_frames.front();
+    frame.data           = (uint16_t*)img_show_data[index];
+    frame.width          = CAMERA_WIDTH;
+    frame.height         = CAMERA_HEIGHT;
+    frame.stride         = CAMERA_WIDTH;
+    img_show_data[index] = fresh;
+    lv_canvas_set_buffer(camera_canvas, fresh, CAMERA_WIDTH, CAMERA_HEIGHT, LV_COLOR_FORMAT_RGB565);
+    return true;
+}
+
+void HalEsp32::releaseCameraFrame(const CameraFrame_t& frame)
+{
+    if (frame.data == NULL) return;
+
+    // 缓冲里还留着应用用过的照片，放回池之前清零（预览下次取出时直接显示黑色）
+    memset(frame.data, 0, CAMERA_WIDTH * CAMERA_HEIGHT * 2);
+    std::lock_guard<std::mutex> lock(camera_pool_mutex);
+    camera_frame_pool.push_back((uint8_t*)frame.data);
+}
+
+// 缩放用的 PPA SRM client，第一次缩放时注册后一直保留（和相机任务的 client 分开，可以在任意任务里调用）
+static ppa_client_handle_t ppa_scale_handle = NULL;
+static std::mutex ppa_scale_mutex;
+
+// PPA 的缩放倍率步长是 1/16，范围 1/16 ~ 16
+static bool ppa_scale_exact(int32_t src_len, int32_t dst_len)
+{
+    return (dst_len * 16) % src_len == 0 && dst_len * 16 >= src_len && dst_len < src_len * 16;
+}
+
+void HalEsp32::scaleImage(const ImageScaler::Image565_t& src, const ImageScaler::Image565_t& dst,
+                          ImageScaler::Policy_t policy, ImageScaler::Filter_t filter, uint16_t fill)
+{
+    // PPA 的插值方式是固定的，filter 只对软件路径有效；倍率不是 1/16 的整数倍或输出缓冲没有按 cache line
+    // 对齐时交给软件路径（结果的位置和大小一样）
+    const auto map   = ImageScaler::mapping(src.width, src.height, dst.width, dst.height, policy);
+    size_t alignment = 0;
+    esp_cache_get_alignment(MALLOC_CAP_DMA | MALLOC_CAP_SPIRAM, &alignment);
+    const size_t dst_size = (size_t)dst.stride * dst.height * sizeof(uint16_t);
+    const bool aligned    = alignment == 0 || ((uintptr_t)dst.data % alignment == 0 && dst_size % alignment == 0);
+    if (!src.data || !dst.data || map.dstW <= 0 || map.dstH <= 0 || !aligned || !ppa_scale_exact(map.srcW, map.dstW) ||
+        !ppa_scale_exact(map.srcH, map.dstH)) {
+        HalBase::scaleImage(src, dst, policy, filter, fill);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(ppa_scale_mutex);
+    if (ppa_scale_handle == NULL) {
+        ppa_client_config_t config = {
+            .oper_type             = PPA_OPERATION_SRM,
+            .max_pending_trans_num = 1,
+        };
+        if (ppa_register_client(&config, &ppa_scale_handle) != ESP_OK) {
+            ppa_scale_handle = NULL;
+            HalBase::scaleImage(src, dst, policy, filter, fill);
+            return;
+        }
+    }
+
+    ppa_srm_oper_config_t srm_config = {.in             = {.buffer         = src.data,
+                                                           .pic_w          = (uint32_t)src.stride,
+                                                           .pic_h          = (uint32_t)src.height,
+                                                           .block_w        = (uint32_t)map.srcW,
+                                                           .block_h        = (uint32_t)map.srcH,
+                                                           .block_offset_x = (uint32_t)map.srcX,
+                                                           .block_offset_y = (uint32_t)map.srcY,
+                                                           .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
+                                        .out            = {.buffer         = dst.data,
+                                                           .buffer_size    = (uint32_t)dst_size,
+                                                           .pic_w          = (uint32_t)dst.stride,
+                                                           .pic_h          = (uint32_t)dst.height,
+                                                           .block_offset_x = (uint32_t)map.dstX,
+                                                           .block_offset_y = (uint32_t)map.dstY,
+                                                           .srm_cm         = PPA_SRM_COLOR_MODE_RGB565},
+                                        .rotation_angle = PPA_SRM_ROTATION_ANGLE_0,
+                                        .scale_x        = (float)map.dstW / map.srcW,
+                                        .scale_y        = (float)map.dstH / map.srcH,
+                                        .mirror_x       = false,
+                                        .mirror_y       = false,
+                                        .rgb_swap       = false,
+                                        .byte_swap      = false,
+                                        .mode           = PPA_TRANS_MODE_BLOCKING};
+    if (ppa_do_scale_rotate_mirror(ppa_scale_handle, &srm_config) != ESP_OK) {
+        ESP_LOGE(TAG, "ppa scale failed, fall back to software");
+        HalBase::scaleImage(src, dst, policy, filter, fill);
+        return;
+    }
+
+    // 边框在 PPA 写完之后再填，免得 DMA 之后的 cache 同步盖掉
+    ImageScaler::fillBorder(dst, map, fill);
 }
@@ -0,0 +1,195 @@
+/*
+ * SPDX-FileCopyrightText: 2025 M5Stack Technology CO LTD
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "hal/hal_esp32.h"
+#include <mooncake_log.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <lvgl.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <bsp/m5stack_tab5.h>
+
+#define TAG "touch"
+
+extern esp_lcd_touch_handle_t _lcd_touch_handle;
+
+// The LVGL indev only reads once per refresh period (~33 ms). This task is the single reader of the touch
+// controller: it keeps the latest state for the LVGL read callback and, when enabled, pushes every sample into
+// the HAL ring buffer so the app can consume the full rate.
+static constexpr uint32_t TOUCH_POLL_INTERVAL_MS = 4;
+
+struct TouchState_t {
+    std::mutex mutex;
+    uint16_t x   = 0;
+    uint16_t y   = 0;
+    bool pressed = false;
+};
+static TouchState_t _touch_state;
+static std::atomic<bool> _touch_sampling{false};
+
+static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
+{
+    std::lock_guard<std::mutex> lock(_touch_state.mutex);
+    data->point.x = _touch_state.x;
+    data->point.y = _touch_state.y;
+    data->state   = _touch_state.pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+}
+
+// Same transform LVGL applies to pointer input for LV_DISPLAY_ROTATION_90 (panel is 720x1280 native)
+static void touch_to_display(uint16_t touchX, uint16_t touchY, int32_t& x, int32_t& y)
+{
+    x = BSP_LCD_V_RES - 1 - touchY;
+    y = touchX;
+}
+
+// esp_lcd_touch drops the controller's track IDs, so fingers are matched to the previous poll by distance. At a
+// 4 ms poll interval a finger moves far less than this between reads, while two fingers are rarely closer.
+static constexpr int32_t TOUCH_TRACK_RADIUS = 160;
+
+/**
+ * @brief Assign finger IDs to the points of one read and queue the changes
+ *
+ * Points are matched to the fingers that were down by the closest pair first. Fingers without a point are
+ * released, points without a finger get the lowest free ID. Releases are queued before presses so the app never
+ * sees more fingers than the controller reported.
+ */
+static void track_touch_points(hal::HalBase::TouchSample_t* fingers, const int32_t* xs, const int32_t* ys, int count,
+                               uint64_t now)
+{
+    constexpr int MAX_POINTS = hal::HalBase::MAX_TOUCH_POINTS;
+    int point_of[MAX_POINTS];
+    bool matched[MAX_POINTS] = {};
+    for (int id = 0; id < MAX_POINTS; id++) {
+        point_of[id] = -1;
+    }
+
+    while (true) {
+        int best_id          = -1;
+        int best_point       = -1;
+        int64_t best_dist_sq = (int64_t)TOUCH_TRACK_RADIUS * TOUCH_TRACK_RADIUS;
+        for (int id = 0; id < MAX_POINTS; id++) {
+            if (!fingers[id].pressed || point_of[id] >= 0) continue;
+            for (int i = 0; i < count; i++) {
+                if (matched[i]) continue;
+                const int64_t dx      = xs[i] - fingers[id].x;
+                const int64_t dy      = ys[i] - fingers[id].y;
+                const int64_t dist_sq = dx * dx + dy * dy;
+                if (dist_sq <= best_dist_sq) {
+                    best_dist_sq = dist_sq;
+                    best_id      = id;
+                    best_point   = i;
+                }
+            }
+        }
+        if (best_id < 0) break;
+        point_of[best_id]   = best_point;
+        matched[best_point] = true;
+    }
+
+    // Only state changes and movement are worth queueing
+    auto queue = [&](int id, int32_t x, int32_t y, bool pressed) {
+        hal::HalBase::TouchSample_t& last = fingers[id];
+        if (pressed == last.pressed && x == last.x && y == last.y) return;
+        last.x           = x;
+        last.y           = y;
+        last.pressed     = pressed;
+        last.timestampUs = now;
+        last.id          = id;
+        GetHAL()->touchSamples.push(last);
+    };
+
+    for (int id = 0; id < MAX_POINTS; id++) {
+        if (fingers[id].pressed && point_of[id] < 0) {
+            queue(id, fingers[id].x, fingers[id].y, false);
+        }
+    }
+    for (int id = 0; id < MAX_POINTS; id++) {
+        if (point_of[id] >= 0) queue(id, xs[point_of[id]], ys[point_of[id]], true);
+    }
+    for (int i = 0; i < count; i++) {
+        if (matched[i]) continue;
+        for (int id = 0; id < MAX_POINTS; id++) {
+            if (fingers[id].pressed) continue;
+            queue(id, xs[i], ys[i], true);
+            break;
+        }
+    }
+}
+
+static void touch_poll_task(void* param)
+{
+    constexpr int MAX_POINTS = hal::HalBase::MAX_TOUCH_POINTS;
+    hal::HalBase::TouchSample_t fingers[MAX_POINTS];  // Last queued sample of each finger ID
+
+    while (1) {
+        uint16_t touch_x[MAX_POINTS];
+        uint16_t touch_y[MAX_POINTS];
+        uint16_t touch_strength[MAX_POINTS];
+        uint8_t touch_cnt = 0;
+
+        esp_lcd_touch_read_data(_lcd_touch_handle);
+        bool pressed = esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt,
+                                                     MAX_POINTS);
+        uint64_t now = esp_timer_get_time();
+        if (!pressed) touch_cnt = 0;
+
+        // LVGL keeps using the first reported point as its single pointer
+        _touch_state.mutex.lock();
+        _touch_state.pressed = pressed;
+        if (pressed) {
+            _touch_state.x = touch_x[0];
+            _touch_state.y = touch_y[0];
+        }
+        _touch_state.mutex.unlock();
+
+        if (_touch_sampling.load(std::memory_order_relaxed)) {
+            int32_t xs[MAX_POINTS];
+            int32_t ys[MAX_POINTS];
+            const int count = std::min<int>(touch_cnt, MAX_POINTS);
+            for (int i = 0; i < count; i++) {
+                touch_to_display(touch_x[i], touch_y[i], xs[i], ys[i]);
+            }
+            track_touch_points(fingers, xs, ys, count, now);
+        } else {
+            for (auto& finger : fingers) {
+                finger = hal::HalBase::TouchSample_t();
+            }
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(TOUCH_POLL_INTERVAL_MS));
+    }
+}
+
+void HalEsp32::touch_init()
+{
+    mclog::tagInfo(TAG, "touch init, poll interval {} ms", TOUCH_POLL_INTERVAL_MS);
+
+    // Touchpad lvgl indev
+    lvTouchpad = lv_indev_create();
+    lv_indev_set_type(lvTouchpad, LV_INDEV_TYPE_POINTER);
+    lv_indev_set_read_cb(lvTouchpad, lvgl_read_cb);
+    lv_indev_set_display(lvTouchpad, lvDisp);
+
+    if (_lcd_touch_handle == NULL) {
+        mclog::tagError(TAG, "touch handle is null");
+        return;
+    }
+    xTaskCreatePinnedToCore(touch_poll_task, "touch", 4096, NULL, 6, NULL, 0);
+}
+
+bool HalEsp32::setTouchSampling(bool enable)
+{
+    _touch_sampling.store(enable, std::memory_order_relaxed);
+    mclog::tagInfo(TAG, "touch sampling: {}", enable);
+    return _lcd_touch_handle != NULL;
+}
+
+int HalEsp32::getMaxTouchPoints()
+{
+    return hal::HalBase::MAX_TOUCH_POINTS;
+}
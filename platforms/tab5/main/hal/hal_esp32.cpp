@@ -14,36 +14,8 @@ extern "C" {
 #include <bsp/m5stack_tab5.h>
 #include <lv_demos.h>
 
-extern esp_lcd_touch_handle_t _lcd_touch_handle;
-
 static const std::string _tag = "hal";
 
-static void lvgl_read_cb(lv_indev_t* indev, lv_indev_data_t* data)
-{
-    if (_lcd_touch_handle == NULL) {
-        data->state = LV_INDEV_STATE_REL;
-        return;
-    }
-
-    uint16_t touch_x[1];
-    uint16_t touch_y[1];
-    uint16_t touch_strength[1];
-    uint8_t touch_cnt = 0;
-
-    esp_lcd_touch_read_data(_lcd_touch_handle);
-    bool touchpad_pressed =
-        esp_lcd_touch_get_coordinates(_lcd_touch_handle, touch_x, touch_y, touch_strength, &touch_cnt, 1);
-    // mclog::tagInfo(_tag, "touchpad pressed: {}", touchpad_pressed);
-
-    if (!touchpad_pressed) {
-        data->state = LV_INDEV_STATE_REL;
-    } else {
-        data->state   = LV_INDEV_STATE_PR;
-        data->point.x = touch_x[0];
-        data->point.y = touch_y[0];
-    }
-}
-
 void HalEsp32::init()
 {
     mclog::tagInfo(_tag, "init");
@@ -102,14 +74,12 @@ void HalEsp32::init()
                              }};
     lvDisp = bsp_display_start_with_config(&cfg);
     lv_display_set_rotation(lvDisp, LV_DISPLAY_ROTATION_90);
+    hookLatencyFlush(lvDisp);
     bsp_display_backlight_on();
 
     // Touchpad lvgl indev
     mclog::tagInfo(_tag, "create lvgl touchpad indev");
-    lvTouchpad = lv_indev_create();
-    lv_indev_set_type(lvTouchpad, LV_INDEV_TYPE_POINTER);
-    lv_indev_set_read_cb(lvTouchpad, lvgl_read_cb);
-    lv_indev_set_display(lvTouchpad, lvDisp);
+    touch_init();
 
     mclog::tagInfo(_tag, "usb host init");
     bsp_usb_host_start(BSP_USB_HOST_POWER_MODE_USB_DEV, true);
@@ -189,6 +159,11 @@ uint32_t HalEsp32::millis()
     return esp_timer_get_time() / 1000;
 }
 
+uint64_t HalEsp32::micros()
+{
+    return esp_timer_get_time();
+}
+
 int HalEsp32::getCpuTemp()
 {
     if (_temp_sensor == nullptr) {
@@ -279,10 +254,14 @@ std::vector<hal::HalBase::FileEntry_t> HalEsp32::scanSdCard(const std::string& d
 {
     std::vector<hal::HalBase::FileEntry_t> file_entries;
 
-    mclog::tagInfo(_tag, "init sd card");
-    if (bsp_sdcard_init("/sd", 25) != ESP_OK) {
-        mclog::error("failed to mount sd card");
-        return file_entries;
+    // Keep the card mounted if it is already in use as scratch storage
+    const bool keep_mounted = _sd_card_mounted;
+    if (!keep_mounted) {
+        mclog::tagInfo(_tag, "init sd card");
+        if (bsp_sdcard_init("/sd", 25) != ESP_OK) {
+            mclog::error("failed to mount sd card");
+            return file_entries;
+        }
     }
 
     std::string target_path = "/sd/" + dirPath;
@@ -290,6 +269,9 @@ std::vector<hal::HalBase::FileEntry_t> HalEsp32::scanSdCard(const std::string& d
     DIR* dir = opendir(target_path.c_str());
     if (dir == nullptr) {
         mclog::error("failed to open directory: {}", target_path);
+        if (!keep_mounted) {
+            bsp_sdcard_deinit("/sd");
+        }
         return file_entries;
     }
 
@@ -307,12 +289,28 @@ std::vector<hal::HalBase::FileEntry_t> HalEsp32::scanSdCard(const std::string& d
 
     closedir(dir);
 
-    mclog::tagInfo(_tag, "deinit sd card");
-    bsp_sdcard_deinit("/sd");
+    if (!keep_mounted) {
+        mclog::tagInfo(_tag, "deinit sd card");
+        bsp_sdcard_deinit("/sd");
+    }
 
     return file_entries;
 }
 
+std::string HalEsp32::getScratchDir()
+{
+    // Mounted on first use and kept mounted, since scratch files stay open while an app runs
+    if (!_sd_card_mounted) {
+        mclog::tagInfo(_tag, "mount sd card for scratch files");
+        if (bsp_sdcard_init("/sd", 25) != ESP_OK) {
+            mclog::tagError(_tag, "failed to mount sd card");
+            return "";
+        }
+        _sd_card_mounted = true;
+    }
+    return "/sd";
+}
+
 /* -------------------------------------------------------------------------- */
 /*                                  Interface                                 */
 /* -------------------------------------------------------------------------- */
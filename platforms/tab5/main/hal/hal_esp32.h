@@ -20,6 +20,7 @@ public:
 
     void delay(uint32_t ms) override;
     uint32_t millis() override;
+    uint64_t micros() override;
     int getCpuTemp() override;
 
     INA226 ina226;
@@ -33,6 +34,9 @@ public:
     void lvglLock() override;
     void lvglUnlock() override;
 
+    bool setTouchSampling(bool enable) override;
+    int getMaxTouchPoints() override;
+
     void updatePowerMonitorData() override;
     void updateImuData() override;
     void clearImuIrq() override;
@@ -56,6 +60,14 @@ public:
     void startCameraCapture(lv_obj_t* imgCanvas) override;
     void stopCameraCapture() override;
     bool isCameraCapturing() override;
+    void powerOffCamera() override;
+    CameraState_t getCameraState() override;
+    CameraStartStats_t getCameraStartStats() override;
+    TripleBuffer::Stats_t getCameraFrameStats() override;
+    bool takeCameraFrame(CameraFrame_t& frame) override;
+    void releaseCameraFrame(const CameraFrame_t& frame) override;
+    void scaleImage(const ImageScaler::Image565_t& src, const ImageScaler::Image565_t& dst,
+                    ImageScaler::Policy_t policy, ImageScaler::Filter_t filter, uint16_t fill) override;
 
     void setSpeakerVolume(uint8_t volume) override;
     uint8_t getSpeakerVolume() override;
@@ -77,6 +89,7 @@ public:
 
     bool isSdCardMounted() override;
     std::vector<FileEntry_t> scanSdCard(const std::string& dirPath) override;
+    std::string getScratchDir() override;
 
     bool usbCDetect() override;
     bool usbADetect() override;
@@ -91,6 +104,7 @@ public:
 private:
     void set_gpio_output_capability();
     void hid_init();
+    void touch_init();
     void rs485_init();
     bool wifi_init();
     void imu_init();